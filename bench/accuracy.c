@@ -0,0 +1,2933 @@
+// Compile: gcc -O2 math/math_base.c math/vector.c math/matrix.c math/broadphase.c math/transform.c math/camera.c math/matn.c math/sparse.c math/lu.c math/svd.c math/spline.c math/anim.c math/noise.c math/random.c math/probe.c math/metrics.c math/arena.c math/pool.c math/jobgraph.c math/xformstore.c math/quant.c bench/accuracy.c -pthread -o accuracy
+// Запуск: accuracy [вариант=ulp ...] - бюджеты ошибки вместо заданных в acc_cases.
+// Код возврата 1, если ошибка какого-либо варианта больше его бюджета.
+
+/*
+Точность и скорость ядер библиотеки. Каждый вариант считается на двух
+наборах входов - плотном (равномерно по области определения) и
+неудобном (границы области, окрестности особых точек с шагом в ulp,
+крайние масштабы) - и сравнивается с вычислением в double.
+
+Ошибка измеряется в ulp результата float. Для векторов и матриц берётся
+наибольшая ошибка компонента в ulp наибольшей по модулю компоненты
+эталона (нормированная ошибка). Входы, для которых эталон не помещается
+во float, пропускаются.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "../math.h"
+#include "../math/lane.h"
+
+#define ACC_COUNT       65536   // элементов плотного набора
+#define ACC_MAX_IN      32      // чисел float на входной элемент
+#define ACC_MAX_OUT     16      // чисел float на выходной элемент
+#define ACC_SAMPLES     5       // замеров скорости, берётся лучший
+
+// вариант ядра: вход и выход - in_dim и out_dim чисел на элемент
+typedef struct {
+    const char*     group;      // варианты одной функции сравниваются между собой
+    const char*     name;
+    int             in_dim;
+    int             out_dim;
+    int             ( *gen )( float* in, int cap, int adversarial );
+    void            ( *run )( float* out, const float* in, int count );
+    void            ( *ref )( double* out, const float* in, int count );
+    double          budget;     // допустимая ошибка в ulp
+} acccase_t;
+
+typedef struct {
+    double          max_ulp;
+    double          mean_ulp;
+    int             count;      // учтённых элементов
+    int             worst;      // номер элемента с наибольшей ошибкой
+    float           worst_in[ACC_MAX_IN];
+} accerror_t;
+
+static float    acc_in[ACC_COUNT * ACC_MAX_IN];
+static float    acc_out[ACC_COUNT * ACC_MAX_OUT];
+static double   acc_ref[ACC_COUNT * ACC_MAX_OUT];
+
+static volatile float acc_sink;
+
+static double AccNow( void ) {
+#if defined( _WIN32 )
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &counter );
+    return ( double )counter.QuadPart / ( double )freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+static float AccRand( void ) {
+    return ( float )rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+/*
+AccUlp
+
+Размер ulp числа float, ближайшего к |x|.
+*/
+static double AccUlp( double x ) {
+    float f = ( float )fabs( x );
+    int e;
+    if( f < FLT_MIN ) {
+        return ldexp( 1.0, -149 );
+    }
+    frexpf( f, &e );
+    return ldexp( 1.0, e - 24 );
+}
+
+/*
+AccNeighbors
+
+Запись x и соседних чисел float на расстоянии до k ulp в in.
+Возвращает новое число записанных значений.
+*/
+static int AccNeighbors( float* in, int n, int cap, float x, int k ) {
+    float lo = x;
+    float hi = x;
+    if( n < cap ) {
+        in[n++] = x;
+    }
+    for( int i = 0; ( i < k ) && ( n + 2 <= cap ); i++ ) {
+        lo = nextafterf( lo, -FLT_MAX );
+        hi = nextafterf( hi, FLT_MAX );
+        in[n++] = lo;
+        in[n++] = hi;
+    }
+    return n;
+}
+
+/* наборы входов */
+
+// положительные числа, равномерно по логарифму на [2^-lo, 2^hi]
+static int AccGenLogRange( float* in, int cap, int lo, int hi ) {
+    for( int i = 0; i < cap; i++ ) {
+        in[i] = ( float )exp2( -lo + ( double )( lo + hi ) * i / ( cap - 1 ) );
+    }
+    return cap;
+}
+
+static int AccGenPositive( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        return AccGenLogRange( in, cap, 40, 40 );
+    }
+    int n = 0;
+    // только нормализованные числа: аппаратный rsqrt считает денормализованные нулём
+    for( int e = -125; e <= 127; e += 3 ) {
+        n = AccNeighbors( in, n, cap, ldexpf( 1.0f, e ), 3 );
+    }
+    n = AccNeighbors( in, n, cap, FLT_MAX, 3 );
+    n = AccNeighbors( in, n, cap, ldexpf( 1.0f, -124 ), 3 );
+    return n;
+}
+
+static int AccGenAngle( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        for( int i = 0; i < cap; i++ ) {
+            in[i] = ( float )( -2.0 * M_PI + 4.0 * M_PI * i / ( cap - 1 ) );
+        }
+        return cap;
+    }
+    int n = 0;
+    for( int k = -64; k <= 64; k++ ) {
+        n = AccNeighbors( in, n, cap, ( float )( k * M_PI / 2.0 ), 4 );
+    }
+    n = AccNeighbors( in, n, cap, 1e-30f, 2 );
+    n = AccNeighbors( in, n, cap, -1e-30f, 2 );
+    n = AccNeighbors( in, n, cap, 1e4f, 2 );
+    n = AccNeighbors( in, n, cap, 1e5f, 2 );
+    return n;
+}
+
+// углы без окрестностей pi / 2 + k pi, где тангенс уходит в бесконечность
+static int AccGenTanAngle( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        for( int i = 0; i < cap; i++ ) {
+            in[i] = ( float )( -1.5 + 3.0 * i / ( cap - 1 ) );
+        }
+        return cap;
+    }
+    int n = 0;
+    for( int k = -64; k <= 64; k++ ) {
+        n = AccNeighbors( in, n, cap, ( float )( k * M_PI ), 4 );
+        n = AccNeighbors( in, n, cap, ( float )( k * M_PI + M_PI / 4.0 ), 4 );
+    }
+    return n;
+}
+
+static int AccGenUnit( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        for( int i = 0; i < cap; i++ ) {
+            in[i] = -1.0f + 2.0f * i / ( cap - 1 );
+        }
+        return cap;
+    }
+    int n = 0;
+    n = AccNeighbors( in, n, cap, 0.0f, 2 );
+    n = AccNeighbors( in, n, cap, 0.5f, 4 );
+    n = AccNeighbors( in, n, cap, -0.5f, 4 );
+    for( int k = 1; k <= 32; k++ ) {
+        in[n++] = 1.0f - k * FLT_EPSILON * 0.5f;
+        in[n++] = -1.0f + k * FLT_EPSILON * 0.5f;
+    }
+    in[n++] = 1.0f;
+    in[n++] = -1.0f;
+    return n;
+}
+
+static int AccGenReal( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        for( int i = 0; i < cap; i++ ) {
+            in[i] = -50.0f + 100.0f * i / ( cap - 1 );
+        }
+        return cap;
+    }
+    int n = 0;
+    const float pts[] = { 0.0f, 1.0f, -1.0f, 1e-30f, -1e-30f, 1e30f, -1e30f, FLT_MAX, -FLT_MAX };
+    for( int i = 0; i < ( int )( sizeof( pts ) / sizeof( pts[0] ) ); i++ ) {
+        n = AccNeighbors( in, n, cap, pts[i], 3 );
+    }
+    return n;
+}
+
+static int AccGenExp( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        for( int i = 0; i < cap; i++ ) {
+            in[i] = -87.0f + 175.0f * i / ( cap - 1 );
+        }
+        return cap;
+    }
+    int n = 0;
+    const float pts[] = { 0.0f, 1e-7f, -1e-7f, 1.0f, -1.0f, 88.7f, -87.3f, 0.5f };
+    for( int i = 0; i < ( int )( sizeof( pts ) / sizeof( pts[0] ) ); i++ ) {
+        n = AccNeighbors( in, n, cap, pts[i], 4 );
+    }
+    return n;
+}
+
+static int AccGenLog( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        return AccGenLogRange( in, cap, 100, 100 );
+    }
+    int n = 0;
+    n = AccNeighbors( in, n, cap, 1.0f, 16 );
+    n = AccNeighbors( in, n, cap, FLT_MIN, 3 );
+    n = AccNeighbors( in, n, cap, FLT_MAX, 3 );
+    n = AccNeighbors( in, n, cap, ( float )M_E, 3 );
+    return n;
+}
+
+// пары ( x, y ) для pow: x на [1/64, 64], y на [-8, 8]
+static int AccGenPow( float* in, int cap, int adversarial ) {
+    int n = 0;
+    if( !adversarial ) {
+        for( int i = 0; i < cap; i++ ) {
+            in[2 * i] = ( float )exp2( -6.0 + 12.0 * ( i % 256 ) / 255.0 );
+            in[2 * i + 1] = -8.0f + 16.0f * ( i / 256 ) / ( cap / 256 - 1 );
+        }
+        return cap;
+    }
+    const float xs[] = { 1.0f, 2.0f, 0.5f, 10.0f, 1.0f + FLT_EPSILON, 1.0f - FLT_EPSILON * 0.5f };
+    const float ys[] = { 0.0f, 1.0f, -1.0f, 2.0f, 0.5f, 100.0f, -100.0f, 1000.0f };
+    for( int i = 0; i < ( int )( sizeof( xs ) / sizeof( xs[0] ) ); i++ ) {
+        for( int j = 0; j < ( int )( sizeof( ys ) / sizeof( ys[0] ) ); j++ ) {
+            in[2 * n] = xs[i];
+            in[2 * n + 1] = ys[j];
+            n++;
+        }
+    }
+    return n;
+}
+
+// пары ( y, x ) для atan2: точки окружностей разного радиуса и оси
+static int AccGenAtan2( float* in, int cap, int adversarial ) {
+    int n = 0;
+    if( !adversarial ) {
+        for( int i = 0; i < cap; i++ ) {
+            double a = 2.0 * M_PI * ( i % 1024 ) / 1024.0;
+            double r = exp2( -20.0 + 40.0 * ( i / 1024 ) / ( cap / 1024 - 1 ) );
+            in[2 * i] = ( float )( r * sin( a ) );
+            in[2 * i + 1] = ( float )( r * cos( a ) );
+        }
+        return cap;
+    }
+    const float pts[][2] = { { 0.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, -1.0f }, { -1.0f, 0.0f },
+                             { 1e-30f, 1.0f }, { 1.0f, 1e-30f }, { -1e-30f, -1.0f }, { 1e-30f, -1.0f },
+                             { 1.0f, 1.0f }, { -1.0f, -1.0f }, { 1e30f, 1e-30f }, { 1e-30f, 1e30f } };
+    for( int i = 0; i < ( int )( sizeof( pts ) / sizeof( pts[0] ) ); i++ ) {
+        in[2 * n] = pts[i][0];
+        in[2 * n + 1] = pts[i][1];
+        n++;
+    }
+    return n;
+}
+
+// векторы длиной от 2^-20 до 2^20; неудобные - почти осевые и крайние масштабы
+static int AccGenVec3( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        for( int i = 0; i < cap; i++ ) {
+            float s = ( float )exp2( -20.0 + 40.0 * i / ( cap - 1 ) );
+            for( int k = 0; k < 3; k++ ) {
+                in[3 * i + k] = AccRand() * s;
+            }
+        }
+        return cap;
+    }
+    int n = 0;
+    const float scales[] = { 1e-18f, 1e-6f, 1.0f, 1e6f, 1e18f };
+    const float dirs[][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 1, 1e-4f, 0 }, { 1e-4f, 1e-4f, 1 },
+                              { 1, 1, 1 }, { -1, 1e-7f, 1e-7f }, { 3, 4, 12 } };
+    for( int i = 0; i < ( int )( sizeof( scales ) / sizeof( scales[0] ) ); i++ ) {
+        for( int j = 0; j < ( int )( sizeof( dirs ) / sizeof( dirs[0] ) ); j++ ) {
+            for( int k = 0; k < 3; k++ ) {
+                in[3 * n + k] = dirs[j][k] * scales[i];
+            }
+            n++;
+        }
+    }
+    return n;
+}
+
+/*
+AccGenMat
+
+Случайные матрицы dim x dim: плотный набор - с преобладающей диагональю,
+неудобный - строки разной длины и масштабы 1e-6 .. 1e6, при которых
+определитель и произведения элементов ещё представимы во float.
+При sym матрицы симметричные.
+*/
+static int AccGenMat( float* in, int cap, int adversarial, int dim, int sym ) {
+    int size = dim * dim;
+    int count = adversarial ? 256 : cap;
+    for( int i = 0; i < count; i++ ) {
+        float* m = in + i * size;
+        float scale = adversarial ? ( float )pow( 10.0, -6.0 + 12.0 * ( i % 5 ) / 4.0 ) : 1.0f;
+        for( int r = 0; r < dim; r++ ) {
+            for( int c = 0; c < dim; c++ ) {
+                m[r * dim + c] = AccRand();
+            }
+            if( adversarial ) {
+                // строки с сильно разной длиной
+                for( int c = 0; c < dim; c++ ) {
+                    m[r * dim + c] *= ( float )pow( 10.0, -1.5 * r / ( dim - 1 ) );
+                }
+            }
+            else {
+                m[r * dim + r] += dim;
+            }
+        }
+        if( sym ) {
+            for( int r = 0; r < dim; r++ ) {
+                for( int c = 0; c < r; c++ ) {
+                    m[r * dim + c] = m[c * dim + r];
+                }
+            }
+        }
+        for( int k = 0; k < size; k++ ) {
+            m[k] *= scale;
+        }
+    }
+    return count;
+}
+
+static int AccGenMat3( float* in, int cap, int adversarial ) {
+    return AccGenMat( in, cap, adversarial, 3, 0 );
+}
+
+static int AccGenSym3( float* in, int cap, int adversarial ) {
+    return AccGenMat( in, cap, adversarial, 3, 1 );
+}
+
+static int AccGenMat4( float* in, int cap, int adversarial ) {
+    return AccGenMat( in, cap, adversarial, 4, 0 );
+}
+
+// две матрицы подряд
+static int AccGenMat4Pair( float* in, int cap, int adversarial ) {
+    static float tmp[ACC_COUNT * 16];
+    int n = AccGenMat( tmp, cap * 2 < ACC_COUNT ? cap * 2 : ACC_COUNT, adversarial, 4, 0 ) / 2;
+    memcpy( in, tmp, ( size_t )n * 32 * sizeof( float ) );
+    return n;
+}
+
+/* варианты скалярных функций */
+
+#define ACC_UNARY( name, expr ) \
+    static void AccRun_##name( float* out, const float* in, int count ) { \
+        for( int i = 0; i < count; i++ ) { \
+            float x = in[i]; \
+            out[i] = ( expr ); \
+        } \
+    }
+
+#define ACC_BINARY( name, expr ) \
+    static void AccRun_##name( float* out, const float* in, int count ) { \
+        for( int i = 0; i < count; i++ ) { \
+            float x = in[2 * i]; \
+            float y = in[2 * i + 1]; \
+            out[i] = ( expr ); \
+        } \
+    }
+
+#define ACC_REF_UNARY( name, expr ) \
+    static void AccRef_##name( double* out, const float* in, int count ) { \
+        for( int i = 0; i < count; i++ ) { \
+            double x = in[i]; \
+            out[i] = ( expr ); \
+        } \
+    }
+
+#define ACC_REF_BINARY( name, expr ) \
+    static void AccRef_##name( double* out, const float* in, int count ) { \
+        for( int i = 0; i < count; i++ ) { \
+            double x = in[2 * i]; \
+            double y = in[2 * i + 1]; \
+            out[i] = ( expr ); \
+        } \
+    }
+
+ACC_UNARY( isqrt1f, isqrt1f( x ) )
+ACC_UNARY( rsqrtf, 1.0f / sqrtf( x ) )
+ACC_UNARY( sqrt1f, sqrt1f( x ) )
+ACC_UNARY( sqrtf, sqrtf( x ) )
+ACC_UNARY( sin1f, sin1f( x ) )
+ACC_UNARY( cos1f, cos1f( x ) )
+ACC_UNARY( tan1f, tan1f( x ) )
+ACC_UNARY( asin1f, asin1f( x ) )
+ACC_UNARY( acos1f, acos1f( x ) )
+ACC_UNARY( atan1f, atan1f( x ) )
+ACC_UNARY( exp1f, exp1f( x ) )
+ACC_UNARY( expf, expf( x ) )
+ACC_UNARY( log1f, log1f( x ) )
+ACC_BINARY( pow2f, pow2f( x, y ) )
+ACC_BINARY( atan2f, atan2f( x, y ) )
+
+ACC_REF_UNARY( rsqrt, 1.0 / sqrt( x ) )
+ACC_REF_UNARY( sqrt, sqrt( x ) )
+ACC_REF_UNARY( sin, sin( x ) )
+ACC_REF_UNARY( cos, cos( x ) )
+ACC_REF_UNARY( tan, tan( x ) )
+ACC_REF_UNARY( asin, asin( x ) )
+ACC_REF_UNARY( acos, acos( x ) )
+ACC_REF_UNARY( atan, atan( x ) )
+ACC_REF_UNARY( exp, exp( x ) )
+ACC_REF_UNARY( log, log( x ) )
+ACC_REF_BINARY( pow, pow( x, y ) )
+ACC_REF_BINARY( atan2, atan2( x, y ) )
+
+// LaneRsqrt по LANE_WIDTH чисел: rsqrt с одним шагом Ньютона
+static void AccRun_LaneRsqrt( float* out, const float* in, int count ) {
+    int i = 0;
+    for( ; i + LANE_WIDTH <= count; i += LANE_WIDTH ) {
+        LaneStore( out + i, LaneRsqrt( LaneLoad( in + i ) ) );
+    }
+    for( ; i < count; i++ ) {
+        float buf[LANE_WIDTH];
+        LaneStore( buf, LaneRsqrt( LaneSet1( in[i] ) ) );
+        out[i] = buf[0];
+    }
+}
+
+/* векторы */
+
+static void AccRun_Vec3Norm( float* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        vec3_t v;
+        Vec3Set( &v, in[3 * i], in[3 * i + 1], in[3 * i + 2] );
+        Vec3Norm( &v );
+        memcpy( out + 3 * i, v.m, 3 * sizeof( float ) );
+    }
+}
+
+static void AccRun_Vec3NormVal( float* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        vec3_t v = Vec3NormVal( Vec3Make( in[3 * i], in[3 * i + 1], in[3 * i + 2] ) );
+        memcpy( out + 3 * i, v.m, 3 * sizeof( float ) );
+    }
+}
+
+static void AccRef_Norm3( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* v = in + 3 * i;
+        double len = sqrt( ( double )v[0] * v[0] + ( double )v[1] * v[1] + ( double )v[2] * v[2] );
+        for( int k = 0; k < 3; k++ ) {
+            out[3 * i + k] = v[k] / len;
+        }
+    }
+}
+
+static void AccRun_Vec3Len( float* out, const float* in, int count ) {
+    vec3_t zero;
+    Vec3Zero( &zero );
+    for( int i = 0; i < count; i++ ) {
+        vec3_t v;
+        Vec3Set( &v, in[3 * i], in[3 * i + 1], in[3 * i + 2] );
+        out[i] = Vec3Len( &v, &zero );
+    }
+}
+
+static void AccRun_Vec3SqrLen( float* out, const float* in, int count ) {
+    vec3_t zero;
+    Vec3Zero( &zero );
+    for( int i = 0; i < count; i++ ) {
+        vec3_t v;
+        Vec3Set( &v, in[3 * i], in[3 * i + 1], in[3 * i + 2] );
+        out[i] = Vec3SqrLen( &v, &zero );
+    }
+}
+
+static void AccRef_Len3( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* v = in + 3 * i;
+        out[i] = sqrt( ( double )v[0] * v[0] + ( double )v[1] * v[1] + ( double )v[2] * v[2] );
+    }
+}
+
+static void AccRef_SqrLen3( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* v = in + 3 * i;
+        out[i] = ( double )v[0] * v[0] + ( double )v[1] * v[1] + ( double )v[2] * v[2];
+    }
+}
+
+/* матрицы 4-го порядка */
+
+static void AccRun_Mat4InvTo( float* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        mat4_t m, r;
+        memcpy( m.m, in + 16 * i, sizeof( m.m ) );
+        if( !Mat4InvTo( &r, &m ) ) {
+            Mat4Zero( &r );
+        }
+        memcpy( out + 16 * i, r.m, sizeof( r.m ) );
+    }
+}
+
+static void AccRun_Mat4LuSolve( float* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        mat4_t m;
+        lu4_t lu;
+        memcpy( m.m, in + 16 * i, sizeof( m.m ) );
+        if( !Lu4Factor( &lu, &m ) ) {
+            memset( out + 16 * i, 0, 16 * sizeof( float ) );
+            continue;
+        }
+        // столбцы обратной матрицы - решения для столбцов единичной
+        for( int c = 0; c < 4; c++ ) {
+            vec4_t e, x;
+            Vec4Set( &e, c == 0, c == 1, c == 2, c == 3 );
+            Lu4Solve( &x, &lu, &e );
+            for( int r = 0; r < 4; r++ ) {
+                out[16 * i + r * 4 + c] = x.m[r];
+            }
+        }
+    }
+}
+
+// обращение методом Гаусса-Жордана с выбором главного элемента в double
+static void AccRef_Inv4( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        double a[4][8];
+        for( int r = 0; r < 4; r++ ) {
+            for( int c = 0; c < 4; c++ ) {
+                a[r][c] = in[16 * i + r * 4 + c];
+                a[r][c + 4] = r == c;
+            }
+        }
+        for( int c = 0; c < 4; c++ ) {
+            int p = c;
+            for( int r = c + 1; r < 4; r++ ) {
+                if( fabs( a[r][c] ) > fabs( a[p][c] ) ) {
+                    p = r;
+                }
+            }
+            for( int k = 0; k < 8; k++ ) {
+                double t = a[c][k];
+                a[c][k] = a[p][k];
+                a[p][k] = t;
+            }
+            double d = 1.0 / a[c][c];
+            for( int k = 0; k < 8; k++ ) {
+                a[c][k] *= d;
+            }
+            for( int r = 0; r < 4; r++ ) {
+                if( r != c ) {
+                    double f = a[r][c];
+                    for( int k = 0; k < 8; k++ ) {
+                        a[r][k] -= f * a[c][k];
+                    }
+                }
+            }
+        }
+        for( int r = 0; r < 4; r++ ) {
+            for( int c = 0; c < 4; c++ ) {
+                out[16 * i + r * 4 + c] = a[r][c + 4];
+            }
+        }
+    }
+}
+
+static void AccRun_Mat4Mul( float* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        mat4_t a, b, r;
+        memcpy( a.m, in + 32 * i, sizeof( a.m ) );
+        memcpy( b.m, in + 32 * i + 16, sizeof( b.m ) );
+        Mat4Mul( &r, &a, &b );
+        memcpy( out + 16 * i, r.m, sizeof( r.m ) );
+    }
+}
+
+static void AccRun_Mat4MulR( float* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        mat4_t a, b, r;
+        memcpy( a.m, in + 32 * i, sizeof( a.m ) );
+        memcpy( b.m, in + 32 * i + 16, sizeof( b.m ) );
+        Mat4MulR( &r, &a, &b );
+        memcpy( out + 16 * i, r.m, sizeof( r.m ) );
+    }
+}
+
+static void AccRef_Mul4( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* a = in + 32 * i;
+        const float* b = a + 16;
+        for( int r = 0; r < 4; r++ ) {
+            for( int c = 0; c < 4; c++ ) {
+                double s = 0.0;
+                for( int k = 0; k < 4; k++ ) {
+                    s += ( double )a[r * 4 + k] * b[k * 4 + c];
+                }
+                out[16 * i + r * 4 + c] = s;
+            }
+        }
+    }
+}
+
+/* разложения матриц 3-го порядка */
+
+/*
+AccJacobi3
+
+Собственные значения симметричной матрицы a методом Якоби в double по убыванию.
+*/
+static void AccJacobi3( double* val, double a[3][3] ) {
+    for( int sweep = 0; sweep < 50; sweep++ ) {
+        double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        if( off < 1e-300 ) {
+            break;
+        }
+        for( int p = 0; p < 2; p++ ) {
+            for( int q = p + 1; q < 3; q++ ) {
+                if( a[p][q] == 0.0 ) {
+                    continue;
+                }
+                double theta = ( a[q][q] - a[p][p] ) / ( 2.0 * a[p][q] );
+                double t = ( theta >= 0.0 ? 1.0 : -1.0 ) / ( fabs( theta ) + sqrt( theta * theta + 1.0 ) );
+                double c = 1.0 / sqrt( t * t + 1.0 );
+                double s = t * c;
+                for( int k = 0; k < 3; k++ ) {
+                    double akp = a[k][p];
+                    double akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for( int k = 0; k < 3; k++ ) {
+                    double apk = a[p][k];
+                    double aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+            }
+        }
+    }
+    for( int k = 0; k < 3; k++ ) {
+        val[k] = a[k][k];
+    }
+    for( int i = 0; i < 2; i++ ) {
+        for( int j = i + 1; j < 3; j++ ) {
+            if( val[j] > val[i] ) {
+                double t = val[i];
+                val[i] = val[j];
+                val[j] = t;
+            }
+        }
+    }
+}
+
+static void AccRef_SymEigen3( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        double a[3][3];
+        for( int k = 0; k < 9; k++ ) {
+            a[k / 3][k % 3] = in[9 * i + k];
+        }
+        AccJacobi3( out + 3 * i, a );
+    }
+}
+
+// сингулярные числа - корни собственных значений A^T * A
+static void AccRef_Sigma3( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* m = in + 9 * i;
+        double a[3][3];
+        for( int r = 0; r < 3; r++ ) {
+            for( int c = 0; c < 3; c++ ) {
+                double s = 0.0;
+                for( int k = 0; k < 3; k++ ) {
+                    s += ( double )m[k * 3 + r] * m[k * 3 + c];
+                }
+                a[r][c] = s;
+            }
+        }
+        AccJacobi3( out + 3 * i, a );
+        for( int k = 0; k < 3; k++ ) {
+            out[3 * i + k] = sqrt( out[3 * i + k] > 0.0 ? out[3 * i + k] : 0.0 );
+        }
+    }
+}
+
+static void AccSigmaOut( float* out, const vec3_t* s ) {
+    out[0] = s->x;
+    out[1] = s->y;
+    out[2] = fabsf( s->z );
+}
+
+static void AccRun_Mat3Svd( float* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        mat3_t m;
+        svd3_t d;
+        memcpy( m.m, in + 9 * i, sizeof( m.m ) );
+        Mat3Svd( &d, &m );
+        AccSigmaOut( out + 3 * i, &d.s );
+    }
+}
+
+static void AccRun_Mat3SvdArray( float* out, const float* in, int count ) {
+    static svd3_t d[ACC_COUNT];
+    static mat3_t m[ACC_COUNT];
+    memcpy( m, in, ( size_t )count * sizeof( mat3_t ) );
+    Mat3SvdArray( d, m, count );
+    for( int i = 0; i < count; i++ ) {
+        AccSigmaOut( out + 3 * i, &d[i].s );
+    }
+}
+
+static void AccRun_Mat3SymEigen( float* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        mat3_t m;
+        eigen3_t e;
+        memcpy( m.m, in + 9 * i, sizeof( m.m ) );
+        Mat3SymEigen( &e, &m );
+        memcpy( out + 3 * i, e.values.m, 3 * sizeof( float ) );
+    }
+}
+
+static void AccRun_Mat3SymEigenArray( float* out, const float* in, int count ) {
+    static eigen3_t e[ACC_COUNT];
+    static mat3_t m[ACC_COUNT];
+    memcpy( m, in, ( size_t )count * sizeof( mat3_t ) );
+    Mat3SymEigenArray( e, m, count );
+    for( int i = 0; i < count; i++ ) {
+        memcpy( out + 3 * i, e[i].values.m, 3 * sizeof( float ) );
+    }
+}
+
+/* решение систем */
+
+#define ACC_SOLVE_BLOCK 64      // правых частей на одну матрицу
+
+/*
+AccGenSolve
+
+Системы dim x dim: каждые ACC_SOLVE_BLOCK элементов - одна матрица из
+AccGenMat и разные правые части. Элемент - матрица, за ней правая часть.
+В неудобном наборе каждая восьмая матрица - поворот с переносом
+до 1e7 (мировое преобразование), следующая за ней - диагональная
+с элементами от 1e-7 до 1e7: обе хорошо решаются и не должны
+считаться вырожденными.
+*/
+static int AccGenSolve( float* in, int cap, int adversarial, int dim ) {
+    static float tmp[ACC_COUNT / ACC_SOLVE_BLOCK * 16];
+    int stride = dim * dim + dim;
+    int num_mats = AccGenMat( tmp, cap / ACC_SOLVE_BLOCK, adversarial, dim, 0 );
+    for( int j = 0; adversarial && ( j < num_mats ); j++ ) {
+        float* m = tmp + j * dim * dim;
+        if( j % 8 == 6 ) {
+            // поворот вокруг последней оси 3x3 части, перенос в последнем столбце
+            float c = cosf( ( float )j ), s = sinf( ( float )j );
+            memset( m, 0, dim * dim * sizeof( float ) );
+            for( int r = 0; r < dim; r++ ) {
+                m[r * dim + r] = 1.0f;
+            }
+            m[0] = c;
+            m[1] = -s;
+            m[dim] = s;
+            m[dim + 1] = c;
+            for( int r = 0; r < dim - 1; r++ ) {
+                m[r * dim + dim - 1] = AccRand() * ( float )pow( 10.0, 3 + ( j / 8 ) % 5 );
+            }
+        }
+        else if( j % 8 == 7 ) {
+            memset( m, 0, dim * dim * sizeof( float ) );
+            for( int r = 0; r < dim; r++ ) {
+                m[r * dim + r] = ( float )pow( 10.0, ( ( j / 8 + r ) % 3 - 1 ) * 7.0 );
+            }
+        }
+    }
+    int n = 0;
+    for( int j = 0; j < num_mats; j++ ) {
+        for( int k = 0; k < ACC_SOLVE_BLOCK; k++, n++ ) {
+            float* e = in + n * stride;
+            float scale = adversarial ? ( float )pow( 10.0, -6.0 + 12.0 * ( k % 5 ) / 4.0 ) : 1.0f;
+            memcpy( e, tmp + j * dim * dim, dim * dim * sizeof( float ) );
+            for( int r = 0; r < dim; r++ ) {
+                e[dim * dim + r] = AccRand() * scale;
+            }
+        }
+    }
+    return n;
+}
+
+static int AccGenSolve3( float* in, int cap, int adversarial ) {
+    return AccGenSolve( in, cap, adversarial, 3 );
+}
+
+static int AccGenSolve4( float* in, int cap, int adversarial ) {
+    return AccGenSolve( in, cap, adversarial, 4 );
+}
+
+/*
+AccSolve3
+
+Решения систем, собранных AccGenSolve3: mode 0 - Lu3Solve для каждой
+правой части, 1 - Lu3SolveArray на блок, 2 - Mat3SolveArray, которая
+разлагает матрицу каждой системы заново.
+Для вырожденных матриц записываются нули.
+*/
+static void AccSolve3( float* out, const float* in, int count, int mode ) {
+    for( int i = 0; i < count; i += ACC_SOLVE_BLOCK ) {
+        int num = count - i < ACC_SOLVE_BLOCK ? count - i : ACC_SOLVE_BLOCK;
+        vec3_t b[ACC_SOLVE_BLOCK], x[ACC_SOLVE_BLOCK];
+        mat3_t m[ACC_SOLVE_BLOCK];
+        lu3_t lu;
+        mbool_t ok = mtrue;
+        for( int k = 0; k < num; k++ ) {
+            memcpy( m[k].m, in + 12 * ( i + k ), sizeof( m[k].m ) );
+            memcpy( b[k].m, in + 12 * ( i + k ) + 9, sizeof( b[k].m ) );
+        }
+        if( mode == 2 ) {
+            // вырожденные системы Mat3SolveArray обнуляет сама
+            Mat3SolveArray( x, m, b, num );
+        }
+        else if( !Lu3Factor( &lu, &m[0] ) ) {
+            ok = mfalse;
+        }
+        else if( mode == 1 ) {
+            Lu3SolveArray( x, &lu, b, num );
+        }
+        else {
+            for( int k = 0; k < num; k++ ) {
+                Lu3Solve( &x[k], &lu, &b[k] );
+            }
+        }
+        for( int k = 0; k < num; k++ ) {
+            if( ok ) {
+                memcpy( out + 3 * ( i + k ), x[k].m, sizeof( x[k].m ) );
+            }
+            else {
+                memset( out + 3 * ( i + k ), 0, sizeof( x[k].m ) );
+            }
+        }
+    }
+}
+
+static void AccSolve4( float* out, const float* in, int count, int mode ) {
+    for( int i = 0; i < count; i += ACC_SOLVE_BLOCK ) {
+        int num = count - i < ACC_SOLVE_BLOCK ? count - i : ACC_SOLVE_BLOCK;
+        vec4_t b[ACC_SOLVE_BLOCK], x[ACC_SOLVE_BLOCK];
+        mat4_t m[ACC_SOLVE_BLOCK];
+        lu4_t lu;
+        mbool_t ok = mtrue;
+        for( int k = 0; k < num; k++ ) {
+            memcpy( m[k].m, in + 20 * ( i + k ), sizeof( m[k].m ) );
+            memcpy( b[k].m, in + 20 * ( i + k ) + 16, sizeof( b[k].m ) );
+        }
+        if( mode == 2 ) {
+            // вырожденные системы Mat4SolveArray обнуляет сама
+            Mat4SolveArray( x, m, b, num );
+        }
+        else if( !Lu4Factor( &lu, &m[0] ) ) {
+            ok = mfalse;
+        }
+        else if( mode == 1 ) {
+            Lu4SolveArray( x, &lu, b, num );
+        }
+        else {
+            for( int k = 0; k < num; k++ ) {
+                Lu4Solve( &x[k], &lu, &b[k] );
+            }
+        }
+        for( int k = 0; k < num; k++ ) {
+            if( ok ) {
+                memcpy( out + 4 * ( i + k ), x[k].m, sizeof( x[k].m ) );
+            }
+            else {
+                memset( out + 4 * ( i + k ), 0, sizeof( x[k].m ) );
+            }
+        }
+    }
+}
+
+static void AccRun_Lu3Solve( float* out, const float* in, int count ) {
+    AccSolve3( out, in, count, 0 );
+}
+
+static void AccRun_Lu3SolveArray( float* out, const float* in, int count ) {
+    AccSolve3( out, in, count, 1 );
+}
+
+static void AccRun_Mat3SolveArray( float* out, const float* in, int count ) {
+    AccSolve3( out, in, count, 2 );
+}
+
+static void AccRun_Lu4Solve( float* out, const float* in, int count ) {
+    AccSolve4( out, in, count, 0 );
+}
+
+static void AccRun_Lu4SolveArray( float* out, const float* in, int count ) {
+    AccSolve4( out, in, count, 1 );
+}
+
+static void AccRun_Mat4SolveArray( float* out, const float* in, int count ) {
+    AccSolve4( out, in, count, 2 );
+}
+
+// метод Гаусса с выбором главного элемента в double
+static void AccRef_Solve( double* out, const float* in, int count, int dim ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* e = in + i * ( dim * dim + dim );
+        double a[4][5];
+        for( int r = 0; r < dim; r++ ) {
+            for( int c = 0; c < dim; c++ ) {
+                a[r][c] = e[r * dim + c];
+            }
+            a[r][dim] = e[dim * dim + r];
+        }
+        for( int c = 0; c < dim; c++ ) {
+            int p = c;
+            for( int r = c + 1; r < dim; r++ ) {
+                if( fabs( a[r][c] ) > fabs( a[p][c] ) ) {
+                    p = r;
+                }
+            }
+            for( int k = 0; k <= dim; k++ ) {
+                double t = a[c][k];
+                a[c][k] = a[p][k];
+                a[p][k] = t;
+            }
+            for( int r = c + 1; r < dim; r++ ) {
+                double f = a[r][c] / a[c][c];
+                for( int k = c; k <= dim; k++ ) {
+                    a[r][k] -= f * a[c][k];
+                }
+            }
+        }
+        for( int r = dim - 1; r >= 0; r-- ) {
+            double s = a[r][dim];
+            for( int k = r + 1; k < dim; k++ ) {
+                s -= a[r][k] * out[i * dim + k];
+            }
+            out[i * dim + r] = s / a[r][r];
+        }
+    }
+}
+
+static void AccRef_Solve3( double* out, const float* in, int count ) {
+    AccRef_Solve( out, in, count, 3 );
+}
+
+static void AccRef_Solve4( double* out, const float* in, int count ) {
+    AccRef_Solve( out, in, count, 4 );
+}
+
+/* ковариация */
+
+#define ACC_COV_POINTS  8       // точек в облаке
+
+/*
+AccGenCloud
+
+Облака из ACC_COV_POINTS точек: плотный набор - в единичном кубе,
+неудобный - малые облака далеко от начала координат, вытянутые
+вдоль оси и вырожденные (все точки совпадают).
+*/
+static int AccGenCloud( float* in, int cap, int adversarial ) {
+    int stride = 3 * ACC_COV_POINTS;
+    if( !adversarial ) {
+        for( int i = 0; i < cap * stride; i++ ) {
+            in[i] = AccRand();
+        }
+        return cap;
+    }
+    int n = 0;
+    for( int e = 0; e <= 6; e++ ) {
+        for( int s = 0; s <= 4; s++ ) {
+            for( int shape = 0; shape < 3; shape++, n++ ) {
+                float offset = ( float )pow( 10.0, e );
+                float spread = shape == 2 ? 0.0f : ( float )pow( 10.0, -s );
+                for( int p = 0; p < ACC_COV_POINTS; p++ ) {
+                    float t = AccRand();
+                    for( int k = 0; k < 3; k++ ) {
+                        // shape 1 - точки почти на одной прямой
+                        float d = shape == 1 ? t + AccRand() * 1e-3f : AccRand();
+                        in[n * stride + 3 * p + k] = offset * ( k == 0 ? 1.0f : -0.5f ) + d * spread;
+                    }
+                }
+            }
+        }
+    }
+    return n;
+}
+
+static void AccRun_Mat3Covariance( float* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        vec3_t p[ACC_COV_POINTS];
+        mat3_t cov;
+        memcpy( p, in + i * 3 * ACC_COV_POINTS, sizeof( p ) );
+        Mat3Covariance( &cov, NULL, p, ACC_COV_POINTS );
+        const float v[6] = { cov.m[0], cov.m[1], cov.m[2], cov.m[4], cov.m[5], cov.m[8] };
+        memcpy( out + 6 * i, v, sizeof( v ) );
+    }
+}
+
+// ковариация в два прохода: сначала центр, затем суммы отклонений
+static void AccRef_Covariance( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* p = in + i * 3 * ACC_COV_POINTS;
+        double mean[3] = { 0.0, 0.0, 0.0 };
+        for( int j = 0; j < ACC_COV_POINTS; j++ ) {
+            for( int k = 0; k < 3; k++ ) {
+                mean[k] += p[3 * j + k];
+            }
+        }
+        for( int k = 0; k < 3; k++ ) {
+            mean[k] /= ACC_COV_POINTS;
+        }
+        const int rows[6] = { 0, 0, 0, 1, 1, 2 };
+        const int cols[6] = { 0, 1, 2, 1, 2, 2 };
+        for( int c = 0; c < 6; c++ ) {
+            double s = 0.0;
+            for( int j = 0; j < ACC_COV_POINTS; j++ ) {
+                s += ( p[3 * j + rows[c]] - mean[rows[c]] ) * ( p[3 * j + cols[c]] - mean[cols[c]] );
+            }
+            out[6 * i + c] = s / ACC_COV_POINTS;
+        }
+    }
+}
+
+/* камера */
+
+/*
+AccGenPersp
+
+Параметры перспективы ( fovy, aspect, znear, zfar, flags ).
+Неудобные - почти нулевой и почти развёрнутый угол обзора, крайние
+пропорции, zfar на ulp дальше znear и очень далёкая дальняя плоскость.
+*/
+static int AccGenPersp( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        for( int i = 0; i < cap; i++ ) {
+            float* p = in + 5 * i;
+            p[0] = 0.1f + 1.45f * ( AccRand() + 1.0f );
+            p[1] = ( float )exp2( 2.0 * AccRand() );
+            p[2] = ( float )exp2( -10.0 + 7.0 * ( AccRand() + 1.0f ) );
+            p[3] = p[2] * ( float )exp2( 10.5 + 9.5 * AccRand() );
+            p[4] = ( float )( i & 3 );
+        }
+        return cap;
+    }
+    const float fovy[] = { 1e-3f, 0.5f, 1.5707964f, 3.0f, 3.14f };
+    const float aspect[] = { 1e-2f, 1.0f, 1e2f };
+    const float znear[] = { 1e-4f, 1.0f, 1e4f };
+    const float ratio[] = { 0.0f, 2.0f, 1e3f, 1e6f };
+    int n = 0;
+    for( int a = 0; a < 5; a++ ) {
+        for( int b = 0; b < 3; b++ ) {
+            for( int c = 0; c < 3; c++ ) {
+                for( int d = 0; d < 4; d++ ) {
+                    for( int flags = 0; flags < 4; flags++, n++ ) {
+                        float* p = in + 5 * n;
+                        p[0] = fovy[a];
+                        p[1] = aspect[b];
+                        p[2] = znear[c];
+                        p[3] = ratio[d] == 0.0f ? nextafterf( znear[c], FLT_MAX ) : znear[c] * ratio[d];
+                        p[4] = ( float )flags;
+                    }
+                }
+            }
+        }
+    }
+    return n;
+}
+
+static void AccRun_CameraPersp( float* out, const float* in, int count, int inverse ) {
+    static perspective_t p[ACC_COUNT];
+    static mat4_t proj[ACC_COUNT];
+    static mat4_t inv[ACC_COUNT];
+    for( int i = 0; i < count; i++ ) {
+        p[i].fovy = in[5 * i];
+        p[i].aspect = in[5 * i + 1];
+        p[i].znear = in[5 * i + 2];
+        p[i].zfar = in[5 * i + 3];
+        p[i].flags = ( int )in[5 * i + 4];
+    }
+    CameraPerspectiveArray( proj, inv, p, count );
+    memcpy( out, inverse ? inv : proj, ( size_t )count * sizeof( mat4_t ) );
+}
+
+static void AccRun_CameraPerspectiveArray( float* out, const float* in, int count ) {
+    AccRun_CameraPersp( out, in, count, 0 );
+}
+
+static void AccRun_CameraPerspectiveArrayInv( float* out, const float* in, int count ) {
+    AccRun_CameraPersp( out, in, count, 1 );
+}
+
+static void AccRef_Persp( double* out, const float* in, int count, int inverse ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* p = in + 5 * i;
+        int flags = ( int )p[4];
+        double sy = 1.0 / tan( p[0] * 0.5 );
+        double sx = sy / p[1];
+        double zn = p[2];
+        double zf = p[3];
+        double a, b;
+        if( flags & CAMERA_INFINITE_FAR ) {
+            a = ( flags & CAMERA_REVERSED_Z ) ? 0.0 : -1.0;
+            b = ( flags & CAMERA_REVERSED_Z ) ? zn : -zn;
+        }
+        else if( flags & CAMERA_REVERSED_Z ) {
+            a = zn / ( zf - zn );
+            b = zn * zf / ( zf - zn );
+        }
+        else {
+            a = zf / ( zn - zf );
+            b = zn * zf / ( zn - zf );
+        }
+        double* m = out + 16 * i;
+        memset( m, 0, 16 * sizeof( double ) );
+        if( inverse ) {
+            m[0] = 1.0 / sx;
+            m[5] = 1.0 / sy;
+            m[11] = -1.0;
+            m[14] = 1.0 / b;
+            m[15] = a / b;
+        }
+        else {
+            m[0] = sx;
+            m[5] = sy;
+            m[10] = a;
+            m[11] = b;
+            m[14] = -1.0;
+        }
+    }
+}
+
+static void AccRef_Perspective( double* out, const float* in, int count ) {
+    AccRef_Persp( out, in, count, 0 );
+}
+
+static void AccRef_PerspectiveInv( double* out, const float* in, int count ) {
+    AccRef_Persp( out, in, count, 1 );
+}
+
+/*
+AccGenOrtho
+
+Параметры ( left, right, bottom, top, znear, zfar, flags ). Неудобные -
+узкие объёмы далеко от оси, когда сдвиг много больше масштаба.
+*/
+static int AccGenOrtho( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        for( int i = 0; i < cap; i++ ) {
+            float* p = in + 7 * i;
+            for( int k = 0; k < 6; k += 2 ) {
+                p[k] = AccRand() * 100.0f;
+                p[k + 1] = p[k] + ( float )exp2( 2.0 + 6.0 * AccRand() );
+            }
+            p[6] = ( float )( i & 1 );
+        }
+        return cap;
+    }
+    const float center[] = { 0.0f, 1.0f, -1e3f, 1e4f };
+    const float size[] = { 1e-3f, 1.0f, 1e3f };
+    int n = 0;
+    for( int a = 0; a < 4; a++ ) {
+        for( int b = 0; b < 3; b++ ) {
+            for( int c = 0; c < 3; c++ ) {
+                for( int flags = 0; flags < 2; flags++, n++ ) {
+                    float* p = in + 7 * n;
+                    p[0] = center[a] - size[b];
+                    p[1] = center[a] + size[b];
+                    p[2] = -center[a] - size[c];
+                    p[3] = -center[a] + size[c];
+                    p[4] = center[a];
+                    p[5] = center[a] + size[( b + c ) % 3];
+                    p[6] = ( float )flags;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+static void AccRun_CameraOrthoAny( float* out, const float* in, int count, int inverse ) {
+    static ortho_t p[ACC_COUNT];
+    static mat4_t proj[ACC_COUNT];
+    static mat4_t inv[ACC_COUNT];
+    for( int i = 0; i < count; i++ ) {
+        p[i].left = in[7 * i];
+        p[i].right = in[7 * i + 1];
+        p[i].bottom = in[7 * i + 2];
+        p[i].top = in[7 * i + 3];
+        p[i].znear = in[7 * i + 4];
+        p[i].zfar = in[7 * i + 5];
+        p[i].flags = ( int )in[7 * i + 6];
+    }
+    CameraOrthoArray( proj, inv, p, count );
+    memcpy( out, inverse ? inv : proj, ( size_t )count * sizeof( mat4_t ) );
+}
+
+static void AccRun_CameraOrthoArray( float* out, const float* in, int count ) {
+    AccRun_CameraOrthoAny( out, in, count, 0 );
+}
+
+static void AccRun_CameraOrthoArrayInv( float* out, const float* in, int count ) {
+    AccRun_CameraOrthoAny( out, in, count, 1 );
+}
+
+static void AccRef_OrthoAny( double* out, const float* in, int count, int inverse ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* p = in + 7 * i;
+        double w = ( double )p[1] - p[0];
+        double h = ( double )p[3] - p[2];
+        double d = ( double )p[5] - p[4];
+        double* m = out + 16 * i;
+        memset( m, 0, 16 * sizeof( double ) );
+        m[15] = 1.0;
+        if( inverse ) {
+            m[0] = w * 0.5;
+            m[3] = ( ( double )p[1] + p[0] ) * 0.5;
+            m[5] = h * 0.5;
+            m[7] = ( ( double )p[3] + p[2] ) * 0.5;
+            m[10] = ( ( int )p[6] & CAMERA_REVERSED_Z ) ? d : -d;
+            m[11] = ( ( int )p[6] & CAMERA_REVERSED_Z ) ? -( double )p[5] : -( double )p[4];
+        }
+        else {
+            m[0] = 2.0 / w;
+            m[3] = -( ( double )p[1] + p[0] ) / w;
+            m[5] = 2.0 / h;
+            m[7] = -( ( double )p[3] + p[2] ) / h;
+            m[10] = ( ( int )p[6] & CAMERA_REVERSED_Z ) ? 1.0 / d : -1.0 / d;
+            m[11] = ( ( int )p[6] & CAMERA_REVERSED_Z ) ? p[5] / d : -p[4] / d;
+        }
+    }
+}
+
+static void AccRef_Ortho( double* out, const float* in, int count ) {
+    AccRef_OrthoAny( out, in, count, 0 );
+}
+
+static void AccRef_OrthoInv( double* out, const float* in, int count ) {
+    AccRef_OrthoAny( out, in, count, 1 );
+}
+
+/*
+AccGenLookAt
+
+Параметры ( eye, target, up ). Неудобные - камера далеко от начала
+координат и вектор up, отклонённый от направления взгляда на малый угол.
+*/
+static int AccGenLookAt( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        for( int i = 0; i < cap; i++ ) {
+            for( int k = 0; k < 9; k++ ) {
+                in[9 * i + k] = AccRand() * ( k < 6 ? 100.0f : 1.0f );
+            }
+        }
+        return cap;
+    }
+    const float offset[] = { 0.0f, 1e3f, 1e5f };
+    const float dist[] = { 1e-2f, 1.0f, 1e3f };
+    const float angle[] = { 1e-3f, 1e-2f, 0.5f, 1.5707964f };
+    const float dirs[][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0.6f, 0.0f, 0.8f } };
+    int n = 0;
+    for( int a = 0; a < 3; a++ ) {
+        for( int b = 0; b < 3; b++ ) {
+            for( int c = 0; c < 4; c++ ) {
+                for( int d = 0; d < 4; d++, n++ ) {
+                    float* p = in + 9 * n;
+                    const float* f = dirs[d];
+                    // перпендикуляр к f в плоскости, содержащей ось y или x
+                    float q[3] = { -f[1], f[0], 0.0f };
+                    if( f[0] == 0.0f && f[1] == 0.0f ) {
+                        q[0] = 1.0f;
+                    }
+                    for( int k = 0; k < 3; k++ ) {
+                        p[k] = offset[a];
+                        p[3 + k] = offset[a] + f[k] * dist[b];
+                        p[6 + k] = f[k] * cosf( angle[c] ) + q[k] * sinf( angle[c] );
+                    }
+                }
+            }
+        }
+    }
+    return n;
+}
+
+static void AccRun_CameraLookAtAny( float* out, const float* in, int count, int inverse ) {
+    static lookat_t p[ACC_COUNT];
+    static mat4_t view[ACC_COUNT];
+    static mat4_t inv[ACC_COUNT];
+    for( int i = 0; i < count; i++ ) {
+        memcpy( p[i].eye.m, in + 9 * i, 3 * sizeof( float ) );
+        memcpy( p[i].target.m, in + 9 * i + 3, 3 * sizeof( float ) );
+        memcpy( p[i].up.m, in + 9 * i + 6, 3 * sizeof( float ) );
+    }
+    CameraLookAtArray( view, inv, p, count );
+    memcpy( out, inverse ? inv : view, ( size_t )count * sizeof( mat4_t ) );
+}
+
+static void AccRun_CameraLookAtArray( float* out, const float* in, int count ) {
+    AccRun_CameraLookAtAny( out, in, count, 0 );
+}
+
+static void AccRun_CameraLookAtArrayInv( float* out, const float* in, int count ) {
+    AccRun_CameraLookAtAny( out, in, count, 1 );
+}
+
+static void AccNorm3d( double* v ) {
+    double len = sqrt( v[0] * v[0] + v[1] * v[1] + v[2] * v[2] );
+    for( int k = 0; k < 3; k++ ) {
+        v[k] /= len;
+    }
+}
+
+static void AccCross3d( double* out, const double* a, const double* b ) {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static void AccRef_LookAtAny( double* out, const float* in, int count, int inverse ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* p = in + 9 * i;
+        double e[3], f[3], up[3], s[3], u[3];
+        for( int k = 0; k < 3; k++ ) {
+            e[k] = p[k];
+            f[k] = ( double )p[3 + k] - p[k];
+            up[k] = p[6 + k];
+        }
+        AccNorm3d( f );
+        AccCross3d( s, f, up );
+        AccNorm3d( s );
+        AccCross3d( u, s, f );
+        double* m = out + 16 * i;
+        memset( m, 0, 16 * sizeof( double ) );
+        m[15] = 1.0;
+        for( int k = 0; k < 3; k++ ) {
+            if( inverse ) {
+                m[k * 4] = s[k];
+                m[k * 4 + 1] = u[k];
+                m[k * 4 + 2] = -f[k];
+                m[k * 4 + 3] = e[k];
+            }
+            else {
+                m[k] = s[k];
+                m[4 + k] = u[k];
+                m[8 + k] = -f[k];
+                m[3] -= s[k] * e[k];
+                m[7] -= u[k] * e[k];
+                m[11] += f[k] * e[k];
+            }
+        }
+    }
+}
+
+static void AccRef_LookAt( double* out, const float* in, int count ) {
+    AccRef_LookAtAny( out, in, count, 0 );
+}
+
+static void AccRef_LookAtInv( double* out, const float* in, int count ) {
+    AccRef_LookAtAny( out, in, count, 1 );
+}
+
+/* матрицы нормалей */
+
+/*
+AccGenXform
+
+Преобразования по очереди: аффинные из AccGenMat, равномерный масштаб
+(в неудобном наборе - 2^-60 .. 2^60), поворот вокруг случайной оси
+и проективные. Элемент - 16 чисел матрицы, вид определяет XformFromMat4.
+*/
+static int AccGenXform( float* in, int cap, int adversarial ) {
+    int n = AccGenMat4( in, cap, adversarial );
+    for( int i = 0; i < n; i++ ) {
+        float* m = in + 16 * i;
+        xform_t x;
+        vec3_t axis;
+        switch( i & 3 ) {
+            case 0:
+                m[12] = m[13] = m[14] = 0.0f;
+                m[15] = 1.0f;
+                break;
+
+            case 1:
+                XformScale( &x, ( float )exp2( ( adversarial ? 60.0 : 10.0 ) * AccRand() ) );
+                memcpy( m, x.m.m, sizeof( x.m.m ) );
+                break;
+
+            case 2:
+                Vec3Set( &axis, AccRand(), AccRand(), AccRand() );
+                XformRotate( &x, &axis, ( adversarial ? 1e-4f : 3.0f ) * AccRand() );
+                memcpy( m, x.m.m, sizeof( x.m.m ) );
+                break;
+
+            default:
+                break;
+        }
+        if( ( i & 3 ) != 3 ) {
+            m[3] = AccRand() * 100.0f;
+            m[7] = AccRand() * 100.0f;
+            m[11] = AccRand() * 100.0f;
+        }
+    }
+    return n;
+}
+
+static void AccRun_Mat4ToNormalMat3Array( float* out, const float* in, int count ) {
+    static mat4_t m[ACC_COUNT];
+    static mat3_t r[ACC_COUNT];
+    memcpy( m, in, ( size_t )count * sizeof( mat4_t ) );
+    Mat4ToNormalMat3Array( r, m, count );
+    memcpy( out, r, ( size_t )count * sizeof( mat3_t ) );
+}
+
+static void AccRun_XformToNormalMat3Array( float* out, const float* in, int count ) {
+    static xform_t x[ACC_COUNT];
+    static mat3_t r[ACC_COUNT];
+    for( int i = 0; i < count; i++ ) {
+        mat4_t m;
+        memcpy( m.m, in + 16 * i, sizeof( m.m ) );
+        XformFromMat4( &x[i], &m );
+    }
+    XformToNormalMat3Array( r, x, count );
+    memcpy( out, r, ( size_t )count * sizeof( mat3_t ) );
+}
+
+// обратная транспонированная к 3x3 части: алгебраические дополнения, делённые на определитель
+static void AccRef_NormalMat3( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* m = in + 16 * i;
+        double a[3][3];
+        for( int r = 0; r < 3; r++ ) {
+            for( int c = 0; c < 3; c++ ) {
+                a[r][c] = m[r * 4 + c];
+            }
+        }
+        double cof[3][3];
+        for( int r = 0; r < 3; r++ ) {
+            AccCross3d( cof[r], a[( r + 1 ) % 3], a[( r + 2 ) % 3] );
+        }
+        double det = a[0][0] * cof[0][0] + a[0][1] * cof[0][1] + a[0][2] * cof[0][2];
+        for( int k = 0; k < 9; k++ ) {
+            out[9 * i + k] = cof[k / 3][k % 3] / det;
+        }
+    }
+}
+
+/* сплайны */
+
+#define ACC_SPLINE_POINTS   67      // точек кривой Катмулла-Рома, 64 сегмента
+
+static cubic_t  acc_spline[ACC_SPLINE_POINTS];
+static int      acc_spline_segments;
+
+/*
+AccGenSpline
+
+Параметры u кривой из 64 сегментов. Неудобные - границы сегментов
+с соседями через ulp и значения за пределами [0, 64].
+*/
+static int AccGenSpline( float* in, int cap, int adversarial ) {
+    if( acc_spline_segments == 0 ) {
+        vec4_t p[ACC_SPLINE_POINTS];
+        for( int i = 0; i < ACC_SPLINE_POINTS; i++ ) {
+            Vec4Set( &p[i], AccRand() * 100.0f, AccRand() * 100.0f, AccRand() * 100.0f, AccRand() );
+        }
+        acc_spline_segments = Spline4CatmullRomPath( acc_spline, p, ACC_SPLINE_POINTS );
+    }
+    if( !adversarial ) {
+        for( int i = 0; i < cap; i++ ) {
+            in[i] = ( float )acc_spline_segments * i / ( cap - 1 );
+        }
+        return cap;
+    }
+    int n = 0;
+    for( int k = 0; k <= acc_spline_segments; k++ ) {
+        n = AccNeighbors( in, n, cap, ( float )k, 4 );
+    }
+    in[n++] = -1.0f;
+    in[n++] = ( float )acc_spline_segments + 1.0f;
+    return n;
+}
+
+static void AccRun_Spline3Eval( float* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        vec3_t p = Spline3Eval( acc_spline, acc_spline_segments, in[i] );
+        memcpy( out + 3 * i, p.m, sizeof( p.m ) );
+    }
+}
+
+static void AccRun_Spline3EvalArray( float* out, const float* in, int count ) {
+    Spline3EvalArray( ( vec3_t* )out, acc_spline, acc_spline_segments, in, count );
+}
+
+static void AccRun_Spline4EvalArray( float* out, const float* in, int count ) {
+    static vec4_t p[ACC_COUNT];
+    Spline4EvalArray( p, acc_spline, acc_spline_segments, in, count );
+    memcpy( out, p, ( size_t )count * sizeof( vec4_t ) );
+}
+
+// схема Горнера в double по тем же коэффициентам
+static void AccRef_Spline( double* out, const float* in, int count, int dim ) {
+    for( int i = 0; i < count; i++ ) {
+        double u = in[i] < 0.0f ? 0.0 : in[i] > acc_spline_segments ? acc_spline_segments : in[i];
+        int s = ( int )u < acc_spline_segments - 1 ? ( int )u : acc_spline_segments - 1;
+        double t = u - s;
+        const cubic_t* c = &acc_spline[s];
+        for( int k = 0; k < dim; k++ ) {
+            out[i * dim + k] = ( ( ( double )c->c[3].m[k] * t + c->c[2].m[k] ) * t + c->c[1].m[k] ) * t + c->c[0].m[k];
+        }
+    }
+}
+
+static void AccRef_Spline3( double* out, const float* in, int count ) {
+    AccRef_Spline( out, in, count, 3 );
+}
+
+static void AccRef_Spline4( double* out, const float* in, int count ) {
+    AccRef_Spline( out, in, count, 4 );
+}
+
+/* шум */
+
+static float    acc_nx[ACC_COUNT];
+static float    acc_ny[ACC_COUNT];
+static float    acc_nz[ACC_COUNT];
+static float    acc_nw[ACC_COUNT];
+
+/*
+AccGenNoise
+
+Точки ( x, y, z, w ): плотный набор - два периода решётки вокруг нуля,
+неудобный - узлы решётки, кратные периоду 289 и далёкие координаты
+с соседями через ulp.
+*/
+static int AccGenNoise( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        for( int i = 0; i < 4 * cap; i++ ) {
+            in[i] = AccRand() * 289.0f;
+        }
+        return cap;
+    }
+    float vals[256];
+    int nv = 0;
+    const float pts[] = { 0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 288.0f, 289.0f, -289.0f, 578.0f, 1e4f, -1e5f, 1e6f };
+    for( int i = 0; i < ( int )( sizeof( pts ) / sizeof( pts[0] ) ); i++ ) {
+        nv = AccNeighbors( vals, nv, 256, pts[i], 2 );
+    }
+    int n = cap < 4096 ? cap : 4096;
+    for( int i = 0; i < 4 * n; i++ ) {
+        in[i] = vals[rand() % nv];
+    }
+    return n;
+}
+
+// перекладка точек в структуру массивов для функций *Array
+static void AccNoiseSoa( const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        acc_nx[i] = in[4 * i];
+        acc_ny[i] = in[4 * i + 1];
+        acc_nz[i] = in[4 * i + 2];
+        acc_nw[i] = in[4 * i + 3];
+    }
+}
+
+static void AccRun_NoisePerlin2Array( float* out, const float* in, int count ) {
+    AccNoiseSoa( in, count );
+    NoisePerlin2Array( out, acc_nx, acc_ny, count );
+}
+
+static void AccRun_NoisePerlin3Array( float* out, const float* in, int count ) {
+    AccNoiseSoa( in, count );
+    NoisePerlin3Array( out, acc_nx, acc_ny, acc_nz, count );
+}
+
+static void AccRun_NoisePerlin4Array( float* out, const float* in, int count ) {
+    AccNoiseSoa( in, count );
+    NoisePerlin4Array( out, acc_nx, acc_ny, acc_nz, acc_nw, count );
+}
+
+static void AccRun_NoiseSimplex2Array( float* out, const float* in, int count ) {
+    AccNoiseSoa( in, count );
+    NoiseSimplex2Array( out, acc_nx, acc_ny, count );
+}
+
+static void AccRun_NoiseSimplex3Array( float* out, const float* in, int count ) {
+    AccNoiseSoa( in, count );
+    NoiseSimplex3Array( out, acc_nx, acc_ny, acc_nz, count );
+}
+
+static void AccRun_NoiseSimplex4Array( float* out, const float* in, int count ) {
+    AccNoiseSoa( in, count );
+    NoiseSimplex4Array( out, acc_nx, acc_ny, acc_nz, acc_nw, count );
+}
+
+// эталон шума - скалярные функции: *Array должны совпадать с ними точно
+#define ACC_REF_NOISE( name, type ) \
+    static void AccRef_##name( double* out, const float* in, int count ) { \
+        for( int i = 0; i < count; i++ ) { \
+            type p; \
+            memcpy( p.m, in + 4 * i, sizeof( p.m ) ); \
+            out[i] = name( &p ); \
+        } \
+    }
+
+ACC_REF_NOISE( NoisePerlin2, vec2_t )
+ACC_REF_NOISE( NoisePerlin3, vec3_t )
+ACC_REF_NOISE( NoisePerlin4, vec4_t )
+ACC_REF_NOISE( NoiseSimplex2, vec2_t )
+ACC_REF_NOISE( NoiseSimplex3, vec3_t )
+ACC_REF_NOISE( NoiseSimplex4, vec4_t )
+
+/*
+Эталон шума в double: тот же хеш permute( x ) = ( 34 * x * x + x ) mod 289
+и те же решётки градиентов, что в noise.c, но mod, дробные части,
+нормировка градиентов и смешивание считаются точно.
+*/
+
+static double AccNoiseMod( double x ) {
+    return x - floor( x / 289.0 ) * 289.0;
+}
+
+static double AccNoisePermute( double x ) {
+    return AccNoiseMod( ( x * 34.0 + 1.0 ) * x );
+}
+
+static double AccNoiseFade( double t ) {
+    return t * t * t * ( t * ( t * 6.0 - 15.0 ) + 10.0 );
+}
+
+static double AccNoiseLerp( double a, double b, double t ) {
+    return a + ( b - a ) * t;
+}
+
+static double AccNoiseFalloff( double d2 ) {
+    double t = d2 < 0.5 ? 0.5 - d2 : 0.0;
+    return t * t * t * t;
+}
+
+static double AccNoiseSign( double x ) {
+    return x < 0.0 ? -1.0 : 1.0;
+}
+
+// градиент узла с хешем h, умноженный скалярно на смещение x[0..dim-1]; цифры h - в целых
+static double AccNoiseGrad( double h, const double* x, int dim ) {
+    int hi = ( int )h;
+    double g[4];
+    if( dim == 2 ) {
+        g[0] = ( hi % 41 ) / 41.0 * 2.0 - 1.0;
+        g[1] = fabs( g[0] ) - 0.5;
+        g[0] -= floor( g[0] + 0.5 );
+    }
+    else if( dim == 3 ) {
+        g[0] = ( hi % 7 ) / 3.0 - 1.0;
+        g[1] = ( hi / 7 % 7 ) / 3.0 - 1.0;
+        double au = fabs( g[0] );
+        double av = fabs( g[1] );
+        g[2] = 1.0 - au - av;
+        if( g[2] < 0.0 ) {
+            g[0] = ( 1.0 - av ) * AccNoiseSign( g[0] );
+            g[1] = ( 1.0 - au ) * AccNoiseSign( g[1] );
+        }
+    }
+    else {
+        g[0] = ( hi / 42 ) / 3.0 - 1.0;
+        g[1] = ( hi / 7 % 7 ) / 3.0 - 1.0;
+        g[2] = ( hi % 7 ) / 3.0 - 1.0;
+        g[3] = 1.5 - fabs( g[0] ) - fabs( g[1] ) - fabs( g[2] );
+        if( g[3] < 0.0 ) {
+            for( int k = 0; k < 3; k++ ) {
+                g[k] -= AccNoiseSign( g[k] );
+            }
+        }
+    }
+    double d = 0.0;
+    double n = 0.0;
+    for( int k = 0; k < dim; k++ ) {
+        d += g[k] * x[k];
+        n += g[k] * g[k];
+    }
+    return d / sqrt( n );
+}
+
+static double AccNoisePerlin( const float* p, int dim ) {
+    static const double scale[3] = { 1.41f, 1.15f, 1.0f };
+    double f[4], i[4], n[16], x[4];
+    for( int d = 0; d < dim; d++ ) {
+        double fl = floor( p[d] );
+        f[d] = p[d] - fl;
+        i[d] = AccNoiseMod( fl );
+    }
+    // угол c: бит d - сдвиг по оси d
+    for( int c = 0; c < ( 1 << dim ); c++ ) {
+        double h = 0.0;
+        for( int d = 0; d < dim; d++ ) {
+            int o = ( c >> d ) & 1;
+            h = AccNoisePermute( h + i[d] + o );
+            x[d] = f[d] - o;
+        }
+        n[c] = AccNoiseGrad( h, x, dim );
+    }
+    for( int d = 0, len = 1 << dim; d < dim; d++ ) {
+        len >>= 1;
+        for( int k = 0; k < len; k++ ) {
+            n[k] = AccNoiseLerp( n[2 * k], n[2 * k + 1], AccNoiseFade( f[d] ) );
+        }
+    }
+    return n[0] * scale[dim - 2];
+}
+
+static double AccNoiseSimplex( const float* p, int dim ) {
+    static const double scale[3] = { 99.0f, 107.0f, 108.0f };
+    double F = ( sqrt( dim + 1.0 ) - 1.0 ) / dim;
+    double G = ( 1.0 - 1.0 / sqrt( dim + 1.0 ) ) / dim;
+    double s = 0.0;
+    double t = 0.0;
+    double i[4], x0[4];
+    int rank[4];
+    for( int d = 0; d < dim; d++ ) {
+        s += p[d];
+    }
+    for( int d = 0; d < dim; d++ ) {
+        i[d] = floor( p[d] + s * F );
+        t += i[d];
+    }
+    for( int d = 0; d < dim; d++ ) {
+        x0[d] = p[d] - i[d] + t * G;
+        rank[d] = 0;
+        i[d] = AccNoiseMod( i[d] );
+    }
+    // ранг координаты - число координат, не больших её (при равенстве выигрывает меньший индекс)
+    for( int a = 0; a < dim; a++ ) {
+        for( int b = a + 1; b < dim; b++ ) {
+            if( x0[a] >= x0[b] ) {
+                rank[a]++;
+            }
+            else {
+                rank[b]++;
+            }
+        }
+    }
+    // вершина v сдвинута на 1 по координатам с рангом не меньше dim - v
+    double sum = 0.0;
+    for( int v = 0; v <= dim; v++ ) {
+        double x[4];
+        double h = 0.0;
+        double d2 = 0.0;
+        for( int d = 0; d < dim; d++ ) {
+            int o = rank[d] >= dim - v;
+            x[d] = x0[d] - o + v * G;
+            h = AccNoisePermute( h + i[d] + o );
+            d2 += x[d] * x[d];
+        }
+        sum += AccNoiseFalloff( d2 ) * AccNoiseGrad( h, x, dim );
+    }
+    return sum * scale[dim - 2];
+}
+
+/*
+AccGenNoiseNear
+
+Точки для сравнения с эталоном в double: плотный набор - как AccGenNoise,
+неудобный - узлы решётки и кратные периоду 289 с соседями через ulp,
+но не дальше 578. Дальше ulp самой координаты (1/16 при 1e6) сдвигает
+точку на заметную долю клетки, и ошибка говорит о входе, а не о ядре.
+*/
+static int AccGenNoiseNear( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        return AccGenNoise( in, cap, 0 );
+    }
+    float vals[256];
+    int nv = 0;
+    const float pts[] = { 0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 0.2113249f, 0.3660254f, 288.0f, 289.0f, -289.0f, 578.0f };
+    for( int i = 0; i < ( int )( sizeof( pts ) / sizeof( pts[0] ) ); i++ ) {
+        nv = AccNeighbors( vals, nv, 256, pts[i], 2 );
+    }
+    int n = cap < 4096 ? cap : 4096;
+    for( int i = 0; i < 4 * n; i++ ) {
+        in[i] = vals[rand() % nv];
+    }
+    return n;
+}
+
+/*
+Скалярный шум против эталона. Второй компонент выхода - 1, размах шума:
+ошибка меряется в ulp единицы, а не значения, которое около нуля
+может быть сколь угодно малым.
+*/
+#define ACC_RUN_NOISE_REF( name, type ) \
+    static void AccRun_##name##Ref( float* out, const float* in, int count ) { \
+        for( int i = 0; i < count; i++ ) { \
+            type p; \
+            memcpy( p.m, in + 4 * i, sizeof( p.m ) ); \
+            out[2 * i] = name( &p ); \
+            out[2 * i + 1] = 1.0f; \
+        } \
+    }
+
+#define ACC_REF_NOISE_DOUBLE( name, fn, dim ) \
+    static void AccRef_##name##Double( double* out, const float* in, int count ) { \
+        for( int i = 0; i < count; i++ ) { \
+            out[2 * i] = fn( in + 4 * i, dim ); \
+            out[2 * i + 1] = 1.0; \
+        } \
+    }
+
+ACC_RUN_NOISE_REF( NoisePerlin2, vec2_t )
+ACC_RUN_NOISE_REF( NoisePerlin3, vec3_t )
+ACC_RUN_NOISE_REF( NoisePerlin4, vec4_t )
+ACC_RUN_NOISE_REF( NoiseSimplex2, vec2_t )
+ACC_RUN_NOISE_REF( NoiseSimplex3, vec3_t )
+ACC_RUN_NOISE_REF( NoiseSimplex4, vec4_t )
+
+ACC_REF_NOISE_DOUBLE( NoisePerlin2, AccNoisePerlin, 2 )
+ACC_REF_NOISE_DOUBLE( NoisePerlin3, AccNoisePerlin, 3 )
+ACC_REF_NOISE_DOUBLE( NoisePerlin4, AccNoisePerlin, 4 )
+ACC_REF_NOISE_DOUBLE( NoiseSimplex2, AccNoiseSimplex, 2 )
+ACC_REF_NOISE_DOUBLE( NoiseSimplex3, AccNoiseSimplex, 3 )
+ACC_REF_NOISE_DOUBLE( NoiseSimplex4, AccNoiseSimplex, 4 )
+
+/* квантование */
+
+static unsigned char acc_code[ACC_COUNT * 8];
+
+static void AccRun_QuantOct( float* out, const float* in, int count, quantoct_t fmt ) {
+    QuantOctEncodeArray( acc_code, ( const vec3_t* )in, count, fmt );
+    QuantOctDecodeArray( ( vec3_t* )out, acc_code, count, fmt );
+}
+
+static void AccRun_QuantOct16( float* out, const float* in, int count ) {
+    AccRun_QuantOct( out, in, count, QUANT_OCT16 );
+}
+
+static void AccRun_QuantOct24( float* out, const float* in, int count ) {
+    AccRun_QuantOct( out, in, count, QUANT_OCT24 );
+}
+
+static void AccRun_QuantOct32( float* out, const float* in, int count ) {
+    AccRun_QuantOct( out, in, count, QUANT_OCT32 );
+}
+
+static aabb_t   acc_quant_box;
+
+/*
+AccGenPos
+
+Позиции для квантования внутри acc_quant_box = [-4, 4] x [-2, 2] x [-1, 1].
+Плотный набор немного выходит за границы, неудобный - углы, грани,
+центр и точки вне параллелепипеда.
+*/
+static int AccGenPos( float* in, int cap, int adversarial ) {
+    Vec3Set( &acc_quant_box.min, -4.0f, -2.0f, -1.0f );
+    Vec3Set( &acc_quant_box.max, 4.0f, 2.0f, 1.0f );
+    if( !adversarial ) {
+        for( int i = 0; i < cap; i++ ) {
+            for( int k = 0; k < 3; k++ ) {
+                in[3 * i + k] = AccRand() * 1.25f * acc_quant_box.max.m[k];
+            }
+        }
+        return cap;
+    }
+    const float t[] = { -2.0f, -1.0f, -0.5f, 0.0f, 1e-6f, 0.5f, 1.0f, 2.0f };
+    int n = 0;
+    for( int a = 0; a < 8; a++ ) {
+        for( int b = 0; b < 8; b++ ) {
+            for( int c = 0; c < 8; c++, n++ ) {
+                in[3 * n] = t[a] * acc_quant_box.max.x;
+                in[3 * n + 1] = t[b] * acc_quant_box.max.y;
+                in[3 * n + 2] = t[c] * acc_quant_box.max.z;
+            }
+        }
+    }
+    return n;
+}
+
+/*
+AccRun_QuantPos
+
+Четвёртый компонент выхода - размер acc_quant_box по x: он задаёт масштаб
+нормированной ошибки, иначе точки около нуля требовали бы точности,
+которой у равномерного квантования нет.
+*/
+static void AccRun_QuantPos( float* out, const float* in, int count, quantpos_t fmt ) {
+    static vec3_t p[ACC_COUNT];
+    QuantPosEncodeArray( acc_code, ( const vec3_t* )in, count, &acc_quant_box, fmt );
+    QuantPosDecodeArray( p, acc_code, count, &acc_quant_box, fmt );
+    for( int i = 0; i < count; i++ ) {
+        memcpy( out + 4 * i, p[i].m, sizeof( p[i].m ) );
+        out[4 * i + 3] = acc_quant_box.max.x - acc_quant_box.min.x;
+    }
+}
+
+static void AccRun_QuantPos32( float* out, const float* in, int count ) {
+    AccRun_QuantPos( out, in, count, QUANT_POS32 );
+}
+
+static void AccRun_QuantPos48( float* out, const float* in, int count ) {
+    AccRun_QuantPos( out, in, count, QUANT_POS48 );
+}
+
+// точка, прижатая к acc_quant_box, и размер box по x
+static void AccRef_Pos( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        for( int k = 0; k < 3; k++ ) {
+            double v = in[3 * i + k];
+            double lo = acc_quant_box.min.m[k];
+            double hi = acc_quant_box.max.m[k];
+            out[4 * i + k] = v < lo ? lo : v > hi ? hi : v;
+        }
+        out[4 * i + 3] = ( double )acc_quant_box.max.x - acc_quant_box.min.x;
+    }
+}
+
+/*
+AccGenQuat
+
+Ненормализованные кватернионы: плотный набор - случайные, неудобный -
+единичный, повороты на pi вокруг осей, почти равные наибольшие
+компоненты и масштабы 1e-6 .. 1e6.
+*/
+static int AccGenQuat( float* in, int cap, int adversarial ) {
+    if( !adversarial ) {
+        for( int i = 0; i < 4 * cap; i++ ) {
+            in[i] = AccRand();
+        }
+        return cap;
+    }
+    const float dirs[][4] = { { 0, 0, 0, 1 }, { 0, 0, 0, -1 }, { 1, 0, 0, 0 }, { 0, -1, 0, 0 }, { 0, 0, 1, 0 },
+                              { 1, 1, 0, 0 }, { 0.5f, -0.5f, 0.5f, 0.5f }, { 1e-4f, 0, 0, 1 },
+                              { 1, 1 - 1e-6f, 0, 0 }, { 0.3f, -0.4f, 0.5f, 0.7f } };
+    int n = 0;
+    for( int e = -6; e <= 6; e++ ) {
+        for( int j = 0; j < ( int )( sizeof( dirs ) / sizeof( dirs[0] ) ); j++, n++ ) {
+            for( int k = 0; k < 4; k++ ) {
+                in[4 * n + k] = dirs[j][k] * ( float )pow( 10.0, e );
+            }
+        }
+    }
+    return n;
+}
+
+static void AccRun_QuantQuat( float* out, const float* in, int count, quantquat_t fmt ) {
+    QuantQuatEncodeArray( acc_code, ( const vec4_t* )in, count, fmt );
+    QuantQuatDecodeArray( ( vec4_t* )out, acc_code, count, fmt );
+}
+
+static void AccRun_QuantQuat32( float* out, const float* in, int count ) {
+    AccRun_QuantQuat( out, in, count, QUANT_QUAT32 );
+}
+
+static void AccRun_QuantQuat48( float* out, const float* in, int count ) {
+    AccRun_QuantQuat( out, in, count, QUANT_QUAT48 );
+}
+
+// нормализованный кватернион со знаком, при котором наибольшая (первая из равных) компонента положительна
+static void AccRef_Quat( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* q = in + 4 * i;
+        int big = 0;
+        for( int k = 1; k < 4; k++ ) {
+            big = fabsf( q[k] ) > fabsf( q[big] ) ? k : big;
+        }
+        double len = sqrt( ( double )q[0] * q[0] + ( double )q[1] * q[1] + ( double )q[2] * q[2] + ( double )q[3] * q[3] );
+        double s = q[big] < 0.0f ? -1.0 / len : 1.0 / len;
+        for( int k = 0; k < 4; k++ ) {
+            out[4 * i + k] = q[k] * s;
+        }
+    }
+}
+
+/* плотные матрицы */
+
+#define ACC_MATN_INNER  13      // общая размерность сомножителей MatNMul, не кратна MATN_PAD
+#define ACC_MATN_COLS   21      // столбцов матрицы MatNMulVec
+
+static int      acc_matn_rows;                  // форма последнего набора MatNMul
+static int      acc_matn_cols;
+static float    acc_matn_v[ACC_MATN_COLS];      // вектор последнего набора MatNMulVec
+
+/*
+AccGenMatNValue
+
+Элемент матрицы: в плотном наборе из [-1, 1], в неудобном - порядка
+от 1e-3 до 1e3, чтобы суммы теряли младшие разряды при сокращении.
+*/
+static float AccGenMatNValue( int adversarial ) {
+    float f = AccRand();
+    return adversarial ? f * ( float )pow( 10.0, 6.0 * rand() / RAND_MAX - 3.0 ) : f;
+}
+
+/*
+AccGenMatNMul
+
+Произведение матриц n x ACC_MATN_INNER и ACC_MATN_INNER x n: элемент ( i, j ) -
+строка i первой матрицы, за ней столбец j второй. Плотный набор - 256 x 256,
+неудобный - 64 x 64.
+*/
+static int AccGenMatNMul( float* in, int cap, int adversarial ) {
+    static float a[256 * ACC_MATN_INNER], b[ACC_MATN_INNER * 256];
+    int n = adversarial ? 64 : 256;
+    while( n * n > cap ) {
+        n /= 2;
+    }
+    for( int i = 0; i < n * ACC_MATN_INNER; i++ ) {
+        a[i] = AccGenMatNValue( adversarial );
+        b[i] = AccGenMatNValue( adversarial );
+    }
+    for( int i = 0; i < n; i++ ) {
+        for( int j = 0; j < n; j++ ) {
+            float* e = in + ( i * n + j ) * 2 * ACC_MATN_INNER;
+            for( int k = 0; k < ACC_MATN_INNER; k++ ) {
+                e[k] = a[i * ACC_MATN_INNER + k];
+                e[ACC_MATN_INNER + k] = b[k * n + j];
+            }
+        }
+    }
+    acc_matn_rows = n;
+    acc_matn_cols = n;
+    return n * n;
+}
+
+/*
+AccRun_MatNMul
+
+Матрицы собираются из строк элементов ( i, 0 ) и столбцов элементов ( 0, j ).
+Второе число результата - сумма модулей произведений, масштаб ошибки
+при сокращении.
+*/
+static void AccRun_MatNMul( float* out, const float* in, int count ) {
+    int rows = acc_matn_rows;
+    int cols = count / rows;
+    matN_t a, b, c;
+    MatNInit( &a, rows, ACC_MATN_INNER );
+    MatNInit( &b, ACC_MATN_INNER, cols );
+    MatNInit( &c, rows, cols );
+    for( int i = 0; i < rows; i++ ) {
+        memcpy( MatNRow( &a, i ), in + i * cols * 2 * ACC_MATN_INNER, ACC_MATN_INNER * sizeof( float ) );
+    }
+    for( int j = 0; j < cols; j++ ) {
+        for( int k = 0; k < ACC_MATN_INNER; k++ ) {
+            MatNSet( &b, k, j, in[j * 2 * ACC_MATN_INNER + ACC_MATN_INNER + k] );
+        }
+    }
+    MatNMul( &c, &a, &b );
+    for( int i = 0; i < rows; i++ ) {
+        for( int j = 0; j < cols; j++ ) {
+            const float* e = in + ( i * cols + j ) * 2 * ACC_MATN_INNER;
+            float s = 0.0f;
+            for( int k = 0; k < ACC_MATN_INNER; k++ ) {
+                s += fabsf( e[k] * e[ACC_MATN_INNER + k] );
+            }
+            out[2 * ( i * cols + j )] = MatNGet( &c, i, j );
+            out[2 * ( i * cols + j ) + 1] = s;
+        }
+    }
+    MatNRelease( &a );
+    MatNRelease( &b );
+    MatNRelease( &c );
+}
+
+// скалярное произведение и сумма модулей произведений в double
+static void AccRef_Dot( double* out, const float* a, const float* b, int n ) {
+    double s = 0.0, m = 0.0;
+    for( int k = 0; k < n; k++ ) {
+        s += ( double )a[k] * b[k];
+        m += fabs( ( double )a[k] * b[k] );
+    }
+    out[0] = s;
+    out[1] = m;
+}
+
+static void AccRef_MatNMul( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* e = in + i * 2 * ACC_MATN_INNER;
+        AccRef_Dot( out + 2 * i, e, e + ACC_MATN_INNER, ACC_MATN_INNER );
+    }
+}
+
+/*
+AccGenMatNMulVec
+
+Строки матрицы из ACC_MATN_COLS столбцов, элемент - строка.
+Вектор общий для набора. Неудобный набор - 4096 строк.
+*/
+static int AccGenMatNMulVec( float* in, int cap, int adversarial ) {
+    int n = adversarial && ( cap > 4096 ) ? 4096 : cap;
+    for( int k = 0; k < ACC_MATN_COLS; k++ ) {
+        acc_matn_v[k] = AccGenMatNValue( adversarial );
+    }
+    for( int i = 0; i < n * ACC_MATN_COLS; i++ ) {
+        in[i] = AccGenMatNValue( adversarial );
+    }
+    return n;
+}
+
+static void AccRun_MatNMulVec( float* out, const float* in, int count ) {
+    static float r[ACC_COUNT];
+    matN_t m;
+    MatNInit( &m, count, ACC_MATN_COLS );
+    for( int i = 0; i < count; i++ ) {
+        memcpy( MatNRow( &m, i ), in + i * ACC_MATN_COLS, ACC_MATN_COLS * sizeof( float ) );
+    }
+    MatNMulVec( r, &m, acc_matn_v );
+    for( int i = 0; i < count; i++ ) {
+        float s = 0.0f;
+        for( int k = 0; k < ACC_MATN_COLS; k++ ) {
+            s += fabsf( in[i * ACC_MATN_COLS + k] * acc_matn_v[k] );
+        }
+        out[2 * i] = r[i];
+        out[2 * i + 1] = s;
+    }
+    MatNRelease( &m );
+}
+
+static void AccRef_MatNMulVec( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        AccRef_Dot( out + 2 * i, in + i * ACC_MATN_COLS, acc_matn_v, ACC_MATN_COLS );
+    }
+}
+
+/* разреженные системы */
+
+#define ACC_CG_TOLERANCE    1e-6f   // требуемая невязка Bsr3SolveCG относительно |b|
+
+/*
+AccGenChain
+
+Цепочка тел: элемент i - правая часть b_i, блок связи C_i с телом i + 1
+(у последнего тела не используется) и собственная жёсткость d_i > 0.
+Матрица системы симметрична: блок ( i, i + 1 ) - C_i, блок ( i + 1, i ) - C_i
+транспонированный, диагональный блок - d_i плюс суммы модулей соседних
+связей на диагонали, поэтому матрица положительно определена.
+В неудобном наборе тела масштабированы множителями s_i от 1e-3 до 1e3
+(связь умножается на s_i * s_{i + 1}, жёсткость на s_i^2, правая часть на s_i):
+обусловленность растёт на 12 порядков, и сходимость держится
+на предобусловливателе.
+*/
+static int AccGenChain( float* in, int cap, int adversarial ) {
+    int n = adversarial && ( cap > 4096 ) ? 4096 : cap;
+    float s = 1.0f;
+    for( int i = 0; i < n; i++ ) {
+        float* e = in + 13 * i;
+        float next = adversarial ? ( float )pow( 10.0, 6.0 * rand() / RAND_MAX - 3.0 ) : 1.0f;
+        for( int k = 0; k < 3; k++ ) {
+            e[k] = AccRand() * s;
+        }
+        for( int k = 0; k < 9; k++ ) {
+            e[3 + k] = AccRand() * s * next;
+        }
+        e[12] = ( 0.5f + 0.5f * AccRand() ) * s * s;
+        s = next;
+    }
+    return n;
+}
+
+// сумма модулей блока связи тела i, 0 за концами цепочки
+static double AccChainLink( const float* in, int count, int i ) {
+    double s = 0.0;
+    for( int k = 0; ( i >= 0 ) && ( i < count - 1 ) && ( k < 9 ); k++ ) {
+        s += fabs( in[13 * i + 3 + k] );
+    }
+    return s;
+}
+
+/*
+AccChainMul
+
+Строка i произведения матрицы цепочки на x в double.
+*/
+static void AccChainMul( double* out, const float* in, const vec3_t* x, int count, int i ) {
+    double d = in[13 * i + 12] + AccChainLink( in, count, i - 1 ) + AccChainLink( in, count, i );
+    for( int r = 0; r < 3; r++ ) {
+        out[r] = d * x[i].m[r];
+        for( int c = 0; c < 3; c++ ) {
+            if( i < count - 1 ) {
+                out[r] += ( double )in[13 * i + 3 + r * 3 + c] * x[i + 1].m[c];
+            }
+            if( i > 0 ) {
+                out[r] += ( double )in[13 * ( i - 1 ) + 3 + c * 3 + r] * x[i - 1].m[c];
+            }
+        }
+    }
+}
+
+/*
+AccRun_Bsr3SolveCG
+
+Сборка цепочки, решение из нулевого приближения и невязка: результат - строки
+a * x, посчитанные в double по найденному x, и наибольший модуль b
+как масштаб ошибки. Если метод не сошёлся, результат - NaN.
+*/
+static void AccRun_Bsr3SolveCG( float* out, const float* in, int count ) {
+    static int row[3 * ACC_COUNT], col[3 * ACC_COUNT];
+    static mat3_t blocks[3 * ACC_COUNT];
+    static vec3_t b[ACC_COUNT], x[ACC_COUNT];
+    int n = 0;
+    float bmax = 0.0f;
+    for( int i = 0; i < count; i++ ) {
+        const float* e = in + 13 * i;
+        float d = ( float )( e[12] + AccChainLink( in, count, i - 1 ) + AccChainLink( in, count, i ) );
+        memset( &blocks[n], 0, sizeof( mat3_t ) );
+        blocks[n].m[0] = blocks[n].m[4] = blocks[n].m[8] = d;
+        row[n] = col[n] = i;
+        n++;
+        if( i < count - 1 ) {
+            for( int r = 0; r < 3; r++ ) {
+                for( int c = 0; c < 3; c++ ) {
+                    blocks[n].m[r * 3 + c] = e[3 + r * 3 + c];
+                    blocks[n + 1].m[c * 3 + r] = e[3 + r * 3 + c];
+                }
+            }
+            row[n] = col[n + 1] = i;
+            col[n] = row[n + 1] = i + 1;
+            n += 2;
+        }
+        b[i] = Vec3Make( e[0], e[1], e[2] );
+        x[i] = Vec3Make( 0.0f, 0.0f, 0.0f );
+        for( int k = 0; k < 3; k++ ) {
+            bmax = fabsf( e[k] ) > bmax ? fabsf( e[k] ) : bmax;
+        }
+    }
+
+    bsr3_t m;
+    cgparams_t params = { 1000, ACC_CG_TOLERANCE };
+    mbool_t ok = Bsr3FromTriplets( &m, count, row, col, blocks, n ) && Bsr3SolveCG( x, &m, b, &params, NULL );
+    Bsr3Release( &m );
+    for( int i = 0; i < count; i++ ) {
+        double ax[3];
+        AccChainMul( ax, in, x, count, i );
+        for( int r = 0; r < 3; r++ ) {
+            out[4 * i + r] = ok ? ( float )ax[r] : NAN;
+        }
+        out[4 * i + 3] = bmax;
+    }
+}
+
+// точное a * x = b и тот же масштаб
+static void AccRef_Bsr3SolveCG( double* out, const float* in, int count ) {
+    double bmax = 0.0;
+    for( int i = 0; i < 3 * count; i++ ) {
+        double f = fabs( in[13 * ( i / 3 ) + i % 3] );
+        bmax = f > bmax ? f : bmax;
+    }
+    for( int i = 0; i < count; i++ ) {
+        for( int r = 0; r < 3; r++ ) {
+            out[4 * i + r] = in[13 * i + r];
+        }
+        out[4 * i + 3] = bmax;
+    }
+}
+
+/* случайные числа */
+
+#define ACC_RANDOM_SEED     0x5EED5EEDull
+#define ACC_RANDOM_LO       -3.0f
+#define ACC_RANDOM_HI       5.0f
+#define ACC_RANDOM_RADIUS   2.0f
+
+static uint32_t acc_random_stream;      // поток генератора последнего набора
+static vec3_t   acc_random_n;           // нормаль RandomHemisphereArray
+static vec3_t   acc_random_min;         // параллелепипед RandomBoxArray
+static vec3_t   acc_random_max;
+
+/*
+AccGenRandom
+
+Числа из [0, 1), которые генератор выдаст варианту, берущему blocks
+блоков по RANDOM_LANES чисел на каждые RANDOM_LANES элементов: элемент -
+его blocks чисел. Проверяется преобразование чисел в точки, а выбирать
+входы у генератора нельзя, поэтому неудобный набор - другой поток.
+*/
+static int AccGenRandom( float* in, int cap, int adversarial, int blocks ) {
+    float u[RANDOM_LANES];
+    random_t r;
+    Vec3Set( &acc_random_n, 1.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f );
+    Vec3Set( &acc_random_min, -4.0f, -2.0f, -1.0f );
+    Vec3Set( &acc_random_max, 4.0f, 2.0f, 1.0f );
+    acc_random_stream = adversarial ? 1 : 0;
+    RandomInit( &r, ACC_RANDOM_SEED, acc_random_stream );
+    for( int i = 0; i + RANDOM_LANES <= cap; i += RANDOM_LANES ) {
+        for( int j = 0; j < blocks; j++ ) {
+            RandomFloatArray( &r, u, RANDOM_LANES );
+            for( int k = 0; k < RANDOM_LANES; k++ ) {
+                in[( i + k ) * blocks + j] = u[k];
+            }
+        }
+    }
+    return cap / RANDOM_LANES * RANDOM_LANES;
+}
+
+static int AccGenRandom1( float* in, int cap, int adversarial ) {
+    return AccGenRandom( in, cap, adversarial, 1 );
+}
+
+static int AccGenRandom2( float* in, int cap, int adversarial ) {
+    return AccGenRandom( in, cap, adversarial, 2 );
+}
+
+static int AccGenRandom3( float* in, int cap, int adversarial ) {
+    return AccGenRandom( in, cap, adversarial, 3 );
+}
+
+static int AccGenRandom5( float* in, int cap, int adversarial ) {
+    return AccGenRandom( in, cap, adversarial, 5 );
+}
+
+// генератор того же потока, что и у последнего набора: входы варианты не читают,
+// генератор выдаёт их заново
+static void AccRandomInit( random_t* r ) {
+    RandomInit( r, ACC_RANDOM_SEED, acc_random_stream );
+}
+
+// второе число результата - наибольший модуль границ, масштаб ошибки у нуля
+static void AccRun_RandomRange( float* out, const float* in, int count ) {
+    random_t r;
+    ( void )in;
+    AccRandomInit( &r );
+    for( int i = 0; i < count; i++ ) {
+        out[2 * i] = RandomRange( &r, ACC_RANDOM_LO, ACC_RANDOM_HI );
+        out[2 * i + 1] = ACC_RANDOM_HI;
+    }
+}
+
+static void AccRun_RandomRangeArray( float* out, const float* in, int count ) {
+    static float v[ACC_COUNT];
+    random_t r;
+    ( void )in;
+    AccRandomInit( &r );
+    RandomRangeArray( &r, v, ACC_RANDOM_LO, ACC_RANDOM_HI, count );
+    for( int i = 0; i < count; i++ ) {
+        out[2 * i] = v[i];
+        out[2 * i + 1] = ACC_RANDOM_HI;
+    }
+}
+
+static void AccRun_RandomUnitVec2Array( float* out, const float* in, int count ) {
+    random_t r;
+    ( void )in;
+    AccRandomInit( &r );
+    RandomUnitVec2Array( &r, ( vec2_t* )out, count );
+}
+
+static void AccRun_RandomUnitVec3Array( float* out, const float* in, int count ) {
+    random_t r;
+    ( void )in;
+    AccRandomInit( &r );
+    RandomUnitVec3Array( &r, ( vec3_t* )out, count );
+}
+
+static void AccRun_RandomDiscArray( float* out, const float* in, int count ) {
+    random_t r;
+    ( void )in;
+    AccRandomInit( &r );
+    RandomDiscArray( &r, ( vec2_t* )out, ACC_RANDOM_RADIUS, count );
+}
+
+static void AccRun_RandomSphereArray( float* out, const float* in, int count ) {
+    random_t r;
+    ( void )in;
+    AccRandomInit( &r );
+    RandomSphereArray( &r, ( vec3_t* )out, ACC_RANDOM_RADIUS, count );
+}
+
+static void AccRun_RandomHemisphereArray( float* out, const float* in, int count ) {
+    random_t r;
+    ( void )in;
+    AccRandomInit( &r );
+    RandomHemisphereArray( &r, ( vec3_t* )out, &acc_random_n, ACC_RANDOM_RADIUS, count );
+}
+
+// четвёртое число результата - наибольший модуль границ
+static void AccRun_RandomBoxArray( float* out, const float* in, int count ) {
+    static vec3_t p[ACC_COUNT];
+    random_t r;
+    ( void )in;
+    AccRandomInit( &r );
+    RandomBoxArray( &r, p, &acc_random_min, &acc_random_max, count );
+    for( int i = 0; i < count; i++ ) {
+        memcpy( out + 4 * i, p[i].m, sizeof( p[i].m ) );
+        out[4 * i + 3] = acc_random_max.x;
+    }
+}
+
+static void AccRef_RandomRange( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        out[2 * i] = ACC_RANDOM_LO + ( ( double )ACC_RANDOM_HI - ACC_RANDOM_LO ) * in[i];
+        out[2 * i + 1] = ACC_RANDOM_HI;
+    }
+}
+
+static void AccRef_RandomUnitVec2( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        out[2 * i] = cos( 2.0 * M_PI * in[i] );
+        out[2 * i + 1] = sin( 2.0 * M_PI * in[i] );
+    }
+}
+
+// z = 1 - 2u, угол 2 pi v
+static void AccRandomDir( double* out, const float* u ) {
+    double z = 1.0 - 2.0 * u[0];
+    double r = sqrt( 1.0 - z * z );
+    out[0] = r * cos( 2.0 * M_PI * u[1] );
+    out[1] = r * sin( 2.0 * M_PI * u[1] );
+    out[2] = z;
+}
+
+static void AccRef_RandomUnitVec3( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        AccRandomDir( out + 3 * i, in + 2 * i );
+    }
+}
+
+static void AccRef_RandomDisc( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        double d = ACC_RANDOM_RADIUS * sqrt( ( double )in[2 * i] );
+        out[2 * i] = d * cos( 2.0 * M_PI * in[2 * i + 1] );
+        out[2 * i + 1] = d * sin( 2.0 * M_PI * in[2 * i + 1] );
+    }
+}
+
+// направление из u0, u1 и расстояние max( u2, u3, u4 ), как в RandomBallLane
+static void AccRandomBall( double* out, const float* u ) {
+    double d = u[2] > u[3] ? u[2] : u[3];
+    d = ( u[4] > d ? u[4] : d ) * ACC_RANDOM_RADIUS;
+    AccRandomDir( out, u );
+    for( int k = 0; k < 3; k++ ) {
+        out[k] *= d;
+    }
+}
+
+static void AccRef_RandomSphere( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        AccRandomBall( out + 3 * i, in + 5 * i );
+    }
+}
+
+static void AccRef_RandomHemisphere( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        double* p = out + 3 * i;
+        AccRandomBall( p, in + 5 * i );
+        double d = p[0] * acc_random_n.x + p[1] * acc_random_n.y + p[2] * acc_random_n.z;
+        for( int k = 0; d < 0.0 && k < 3; k++ ) {
+            p[k] -= 2.0 * d * acc_random_n.m[k];
+        }
+    }
+}
+
+static void AccRef_RandomBox( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        for( int k = 0; k < 3; k++ ) {
+            out[4 * i + k] = acc_random_min.m[k] + ( ( double )acc_random_max.m[k] - acc_random_min.m[k] ) * in[3 * i + k];
+        }
+        out[4 * i + 3] = acc_random_max.x;
+    }
+}
+
+/* анимация */
+
+static float    acc_anim_time;      // момент выборки последнего набора
+
+/*
+AccGenAnimKey
+
+Ключ кости: перенос из [-1, 1], единичный поворот, масштаб из [0.5, 1.5].
+В неудобном наборе поворот зависит от поворота prev предыдущего ключа:
+противоположный ему, противоположный с отклонением 1e-3 (ближний путь
+выбирается по знаку скалярного произведения, близкого к -1) или равный.
+*/
+static void AccGenAnimKey( float* k, const float* prev, int adversarial, int i ) {
+    double len = 0.0;
+    for( int c = 0; c < 3; c++ ) {
+        k[ANIM_TX + c] = AccRand();
+        k[ANIM_SX + c] = 1.0f + 0.5f * AccRand();
+    }
+    while( len < 0.01 ) {
+        len = 0.0;
+        for( int c = 0; c < 4; c++ ) {
+            k[ANIM_RX + c] = AccRand();
+            len += ( double )k[ANIM_RX + c] * k[ANIM_RX + c];
+        }
+    }
+    if( adversarial && ( prev != NULL ) && ( i % 4 != 3 ) ) {
+        float f = i % 4 == 2 ? 1.0f : -1.0f;
+        float e = i % 4 == 1 ? 1e-3f : 0.0f;
+        len = 0.0;
+        for( int c = 0; c < 4; c++ ) {
+            k[ANIM_RX + c] = f * prev[ANIM_RX + c] + e * k[ANIM_RX + c];
+            len += ( double )k[ANIM_RX + c] * k[ANIM_RX + c];
+        }
+    }
+    for( int c = 0; c < 4; c++ ) {
+        k[ANIM_RX + c] = ( float )( k[ANIM_RX + c] / sqrt( len ) );
+    }
+}
+
+/*
+AccGenAnim
+
+Элемент - keys ключей одной кости по ANIM_CHANNELS чисел.
+Плотный набор берётся в момент 0.37, неудобный - в середине между
+ключами, где промежуточный кватернион nlerp короче всего.
+*/
+static int AccGenAnim( float* in, int cap, int adversarial, int keys ) {
+    acc_anim_time = adversarial ? 0.5f : 0.37f;
+    for( int i = 0; i < cap; i++ ) {
+        for( int k = 0; k < keys; k++ ) {
+            float* e = in + ( i * keys + k ) * ANIM_CHANNELS;
+            AccGenAnimKey( e, k > 0 ? e - ANIM_CHANNELS : NULL, adversarial, i );
+        }
+    }
+    return cap;
+}
+
+static int AccGenAnim2( float* in, int cap, int adversarial ) {
+    return AccGenAnim( in, cap, adversarial, 2 );
+}
+
+static int AccGenAnim3( float* in, int cap, int adversarial ) {
+    return AccGenAnim( in, cap, adversarial, 3 );
+}
+
+/*
+AccAnimClip
+
+Клип из keys ключей в моменты 0, 1, ...: ключ k кости i - ключ first + k
+элемента i, в котором stride ключей.
+*/
+static void AccAnimClip( animclip_t* c, const float* in, int count, int stride, int first, int keys ) {
+    AnimClipInit( c, count, keys );
+    for( int k = 0; k < keys; k++ ) {
+        c->times[k] = ( float )k;
+        for( int ch = 0; ch < ANIM_CHANNELS; ch++ ) {
+            float* d = AnimClipChannel( c, k, ch );
+            for( int i = 0; i < count; i++ ) {
+                d[i] = in[( i * stride + first + k ) * ANIM_CHANNELS + ch];
+            }
+        }
+    }
+}
+
+// поза по костям в out, ANIM_CHANNELS чисел на кость
+static void AccAnimStore( float* out, const animpose_t* p, int count ) {
+    for( int ch = 0; ch < ANIM_CHANNELS; ch++ ) {
+        const float* d = AnimPoseChannel( p, ch );
+        for( int i = 0; i < count; i++ ) {
+            out[i * ANIM_CHANNELS + ch] = d[i];
+        }
+    }
+}
+
+/*
+AccAnimLayers
+
+mode 0 - AnimSample клипа из двух ключей, 1 - AnimSampleLayers двух
+взвешенных слоёв: клипа из двух ключей с весом 0.7 и клипа из одного ключа
+с весом 0.3, 2 - AnimSampleLayers разностного клипа из двух ключей
+с весом 0.6 поверх клипа из одного ключа.
+*/
+static void AccAnimLayers( float* out, const float* in, int count, int mode ) {
+    animclip_t a, b;
+    animpose_t p;
+    AnimPoseInit( &p, count );
+    if( mode == 0 ) {
+        AccAnimClip( &a, in, count, 2, 0, 2 );
+        AnimSample( &p, &a, NULL, acc_anim_time );
+        AnimClipRelease( &a );
+    }
+    else {
+        int additive = mode == 2;
+        AccAnimClip( &a, in, count, 3, additive ? 1 : 0, 2 );
+        AccAnimClip( &b, in, count, 3, additive ? 0 : 2, 1 );
+        animlayer_t layers[2] = {
+            { &a, NULL, acc_anim_time, additive ? 0.6f : 0.7f, additive ? ANIM_BLEND_ADDITIVE : ANIM_BLEND_WEIGHTED },
+            { &b, NULL, 0.0f, additive ? 1.0f : 0.3f, ANIM_BLEND_WEIGHTED },
+        };
+        AnimSampleLayers( &p, layers, 2 );
+        AnimClipRelease( &a );
+        AnimClipRelease( &b );
+    }
+    AccAnimStore( out, &p, count );
+    AnimPoseRelease( &p );
+}
+
+static void AccRun_AnimSample( float* out, const float* in, int count ) {
+    AccAnimLayers( out, in, count, 0 );
+}
+
+static void AccRun_AnimSampleLayers( float* out, const float* in, int count ) {
+    AccAnimLayers( out, in, count, 1 );
+}
+
+static void AccRun_AnimSampleAdditive( float* out, const float* in, int count ) {
+    AccAnimLayers( out, in, count, 2 );
+}
+
+/*
+AccAnimLerp
+
+Перенос и масштаб lerp( a, b, f ), поворот - nlerp по ближнему пути
+без нормализации, как в AnimLerpQuat.
+*/
+static void AccAnimLerp( double* out, const float* a, const float* b, double f ) {
+    double dot = 0.0;
+    for( int c = 0; c < 4; c++ ) {
+        dot += ( double )a[ANIM_RX + c] * b[ANIM_RX + c];
+    }
+    for( int ch = 0; ch < ANIM_CHANNELS; ch++ ) {
+        double v = ( ( ch >= ANIM_RX ) && ( ch <= ANIM_RW ) && ( dot < 0.0 ) ) ? -b[ch] : b[ch];
+        out[ch] = a[ch] + ( v - a[ch] ) * f;
+    }
+}
+
+// нормализация поворота позы
+static void AccAnimNormQuat( double* p ) {
+    double len = 0.0;
+    for( int c = 0; c < 4; c++ ) {
+        len += p[ANIM_RX + c] * p[ANIM_RX + c];
+    }
+    for( int c = 0; c < 4; c++ ) {
+        p[ANIM_RX + c] /= sqrt( len );
+    }
+}
+
+static void AccRef_AnimSample( double* out, const float* in, int count ) {
+    for( int i = 0; i < count; i++ ) {
+        const float* e = in + i * 2 * ANIM_CHANNELS;
+        AccAnimLerp( out + i * ANIM_CHANNELS, e, e + ANIM_CHANNELS, acc_anim_time );
+        AccAnimNormQuat( out + i * ANIM_CHANNELS );
+    }
+}
+
+/*
+AccRef_AnimSampleLayers
+
+Взвешенное среднее с весами 0.7 и 0.3 (во float, как у слоёв): знак
+поворота второго слоя выбирается по согласию с первым.
+*/
+static void AccRef_AnimSampleLayers( double* out, const float* in, int count ) {
+    const double wa = 0.7f, wb = 0.3f;
+    for( int i = 0; i < count; i++ ) {
+        const float* e = in + i * 3 * ANIM_CHANNELS;
+        const float* b = e + 2 * ANIM_CHANNELS;
+        double* p = out + i * ANIM_CHANNELS;
+        double dot = 0.0;
+        AccAnimLerp( p, e, e + ANIM_CHANNELS, acc_anim_time );
+        AccAnimNormQuat( p );
+        for( int c = 0; c < 4; c++ ) {
+            dot += p[ANIM_RX + c] * b[ANIM_RX + c];
+        }
+        for( int ch = 0; ch < ANIM_CHANNELS; ch++ ) {
+            int flip = ( ch >= ANIM_RX ) && ( ch <= ANIM_RW ) && ( dot < 0.0 );
+            p[ch] = ( wa * p[ch] + wb * ( flip ? -b[ch] : b[ch] ) ) / ( wa + wb );
+        }
+        AccAnimNormQuat( p );
+    }
+}
+
+/*
+AccRef_AnimSampleAdditive
+
+Перенос прибавляется с весом 0.6, масштаб умножается на lerp( 1, s, 0.6 ),
+поворот основы домножается справа на nlerp( 1, q, 0.6 ) по ближнему пути.
+*/
+static void AccRef_AnimSampleAdditive( double* out, const float* in, int count ) {
+    const double w = 0.6f;
+    for( int i = 0; i < count; i++ ) {
+        const float* e = in + i * 3 * ANIM_CHANNELS;
+        double* p = out + i * ANIM_CHANNELS;
+        double d[ANIM_CHANNELS], r[4], q[4];
+        AccAnimLerp( d, e + ANIM_CHANNELS, e + 2 * ANIM_CHANNELS, acc_anim_time );
+        for( int c = 0; c < 3; c++ ) {
+            p[ANIM_TX + c] = e[ANIM_TX + c] + w * d[ANIM_TX + c];
+            p[ANIM_SX + c] = e[ANIM_SX + c] * ( 1.0 + ( d[ANIM_SX + c] - 1.0 ) * w );
+        }
+        double sw = d[ANIM_RW] < 0.0 ? -w : w;
+        for( int c = 0; c < 4; c++ ) {
+            r[c] = e[ANIM_RX + c];
+            q[c] = sw * d[ANIM_RX + c];
+        }
+        q[3] += 1.0 - w;
+        p[ANIM_RX] = r[3] * q[0] + r[0] * q[3] + r[1] * q[2] - r[2] * q[1];
+        p[ANIM_RY] = r[3] * q[1] - r[0] * q[2] + r[1] * q[3] + r[2] * q[0];
+        p[ANIM_RZ] = r[3] * q[2] + r[0] * q[1] - r[1] * q[0] + r[2] * q[3];
+        p[ANIM_RW] = r[3] * q[3] - r[0] * q[0] - r[1] * q[1] - r[2] * q[2];
+        AccAnimNormQuat( p );
+    }
+}
+
+/*
+Бюджеты в ulp. Функции libm - несколько ulp; isqrt1f - одна итерация
+Ньютона после приближения битовым сдвигом (относительная ошибка до 1.8e-3);
+для обращения матриц и решения систем ошибка растёт с числом
+обусловленности, для видовой матрицы - при up, почти параллельном
+направлению взгляда. Пакетный шум сравнивается со скалярным и должен
+совпадать точно, скалярный - с double на тех же хешах в ulp единицы:
+у симплексного шума сокращаются вклады вершин порядка 0.5^4.
+Бюджеты квантования - половина шага сетки в ulp единицы (направления,
+кватернионы) или размера box (позиции). Скалярные произведения MatN
+считаются в ulp суммы модулей слагаемых, невязка Bsr3SolveCG - в ulp
+наибольшего модуля b при остановке на ACC_CG_TOLERANCE.
+*/
+static acccase_t acc_cases[] = {
+    { "rsqrt",        "isqrt1f",                   1,  1,  AccGenPositive,   AccRun_isqrt1f,                   AccRef_rsqrt,               32768.0 },
+    { "rsqrt",        "LaneRsqrt",                 1,  1,  AccGenPositive,   AccRun_LaneRsqrt,                 AccRef_rsqrt,               8.0 },
+    { "rsqrt",        "1/sqrtf",                   1,  1,  AccGenPositive,   AccRun_rsqrtf,                    AccRef_rsqrt,               2.0 },
+    { "sqrt",         "sqrt1f",                    1,  1,  AccGenPositive,   AccRun_sqrt1f,                    AccRef_sqrt,                0.5 },
+    { "sqrt",         "sqrtf",                     1,  1,  AccGenPositive,   AccRun_sqrtf,                     AccRef_sqrt,                0.5 },
+    { "sin",          "sin1f",                     1,  1,  AccGenAngle,      AccRun_sin1f,                     AccRef_sin,                 2.0 },
+    { "cos",          "cos1f",                     1,  1,  AccGenAngle,      AccRun_cos1f,                     AccRef_cos,                 2.0 },
+    { "tan",          "tan1f",                     1,  1,  AccGenTanAngle,   AccRun_tan1f,                     AccRef_tan,                 2.0 },
+    { "asin",         "asin1f",                    1,  1,  AccGenUnit,       AccRun_asin1f,                    AccRef_asin,                2.0 },
+    { "acos",         "acos1f",                    1,  1,  AccGenUnit,       AccRun_acos1f,                    AccRef_acos,                2.0 },
+    { "atan",         "atan1f",                    1,  1,  AccGenReal,       AccRun_atan1f,                    AccRef_atan,                2.0 },
+    { "atan2",        "atan2f",                    2,  1,  AccGenAtan2,      AccRun_atan2f,                    AccRef_atan2,               2.0 },
+    { "exp",          "exp1f",                     1,  1,  AccGenExp,        AccRun_exp1f,                     AccRef_exp,                 2.0 },
+    { "exp",          "expf",                      1,  1,  AccGenExp,        AccRun_expf,                      AccRef_exp,                 2.0 },
+    { "log",          "log1f",                     1,  1,  AccGenLog,        AccRun_log1f,                     AccRef_log,                 2.0 },
+    { "pow",          "pow2f",                     2,  1,  AccGenPow,        AccRun_pow2f,                     AccRef_pow,                 2.0 },
+    { "vec3 norm",    "Vec3Norm",                  3,  3,  AccGenVec3,       AccRun_Vec3Norm,                  AccRef_Norm3,               4.0 },
+    { "vec3 norm",    "Vec3NormVal",               3,  3,  AccGenVec3,       AccRun_Vec3NormVal,               AccRef_Norm3,               4.0 },
+    { "vec3 len",     "Vec3Len",                   3,  1,  AccGenVec3,       AccRun_Vec3Len,                   AccRef_Len3,                2.0 },
+    { "vec3 sqrlen",  "Vec3SqrLen",                3,  1,  AccGenVec3,       AccRun_Vec3SqrLen,                AccRef_SqrLen3,             4.0 },
+    { "mat4 inv",     "Mat4InvTo",                 16, 16, AccGenMat4,       AccRun_Mat4InvTo,                 AccRef_Inv4,                1024.0 },
+    { "mat4 inv",     "Lu4Solve",                  16, 16, AccGenMat4,       AccRun_Mat4LuSolve,               AccRef_Inv4,                1024.0 },
+    { "mat4 mul",     "Mat4Mul",                   32, 16, AccGenMat4Pair,   AccRun_Mat4Mul,                   AccRef_Mul4,                8.0 },
+    { "mat4 mul",     "Mat4MulR",                  32, 16, AccGenMat4Pair,   AccRun_Mat4MulR,                  AccRef_Mul4,                8.0 },
+    { "mat3 sigma",   "Mat3Svd",                   9,  3,  AccGenMat3,       AccRun_Mat3Svd,                   AccRef_Sigma3,              128.0 },
+    { "mat3 sigma",   "Mat3SvdArray",              9,  3,  AccGenMat3,       AccRun_Mat3SvdArray,              AccRef_Sigma3,              128.0 },
+    { "mat3 eigen",   "Mat3SymEigen",              9,  3,  AccGenSym3,       AccRun_Mat3SymEigen,              AccRef_SymEigen3,           128.0 },
+    { "mat3 eigen",   "Mat3SymEigenArray",         9,  3,  AccGenSym3,       AccRun_Mat3SymEigenArray,         AccRef_SymEigen3,           128.0 },
+    { "mat3 solve",   "Lu3Solve",                  12, 3,  AccGenSolve3,     AccRun_Lu3Solve,                  AccRef_Solve3,              2048.0 },
+    { "mat3 solve",   "Lu3SolveArray",             12, 3,  AccGenSolve3,     AccRun_Lu3SolveArray,             AccRef_Solve3,              2048.0 },
+    { "mat3 solve",   "Mat3SolveArray",            12, 3,  AccGenSolve3,     AccRun_Mat3SolveArray,            AccRef_Solve3,              2048.0 },
+    { "mat4 solve",   "Lu4Solve",                  20, 4,  AccGenSolve4,     AccRun_Lu4Solve,                  AccRef_Solve4,              4096.0 },
+    { "mat4 solve",   "Lu4SolveArray",             20, 4,  AccGenSolve4,     AccRun_Lu4SolveArray,             AccRef_Solve4,              4096.0 },
+    { "mat4 solve",   "Mat4SolveArray",            20, 4,  AccGenSolve4,     AccRun_Mat4SolveArray,            AccRef_Solve4,              4096.0 },
+    { "covariance",   "Mat3Covariance",            24, 6,  AccGenCloud,      AccRun_Mat3Covariance,            AccRef_Covariance,          1.0 },
+    { "perspective",  "CameraPerspectiveArray",    5,  16, AccGenPersp,      AccRun_CameraPerspectiveArray,    AccRef_Perspective,         4.0 },
+    { "persp inv",    "CameraPerspectiveArrayInv", 5,  16, AccGenPersp,      AccRun_CameraPerspectiveArrayInv, AccRef_PerspectiveInv,      4.0 },
+    { "ortho",        "CameraOrthoArray",          7,  16, AccGenOrtho,      AccRun_CameraOrthoArray,          AccRef_Ortho,               4.0 },
+    { "ortho inv",    "CameraOrthoArrayInv",       7,  16, AccGenOrtho,      AccRun_CameraOrthoArrayInv,       AccRef_OrthoInv,            4.0 },
+    { "lookat",       "CameraLookAtArray",         9,  16, AccGenLookAt,     AccRun_CameraLookAtArray,         AccRef_LookAt,              1024.0 },
+    { "lookat inv",   "CameraLookAtArrayInv",      9,  16, AccGenLookAt,     AccRun_CameraLookAtArrayInv,      AccRef_LookAtInv,           1024.0 },
+    { "normal mat3",  "Mat4ToNormalMat3Array",     16, 9,  AccGenMat4,       AccRun_Mat4ToNormalMat3Array,     AccRef_NormalMat3,          512.0 },
+    { "normal mat3",  "XformToNormalMat3Array",    16, 9,  AccGenXform,      AccRun_XformToNormalMat3Array,    AccRef_NormalMat3,          64.0 },
+    { "spline3",      "Spline3Eval",               1,  3,  AccGenSpline,     AccRun_Spline3Eval,               AccRef_Spline3,             16.0 },
+    { "spline3",      "Spline3EvalArray",          1,  3,  AccGenSpline,     AccRun_Spline3EvalArray,          AccRef_Spline3,             16.0 },
+    { "spline4",      "Spline4EvalArray",          1,  4,  AccGenSpline,     AccRun_Spline4EvalArray,          AccRef_Spline4,             16.0 },
+    { "perlin2",      "NoisePerlin2Array",         4,  1,  AccGenNoise,      AccRun_NoisePerlin2Array,         AccRef_NoisePerlin2,        0.0 },
+    { "perlin3",      "NoisePerlin3Array",         4,  1,  AccGenNoise,      AccRun_NoisePerlin3Array,         AccRef_NoisePerlin3,        0.0 },
+    { "perlin4",      "NoisePerlin4Array",         4,  1,  AccGenNoise,      AccRun_NoisePerlin4Array,         AccRef_NoisePerlin4,        0.0 },
+    { "simplex2",     "NoiseSimplex2Array",        4,  1,  AccGenNoise,      AccRun_NoiseSimplex2Array,        AccRef_NoiseSimplex2,       0.0 },
+    { "simplex3",     "NoiseSimplex3Array",        4,  1,  AccGenNoise,      AccRun_NoiseSimplex3Array,        AccRef_NoiseSimplex3,       0.0 },
+    { "simplex4",     "NoiseSimplex4Array",        4,  1,  AccGenNoise,      AccRun_NoiseSimplex4Array,        AccRef_NoiseSimplex4,       0.0 },
+    { "perlin2 ref",  "NoisePerlin2",              4,  2,  AccGenNoiseNear,  AccRun_NoisePerlin2Ref,           AccRef_NoisePerlin2Double,  32.0 },
+    { "perlin3 ref",  "NoisePerlin3",              4,  2,  AccGenNoiseNear,  AccRun_NoisePerlin3Ref,           AccRef_NoisePerlin3Double,  32.0 },
+    { "perlin4 ref",  "NoisePerlin4",              4,  2,  AccGenNoiseNear,  AccRun_NoisePerlin4Ref,           AccRef_NoisePerlin4Double,  32.0 },
+    { "simplex2 ref", "NoiseSimplex2",             4,  2,  AccGenNoiseNear,  AccRun_NoiseSimplex2Ref,          AccRef_NoiseSimplex2Double, 4096.0 },
+    { "simplex3 ref", "NoiseSimplex3",             4,  2,  AccGenNoiseNear,  AccRun_NoiseSimplex3Ref,          AccRef_NoiseSimplex3Double, 4096.0 },
+    { "simplex4 ref", "NoiseSimplex4",             4,  2,  AccGenNoiseNear,  AccRun_NoiseSimplex4Ref,          AccRef_NoiseSimplex4Double, 4096.0 },
+    { "oct quant",    "QuantOct16",                3,  3,  AccGenVec3,       AccRun_QuantOct16,                AccRef_Norm3,               524288.0 },
+    { "oct quant",    "QuantOct24",                3,  3,  AccGenVec3,       AccRun_QuantOct24,                AccRef_Norm3,               32768.0 },
+    { "oct quant",    "QuantOct32",                3,  3,  AccGenVec3,       AccRun_QuantOct32,                AccRef_Norm3,               2048.0 },
+    { "pos quant",    "QuantPos32",                3,  4,  AccGenPos,        AccRun_QuantPos32,                AccRef_Pos,                 4096.0 },
+    { "pos quant",    "QuantPos48",                3,  4,  AccGenPos,        AccRun_QuantPos48,                AccRef_Pos,                 128.0 },
+    { "quat quant",   "QuantQuat32",               4,  4,  AccGenQuat,       AccRun_QuantQuat32,               AccRef_Quat,                65536.0 },
+    { "quat quant",   "QuantQuat48",               4,  4,  AccGenQuat,       AccRun_QuantQuat48,               AccRef_Quat,                2048.0 },
+    { "matN mul",     "MatNMul",                   26, 2,  AccGenMatNMul,    AccRun_MatNMul,                   AccRef_MatNMul,             16.0 },
+    { "matN mulvec",  "MatNMulVec",                21, 2,  AccGenMatNMulVec, AccRun_MatNMulVec,                AccRef_MatNMulVec,          32.0 },
+    { "bsr3 cg",      "Bsr3SolveCG",               13, 4,  AccGenChain,      AccRun_Bsr3SolveCG,               AccRef_Bsr3SolveCG,         1024.0 },
+    { "random range", "RandomRange",               1,  2,  AccGenRandom1,    AccRun_RandomRange,               AccRef_RandomRange,         0.5 },
+    { "random range", "RandomRangeArray",          1,  2,  AccGenRandom1,    AccRun_RandomRangeArray,          AccRef_RandomRange,         0.5 },
+    { "random vec2",  "RandomUnitVec2Array",       1,  2,  AccGenRandom1,    AccRun_RandomUnitVec2Array,       AccRef_RandomUnitVec2,      8.0 },
+    { "random vec3",  "RandomUnitVec3Array",       2,  3,  AccGenRandom2,    AccRun_RandomUnitVec3Array,       AccRef_RandomUnitVec3,      32.0 },
+    { "random disc",  "RandomDiscArray",           2,  2,  AccGenRandom2,    AccRun_RandomDiscArray,           AccRef_RandomDisc,          8.0 },
+    { "random ball",  "RandomSphereArray",         5,  3,  AccGenRandom5,    AccRun_RandomSphereArray,         AccRef_RandomSphere,        32.0 },
+    { "random hemi",  "RandomHemisphereArray",     5,  3,  AccGenRandom5,    AccRun_RandomHemisphereArray,     AccRef_RandomHemisphere,    32.0 },
+    { "random box",   "RandomBoxArray",            3,  4,  AccGenRandom3,    AccRun_RandomBoxArray,            AccRef_RandomBox,           0.5 },
+    { "anim sample",  "AnimSample",                20, 10, AccGenAnim2,      AccRun_AnimSample,                AccRef_AnimSample,          8.0 },
+    { "anim blend",   "AnimSampleLayers",          30, 10, AccGenAnim3,      AccRun_AnimSampleLayers,          AccRef_AnimSampleLayers,    8.0 },
+    { "anim add",     "AnimSampleLayers",          30, 10, AccGenAnim3,      AccRun_AnimSampleAdditive,        AccRef_AnimSampleAdditive,  16.0 },
+};
+
+/*
+AccMeasure
+
+Ошибка варианта на count элементах, уже посчитанных в acc_out и acc_ref.
+*/
+static void AccMeasure( accerror_t* e, const acccase_t* ac, int count ) {
+    double sum = 0.0;
+    e->max_ulp = 0.0;
+    e->count = 0;
+    e->worst = -1;
+    for( int i = 0; i < count; i++ ) {
+        const double* ref = acc_ref + ( size_t )i * ac->out_dim;
+        const float* out = acc_out + ( size_t )i * ac->out_dim;
+        double scale = 0.0;
+        int finite = 1;
+        for( int k = 0; k < ac->out_dim; k++ ) {
+            finite &= isfinite( ( float )ref[k] );
+            scale = fabs( ref[k] ) > scale ? fabs( ref[k] ) : scale;
+        }
+        if( !finite ) {
+            continue;
+        }
+        double ulp = AccUlp( scale );
+        double err = 0.0;
+        for( int k = 0; k < ac->out_dim; k++ ) {
+            double d = isfinite( out[k] ) ? fabs( out[k] - ref[k] ) / ulp : INFINITY;
+            err = d > err ? d : err;
+        }
+        if( ( e->worst < 0 ) || ( err > e->max_ulp ) ) {
+            e->max_ulp = err;
+            e->worst = i;
+            memcpy( e->worst_in, acc_in + ( size_t )i * ac->in_dim, ac->in_dim * sizeof( float ) );
+        }
+        sum += err;
+        e->count++;
+    }
+    e->mean_ulp = e->count > 0 ? sum / e->count : 0.0;
+}
+
+/*
+AccRun
+
+Ошибка на обоих наборах и лучшее время на элемент плотного набора в наносекундах.
+*/
+static double AccRun( accerror_t* err, const acccase_t* ac ) {
+    double best = 1e30;
+    // свой поток случайных чисел у каждого варианта: входы не зависят от предыдущих вариантов
+    srand( 1 );
+    for( int set = 1; set >= 0; set-- ) {
+        int count = ac->gen( acc_in, ACC_COUNT, set );
+        ac->run( acc_out, acc_in, count );
+        ac->ref( acc_ref, acc_in, count );
+        AccMeasure( &err[set], ac, count );
+    }
+    // после цикла в acc_in лежит плотный набор
+    for( int s = 0; s < ACC_SAMPLES; s++ ) {
+        double t0 = AccNow();
+        ac->run( acc_out, acc_in, ACC_COUNT );
+        double t = ( AccNow() - t0 ) / ACC_COUNT;
+        best = t < best ? t : best;
+    }
+    acc_sink += acc_out[0];
+    return best * 1e9;
+}
+
+int main( int argc, char** argv ) {
+    int num_cases = sizeof( acc_cases ) / sizeof( acc_cases[0] );
+    accerror_t err[sizeof( acc_cases ) / sizeof( acc_cases[0] )][2];
+    double ns[sizeof( acc_cases ) / sizeof( acc_cases[0] )];
+    int failed = 0;
+
+    // бюджеты из командной строки: имя=ulp
+    for( int a = 1; a < argc; a++ ) {
+        const char* eq = strchr( argv[a], '=' );
+        int found = 0;
+        for( int i = 0; ( eq != NULL ) && ( i < num_cases ); i++ ) {
+            if( ( strlen( acc_cases[i].name ) == ( size_t )( eq - argv[a] ) ) &&
+                ( strncmp( acc_cases[i].name, argv[a], eq - argv[a] ) == 0 ) ) {
+                acc_cases[i].budget = atof( eq + 1 );
+                found = 1;
+            }
+        }
+        if( !found ) {
+            fprintf( stderr, "unknown budget '%s', expected variant=ulp\n", argv[a] );
+            return 2;
+        }
+    }
+
+    MathInit();
+    for( int i = 0; i < num_cases; i++ ) {
+        ns[i] = AccRun( err[i], &acc_cases[i] );
+    }
+
+    printf( "%-12s %-26s %11s %11s %11s %10s %9s %7s\n",
+            "function", "variant", "dense max", "dense mean", "adv max", "ns/elem", "budget", "pareto" );
+    for( int i = 0; i < num_cases; i++ ) {
+        const acccase_t* ac = &acc_cases[i];
+        double worst = err[i][0].max_ulp > err[i][1].max_ulp ? err[i][0].max_ulp : err[i][1].max_ulp;
+
+        // вариант на границе Парето, если никакой другой вариант функции
+        // не быстрее и не точнее одновременно
+        int pareto = 1;
+        for( int j = 0; j < num_cases; j++ ) {
+            if( ( j == i ) || ( strcmp( acc_cases[j].group, ac->group ) != 0 ) ) {
+                continue;
+            }
+            double wj = err[j][0].max_ulp > err[j][1].max_ulp ? err[j][0].max_ulp : err[j][1].max_ulp;
+            if( ( ns[j] <= ns[i] ) && ( wj <= worst ) && ( ( ns[j] < ns[i] ) || ( wj < worst ) ) ) {
+                pareto = 0;
+            }
+        }
+        int over = !( worst <= ac->budget );
+        failed += over;
+        printf( "%-12s %-26s %11.3g %11.3g %11.3g %10.2f %9.3g %7s%s\n", ac->group, ac->name,
+                err[i][0].max_ulp, err[i][0].mean_ulp, err[i][1].max_ulp, ns[i], ac->budget,
+                pareto ? "*" : "", over ? "   OVER BUDGET" : "" );
+        if( over ) {
+            // вход с наибольшей ошибкой, чтобы случай можно было воспроизвести
+            const accerror_t* e = &err[i][err[i][1].max_ulp > err[i][0].max_ulp];
+            printf( "%39s", "worst input:" );
+            for( int k = 0; k < ac->in_dim; k++ ) {
+                printf( " %.9g", e->worst_in[k] );
+            }
+            printf( "\n" );
+        }
+    }
+
+    MathRelease();
+    if( failed > 0 ) {
+        printf( "\n%d variant(s) over error budget\n", failed );
+        return 1;
+    }
+    return 0;
+}
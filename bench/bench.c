@@ -0,0 +1,1325 @@
+// Compile: gcc -O2 math/math_base.c math/vector.c math/matrix.c math/broadphase.c math/transform.c math/camera.c math/matn.c math/sparse.c math/lu.c math/svd.c math/spline.c math/anim.c math/noise.c math/random.c math/probe.c math/metrics.c math/arena.c math/pool.c math/jobgraph.c math/xformstore.c math/quant.c bench/bench.c -pthread -o bench_run
+// Для AVX добавить -mavx.
+// В Linux рядом со временем выводятся аппаратные счётчики на элемент (perf_event_open,
+// сумма по всем потокам, включая пул), если их разрешает kernel.perf_event_paranoid.
+// Событие векторных FP-операций берётся для процессоров Intel или из переменной
+// окружения BENCH_PERF_FP_VEC (raw-код в hex).
+// Запуск: bench_run [--save файл] [--compare файл] [--threshold процент]
+// --save записывает замеры в файл базовой линии, --compare сравнивает с ним текущий запуск
+// и возвращает код 1, если какой-либо вариант значимо медленнее (по умолчанию на 5% и больше).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined( __linux__ )
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <cpuid.h>
+#endif
+#endif
+
+#include "../math.h"
+
+#define BENCH_COUNT     4096    // элементов в одном проходе
+#define BENCH_SAMPLES   9       // замеров, берётся лучший
+#define BENCH_PASSES    200     // проходов в одном замере
+#define BENCH_BONES     64      // костей в клипе анимации
+#define BENCH_KEYS      64      // ключей в клипе анимации
+#define BENCH_MAP       4096    // сторона карты высот для шума
+#define BENCH_NODES     65536   // узлов иерархии в конвейере кадра
+#define BENCH_NODE_VERTS 8      // вершин на узел (углы ограничивающего куба)
+#define BENCH_STORE_DIRTY 16    // изменённых диапазонов по 32 матрицы за кадр в хранилище
+#define BENCH_SAP_BODIES 4096   // тел в sweep-and-prune
+#define BENCH_SAP_MOVED 256     // тел, сдвигающихся за кадр
+
+#define BENCH_BASELINE_MAGIC    "math-bench-baseline"
+#define BENCH_BASELINE_VERSION  1
+#define BENCH_ALPHA             0.01    // уровень значимости сравнения с базовой линией
+
+// ключ кости в раскладке "массив структур" - точка отсчёта для animclip_t
+typedef struct {
+    vec3_t          t;
+    vec4_t          r;
+    vec3_t          s;
+} benchkey_t;
+
+// аппаратные счётчики, снимаемые вокруг замера
+typedef enum {
+    BENCH_PERF_CYCLES = 0,
+    BENCH_PERF_INSTR,
+    BENCH_PERF_L1_MISS,         // промахи чтения L1 данных
+    BENCH_PERF_LLC_MISS,
+    BENCH_PERF_BRANCH_MISS,
+    BENCH_PERF_FP_VEC,          // упакованные FP-инструкции SSE/AVX
+    BENCH_PERF_COUNT
+} benchperf_t;
+
+// один замеряемый вариант ядра
+typedef struct {
+    const char*     group;      // варианты одной группы сравниваются между собой
+    const char*     name;
+    void            (*run)( int count );
+} benchcase_t;
+
+static vec3_t   bench_v3a[BENCH_COUNT];
+static vec3_t   bench_v3b[BENCH_COUNT];
+static vec3_t   bench_v3out[BENCH_COUNT];
+static vec4_t   bench_v4a[BENCH_COUNT];
+static vec4_t   bench_v4out[BENCH_COUNT];
+static mat4_t   bench_m4a[BENCH_COUNT];
+static mat4_t   bench_m4out[BENCH_COUNT];
+static mat4_t   bench_m4;
+static mat3_t   bench_m3a[BENCH_COUNT];
+static mat3_t   bench_m3out[BENCH_COUNT];
+static svd3_t   bench_svd[BENCH_COUNT];
+static cubic_t  bench_spline[8];
+static float    bench_u[BENCH_COUNT];
+static animclip_t   bench_clip;
+static animpose_t   bench_pose;
+static animcursor_t bench_cursor;
+static benchkey_t   bench_keys[BENCH_BONES][BENCH_KEYS];
+static float        bench_key_times[BENCH_KEYS];
+static benchkey_t   bench_bones[BENCH_BONES];
+static float        bench_time;
+static random_t     bench_rng;
+
+static volatile float bench_sink;
+
+static int      bench_perf_fd[BENCH_PERF_COUNT];    // -1 - счётчик недоступен
+static int      bench_perf_any;
+
+/*
+BenchNow
+
+Текущее время в секундах от произвольной точки отсчёта.
+*/
+static double BenchNow( void ) {
+#if defined( _WIN32 )
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &counter );
+    return ( double )counter.QuadPart / ( double )freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+static float BenchRand( void ) {
+    return ( float )rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+/*
+BenchPerfOpen
+
+Открытие аппаратных счётчиков процесса. Счётчики наследуются потоками,
+созданными после открытия, и при чтении суммируются по ним, поэтому
+функция вызывается до MathInit - иначе работа потоков пула не попала бы
+в замер. Счётчики открываются по одному, а не группой (PERF_FORMAT_GROUP
+несовместим с наследованием), чтобы отсутствие одного события
+не отключало остальные.
+*/
+static void BenchPerfOpen( void ) {
+    for( int i = 0; i < BENCH_PERF_COUNT; i++ ) {
+        bench_perf_fd[i] = -1;
+    }
+#if defined( __linux__ )
+    static const struct {
+        uint32_t    type;
+        uint64_t    config;
+    } events[BENCH_PERF_COUNT] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) |
+                              ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 ) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_RAW, 0 },
+    };
+    uint64_t fp_vec = 0;
+    const char* env = getenv( "BENCH_PERF_FP_VEC" );
+    if( env != NULL ) {
+        fp_vec = strtoull( env, NULL, 16 );
+    }
+#if defined( __x86_64__ ) || defined( __i386__ )
+    else {
+        unsigned int a, b, c, d;
+        // FP_ARITH_INST_RETIRED, все упакованные варианты 128 и 256 бит (Intel начиная с Broadwell)
+        if( __get_cpuid( 0, &a, &b, &c, &d ) && ( b == 0x756e6547 ) && ( d == 0x49656e69 ) && ( c == 0x6c65746e ) ) {
+            fp_vec = 0x3cc7;
+        }
+    }
+#endif
+    for( int i = 0; i < BENCH_PERF_COUNT; i++ ) {
+        struct perf_event_attr attr;
+        if( ( i == BENCH_PERF_FP_VEC ) && ( fp_vec == 0 ) ) {
+            continue;
+        }
+        memset( &attr, 0, sizeof( attr ) );
+        attr.size = sizeof( attr );
+        attr.type = events[i].type;
+        attr.config = i == BENCH_PERF_FP_VEC ? fp_vec : events[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        bench_perf_fd[i] = ( int )syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 );
+        bench_perf_any |= bench_perf_fd[i] >= 0;
+    }
+#endif
+}
+
+static void BenchPerfClose( void ) {
+#if defined( __linux__ )
+    for( int i = 0; i < BENCH_PERF_COUNT; i++ ) {
+        if( bench_perf_fd[i] >= 0 ) {
+            close( bench_perf_fd[i] );
+        }
+    }
+#endif
+}
+
+static void BenchPerfBegin( void ) {
+#if defined( __linux__ )
+    for( int i = 0; i < BENCH_PERF_COUNT; i++ ) {
+        if( bench_perf_fd[i] >= 0 ) {
+            ioctl( bench_perf_fd[i], PERF_EVENT_IOC_RESET, 0 );
+            ioctl( bench_perf_fd[i], PERF_EVENT_IOC_ENABLE, 0 );
+        }
+    }
+#endif
+}
+
+/*
+BenchPerfEnd
+
+Остановка счётчиков и запись их значений в out, -1 для недоступных.
+Если ядро делило счётчик с другими событиями, значение экстраполируется
+на всё время замера.
+*/
+static void BenchPerfEnd( double* out ) {
+    for( int i = 0; i < BENCH_PERF_COUNT; i++ ) {
+        out[i] = -1.0;
+    }
+#if defined( __linux__ )
+    for( int i = 0; i < BENCH_PERF_COUNT; i++ ) {
+        if( bench_perf_fd[i] >= 0 ) {
+            ioctl( bench_perf_fd[i], PERF_EVENT_IOC_DISABLE, 0 );
+        }
+    }
+    for( int i = 0; i < BENCH_PERF_COUNT; i++ ) {
+        uint64_t v[3];  // значение, время включения, время работы
+        if( ( bench_perf_fd[i] < 0 ) || ( read( bench_perf_fd[i], v, sizeof( v ) ) != sizeof( v ) ) || ( v[2] == 0 ) ) {
+            continue;
+        }
+        out[i] = ( double )v[0] * ( ( double )v[1] / v[2] );
+    }
+#endif
+}
+
+// значение счётчика или прочерк, если счётчик недоступен
+static void BenchPrintPerf( double v, int width ) {
+    if( v < 0.0 ) {
+        printf( " %*s", width, "-" );
+    }
+    else {
+        printf( " %*.3f", width, v );
+    }
+}
+
+/*
+BenchFill
+
+Заполнение входных массивов случайными значениями.
+*/
+static void BenchFill( void ) {
+    srand( 1 );
+    for( int i = 0; i < BENCH_COUNT; i++ ) {
+        Vec3Set( &bench_v3a[i], BenchRand(), BenchRand(), BenchRand() );
+        Vec3Set( &bench_v3b[i], BenchRand(), BenchRand(), BenchRand() );
+        Vec4Set( &bench_v4a[i], BenchRand(), BenchRand(), BenchRand(), 1.0f );
+        for( int k = 0; k < 16; k++ ) {
+            bench_m4a[i].m[k] = BenchRand();
+        }
+        for( int k = 0; k < 9; k++ ) {
+            bench_m3a[i].m[k] = BenchRand();
+        }
+    }
+    for( int k = 0; k < 16; k++ ) {
+        bench_m4.m[k] = BenchRand();
+    }
+    Spline3CatmullRomPath( bench_spline, bench_v3a, 11 );
+    for( int i = 0; i < BENCH_COUNT; i++ ) {
+        bench_u[i] = 8.0f * i / BENCH_COUNT;
+    }
+
+    RandomInit( &bench_rng, 1, 0 );
+
+    AnimClipInit( &bench_clip, BENCH_BONES, BENCH_KEYS );
+    AnimPoseInit( &bench_pose, BENCH_BONES );
+    AnimCursorReset( &bench_cursor );
+    for( int k = 0; k < BENCH_KEYS; k++ ) {
+        bench_key_times[k] = bench_clip.times[k] = k / 30.0f;
+        for( int b = 0; b < BENCH_BONES; b++ ) {
+            benchkey_t* key = &bench_keys[b][k];
+            Vec3Set( &key->t, BenchRand(), BenchRand(), BenchRand() );
+            Vec4Set( &key->r, BenchRand(), BenchRand(), BenchRand(), BenchRand() );
+            Vec4Norm( &key->r );
+            Vec3Set( &key->s, 1.0f, 1.0f, 1.0f );
+            for( int c = 0; c < 3; c++ ) {
+                AnimClipChannel( &bench_clip, k, ANIM_TX + c )[b] = key->t.m[c];
+                AnimClipChannel( &bench_clip, k, ANIM_SX + c )[b] = key->s.m[c];
+            }
+            for( int c = 0; c < 4; c++ ) {
+                AnimClipChannel( &bench_clip, k, ANIM_RX + c )[b] = key->r.m[c];
+            }
+        }
+    }
+}
+
+
+
+/* out = a * s + b */
+
+static void BenchMaddPtr( int count ) {
+    for( int i = 0; i < count; i++ ) {
+        vec3_t t;
+        Vec3Cpy( &t, &bench_v3a[i] );
+        Vec3Scale1f( &t, 0.5f );
+        Vec3Add( &bench_v3out[i], &t, &bench_v3b[i] );
+    }
+}
+
+static void BenchMaddVal( int count ) {
+    for( int i = 0; i < count; i++ ) {
+        bench_v3out[i] = Vec3AddVal( Vec3Scale1fVal( bench_v3a[i], 0.5f ), bench_v3b[i] );
+    }
+}
+
+
+
+/* out[i] = M * v[i] */
+
+static void BenchMulVec4Ptr( int count ) {
+    for( int i = 0; i < count; i++ ) {
+        Mat4MulVec4( &bench_v4out[i], &bench_m4, &bench_v4a[i] );
+    }
+}
+
+static void BenchMulVec4Restrict( int count ) {
+    for( int i = 0; i < count; i++ ) {
+        Mat4MulVec4R( &bench_v4out[i], &bench_m4, &bench_v4a[i] );
+    }
+}
+
+static void BenchMulVec4Val( int count ) {
+    for( int i = 0; i < count; i++ ) {
+        bench_v4out[i] = Mat4MulVec4Val( &bench_m4, bench_v4a[i] );
+    }
+}
+
+
+
+/* out[i] = M * A[i] */
+
+static void BenchMat4MulPtr( int count ) {
+    for( int i = 0; i < count; i++ ) {
+        Mat4Mul( &bench_m4out[i], &bench_m4, &bench_m4a[i] );
+    }
+}
+
+static void BenchMat4MulRestrict( int count ) {
+    for( int i = 0; i < count; i++ ) {
+        Mat4MulR( &bench_m4out[i], &bench_m4, &bench_m4a[i] );
+    }
+}
+
+
+
+/* SVD и полярное разложение mat3 */
+
+static void BenchSvdSingle( int count ) {
+    for( int i = 0; i < count; i++ ) {
+        Mat3Svd( &bench_svd[i], &bench_m3a[i] );
+    }
+}
+
+static void BenchSvdArray( int count ) {
+    Mat3SvdArray( bench_svd, bench_m3a, count );
+}
+
+static void BenchPolarSingle( int count ) {
+    for( int i = 0; i < count; i++ ) {
+        Mat3Polar( &bench_m3out[i], NULL, &bench_m3a[i] );
+    }
+}
+
+static void BenchPolarArray( int count ) {
+    Mat3PolarArray( bench_m3out, NULL, bench_m3a, count );
+}
+
+
+
+/* равномерная выборка точек сплайна из 8 сегментов */
+
+static void BenchSplineEval( int count ) {
+    Spline3EvalArray( bench_v3out, bench_spline, 8, bench_u, count );
+}
+
+static void BenchSplineForwardDiff( int count ) {
+    Spline3Tessellate( bench_v3out, bench_spline, 8, ( count - 1 ) / 8 );
+}
+
+
+
+/* выборка клипа анимации: время растёт, count - количество костей */
+
+static float BenchAnimTime( void ) {
+    bench_time += 1.0f / 240.0f;
+    if( bench_time > bench_key_times[BENCH_KEYS - 1] ) {
+        bench_time = 0.0f;
+    }
+    return bench_time;
+}
+
+static void BenchAnimPerBone( int count ) {
+    for( int p = 0; p < count / BENCH_BONES; p++ ) {
+        float time = BenchAnimTime();
+        for( int b = 0; b < BENCH_BONES; b++ ) {
+            // двоичный поиск ключа отдельно для каждой кости
+            int lo = 0;
+            int hi = BENCH_KEYS - 1;
+            while( hi - lo > 1 ) {
+                int mid = ( lo + hi ) / 2;
+                if( bench_key_times[mid] <= time ) {
+                    lo = mid;
+                }
+                else {
+                    hi = mid;
+                }
+            }
+            float f = ( time - bench_key_times[lo] ) / ( bench_key_times[lo + 1] - bench_key_times[lo] );
+            const benchkey_t* a = &bench_keys[b][lo];
+            const benchkey_t* c = &bench_keys[b][lo + 1];
+            Vec3Lerp( &bench_bones[b].t, &a->t, &c->t, f );
+            Vec4Lerp( &bench_bones[b].r, &a->r, &c->r, f );
+            Vec4Norm( &bench_bones[b].r );
+            Vec3Lerp( &bench_bones[b].s, &a->s, &c->s, f );
+        }
+    }
+}
+
+static void BenchAnimSoa( int count ) {
+    for( int p = 0; p < count / BENCH_BONES; p++ ) {
+        AnimSample( &bench_pose, &bench_clip, &bench_cursor, BenchAnimTime() );
+    }
+}
+
+
+
+/* случайные единичные векторы */
+
+static void BenchUnitRand( int count ) {
+    for( int i = 0; i < count; i++ ) {
+        Vec3Set( &bench_v3out[i], BenchRand(), BenchRand(), BenchRand() );
+        Vec3Norm( &bench_v3out[i] );
+    }
+}
+
+static void BenchUnitXoshiro( int count ) {
+    RandomUnitVec3Array( &bench_rng, bench_v3out, count );
+}
+
+
+
+static const benchcase_t bench_cases[] = {
+    { "vec3 madd",      "pointer",      BenchMaddPtr },
+    { "vec3 madd",      "value",        BenchMaddVal },
+    { "mat4 * vec4",    "pointer",      BenchMulVec4Ptr },
+    { "mat4 * vec4",    "restrict",     BenchMulVec4Restrict },
+    { "mat4 * vec4",    "value",        BenchMulVec4Val },
+    { "mat4 * mat4",    "pointer",      BenchMat4MulPtr },
+    { "mat4 * mat4",    "restrict",     BenchMat4MulRestrict },
+    { "mat3 svd",       "single",       BenchSvdSingle },
+    { "mat3 svd",       "array",        BenchSvdArray },
+    { "mat3 polar",     "single",       BenchPolarSingle },
+    { "mat3 polar",     "array",        BenchPolarArray },
+    { "spline3 sample", "eval",         BenchSplineEval },
+    { "spline3 sample", "fwd diff",     BenchSplineForwardDiff },
+    { "anim sample",    "per bone",     BenchAnimPerBone },
+    { "anim sample",    "soa",          BenchAnimSoa },
+    { "random unit3",   "rand+norm",    BenchUnitRand },
+    { "random unit3",   "xoshiro",      BenchUnitXoshiro },
+};
+
+/*
+BenchMatNNaive
+
+Умножение матриц тройным циклом без блоков - точка отсчёта для MatNMul.
+*/
+static void BenchMatNNaive( matN_t* out, const matN_t* a, const matN_t* b ) {
+    for( int i = 0; i < a->rows; i++ ) {
+        for( int j = 0; j < b->cols; j++ ) {
+            float s = 0.0f;
+            for( int k = 0; k < a->cols; k++ ) {
+                s += MatNGet( a, i, k ) * MatNGet( b, k, j );
+            }
+            MatNSet( out, i, j, s );
+        }
+    }
+}
+
+/*
+BenchMatN
+
+Сравнение MatNMul с тройным циклом в GFLOP/s для матриц n x n.
+*/
+static void BenchMatN( int n ) {
+    matN_t a, b, c;
+    if( !MatNInit( &a, n, n ) || !MatNInit( &b, n, n ) || !MatNInit( &c, n, n ) ) {
+        printf( "matN %d: out of memory\n", n );
+        return;
+    }
+    for( int i = 0; i < n; i++ ) {
+        for( int j = 0; j < n; j++ ) {
+            MatNSet( &a, i, j, BenchRand() );
+            MatNSet( &b, i, j, BenchRand() );
+        }
+    }
+
+    double flops = 2.0 * n * n * n;
+    double naive = 1e30;
+    double tiled = 1e30;
+    for( int s = 0; s < 3; s++ ) {
+        double t0 = BenchNow();
+        BenchMatNNaive( &c, &a, &b );
+        double t1 = BenchNow();
+        MatNMul( &c, &a, &b );
+        double t2 = BenchNow();
+        naive = t1 - t0 < naive ? t1 - t0 : naive;
+        tiled = t2 - t1 < tiled ? t2 - t1 : tiled;
+    }
+    bench_sink += MatNGet( &c, 0, 0 );
+
+    printf( "matN %4d      naive %8.2f GFLOP/s   tiled %8.2f GFLOP/s %9.2fx\n",
+            n, flops / naive * 1e-9, flops / tiled * 1e-9, naive / tiled );
+
+    MatNRelease( &a );
+    MatNRelease( &b );
+    MatNRelease( &c );
+}
+
+/*
+BenchSvdAccuracy
+
+Наибольшая ошибка восстановления |U * S * V^T - A| относительно max|A|
+и отклонение U^T * U от единичной по всем входным матрицам.
+*/
+static void BenchSvdAccuracy( void ) {
+    float recon = 0.0f;
+    float ortho = 0.0f;
+
+    Mat3SvdArray( bench_svd, bench_m3a, BENCH_COUNT );
+    for( int i = 0; i < BENCH_COUNT; i++ ) {
+        const svd3_t* d = &bench_svd[i];
+        float scale = 0.0f;
+        for( int k = 0; k < 9; k++ ) {
+            scale = max2f( scale, abs1f( bench_m3a[i].m[k] ) );
+        }
+        for( int r = 0; r < 3; r++ ) {
+            for( int c = 0; c < 3; c++ ) {
+                float a = 0.0f;
+                float e = 0.0f;
+                for( int k = 0; k < 3; k++ ) {
+                    a += d->u.m[r * 3 + k] * d->s.m[k] * d->v.m[c * 3 + k];
+                    e += d->u.m[k * 3 + r] * d->u.m[k * 3 + c];
+                }
+                recon = max2f( recon, abs1f( a - bench_m3a[i].m[r * 3 + c] ) / scale );
+                ortho = max2f( ortho, abs1f( e - ( r == c ? 1.0f : 0.0f ) ) );
+            }
+        }
+    }
+    printf( "mat3 svd       max recon error %.3g   max orthogonality error %.3g\n", recon, ortho );
+}
+
+/*
+BenchNoiseFill
+
+Заполнение карты высот BENCH_MAP x BENCH_MAP построчно: kind 0..1 - шум Перлина
+и симплексный по одной точке, 2..3 - они же пакетами по строке, 4 - fBm из 4 октав.
+Возвращает время в секундах.
+*/
+static double BenchNoiseFill( float* map, float* xs, float* ys, int kind ) {
+    const float freq = 1.0f / 64.0f;
+    fbm_t fbm = { NOISE_SIMPLEX, 4, 1.0f, 2.0f, 0.5f };
+    double t0 = BenchNow();
+    for( int y = 0; y < BENCH_MAP; y++ ) {
+        float* row = map + ( size_t )y * BENCH_MAP;
+        if( kind < 2 ) {
+            for( int x = 0; x < BENCH_MAP; x++ ) {
+                vec2_t p;
+                Vec2Set( &p, xs[x], y * freq );
+                row[x] = kind == 0 ? NoisePerlin2( &p ) : NoiseSimplex2( &p );
+            }
+            continue;
+        }
+        for( int x = 0; x < BENCH_MAP; x++ ) {
+            ys[x] = y * freq;
+        }
+        if( kind == 2 ) {
+            NoisePerlin2Array( row, xs, ys, BENCH_MAP );
+        }
+        else if( kind == 3 ) {
+            NoiseSimplex2Array( row, xs, ys, BENCH_MAP );
+        }
+        else {
+            NoiseFbm2Array( row, &fbm, xs, ys, BENCH_MAP );
+        }
+    }
+    return BenchNow() - t0;
+}
+
+/*
+BenchNoise
+
+Скорость заполнения карты высот 4K шумом в миллионах точек в секунду.
+*/
+static void BenchNoise( void ) {
+    static const char* names[] = { "perlin2 single", "simplex2 single", "perlin2 array", "simplex2 array", "fbm2 x4 array" };
+    float* map = malloc( ( size_t )BENCH_MAP * BENCH_MAP * sizeof( float ) );
+    float* xs = malloc( BENCH_MAP * sizeof( float ) );
+    float* ys = malloc( BENCH_MAP * sizeof( float ) );
+    if( ( map == NULL ) || ( xs == NULL ) || ( ys == NULL ) ) {
+        printf( "noise: out of memory\n" );
+        free( map );
+        free( xs );
+        free( ys );
+        return;
+    }
+    for( int x = 0; x < BENCH_MAP; x++ ) {
+        xs[x] = x / 64.0f;
+    }
+    for( int k = 0; k < 5; k++ ) {
+        double t = BenchNoiseFill( map, xs, ys, k );
+        printf( "noise %-16s %8.1f Msamples/s\n", names[k], ( double )BENCH_MAP * BENCH_MAP / t * 1e-6 );
+        bench_sink += map[( size_t )BENCH_MAP * BENCH_MAP / 2 + 7];
+    }
+    free( map );
+    free( xs );
+    free( ys );
+}
+
+// данные конвейера кадра: иерархия, отсечение, преобразование вершин
+typedef struct {
+    mat4_t*         local;
+    mat4_t*         world;
+    int*            parent;
+    unsigned char*  visible;
+    vec3_t*         verts;      // BENCH_NODE_VERTS вершин на узел
+    vec4_t          planes[6];  // плоскости пирамиды видимости, нормали внутрь
+} benchframe_t;
+
+static void BenchFrameWorld( void* ctx, int begin, int end ) {
+    benchframe_t* f = ctx;
+    Mat4WorldRange( f->world, f->local, f->parent, begin, end );
+}
+
+// сфера радиуса 1 вокруг начала координат узла против плоскостей пирамиды
+static void BenchFrameCull( void* ctx, int begin, int end ) {
+    benchframe_t* f = ctx;
+    for( int i = begin; i < end; i++ ) {
+        const float* m = f->world[i].m;
+        unsigned char vis = 1;
+        for( int p = 0; p < 6; p++ ) {
+            const vec4_t* pl = &f->planes[p];
+            vis &= pl->x * m[3] + pl->y * m[7] + pl->z * m[11] + pl->w > -1.0f;
+        }
+        f->visible[i] = vis;
+    }
+}
+
+static void BenchFrameVerts( void* ctx, int begin, int end ) {
+    benchframe_t* f = ctx;
+    for( int i = begin; i < end; i++ ) {
+        if( !f->visible[i] ) {
+            continue;
+        }
+        for( int k = 0; k < BENCH_NODE_VERTS; k++ ) {
+            vec3_t v;
+            Vec3Set( &v, k & 1 ? 0.5f : -0.5f, k & 2 ? 0.5f : -0.5f, k & 4 ? 0.5f : -0.5f );
+            Mat4MulVec3( &f->verts[i * BENCH_NODE_VERTS + k], &f->world[i], &v );
+        }
+    }
+}
+
+/*
+BenchFrameGraph
+
+Те же этапы графом заданий: чанк мировых матриц ждёт только чанки
+с родителями, отсечение и вершины чанка - только свой чанк предыдущего этапа.
+*/
+static mbool_t BenchFrameGraph( benchframe_t* f, int chunk ) {
+    arena_t* arena = ArenaFrame();
+    arenamark_t mark = ArenaMark( arena );
+    int chunks = ( BENCH_NODES + chunk - 1 ) / chunk;
+    jobgraph_t g;
+    mbool_t ok = JobGraphInit( &g, arena, 3 * chunks, 64 * chunks );
+    int world = JobGraphStage( &g, BenchFrameWorld, f, BENCH_NODES, chunk );
+    int cull = JobGraphStage( &g, BenchFrameCull, f, BENCH_NODES, chunk );
+    int verts = JobGraphStage( &g, BenchFrameVerts, f, BENCH_NODES, chunk );
+    JobGraphDependIndex( &g, world, world, f->parent );
+    JobGraphDepend( &g, cull, world, JOB_DEP_CHUNK );
+    JobGraphDepend( &g, verts, cull, JOB_DEP_CHUNK );
+    ok = ok && JobGraphRun( &g );
+    ArenaReset( arena, mark );
+    return ok;
+}
+
+/*
+BenchFrame
+
+Конвейер кадра из трёх этапов: последовательными фазами с барьерами
+(иерархия в одном потоке, остальное PoolParallelFor) и графом заданий.
+*/
+static void BenchFrame( void ) {
+    benchframe_t f;
+    f.local = malloc( BENCH_NODES * sizeof( mat4_t ) );
+    f.world = malloc( BENCH_NODES * sizeof( mat4_t ) );
+    f.parent = malloc( BENCH_NODES * sizeof( int ) );
+    f.visible = malloc( BENCH_NODES );
+    f.verts = malloc( ( size_t )BENCH_NODES * BENCH_NODE_VERTS * sizeof( vec3_t ) );
+    vec3_t* check = malloc( ( size_t )BENCH_NODES * BENCH_NODE_VERTS * sizeof( vec3_t ) );
+    if( ( f.local == NULL ) || ( f.world == NULL ) || ( f.parent == NULL ) || ( f.visible == NULL ) ||
+        ( f.verts == NULL ) || ( check == NULL ) ) {
+        printf( "frame: out of memory\n" );
+        free( f.local );
+        free( f.world );
+        free( f.parent );
+        free( f.visible );
+        free( f.verts );
+        free( check );
+        return;
+    }
+
+    // лес из 64 корней, родитель каждого узла среди 64 предыдущих
+    for( int i = 0; i < BENCH_NODES; i++ ) {
+        vec3_t axis;
+        xform_t r;
+        Vec3Set( &axis, BenchRand(), BenchRand(), 1.0f );
+        XformRotate( &r, &axis, BenchRand() * 0.3f );
+        f.local[i] = r.m;
+        f.local[i].m[3] = BenchRand() * 2.0f;
+        f.local[i].m[7] = BenchRand() * 2.0f;
+        f.local[i].m[11] = BenchRand() * 2.0f;
+        f.parent[i] = i < 64 ? -1 : i - 1 - rand() % 64;
+    }
+
+    // плоскости из строк матрицы proj * view (глубина в [0, 1])
+    perspective_t persp = { 1.0f, 16.0f / 9.0f, 0.1f, 500.0f, 0 };
+    lookat_t look;
+    mat4_t proj, view, vp;
+    Vec3Set( &look.eye, 0.0f, 0.0f, 60.0f );
+    Vec3Zero( &look.target );
+    Vec3Set( &look.up, 0.0f, 1.0f, 0.0f );
+    CameraPerspective( &proj, NULL, &persp );
+    CameraLookAt( &view, NULL, &look );
+    Mat4Mul( &vp, &proj, &view );
+    for( int p = 0; p < 6; p++ ) {
+        int row = p / 2;
+        float sign = p & 1 ? -1.0f : 1.0f;
+        vec4_t* pl = &f.planes[p];
+        if( p == 4 ) {
+            Vec4Set( pl, vp.m[8], vp.m[9], vp.m[10], vp.m[11] );
+        }
+        else {
+            Vec4Set( pl, vp.m[12] + sign * vp.m[row * 4], vp.m[13] + sign * vp.m[row * 4 + 1],
+                     vp.m[14] + sign * vp.m[row * 4 + 2], vp.m[15] + sign * vp.m[row * 4 + 3] );
+        }
+        float len = sqrt1f( pl->x * pl->x + pl->y * pl->y + pl->z * pl->z );
+        Vec4Set( pl, pl->x / len, pl->y / len, pl->z / len, pl->w / len );
+    }
+
+    int chunk = PoolChunk( sizeof( mat4_t ) + BENCH_NODE_VERTS * sizeof( vec3_t ) );
+    double phased = 1e30;
+    double graph = 1e30;
+    mbool_t ok = mtrue;
+    for( int s = 0; s < 5; s++ ) {
+        memset( f.verts, 0, ( size_t )BENCH_NODES * BENCH_NODE_VERTS * sizeof( vec3_t ) );
+        double t0 = BenchNow();
+        BenchFrameWorld( &f, 0, BENCH_NODES );
+        PoolParallelFor( BenchFrameCull, &f, BENCH_NODES, chunk );
+        PoolParallelFor( BenchFrameVerts, &f, BENCH_NODES, chunk );
+        double t1 = BenchNow();
+        memcpy( check, f.verts, ( size_t )BENCH_NODES * BENCH_NODE_VERTS * sizeof( vec3_t ) );
+
+        memset( f.verts, 0, ( size_t )BENCH_NODES * BENCH_NODE_VERTS * sizeof( vec3_t ) );
+        double t2 = BenchNow();
+        ok = ok && BenchFrameGraph( &f, chunk );
+        double t3 = BenchNow();
+        ok = ok && ( memcmp( check, f.verts, ( size_t )BENCH_NODES * BENCH_NODE_VERTS * sizeof( vec3_t ) ) == 0 );
+
+        phased = t1 - t0 < phased ? t1 - t0 : phased;
+        graph = t3 - t2 < graph ? t3 - t2 : graph;
+    }
+    int visible = 0;
+    for( int i = 0; i < BENCH_NODES; i++ ) {
+        visible += f.visible[i];
+    }
+    printf( "frame %d nodes (%d visible, %d threads)   phased %7.3f ms   graph %7.3f ms %9.2fx%s\n",
+            BENCH_NODES, visible, PoolNumThreads(), phased * 1e3, graph * 1e3, phased / graph,
+            ok ? "" : "   MISMATCH" );
+
+    free( f.local );
+    free( f.world );
+    free( f.parent );
+    free( f.visible );
+    free( f.verts );
+    free( check );
+}
+
+/*
+BenchSap
+
+Sweep-and-prune на BENCH_SAP_BODIES телах, из которых за кадр сдвигаются
+BENCH_SAP_MOVED, часть тел удаляется и добавляется заново. Время SapUpdate
+на кадр против перебора всех пар через AabbOverlap; после каждого кадра
+множество пар сверяется с перебором.
+*/
+static void BenchSap( void ) {
+    sap_t sap;
+    aabb_t* boxes = malloc( BENCH_SAP_BODIES * sizeof( aabb_t ) );
+    int* ids = malloc( BENCH_SAP_BODIES * sizeof( int ) );
+    if( ( boxes == NULL ) || ( ids == NULL ) || !SapInit( &sap, BENCH_SAP_BODIES ) ) {
+        printf( "sap: out of memory\n" );
+        free( boxes );
+        free( ids );
+        return;
+    }
+
+    // кубы со стороной до 1 в кубе со стороной 40
+    for( int i = 0; i < BENCH_SAP_BODIES; i++ ) {
+        float e = 0.5f + BenchRand() * 0.5f;
+        Vec3Set( &boxes[i].min, BenchRand() * 20.0f, BenchRand() * 20.0f, BenchRand() * 20.0f );
+        Vec3Set( &boxes[i].max, boxes[i].min.x + e, boxes[i].min.y + e, boxes[i].min.z + e );
+        ids[i] = SapAddBody( &sap, &boxes[i] );
+    }
+    mbool_t ok = SapUpdate( &sap );
+
+    int frames = 100;
+    int pairs = 0;
+    double t_sap = 0.0;
+    double t_brute = 0.0;
+    for( int f = 0; f < frames; f++ ) {
+        for( int m = 0; m < BENCH_SAP_MOVED; m++ ) {
+            int i = rand() % BENCH_SAP_BODIES;
+            vec3_t d;
+            Vec3Set( &d, BenchRand() * 0.1f, BenchRand() * 0.1f, BenchRand() * 0.1f );
+            Vec3Add( &boxes[i].min, &boxes[i].min, &d );
+            Vec3Add( &boxes[i].max, &boxes[i].max, &d );
+            if( m % 32 == 0 ) {
+                SapRemoveBody( &sap, ids[i] );
+                ids[i] = SapAddBody( &sap, &boxes[i] );
+            }
+            else {
+                SapSetBody( &sap, ids[i], &boxes[i] );
+            }
+        }
+        double t0 = BenchNow();
+        ok = ok && SapUpdate( &sap );
+        double t1 = BenchNow();
+        int count = 0;
+        for( int a = 0; a < BENCH_SAP_BODIES; a++ ) {
+            for( int b = a + 1; b < BENCH_SAP_BODIES; b++ ) {
+                count += AabbOverlap( &boxes[a], &boxes[b] );
+            }
+        }
+        double t2 = BenchNow();
+        t_sap += t1 - t0;
+        t_brute += t2 - t1;
+
+        // количество пар совпадает с перебором, и каждая пара действительно пересекается
+        const sappair_t* p = SapPairs( &sap );
+        ok = ok && ( count == SapNumPairs( &sap ) );
+        for( int k = 0; ok && ( k < SapNumPairs( &sap ) ); k++ ) {
+            const aabb_t* a = &sap.bodies[p[k].a];
+            const aabb_t* b = &sap.bodies[p[k].b];
+            ok = ( p[k].a < p[k].b ) && sap.alive[p[k].a] && sap.alive[p[k].b] && AabbOverlap( a, b );
+        }
+        pairs = count;
+    }
+
+    printf( "sap %d bodies, %d moved per frame, %d pairs   update %7.3f us   brute force %8.3f us%s\n",
+            BENCH_SAP_BODIES, BENCH_SAP_MOVED, pairs, t_sap * 1e6 / frames, t_brute * 1e6 / frames,
+            ok ? "" : "   MISMATCH" );
+
+    SapRelease( &sap );
+    free( boxes );
+    free( ids );
+}
+
+/*
+BenchStore
+
+Передача BENCH_NODES мировых матриц от симуляции к отрисовке за кадр,
+в котором меняются BENCH_STORE_DIRTY диапазонов: копия всего массива
+(как под мьютексом) против публикации тройного буфера с копированием
+только изменённых диапазонов. Время писателя и читателя на кадр.
+*/
+static void BenchStore( void ) {
+    xformstore_t store;
+    mat4_t* sim = malloc( BENCH_NODES * sizeof( mat4_t ) );
+    mat4_t* shared = malloc( BENCH_NODES * sizeof( mat4_t ) );
+    if( ( sim == NULL ) || ( shared == NULL ) || !XformStoreInit( &store, BENCH_NODES ) ) {
+        printf( "store: out of memory\n" );
+        free( sim );
+        free( shared );
+        return;
+    }
+    for( int i = 0; i < BENCH_NODES; i++ ) {
+        Mat4Ident( &sim[i] );
+    }
+
+    int frames = 200;
+    int copied = 0;
+    mbool_t ok = mtrue;
+    double t0 = BenchNow();
+    for( int f = 0; f < frames; f++ ) {
+        for( int r = 0; r < BENCH_STORE_DIRTY; r++ ) {
+            int b = rand() % ( BENCH_NODES - 32 );
+            for( int i = b; i < b + 32; i++ ) {
+                sim[i].m[3] = ( float )f;
+            }
+        }
+        memcpy( shared, sim, BENCH_NODES * sizeof( mat4_t ) );
+    }
+    double t1 = BenchNow();
+    for( int f = 0; f < frames; f++ ) {
+        mat4_t* w = XformStoreWrite( &store );
+        for( int r = 0; r < BENCH_STORE_DIRTY; r++ ) {
+            int b = rand() % ( BENCH_NODES - 32 );
+            for( int i = b; i < b + 32; i++ ) {
+                w[i].m[3] = ( float )f;
+            }
+            XformStoreDirty( &store, b, b + 32 );
+        }
+        XformStorePublish( &store );
+        copied += store.copied;
+    }
+    double t2 = BenchNow();
+    for( int f = 0; f < frames; f++ ) {
+        unsigned int frame;
+        const mat4_t* m = XformStoreRead( &store, &frame );
+        bench_sink += m[f].m[3];
+        ok = ok && ( frame == ( unsigned int )frames );
+    }
+    double t3 = BenchNow();
+    ok = ok && ( memcmp( XformStoreWrite( &store ), XformStoreRead( &store, NULL ), BENCH_NODES * sizeof( mat4_t ) ) == 0 );
+
+    printf( "store %d matrices, %d dirty ranges   full copy %7.3f ms   publish %7.3f ms (%d copied)   read %6.3f us%s\n",
+            BENCH_NODES, BENCH_STORE_DIRTY, ( t1 - t0 ) * 1e3 / frames, ( t2 - t1 ) * 1e3 / frames, copied / frames,
+            ( t3 - t2 ) * 1e6 / frames, ok ? "" : "   MISMATCH" );
+
+    XformStoreRelease( &store );
+    free( sim );
+    free( shared );
+}
+
+/*
+BenchQuantCode
+
+Кодирование (decode = 0) или декодирование BENCH_COUNT элементов:
+kind 0 - нормали bench_v3a, 1 - позиции в кубе [-1, 1], 2 - кватернионы bench_v4a.
+*/
+static void BenchQuantCode( int kind, int fmt, unsigned char* buf, int decode ) {
+    aabb_t box;
+    Vec3Set( &box.min, -1.0f, -1.0f, -1.0f );
+    Vec3Set( &box.max, 1.0f, 1.0f, 1.0f );
+    if( kind == 0 ) {
+        decode ? QuantOctDecodeArray( bench_v3out, buf, BENCH_COUNT, fmt ) : QuantOctEncodeArray( buf, bench_v3a, BENCH_COUNT, fmt );
+    }
+    else if( kind == 1 ) {
+        decode ? QuantPosDecodeArray( bench_v3out, buf, BENCH_COUNT, &box, fmt ) : QuantPosEncodeArray( buf, bench_v3b, BENCH_COUNT, &box, fmt );
+    }
+    else {
+        decode ? QuantQuatDecodeArray( bench_v4out, buf, BENCH_COUNT, fmt ) : QuantQuatEncodeArray( buf, bench_v4a, BENCH_COUNT, fmt );
+    }
+}
+
+/*
+BenchQuant
+
+Скорость кодирования и декодирования квантованных форматов, сжатие
+относительно float и наибольшая ошибка: угол в градусах для нормалей
+и кватернионов, доля размера куба для позиций.
+*/
+static void BenchQuant( void ) {
+    static const struct {
+        const char* name;
+        int         kind;
+        int         fmt;
+        int         raw;    // байт в несжатом виде
+    } formats[] = {
+        { "oct16", 0, QUANT_OCT16, 12 },
+        { "oct24", 0, QUANT_OCT24, 12 },
+        { "oct32", 0, QUANT_OCT32, 12 },
+        { "pos32", 1, QUANT_POS32, 12 },
+        { "pos48", 1, QUANT_POS48, 12 },
+        { "quat32", 2, QUANT_QUAT32, 16 },
+        { "quat48", 2, QUANT_QUAT48, 16 }
+    };
+    static unsigned char buf[BENCH_COUNT * 8];
+    vec3_t* normals = bench_v3a;
+    vec4_t* quats = bench_v4a;
+
+    // единичные нормали и кватернионы, позиции в кубе [-1, 1]
+    for( int i = 0; i < BENCH_COUNT; i++ ) {
+        Vec3Norm( &normals[i] );
+        Vec4Norm( &quats[i] );
+    }
+    for( int f = 0; f < ( int )( sizeof( formats ) / sizeof( formats[0] ) ); f++ ) {
+        double t[2] = { 1e30, 1e30 };
+        for( int d = 0; d < 2; d++ ) {
+            for( int s = 0; s < 5; s++ ) {
+                double t0 = BenchNow();
+                for( int p = 0; p < BENCH_PASSES / 10; p++ ) {
+                    BenchQuantCode( formats[f].kind, formats[f].fmt, buf, d );
+                }
+                double dt = ( BenchNow() - t0 ) / ( ( double )( BENCH_PASSES / 10 ) * BENCH_COUNT );
+                t[d] = dt < t[d] ? dt : t[d];
+            }
+        }
+
+        double err = 0.0;
+        for( int i = 0; i < BENCH_COUNT; i++ ) {
+            double e = 0.0;
+            double dot = 0.0;
+            double len = 0.0;
+            double ref = 0.0;
+            if( formats[f].kind == 0 ) {
+                // в double и с нормировкой обоих векторов: ошибка округления float
+                // в acos около 1 сравнима с ошибкой oct32
+                for( int c = 0; c < 3; c++ ) {
+                    dot += ( double )normals[i].m[c] * bench_v3out[i].m[c];
+                    len += ( double )bench_v3out[i].m[c] * bench_v3out[i].m[c];
+                    ref += ( double )normals[i].m[c] * normals[i].m[c];
+                }
+                dot = dot / sqrt( len * ref );
+                e = acos( dot < 1.0 ? dot : 1.0 ) * 180.0 / M_PI;
+            }
+            else if( formats[f].kind == 1 ) {
+                for( int c = 0; c < 3; c++ ) {
+                    double d = fabs( ( double )bench_v3b[i].m[c] - bench_v3out[i].m[c] ) * 0.5;
+                    e = d > e ? d : e;
+                }
+            }
+            else {
+                for( int c = 0; c < 4; c++ ) {
+                    dot += ( double )quats[i].m[c] * bench_v4out[i].m[c];
+                    len += ( double )bench_v4out[i].m[c] * bench_v4out[i].m[c];
+                    ref += ( double )quats[i].m[c] * quats[i].m[c];
+                }
+                dot = fabs( dot ) / sqrt( len * ref );
+                e = 2.0 * acos( dot < 1.0 ? dot : 1.0 ) * 180.0 / M_PI;
+            }
+            err = e > err ? e : err;
+        }
+        printf( "quant %-8s encode %7.3f ns   decode %7.3f ns   %d -> %d bytes   max error %.3g%s\n",
+                formats[f].name, t[0] * 1e9, t[1] * 1e9, formats[f].raw, formats[f].fmt, err,
+                formats[f].kind == 1 ? " of size" : " deg" );
+    }
+}
+
+/*
+BenchRun
+
+Замер одного варианта. Время на элемент в наносекундах для каждого из
+BENCH_SAMPLES замеров записывается в samples, возвращается лучшее.
+В perf записываются значения счётчиков на элемент за отдельный проход замера.
+*/
+static double BenchRun( const benchcase_t* bc, double* samples, double* perf ) {
+    double best = 1e30;
+
+    bc->run( BENCH_COUNT ); // прогрев кэша
+    for( int s = 0; s < BENCH_SAMPLES; s++ ) {
+        double t0 = BenchNow();
+        for( int p = 0; p < BENCH_PASSES; p++ ) {
+            bc->run( BENCH_COUNT );
+        }
+        double t = ( BenchNow() - t0 ) / ( ( double )BENCH_PASSES * BENCH_COUNT );
+        samples[s] = t * 1e9;
+        if( t < best ) {
+            best = t;
+        }
+    }
+    BenchPerfBegin();
+    for( int p = 0; p < BENCH_PASSES; p++ ) {
+        bc->run( BENCH_COUNT );
+    }
+    BenchPerfEnd( perf );
+    for( int k = 0; k < BENCH_PERF_COUNT; k++ ) {
+        if( perf[k] >= 0.0 ) {
+            perf[k] /= ( double )BENCH_PASSES * BENCH_COUNT;
+        }
+    }
+    bench_sink += bench_v3out[0].x + bench_v4out[0].x + bench_m4out[0].m[0] + bench_m3out[0].m[0] + bench_svd[0].s.x +
+                  bench_bones[0].t.x + bench_pose.data[0];
+    return best * 1e9;
+}
+
+/*
+BenchSaveBaseline
+
+Запись замеров всех вариантов в файл базовой линии. Формат текстовый:
+заголовок с версией, затем строка на вариант - группа, имя и замеры через табуляцию.
+*/
+static mbool_t BenchSaveBaseline( const char* path, double samples[][BENCH_SAMPLES], int num_cases ) {
+    FILE* f = fopen( path, "w" );
+    if( f == NULL ) {
+        return mfalse;
+    }
+    fprintf( f, "%s %d\n", BENCH_BASELINE_MAGIC, BENCH_BASELINE_VERSION );
+    for( int i = 0; i < num_cases; i++ ) {
+        fprintf( f, "%s\t%s\t%d", bench_cases[i].group, bench_cases[i].name, BENCH_SAMPLES );
+        for( int s = 0; s < BENCH_SAMPLES; s++ ) {
+            fprintf( f, "\t%.6g", samples[i][s] );
+        }
+        fprintf( f, "\n" );
+    }
+    return fclose( f ) == 0;
+}
+
+/*
+BenchMannWhitney
+
+Двусторонний критерий Манна-Уитни для выборок a и b в нормальном приближении
+с поправкой на непрерывность. Возвращает p-значение гипотезы, что выборки
+взяты из одного распределения. Критерий не чувствителен к выбросам
+из-за вытесняющих процессов, в отличие от сравнения средних.
+*/
+static double BenchMannWhitney( const double* a, int na, const double* b, int nb ) {
+    double u = 0.0;
+    for( int i = 0; i < na; i++ ) {
+        for( int j = 0; j < nb; j++ ) {
+            u += a[i] < b[j] ? 1.0 : a[i] == b[j] ? 0.5 : 0.0;
+        }
+    }
+    double mean = 0.5 * na * nb;
+    double sigma = sqrt( na * nb * ( na + nb + 1.0 ) / 12.0 );
+    double z = ( fabs( u - mean ) - 0.5 ) / sigma;
+    return z > 0.0 ? erfc( z / sqrt( 2.0 ) ) : 1.0;
+}
+
+static int BenchCmpDouble( const void* a, const void* b ) {
+    double x = *( const double* )a;
+    double y = *( const double* )b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static double BenchMedian( const double* v, int n ) {
+    double tmp[BENCH_SAMPLES * 4];
+    memcpy( tmp, v, n * sizeof( double ) );
+    qsort( tmp, n, sizeof( double ), BenchCmpDouble );
+    return n % 2 ? tmp[n / 2] : 0.5 * ( tmp[n / 2 - 1] + tmp[n / 2] );
+}
+
+/*
+BenchCompareBaseline
+
+Сравнение текущих замеров с файлом базовой линии. Вариант считается
+изменившимся, если различие значимо по критерию Манна-Уитни на уровне
+BENCH_ALPHA и медианы отличаются больше чем на threshold (доля).
+Возвращает число значимо замедлившихся вариантов или -1, если файл не прочитан.
+*/
+static int BenchCompareBaseline( const char* path, double samples[][BENCH_SAMPLES], int num_cases, double threshold ) {
+    char line[1024];
+    char magic[64];
+    int version = 0;
+    int slower = 0;
+    mbool_t found[sizeof( bench_cases ) / sizeof( bench_cases[0] )] = { mfalse };
+
+    FILE* f = fopen( path, "r" );
+    if( f == NULL ) {
+        return -1;
+    }
+    if( ( fgets( line, sizeof( line ), f ) == NULL ) || ( sscanf( line, "%63s %d", magic, &version ) != 2 ) ||
+        ( strcmp( magic, BENCH_BASELINE_MAGIC ) != 0 ) || ( version != BENCH_BASELINE_VERSION ) ) {
+        printf( "%s: not a version %d baseline\n", path, BENCH_BASELINE_VERSION );
+        fclose( f );
+        return -1;
+    }
+
+    printf( "%-14s %-10s %12s %12s %9s %9s\n", "group", "variant", "base ns", "new ns", "speedup", "p" );
+    while( fgets( line, sizeof( line ), f ) != NULL ) {
+        double base[BENCH_SAMPLES * 4];
+        char* group = line;
+        char* name = strchr( group, '\t' );
+        char* p = name != NULL ? strchr( name + 1, '\t' ) : NULL;
+        if( p == NULL ) {
+            continue;
+        }
+        *name++ = '\0';
+        *p++ = '\0';
+        int n = ( int )strtol( p, &p, 10 );
+        if( ( n <= 0 ) || ( n > BENCH_SAMPLES * 4 ) ) {
+            continue;
+        }
+        for( int s = 0; s < n; s++ ) {
+            base[s] = strtod( p, &p );
+        }
+
+        int i = 0;
+        while( ( i < num_cases ) && ( ( strcmp( bench_cases[i].group, group ) != 0 ) || ( strcmp( bench_cases[i].name, name ) != 0 ) ) ) {
+            i++;
+        }
+        if( i == num_cases ) {
+            printf( "%-14s %-10s %12s\n", group, name, "removed" );
+            continue;
+        }
+        found[i] = mtrue;
+
+        double mb = BenchMedian( base, n );
+        double mn = BenchMedian( samples[i], BENCH_SAMPLES );
+        double pv = BenchMannWhitney( base, n, samples[i], BENCH_SAMPLES );
+        const char* verdict = "";
+        if( ( pv < BENCH_ALPHA ) && ( mn > mb * ( 1.0 + threshold ) ) ) {
+            verdict = "   SLOWER";
+            slower++;
+        }
+        else if( ( pv < BENCH_ALPHA ) && ( mn < mb / ( 1.0 + threshold ) ) ) {
+            verdict = "   faster";
+        }
+        printf( "%-14s %-10s %12.3f %12.3f %8.2fx %9.2g%s\n", group, name, mb, mn, mb / mn, pv, verdict );
+    }
+    fclose( f );
+
+    for( int i = 0; i < num_cases; i++ ) {
+        if( !found[i] ) {
+            printf( "%-14s %-10s %12s %12.3f\n", bench_cases[i].group, bench_cases[i].name, "new",
+                    BenchMedian( samples[i], BENCH_SAMPLES ) );
+        }
+    }
+    return slower;
+}
+
+int main( int argc, char** argv ) {
+    int num_cases = sizeof( bench_cases ) / sizeof( bench_cases[0] );
+    double samples[sizeof( bench_cases ) / sizeof( bench_cases[0] )][BENCH_SAMPLES];
+    const char* group = NULL;
+    double group_base = 0.0;
+    const char* save_path = NULL;
+    const char* compare_path = NULL;
+    double threshold = 0.05;
+    int result = 0;
+
+    for( int a = 1; a < argc; a++ ) {
+        if( ( strcmp( argv[a], "--save" ) == 0 ) && ( a + 1 < argc ) ) {
+            save_path = argv[++a];
+        }
+        else if( ( strcmp( argv[a], "--compare" ) == 0 ) && ( a + 1 < argc ) ) {
+            compare_path = argv[++a];
+        }
+        else if( ( strcmp( argv[a], "--threshold" ) == 0 ) && ( a + 1 < argc ) ) {
+            threshold = atof( argv[++a] ) * 0.01;
+        }
+        else {
+            fprintf( stderr, "usage: %s [--save file] [--compare file] [--threshold percent]\n", argv[0] );
+            return 2;
+        }
+    }
+
+    BenchPerfOpen(); // до MathInit, чтобы счётчики унаследовали потоки пула
+    MathInit();
+    BenchFill();
+
+    printf( "%-14s %-10s %12s %10s", "group", "variant", "ns/elem", "speedup" );
+    if( bench_perf_any ) {
+        printf( " %9s %6s %9s %9s %9s %9s", "instr", "IPC", "L1 miss", "LLC miss", "br miss", "fp vec" );
+    }
+    printf( "\n" );
+    for( int i = 0; i < num_cases; i++ ) {
+        const benchcase_t* bc = &bench_cases[i];
+        double perf[BENCH_PERF_COUNT];
+        double ns = BenchRun( bc, samples[i], perf );
+
+        // первый вариант группы - точка отсчёта для остальных
+        if( ( group == NULL ) || strcmp( group, bc->group ) != 0 ) {
+            group = bc->group;
+            group_base = ns;
+        }
+        printf( "%-14s %-10s %12.3f %9.2fx", bc->group, bc->name, ns, group_base / ns );
+        if( bench_perf_any ) {
+            double ipc = ( perf[BENCH_PERF_CYCLES] > 0.0 ) && ( perf[BENCH_PERF_INSTR] >= 0.0 ) ?
+                         perf[BENCH_PERF_INSTR] / perf[BENCH_PERF_CYCLES] : -1.0;
+            BenchPrintPerf( perf[BENCH_PERF_INSTR], 9 );
+            BenchPrintPerf( ipc, 6 );
+            BenchPrintPerf( perf[BENCH_PERF_L1_MISS], 9 );
+            BenchPrintPerf( perf[BENCH_PERF_LLC_MISS], 9 );
+            BenchPrintPerf( perf[BENCH_PERF_BRANCH_MISS], 9 );
+            BenchPrintPerf( perf[BENCH_PERF_FP_VEC], 9 );
+        }
+        printf( "\n" );
+    }
+    if( !bench_perf_any ) {
+        printf( "(hardware counters unavailable: check kernel.perf_event_paranoid)\n" );
+    }
+    BenchPerfClose();
+
+    if( save_path != NULL ) {
+        if( !BenchSaveBaseline( save_path, samples, num_cases ) ) {
+            printf( "%s: cannot write baseline\n", save_path );
+            result = 2;
+        }
+    }
+    if( compare_path != NULL ) {
+        printf( "\n" );
+        int slower = BenchCompareBaseline( compare_path, samples, num_cases, threshold );
+        if( slower < 0 ) {
+            printf( "%s: cannot read baseline\n", compare_path );
+            result = 2;
+        }
+        else if( slower > 0 ) {
+            printf( "%d variant(s) slower than baseline\n", slower );
+            result = 1;
+        }
+    }
+
+    printf( "\n" );
+    BenchSvdAccuracy();
+
+    printf( "\n" );
+    BenchMatN( 128 );
+    BenchMatN( 256 );
+    BenchMatN( 512 );
+
+    printf( "\n" );
+    BenchNoise();
+
+    printf( "\n" );
+    BenchFrame();
+
+    printf( "\n" );
+    BenchSap();
+
+    printf( "\n" );
+    BenchStore();
+
+    printf( "\n" );
+    BenchQuant();
+
+    AnimClipRelease( &bench_clip );
+    AnimPoseRelease( &bench_pose );
+    MathRelease();
+    return result;
+}
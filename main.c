@@ -1,4 +1,4 @@
-// Compile: gcc math/math_base.c math/vector.c math/matrix.c main.c -o main
+// Compile: gcc math/math_base.c math/vector.c math/matrix.c math/broadphase.c math/transform.c math/camera.c math/matn.c math/sparse.c math/lu.c math/svd.c math/spline.c math/anim.c math/noise.c math/random.c math/probe.c math/metrics.c math/arena.c math/pool.c math/jobgraph.c math/xformstore.c math/quant.c main.c -pthread -o main
 
 #include <stdio.h>
 #include <stdlib.h>
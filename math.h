@@ -4,5 +4,22 @@
 #include "math/math_base.h"
 #include "math/vector.h"
 #include "math/matrix.h"
+#include "math/value.h"
+#include "math/broadphase.h"
+#include "math/transform.h"
+#include "math/camera.h"
+#include "math/matn.h"
+#include "math/sparse.h"
+#include "math/lu.h"
+#include "math/svd.h"
+#include "math/spline.h"
+#include "math/anim.h"
+#include "math/noise.h"
+#include "math/random.h"
+#include "math/arena.h"
+#include "math/pool.h"
+#include "math/jobgraph.h"
+#include "math/xformstore.h"
+#include "math/quant.h"
 
 #endif //__MATH_H__
@@ -0,0 +1,402 @@
+#include <string.h>
+
+#include "anim.h"
+#include "lane.h"
+
+/*
+AnimIdentBlock
+
+Единичное преобразование для всех stride костей блока каналов.
+*/
+static void AnimIdentBlock( float* data, int stride ) {
+    for( int ch = 0; ch < ANIM_CHANNELS; ch++ ) {
+        float v = ( ch == ANIM_RW ) || ( ch >= ANIM_SX ) ? 1.0f : 0.0f;
+        for( int k = 0; k < stride; k++ ) {
+            data[ch * stride + k] = v;
+        }
+    }
+}
+
+/*
+AnimClipInit
+
+Создание клипа из num_keys ключей для num_bones костей.
+Все ключи заполняются единичным преобразованием, времена - нулями.
+Возвращает mfalse, если num_keys < 1 (выборке нужен хотя бы один ключ),
+или при нехватке памяти.
+*/
+mbool_t AnimClipInit( animclip_t* c, int num_bones, int num_keys ) {
+    c->times = NULL;
+    c->data = NULL;
+    if( num_keys < 1 ) {
+        AnimClipRelease( c );
+        return mfalse;
+    }
+    c->num_bones = num_bones;
+    c->stride = ( num_bones + ANIM_PAD - 1 ) / ANIM_PAD * ANIM_PAD;
+    c->num_keys = num_keys;
+    c->times = calloc( num_keys, sizeof( float ) );
+    c->data = MathAlignedAlloc( ( size_t )num_keys * ANIM_CHANNELS * c->stride * sizeof( float ), ANIM_ALIGN );
+    if( ( c->times == NULL ) || ( c->data == NULL ) ) {
+        AnimClipRelease( c );
+        return mfalse;
+    }
+    for( int k = 0; k < num_keys; k++ ) {
+        AnimIdentBlock( c->data + ( size_t )k * ANIM_CHANNELS * c->stride, c->stride );
+    }
+    return mtrue;
+}
+
+/*
+AnimClipRelease
+
+Освобождение памяти клипа.
+*/
+void AnimClipRelease( animclip_t* c ) {
+    free( c->times );
+    MathAlignedFree( c->data );
+    c->times = NULL;
+    c->data = NULL;
+    c->num_bones = 0;
+    c->stride = 0;
+    c->num_keys = 0;
+}
+
+/*
+AnimClipChannel
+
+Вернуть указатель на канал ch ключа key (num_bones значений подряд).
+*/
+float* AnimClipChannel( const animclip_t* c, int key, animchannel_t ch ) {
+    return c->data + ( ( size_t )key * ANIM_CHANNELS + ch ) * c->stride;
+}
+
+/*
+AnimPoseInit
+
+Создание позы для num_bones костей, заполненной единичным преобразованием.
+*/
+mbool_t AnimPoseInit( animpose_t* p, int num_bones ) {
+    p->num_bones = num_bones;
+    p->stride = ( num_bones + ANIM_PAD - 1 ) / ANIM_PAD * ANIM_PAD;
+    p->data = MathAlignedAlloc( ( size_t )ANIM_CHANNELS * ( p->stride > 0 ? p->stride : ANIM_PAD ) * sizeof( float ), ANIM_ALIGN );
+    if( p->data == NULL ) {
+        p->num_bones = 0;
+        p->stride = 0;
+        return mfalse;
+    }
+    AnimPoseIdent( p );
+    return mtrue;
+}
+
+/*
+AnimPoseRelease
+
+Освобождение памяти позы.
+*/
+void AnimPoseRelease( animpose_t* p ) {
+    MathAlignedFree( p->data );
+    p->data = NULL;
+    p->num_bones = 0;
+    p->stride = 0;
+}
+
+/*
+AnimPoseChannel
+
+Вернуть указатель на канал ch позы (num_bones значений подряд).
+*/
+float* AnimPoseChannel( const animpose_t* p, animchannel_t ch ) {
+    return p->data + ( size_t )ch * p->stride;
+}
+
+/*
+AnimPoseIdent
+
+Установка единичного преобразования всем костям.
+*/
+void AnimPoseIdent( animpose_t* p ) {
+    AnimIdentBlock( p->data, p->stride );
+}
+
+/*
+AnimCursorReset
+
+Сброс курсора к началу клипа.
+*/
+void AnimCursorReset( animcursor_t* cur ) {
+    cur->key = 0;
+}
+
+/*
+AnimFindKey
+
+Номер ключа k, для которого times[k] <= time < times[k + 1], и доля
+пути между ключами в frac. Время ограничивается интервалом клипа.
+Если время не уменьшилось с прошлого вызова, поиск идёт вперёд от
+ключа курсора (обычно ноль или один шаг), иначе - двоичный.
+*/
+static int AnimFindKey( const animclip_t* c, animcursor_t* cur, float time, float* frac ) {
+    int n = c->num_keys;
+    *frac = 0.0f;
+    if( n <= 1 ) {
+        return 0;
+    }
+
+    const float* t = c->times;
+    time = clamp3f( t[0], t[n - 1], time );
+
+    int k = cur != NULL ? cur->key : -1;
+    if( ( k < 0 ) || ( k > n - 2 ) || ( t[k] > time ) ) {
+        int lo = 0;
+        int hi = n - 1;
+        while( hi - lo > 1 ) {
+            int mid = ( lo + hi ) / 2;
+            if( t[mid] <= time ) {
+                lo = mid;
+            }
+            else {
+                hi = mid;
+            }
+        }
+        k = lo;
+    }
+    else {
+        while( ( k < n - 2 ) && ( t[k + 1] <= time ) ) {
+            k++;
+        }
+    }
+
+    if( cur != NULL ) {
+        cur->key = k;
+    }
+    float dt = t[k + 1] - t[k];
+    *frac = dt > 0.0f ? min2f( ( time - t[k] ) / dt, 1.0f ) : 0.0f;
+    return k;
+}
+
+/*
+AnimKeys
+
+Указатели на блоки двух соседних ключей для момента time.
+*/
+static float AnimKeys( const animclip_t* c, animcursor_t* cur, float time, const float** a, const float** b ) {
+    float f;
+    int k = AnimFindKey( c, cur, time, &f );
+    *a = AnimClipChannel( c, k, ANIM_TX );
+    *b = k + 1 < c->num_keys ? AnimClipChannel( c, k + 1, ANIM_TX ) : *a;
+    return f;
+}
+
+/*
+AnimLerpQuat
+
+nlerp без нормализации между кватернионами полосы a и b (каналы
+с шагом stride) по ближнему пути: если a * b < 0, b берётся с минусом.
+*/
+static inline void AnimLerpQuat( lanef_t* q, const float* a, const float* b, lanef_t f, int stride ) {
+    lanef_t qa[4], qb[4];
+    lanef_t dot = LaneSet1( 0.0f );
+    for( int c = 0; c < 4; c++ ) {
+        qa[c] = LaneLoad( a + c * stride );
+        qb[c] = LaneLoad( b + c * stride );
+        dot = LaneAdd( dot, LaneMul( qa[c], qb[c] ) );
+    }
+    lanef_t flip = LaneLt( dot, LaneSet1( 0.0f ) );
+    for( int c = 0; c < 4; c++ ) {
+        q[c] = LaneLerp( qa[c], LaneSel( flip, LaneSub( LaneSet1( 0.0f ), qb[c] ), qb[c] ), f );
+    }
+}
+
+/*
+AnimAccumulate
+
+acc += w * lerp( a, b, f ) для переноса и масштаба и w * nlerp( a, b, f )
+(нормализованный) для поворота по всем костям, LANE_WIDTH костей за шаг. Знак кватерниона
+выбирается по согласию с уже накопленным поворотом, так что первый слой
+задаёт полусферу для остальных.
+*/
+static void AnimAccumulate( float* mrestrict acc, const float* mrestrict a, const float* mrestrict b,
+                            float f, float w, int stride ) {
+    lanef_t vf = LaneSet1( f );
+    lanef_t vw = LaneSet1( w );
+    lanef_t zero = LaneSet1( 0.0f );
+
+    for( int k = 0; k < stride; k += LANE_WIDTH ) {
+        for( int ch = ANIM_TX; ch <= ANIM_TZ; ch++ ) {
+            int i = ch * stride + k;
+            lanef_t v = LaneLerp( LaneLoad( a + i ), LaneLoad( b + i ), vf );
+            LaneStore( acc + i, LaneAdd( LaneLoad( acc + i ), LaneMul( vw, v ) ) );
+        }
+        for( int ch = ANIM_SX; ch <= ANIM_SZ; ch++ ) {
+            int i = ch * stride + k;
+            lanef_t v = LaneLerp( LaneLoad( a + i ), LaneLoad( b + i ), vf );
+            LaneStore( acc + i, LaneAdd( LaneLoad( acc + i ), LaneMul( vw, v ) ) );
+        }
+
+        int ir = ANIM_RX * stride + k;
+        lanef_t q[4], r[4];
+        AnimLerpQuat( q, a + ir, b + ir, vf, stride );
+        lanef_t len2 = zero;
+        lanef_t e = zero;
+        for( int c = 0; c < 4; c++ ) {
+            r[c] = LaneLoad( acc + ir + c * stride );
+            len2 = LaneAdd( len2, LaneMul( q[c], q[c] ) );
+            e = LaneAdd( e, LaneMul( r[c], q[c] ) );
+        }
+        // вес относится к повороту, а не к длине промежуточного кватерниона
+        lanef_t ww = LaneMul( LaneSel( LaneLt( e, zero ), LaneSub( zero, vw ), vw ), LaneRsqrt( len2 ) );
+        for( int c = 0; c < 4; c++ ) {
+            LaneStore( acc + ir + c * stride, LaneAdd( r[c], LaneMul( ww, q[c] ) ) );
+        }
+    }
+}
+
+/*
+AnimNormalize
+
+Деление переноса и масштаба на сумму весов и нормализация поворота.
+*/
+static void AnimNormalize( float* mrestrict acc, float total, int stride ) {
+    lanef_t inv = LaneSet1( 1.0f / total );
+    lanef_t zero = LaneSet1( 0.0f );
+
+    for( int k = 0; k < stride; k += LANE_WIDTH ) {
+        for( int ch = ANIM_TX; ch <= ANIM_TZ; ch++ ) {
+            int i = ch * stride + k;
+            LaneStore( acc + i, LaneMul( LaneLoad( acc + i ), inv ) );
+        }
+        for( int ch = ANIM_SX; ch <= ANIM_SZ; ch++ ) {
+            int i = ch * stride + k;
+            LaneStore( acc + i, LaneMul( LaneLoad( acc + i ), inv ) );
+        }
+
+        int ir = ANIM_RX * stride + k;
+        lanef_t r[4];
+        lanef_t len2 = zero;
+        for( int c = 0; c < 4; c++ ) {
+            r[c] = LaneLoad( acc + ir + c * stride );
+            len2 = LaneAdd( len2, LaneMul( r[c], r[c] ) );
+        }
+        lanef_t il = LaneSel( LaneLt( zero, len2 ), LaneRsqrt( len2 ), zero );
+        for( int c = 0; c < 4; c++ ) {
+            LaneStore( acc + ir + c * stride, LaneMul( r[c], il ) );
+        }
+    }
+}
+
+/*
+AnimApplyAdditive
+
+Наложение разностного клипа с весом w: перенос прибавляется,
+масштаб умножается на lerp( 1, s, w ), поворот домножается справа
+на nlerp( 1, q, w ).
+*/
+static void AnimApplyAdditive( float* mrestrict out, const float* mrestrict a, const float* mrestrict b,
+                               float f, float w, int stride ) {
+    lanef_t vf = LaneSet1( f );
+    lanef_t vw = LaneSet1( w );
+    lanef_t one = LaneSet1( 1.0f );
+    lanef_t zero = LaneSet1( 0.0f );
+
+    for( int k = 0; k < stride; k += LANE_WIDTH ) {
+        for( int ch = ANIM_TX; ch <= ANIM_TZ; ch++ ) {
+            int i = ch * stride + k;
+            lanef_t v = LaneLerp( LaneLoad( a + i ), LaneLoad( b + i ), vf );
+            LaneStore( out + i, LaneAdd( LaneLoad( out + i ), LaneMul( vw, v ) ) );
+        }
+        for( int ch = ANIM_SX; ch <= ANIM_SZ; ch++ ) {
+            int i = ch * stride + k;
+            lanef_t v = LaneLerp( LaneLoad( a + i ), LaneLoad( b + i ), vf );
+            LaneStore( out + i, LaneMul( LaneLoad( out + i ), LaneLerp( one, v, vw ) ) );
+        }
+
+        int ir = ANIM_RX * stride + k;
+        lanef_t d[4], q[4], r[4];
+        AnimLerpQuat( d, a + ir, b + ir, vf, stride );
+
+        // nlerp от единичного кватерниона по ближнему пути
+        lanef_t sw = LaneSel( LaneLt( d[3], zero ), LaneSub( zero, vw ), vw );
+        lanef_t len2 = zero;
+        for( int c = 0; c < 4; c++ ) {
+            q[c] = LaneMul( sw, d[c] );
+        }
+        q[3] = LaneAdd( q[3], LaneSub( one, vw ) );
+        for( int c = 0; c < 4; c++ ) {
+            len2 = LaneAdd( len2, LaneMul( q[c], q[c] ) );
+        }
+        lanef_t il = LaneRsqrt( len2 );
+        for( int c = 0; c < 4; c++ ) {
+            q[c] = LaneMul( q[c], il );
+            r[c] = LaneLoad( out + ir + c * stride );
+        }
+
+        // r = r * q
+        lanef_t x = LaneSub( LaneAdd( LaneAdd( LaneMul( r[3], q[0] ), LaneMul( r[0], q[3] ) ), LaneMul( r[1], q[2] ) ), LaneMul( r[2], q[1] ) );
+        lanef_t y = LaneAdd( LaneAdd( LaneSub( LaneMul( r[3], q[1] ), LaneMul( r[0], q[2] ) ), LaneMul( r[1], q[3] ) ), LaneMul( r[2], q[0] ) );
+        lanef_t z = LaneAdd( LaneSub( LaneAdd( LaneMul( r[3], q[2] ), LaneMul( r[0], q[1] ) ), LaneMul( r[1], q[0] ) ), LaneMul( r[2], q[3] ) );
+        lanef_t v = LaneSub( LaneSub( LaneSub( LaneMul( r[3], q[3] ), LaneMul( r[0], q[0] ) ), LaneMul( r[1], q[1] ) ), LaneMul( r[2], q[2] ) );
+        LaneStore( out + ir, x );
+        LaneStore( out + ir + stride, y );
+        LaneStore( out + ir + 2 * stride, z );
+        LaneStore( out + ir + 3 * stride, v );
+    }
+}
+
+/*
+AnimSample
+
+Поза клипа clip в момент time. cur может быть NULL.
+Число костей позы и клипа должно совпадать.
+*/
+void AnimSample( animpose_t* out, const animclip_t* clip, animcursor_t* cur, float time ) {
+    animlayer_t layer = { clip, cur, time, 1.0f, ANIM_BLEND_WEIGHTED };
+    AnimSampleLayers( out, &layer, 1 );
+}
+
+/*
+AnimSampleLayers
+
+Смешивание count слоёв в позу out без промежуточных поз:
+сначала взвешенное среднее всех слоёв ANIM_BLEND_WEIGHTED
+(перенос и масштаб - линейно, поворот - nlerp), затем по порядку
+накладываются слои ANIM_BLEND_ADDITIVE. Если у взвешенных слоёв
+нулевой суммарный вес, основой служит единичная поза.
+Число костей всех клипов и позы должно совпадать.
+*/
+void AnimSampleLayers( animpose_t* out, const animlayer_t* layers, int count ) {
+    int stride = out->stride;
+    float total = 0.0f;
+
+    MATH_METRIC( MATH_METRIC_ANIM_SAMPLE, out->num_bones, 0 );
+    memset( out->data, 0, ( size_t )ANIM_CHANNELS * stride * sizeof( float ) );
+    for( int i = 0; i < count; i++ ) {
+        const animlayer_t* l = &layers[i];
+        if( ( l->mode != ANIM_BLEND_WEIGHTED ) || ( l->weight <= 0.0f ) ) {
+            continue;
+        }
+        const float* a;
+        const float* b;
+        float f = AnimKeys( l->clip, l->cursor, l->time, &a, &b );
+        AnimAccumulate( out->data, a, b, f, l->weight, stride );
+        total += l->weight;
+    }
+
+    if( total > 0.0f ) {
+        AnimNormalize( out->data, total, stride );
+    }
+    else {
+        AnimPoseIdent( out );
+    }
+
+    for( int i = 0; i < count; i++ ) {
+        const animlayer_t* l = &layers[i];
+        if( ( l->mode != ANIM_BLEND_ADDITIVE ) || ( l->weight == 0.0f ) ) {
+            continue;
+        }
+        const float* a;
+        const float* b;
+        float f = AnimKeys( l->clip, l->cursor, l->time, &a, &b );
+        AnimApplyAdditive( out->data, a, b, f, l->weight, stride );
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef __ANIM_H__
+#define __ANIM_H__
+
+#include "math_base.h"
+
+#define ANIM_ALIGN      32      // выравнивание каналов в байтах
+#define ANIM_PAD        8       // количество костей в канале кратно ANIM_PAD
+
+// каналы позы кости: перенос, поворот (кватернион x y z w), масштаб
+typedef enum {
+    ANIM_TX = 0,
+    ANIM_TY,
+    ANIM_TZ,
+    ANIM_RX,
+    ANIM_RY,
+    ANIM_RZ,
+    ANIM_RW,
+    ANIM_SX,
+    ANIM_SY,
+    ANIM_SZ,
+    ANIM_CHANNELS
+} animchannel_t;
+
+/*
+Поза скелета в виде структуры массивов: канал ch всех костей лежит
+подряд с data + ch * stride. Кости за пределами num_bones (выравнивание)
+содержат единичное преобразование, поэтому циклы идут по stride без хвостов.
+*/
+typedef struct {
+    int             num_bones;
+    int             stride;     // num_bones, округлённое вверх до ANIM_PAD
+    float*          data;       // ANIM_CHANNELS * stride элементов
+} animpose_t;
+
+/*
+Клип: num_keys ключей с общими для всех костей временами times.
+Ключ k хранится как поза: канал ch с data + ( k * ANIM_CHANNELS + ch ) * stride,
+поэтому интерполяция между двумя ключами идёт сразу по всем костям.
+*/
+typedef struct {
+    int             num_bones;
+    int             stride;
+    int             num_keys;
+    float*          times;      // по возрастанию
+    float*          data;
+} animclip_t;
+
+// последний найденный ключ: при растущем времени поиск идёт от него
+typedef struct {
+    int             key;
+} animcursor_t;
+
+// способ наложения слоя
+typedef enum {
+    ANIM_BLEND_WEIGHTED = 0,    // взвешенное среднее с другими такими слоями
+    ANIM_BLEND_ADDITIVE         // разница с опорной позой поверх результата
+} animblend_t;
+
+// слой смешивания: клип в момент time с весом weight
+typedef struct {
+    const animclip_t*   clip;
+    animcursor_t*       cursor; // может быть NULL
+    float               time;
+    float               weight;
+    animblend_t         mode;
+} animlayer_t;
+
+
+mbool_t     AnimClipInit( animclip_t* c, int num_bones, int num_keys );
+void        AnimClipRelease( animclip_t* c );
+float*      AnimClipChannel( const animclip_t* c, int key, animchannel_t ch );
+
+mbool_t     AnimPoseInit( animpose_t* p, int num_bones );
+void        AnimPoseRelease( animpose_t* p );
+float*      AnimPoseChannel( const animpose_t* p, animchannel_t ch );
+void        AnimPoseIdent( animpose_t* p );
+
+void        AnimCursorReset( animcursor_t* cur );
+void        AnimSample( animpose_t* out, const animclip_t* clip, animcursor_t* cur, float time );
+void        AnimSampleLayers( animpose_t* out, const animlayer_t* layers, int count );
+
+
+
+#endif //__ANIM_H__
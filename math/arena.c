@@ -0,0 +1,332 @@
+#include <string.h>
+
+#include "arena.h"
+
+#if defined( _MSC_VER )
+#define ARENA_THREAD_EXIT
+#include <windows.h>
+#elif defined( __GNUC__ ) && !defined( _WIN32 ) && !defined( MATH_NO_THREADS )
+#define ARENA_THREAD_EXIT
+#include <pthread.h>
+#endif
+
+// арена кадра одного потока в общем списке
+typedef struct arenanode_s {
+    arena_t                 arena;
+    int                     busy;       // 1, пока арену держит живой поток
+    struct arenanode_s*     next;
+} arenanode_t;
+
+static arenanode_t*     math_arenas;            // арены кадра всех потоков
+static int              math_arena_gen = 1;     // меняется в ArenaFrameRelease
+
+static mthreadlocal arenanode_t*    math_arena_local;
+static mthreadlocal int             math_arena_local_gen;
+static mthreadlocal arena_t         math_arena_empty;   // если арену не удалось создать
+
+#if defined( _MSC_VER )
+
+static int ArenaGen( void ) {
+    return InterlockedCompareExchange( ( volatile LONG* )&math_arena_gen, 0, 0 );
+}
+
+static void ArenaNextGen( void ) {
+    InterlockedIncrement( ( volatile LONG* )&math_arena_gen );
+}
+
+static void ArenaPush( arenanode_t* node ) {
+    do {
+        node->next = math_arenas;
+    } while( InterlockedCompareExchangePointer( ( PVOID volatile* )&math_arenas, node, node->next ) != node->next );
+}
+
+static arenanode_t* ArenaTakeAll( void ) {
+    return InterlockedExchangePointer( ( PVOID volatile* )&math_arenas, NULL );
+}
+
+static inline arenanode_t* ArenaFirst( void ) {
+    return InterlockedCompareExchangePointer( ( PVOID volatile* )&math_arenas, NULL, NULL );
+}
+
+static inline mbool_t ArenaClaim( arenanode_t* node ) {
+    return InterlockedCompareExchange( ( volatile LONG* )&node->busy, 1, 0 ) == 0;
+}
+
+static inline void ArenaUnclaim( arenanode_t* node ) {
+    InterlockedExchange( ( volatile LONG* )&node->busy, 0 );
+}
+
+#else
+
+static int ArenaGen( void ) {
+    return __atomic_load_n( &math_arena_gen, __ATOMIC_ACQUIRE );
+}
+
+static void ArenaNextGen( void ) {
+    __atomic_add_fetch( &math_arena_gen, 1, __ATOMIC_RELEASE );
+}
+
+static void ArenaPush( arenanode_t* node ) {
+    node->next = __atomic_load_n( &math_arenas, __ATOMIC_RELAXED );
+    while( !__atomic_compare_exchange_n( &math_arenas, &node->next, node, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED ) ) {
+    }
+}
+
+static arenanode_t* ArenaTakeAll( void ) {
+    return __atomic_exchange_n( &math_arenas, NULL, __ATOMIC_ACQ_REL );
+}
+
+static inline arenanode_t* ArenaFirst( void ) {
+    return __atomic_load_n( &math_arenas, __ATOMIC_ACQUIRE );
+}
+
+static inline mbool_t ArenaClaim( arenanode_t* node ) {
+    int expected = 0;
+    return __atomic_compare_exchange_n( &node->busy, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED );
+}
+
+static inline void ArenaUnclaim( arenanode_t* node ) {
+    __atomic_store_n( &node->busy, 0, __ATOMIC_RELEASE );
+}
+
+#endif
+
+#if defined( ARENA_THREAD_EXIT )
+
+/*
+ArenaThreadExit
+
+Вызывается при завершении потока: его арена кадра становится свободной
+и достаётся следующему новому потоку, а не лежит без дела до MathRelease.
+Арену прошлого поколения не трогаем - её уже освободил ArenaFrameRelease.
+*/
+static void ArenaThreadExit( void* ptr ) {
+    arenanode_t* node = ptr;
+    if( ( node != NULL ) && ( math_arena_local == node ) && ( math_arena_local_gen == ArenaGen() ) ) {
+        math_arena_local = NULL;
+        ArenaUnclaim( node );
+    }
+}
+
+#endif
+
+#if defined( _MSC_VER )
+
+static INIT_ONCE    math_arena_once = INIT_ONCE_STATIC_INIT;
+static DWORD        math_arena_fls = FLS_OUT_OF_INDEXES;
+
+static VOID WINAPI ArenaFlsCallback( PVOID ptr ) {
+    ArenaThreadExit( ptr );
+}
+
+static BOOL CALLBACK ArenaOnce( PINIT_ONCE once, PVOID param, PVOID* ctx ) {
+    ( void )once;
+    ( void )param;
+    ( void )ctx;
+    math_arena_fls = FlsAlloc( ArenaFlsCallback );
+    return TRUE;
+}
+
+// арена node будет возвращена в список при завершении текущего потока
+static void ArenaOnThreadExit( arenanode_t* node ) {
+    InitOnceExecuteOnce( &math_arena_once, ArenaOnce, NULL, NULL );
+    if( math_arena_fls != FLS_OUT_OF_INDEXES ) {
+        FlsSetValue( math_arena_fls, node );
+    }
+}
+
+#elif defined( ARENA_THREAD_EXIT )
+
+static pthread_once_t   math_arena_once = PTHREAD_ONCE_INIT;
+static pthread_key_t    math_arena_key;
+static int              math_arena_key_ok;
+
+static void ArenaOnce( void ) {
+    math_arena_key_ok = pthread_key_create( &math_arena_key, ArenaThreadExit ) == 0;
+}
+
+static void ArenaOnThreadExit( arenanode_t* node ) {
+    pthread_once( &math_arena_once, ArenaOnce );
+    if( math_arena_key_ok ) {
+        pthread_setspecific( math_arena_key, node );
+    }
+}
+
+#else
+
+// без потоков завершения потока не узнать: арены остаются до MathRelease
+static void ArenaOnThreadExit( arenanode_t* node ) {
+    ( void )node;
+}
+
+#endif
+
+/*
+ArenaReuse
+
+Арена кадра, освобождённая завершившимся потоком, или NULL.
+Узлы удаляются из списка только в ArenaFrameRelease, поэтому обход
+без блокировок безопасен; владение забирается атомарно через busy.
+*/
+static arenanode_t* ArenaReuse( void ) {
+    for( arenanode_t* node = ArenaFirst(); node != NULL; node = node->next ) {
+        if( ArenaClaim( node ) ) {
+            ArenaClear( &node->arena );
+            return node;
+        }
+    }
+    return NULL;
+}
+
+/*
+ArenaInit
+
+Создание арены размером size байт.
+Возвращает mfalse при нехватке памяти, арена тогда пустая.
+*/
+mbool_t ArenaInit( arena_t* a, size_t size ) {
+    a->base = MathAlignedAlloc( size > 0 ? size : 1, ARENA_ALIGN );
+    a->size = a->base != NULL ? size : 0;
+    a->used = 0;
+    a->peak = 0;
+    return a->base != NULL;
+}
+
+void ArenaRelease( arena_t* a ) {
+    MathAlignedFree( a->base );
+    a->base = NULL;
+    a->size = 0;
+    a->used = 0;
+}
+
+/*
+ArenaAlloc
+
+Выделить size байт, выровненных по align (степень двойки).
+Возвращает NULL, если в арене не хватает места; арена при этом не меняется.
+*/
+void* ArenaAlloc( arena_t* a, size_t size, size_t align ) {
+    if( a->base == NULL ) {
+        return NULL;
+    }
+    size_t addr = ( size_t )( a->base + a->used );
+    size_t start = ( ( addr + align - 1 ) & ~( align - 1 ) ) - ( size_t )a->base;
+    if( ( start > a->size ) || ( size > a->size - start ) ) {
+        return NULL;
+    }
+    a->used = start + size;
+    if( a->used > a->peak ) {
+        a->peak = a->used;
+    }
+    return a->base + start;
+}
+
+/*
+ArenaMark
+
+Текущее заполнение арены, к которому её возвращает ArenaReset.
+*/
+arenamark_t ArenaMark( const arena_t* a ) {
+    return a->used;
+}
+
+/*
+ArenaReset
+
+Освободить всё, что выделено после метки mark.
+*/
+void ArenaReset( arena_t* a, arenamark_t mark ) {
+    if( mark < a->used ) {
+        a->used = mark;
+    }
+}
+
+void ArenaClear( arena_t* a ) {
+    a->used = 0;
+}
+
+/*
+ArenaFloatArray
+
+Массивы из count элементов, выровненные по ARENA_ALIGN.
+Возвращают NULL, если в арене не хватает места.
+*/
+float* ArenaFloatArray( arena_t* a, int count ) {
+    return ArenaAlloc( a, ( size_t )( count > 0 ? count : 0 ) * sizeof( float ), ARENA_ALIGN );
+}
+
+vec2_t* ArenaVec2Array( arena_t* a, int count ) {
+    return ArenaAlloc( a, ( size_t )( count > 0 ? count : 0 ) * sizeof( vec2_t ), ARENA_ALIGN );
+}
+
+vec3_t* ArenaVec3Array( arena_t* a, int count ) {
+    return ArenaAlloc( a, ( size_t )( count > 0 ? count : 0 ) * sizeof( vec3_t ), ARENA_ALIGN );
+}
+
+vec4_t* ArenaVec4Array( arena_t* a, int count ) {
+    return ArenaAlloc( a, ( size_t )( count > 0 ? count : 0 ) * sizeof( vec4_t ), ARENA_ALIGN );
+}
+
+mat3_t* ArenaMat3Array( arena_t* a, int count ) {
+    return ArenaAlloc( a, ( size_t )( count > 0 ? count : 0 ) * sizeof( mat3_t ), ARENA_ALIGN );
+}
+
+mat4_t* ArenaMat4Array( arena_t* a, int count ) {
+    return ArenaAlloc( a, ( size_t )( count > 0 ? count : 0 ) * sizeof( mat4_t ), ARENA_ALIGN );
+}
+
+/*
+ArenaFrame
+
+Арена кадра текущего потока. При первом вызове в потоке (или после
+MathRelease) берётся арена завершившегося потока, а если такой нет -
+создаётся арена размером MATH_ARENA_SIZE. Никогда не возвращает NULL:
+если память не выделилась, возвращается пустая арена, из которой любое
+выделение возвращает NULL.
+*/
+arena_t* ArenaFrame( void ) {
+    int gen = ArenaGen();
+    if( ( math_arena_local != NULL ) && ( math_arena_local_gen == gen ) ) {
+        return &math_arena_local->arena;
+    }
+    arenanode_t* node = ArenaReuse();
+    if( node == NULL ) {
+        node = malloc( sizeof( arenanode_t ) );
+        if( ( node == NULL ) || !ArenaInit( &node->arena, MATH_ARENA_SIZE ) ) {
+            free( node );
+            return &math_arena_empty;
+        }
+        node->busy = 1;
+        ArenaPush( node );
+    }
+    ArenaOnThreadExit( node );
+    math_arena_local = node;
+    math_arena_local_gen = gen;
+    return &node->arena;
+}
+
+/*
+ArenaFrameInit
+
+Создание арены кадра вызывающего потока. Вызывается из MathInit.
+*/
+void ArenaFrameInit( void ) {
+    ArenaFrame();
+}
+
+/*
+ArenaFrameRelease
+
+Освобождение арен кадра всех потоков. Вызывается из MathRelease,
+когда другие потоки уже не вызывают функции библиотеки.
+*/
+void ArenaFrameRelease( void ) {
+    ArenaNextGen();
+    arenanode_t* node = ArenaTakeAll();
+    while( node != NULL ) {
+        arenanode_t* next = node->next;
+        ArenaRelease( &node->arena );
+        free( node );
+        node = next;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include "matrix.h"
+
+#define ARENA_ALIGN     32      // выравнивание массивов в байтах
+
+#ifndef MATH_ARENA_SIZE
+#define MATH_ARENA_SIZE ( 4 << 20 ) // размер арены кадра каждого потока в байтах
+#endif
+
+/*
+Линейная арена для временных буферов: выделение - сдвиг указателя,
+освобождаются не отдельные блоки, а всё выделенное после метки (ArenaReset).
+Арена не растёт: если места не хватает, ArenaAlloc возвращает NULL,
+peak показывает наибольший занятый объём для подбора размера.
+
+У каждого потока своя арена кадра (ArenaFrame), поэтому выделение не
+требует блокировок. Арена главного потока создаётся в MathInit, других
+потоков - при первом вызове ArenaFrame. Арена завершившегося потока
+не освобождается, а достаётся следующему новому потоку (в сборках без
+потоков - остаётся до MathRelease). MathRelease освобождает арены
+всех потоков, после него потоки не должны пользоваться полученной памятью.
+
+Функции библиотеки берут из арены кадра временные буферы между
+ArenaMark и ArenaReset, поэтому оставляют арену такой же, какой получили.
+Вызывающий код может так же выделять буферы на кадр и освобождать
+их одним ArenaClear в начале следующего кадра.
+*/
+typedef struct {
+    unsigned char*  base;
+    size_t          size;
+    size_t          used;
+    size_t          peak;
+} arena_t;
+
+typedef size_t      arenamark_t;
+
+
+mbool_t     ArenaInit( arena_t* a, size_t size );
+void        ArenaRelease( arena_t* a );
+void*       ArenaAlloc( arena_t* a, size_t size, size_t align );
+arenamark_t ArenaMark( const arena_t* a );
+void        ArenaReset( arena_t* a, arenamark_t mark );
+void        ArenaClear( arena_t* a );
+
+float*      ArenaFloatArray( arena_t* a, int count );
+vec2_t*     ArenaVec2Array( arena_t* a, int count );
+vec3_t*     ArenaVec3Array( arena_t* a, int count );
+vec4_t*     ArenaVec4Array( arena_t* a, int count );
+mat3_t*     ArenaMat3Array( arena_t* a, int count );
+mat4_t*     ArenaMat4Array( arena_t* a, int count );
+
+arena_t*    ArenaFrame( void );
+void        ArenaFrameInit( void );
+void        ArenaFrameRelease( void );
+
+
+
+#endif //__ARENA_H__
@@ -0,0 +1,604 @@
+#include "broadphase.h"
+
+#define SAP_FULL_SORT   4       // полная пересортировка, если изменено больше 1/4 тел
+
+/*
+SapGrowBodies
+
+Увеличить массивы тел до max_bodies элементов.
+*/
+static mbool_t SapGrowBodies( sap_t* sap, int max_bodies ) {
+    aabb_t* bodies = realloc( sap->bodies, max_bodies * sizeof( aabb_t ) );
+    if( bodies == NULL ) {
+        return mfalse;
+    }
+    sap->bodies = bodies;
+
+    mbool_t* alive = realloc( sap->alive, max_bodies * sizeof( mbool_t ) );
+    if( alive == NULL ) {
+        return mfalse;
+    }
+    sap->alive = alive;
+
+    int* free_ids = realloc( sap->free_ids, max_bodies * sizeof( int ) );
+    if( free_ids == NULL ) {
+        return mfalse;
+    }
+    sap->free_ids = free_ids;
+
+    for( int axis = 0; axis < 3; axis++ ) {
+        sapendpoint_t* endpoints = realloc( sap->endpoints[axis], 2 * max_bodies * sizeof( sapendpoint_t ) );
+        if( endpoints == NULL ) {
+            return mfalse;
+        }
+        sap->endpoints[axis] = endpoints;
+
+        int* endpoint_pos = realloc( sap->endpoint_pos[axis], 2 * max_bodies * sizeof( int ) );
+        if( endpoint_pos == NULL ) {
+            return mfalse;
+        }
+        sap->endpoint_pos[axis] = endpoint_pos;
+    }
+
+    int* moved = realloc( sap->moved, max_bodies * sizeof( int ) );
+    if( moved == NULL ) {
+        return mfalse;
+    }
+    sap->moved = moved;
+
+    mbool_t* moved_flag = realloc( sap->moved_flag, max_bodies * sizeof( mbool_t ) );
+    if( moved_flag == NULL ) {
+        return mfalse;
+    }
+    sap->moved_flag = moved_flag;
+
+    int* active = realloc( sap->active, max_bodies * sizeof( int ) );
+    if( active == NULL ) {
+        return mfalse;
+    }
+    sap->active = active;
+
+    int* active_pos = realloc( sap->active_pos, max_bodies * sizeof( int ) );
+    if( active_pos == NULL ) {
+        return mfalse;
+    }
+    sap->active_pos = active_pos;
+
+    sap->max_bodies = max_bodies;
+    return mtrue;
+}
+
+/*
+SapEndpointLess
+
+Порядок конечных точек: по значению, при равенстве минимум идёт раньше
+максимума, чтобы касающиеся тела считались пересекающимися.
+В бесконечности лежат только точки удалённых тел, там наоборот:
+максимум раньше минимума, и удалённые тела не пересекаются между собой.
+*/
+static mbool_t SapEndpointLess( const sapendpoint_t* a, const sapendpoint_t* b ) {
+    if( a->value != b->value ) {
+        return a->value < b->value;
+    }
+    if( a->value == FLOAT_INFINITY ) {
+        return ( a->id & 1 ) > ( b->id & 1 );
+    }
+    return ( a->id & 1 ) < ( b->id & 1 );
+}
+
+static int SapEndpointCmp( const void* a, const void* b ) {
+    if( SapEndpointLess( a, b ) ) {
+        return -1;
+    }
+    if( SapEndpointLess( b, a ) ) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+SapPairSlot
+
+Начальная ячейка хеш-таблицы для пары a < b.
+*/
+static int SapPairSlot( const sap_t* sap, int a, int b ) {
+    unsigned int h = ( unsigned int )a * 0x9E3779B1u ^ ( unsigned int )b * 0x85EBCA77u;
+    return ( int )( ( h ^ ( h >> 15 ) ) & ( unsigned int )sap->pair_mask );
+}
+
+/*
+SapFindSlot
+
+Ячейка хеш-таблицы с парой a < b или -1, если пары нет.
+*/
+static int SapFindSlot( const sap_t* sap, int a, int b ) {
+    if( sap->pair_mask == 0 ) {
+        return -1;
+    }
+    for( int s = SapPairSlot( sap, a, b );; s = ( s + 1 ) & sap->pair_mask ) {
+        int p = sap->pair_slots[s];
+        if( p < 0 ) {
+            return -1;
+        }
+        if( ( sap->pairs[p].a == a ) && ( sap->pairs[p].b == b ) ) {
+            return s;
+        }
+    }
+}
+
+/*
+SapRehash
+
+Хеш-таблица на size ячеек (степень двойки), заполненная парами из pairs.
+*/
+static mbool_t SapRehash( sap_t* sap, int size ) {
+    int* slots = malloc( size * sizeof( int ) );
+    if( slots == NULL ) {
+        return mfalse;
+    }
+    free( sap->pair_slots );
+    sap->pair_slots = slots;
+    sap->pair_mask = size - 1;
+    for( int s = 0; s < size; s++ ) {
+        slots[s] = -1;
+    }
+    for( int p = 0; p < sap->num_pairs; p++ ) {
+        int s = SapPairSlot( sap, sap->pairs[p].a, sap->pairs[p].b );
+        while( slots[s] >= 0 ) {
+            s = ( s + 1 ) & sap->pair_mask;
+        }
+        slots[s] = p;
+    }
+    return mtrue;
+}
+
+/*
+SapAddPair
+
+Добавить пару в множество пар, если её там ещё нет.
+Хеш-таблица заполняется не больше чем наполовину.
+*/
+static mbool_t SapAddPair( sap_t* sap, int a, int b ) {
+    if( a > b ) {
+        int t = a;
+        a = b;
+        b = t;
+    }
+    if( SapFindSlot( sap, a, b ) >= 0 ) {
+        return mtrue;
+    }
+    if( sap->num_pairs == sap->max_pairs ) {
+        int max_pairs = sap->max_pairs ? sap->max_pairs * 2 : 256;
+        sappair_t* pairs = realloc( sap->pairs, max_pairs * sizeof( sappair_t ) );
+        if( pairs == NULL ) {
+            return mfalse;
+        }
+        sap->pairs = pairs;
+        sap->max_pairs = max_pairs;
+    }
+    if( 2 * ( sap->num_pairs + 1 ) > sap->pair_mask ) {
+        if( !SapRehash( sap, sap->pair_mask ? 2 * ( sap->pair_mask + 1 ) : 512 ) ) {
+            return mfalse;
+        }
+    }
+
+    int p = sap->num_pairs++;
+    sap->pairs[p].a = a;
+    sap->pairs[p].b = b;
+    int s = SapPairSlot( sap, a, b );
+    while( sap->pair_slots[s] >= 0 ) {
+        s = ( s + 1 ) & sap->pair_mask;
+    }
+    sap->pair_slots[s] = p;
+    return mtrue;
+}
+
+/*
+SapRemovePair
+
+Удалить пару из множества пар, если она там есть. Освободившуюся ячейку
+занимают следующие за ней пары (без пометок удаления), место пары
+в списке - последняя пара.
+*/
+static void SapRemovePair( sap_t* sap, int a, int b ) {
+    if( a > b ) {
+        int t = a;
+        a = b;
+        b = t;
+    }
+    int s = SapFindSlot( sap, a, b );
+    if( s < 0 ) {
+        return;
+    }
+    int* slots = sap->pair_slots;
+    int mask = sap->pair_mask;
+    int p = slots[s];
+
+    for( int n = ( s + 1 ) & mask; slots[n] >= 0; n = ( n + 1 ) & mask ) {
+        // пару из ячейки n можно перенести в s, если s лежит между её начальной ячейкой и n
+        int home = SapPairSlot( sap, sap->pairs[slots[n]].a, sap->pairs[slots[n]].b );
+        if( ( ( n - home ) & mask ) >= ( ( n - s ) & mask ) ) {
+            slots[s] = slots[n];
+            s = n;
+        }
+    }
+    slots[s] = -1;
+
+    int last = --sap->num_pairs;
+    if( p != last ) {
+        sap->pairs[p] = sap->pairs[last];
+        slots[SapFindSlot( sap, sap->pairs[p].a, sap->pairs[p].b )] = p;
+    }
+}
+
+/*
+SapSwapped
+
+Конечные точки lo и hi двух тел поменялись местами, теперь lo идёт раньше hi.
+Минимум перед чужим максимумом - интервалы на этой оси начали пересекаться,
+пара добавляется, если тела пересекаются и по остальным осям.
+Максимум перед чужим минимумом - интервалы разошлись, пара удаляется.
+*/
+static void SapSwapped( sap_t* sap, int lo, int hi ) {
+    int a = lo >> 1;
+    int b = hi >> 1;
+    if( ( a == b ) || !( ( lo ^ hi ) & 1 ) ) {
+        return;
+    }
+    if( lo & 1 ) {
+        SapRemovePair( sap, a, b );
+    }
+    else if( sap->alive[a] && sap->alive[b] && AabbOverlap( &sap->bodies[a], &sap->bodies[b] ) ) {
+        if( !SapAddPair( sap, a, b ) ) {
+            sap->rebuild = mtrue;
+        }
+    }
+}
+
+/*
+SapMoveEndpoint
+
+Сдвинуть конечную точку с позиции pos на оси axis на её место
+обменами с соседями. Возвращает mtrue, если точка сдвинулась.
+*/
+static mbool_t SapMoveEndpoint( sap_t* sap, int axis, int pos ) {
+    sapendpoint_t* ep = sap->endpoints[axis];
+    int* ep_pos = sap->endpoint_pos[axis];
+    sapendpoint_t e = ep[pos];
+    int i = pos;
+
+    while( ( i > 0 ) && SapEndpointLess( &e, &ep[i - 1] ) ) {
+        SapSwapped( sap, e.id, ep[i - 1].id );
+        ep[i] = ep[i - 1];
+        ep_pos[ep[i].id] = i;
+        i--;
+    }
+    while( ( i + 1 < sap->num_endpoints ) && SapEndpointLess( &ep[i + 1], &e ) ) {
+        SapSwapped( sap, ep[i + 1].id, e.id );
+        ep[i] = ep[i + 1];
+        ep_pos[ep[i].id] = i;
+        i++;
+    }
+    ep[i] = e;
+    ep_pos[e.id] = i;
+    return i != pos;
+}
+
+/*
+SapSortMoved
+
+Досортировка конечных точек изменённых тел на оси axis. Точки остальных
+тел упорядочены между собой, поэтому каждая инверсия затрагивает точку
+изменённого тела; проходы повторяются, пока хоть одна из них сдвигается.
+*/
+static void SapSortMoved( sap_t* sap, int axis ) {
+    mbool_t shifted;
+    do {
+        shifted = mfalse;
+        for( int m = 0; m < sap->num_moved; m++ ) {
+            int id = sap->moved[m];
+            for( int is_max = 0; is_max < 2; is_max++ ) {
+                if( SapMoveEndpoint( sap, axis, sap->endpoint_pos[axis][( id << 1 ) | is_max] ) ) {
+                    shifted = mtrue;
+                }
+            }
+        }
+    } while( shifted );
+}
+
+/*
+SapSortAll
+
+Полная сортировка конечных точек на оси axis, без обновления пар.
+*/
+static void SapSortAll( sap_t* sap, int axis ) {
+    qsort( sap->endpoints[axis], sap->num_endpoints, sizeof( sapendpoint_t ), SapEndpointCmp );
+    for( int i = 0; i < sap->num_endpoints; i++ ) {
+        sap->endpoint_pos[axis][sap->endpoints[axis][i].id] = i;
+    }
+}
+
+/*
+SapRebuildPairs
+
+Построить множество пар заново полным проходом по оси x.
+Нужно после полной сортировки и после того, как пара не добавилась
+из-за нехватки памяти.
+*/
+static mbool_t SapRebuildPairs( sap_t* sap ) {
+    int num_active = 0;
+
+    sap->num_pairs = 0;
+    if( sap->pair_mask != 0 ) {
+        for( int s = 0; s <= sap->pair_mask; s++ ) {
+            sap->pair_slots[s] = -1;
+        }
+    }
+    for( int i = 0; i < sap->num_endpoints; i++ ) {
+        int id = sap->endpoints[0][i].id >> 1;
+        if( !sap->alive[id] ) {
+            continue;
+        }
+
+        if( sap->endpoints[0][i].id & 1 ) {
+            // интервал закрылся - убираем тело из активного списка
+            int pos = sap->active_pos[id];
+            int last = sap->active[--num_active];
+            sap->active[pos] = last;
+            sap->active_pos[last] = pos;
+            continue;
+        }
+
+        const aabb_t* box = &sap->bodies[id];
+        for( int k = 0; k < num_active; k++ ) {
+            const aabb_t* other = &sap->bodies[sap->active[k]];
+            if( ( box->min.y <= other->max.y ) && ( other->min.y <= box->max.y ) &&
+                ( box->min.z <= other->max.z ) && ( other->min.z <= box->max.z ) ) {
+                if( !SapAddPair( sap, id, sap->active[k] ) ) {
+                    return mfalse;
+                }
+            }
+        }
+        sap->active[num_active] = id;
+        sap->active_pos[id] = num_active;
+        num_active++;
+    }
+    return mtrue;
+}
+
+/*
+SapMarkMoved
+
+Запомнить тело id для досортировки при следующем SapUpdate.
+*/
+static void SapMarkMoved( sap_t* sap, int id ) {
+    if( !sap->moved_flag[id] ) {
+        sap->moved_flag[id] = mtrue;
+        sap->moved[sap->num_moved++] = id;
+    }
+}
+
+/*
+SapInit
+
+Инициализация sweep-and-prune на max_bodies тел.
+Массивы увеличиваются автоматически, max_bodies - начальная ёмкость.
+*/
+mbool_t SapInit( sap_t* sap, int max_bodies ) {
+    sap->bodies = NULL;
+    sap->alive = NULL;
+    sap->free_ids = NULL;
+    sap->num_free = 0;
+    sap->num_bodies = 0;
+    sap->max_bodies = 0;
+    for( int axis = 0; axis < 3; axis++ ) {
+        sap->endpoints[axis] = NULL;
+        sap->endpoint_pos[axis] = NULL;
+    }
+    sap->num_endpoints = 0;
+    sap->moved = NULL;
+    sap->moved_flag = NULL;
+    sap->num_moved = 0;
+    sap->active = NULL;
+    sap->active_pos = NULL;
+    sap->pairs = NULL;
+    sap->num_pairs = 0;
+    sap->max_pairs = 0;
+    sap->pair_slots = NULL;
+    sap->pair_mask = 0;
+    sap->rebuild = mfalse;
+
+    if( max_bodies < 16 ) {
+        max_bodies = 16;
+    }
+    if( !SapGrowBodies( sap, max_bodies ) ) {
+        SapRelease( sap );
+        return mfalse;
+    }
+    return mtrue;
+}
+
+/*
+SapRelease
+
+Освобождение памяти sweep-and-prune.
+*/
+void SapRelease( sap_t* sap ) {
+    free( sap->bodies );
+    free( sap->alive );
+    free( sap->free_ids );
+    for( int axis = 0; axis < 3; axis++ ) {
+        free( sap->endpoints[axis] );
+        free( sap->endpoint_pos[axis] );
+        sap->endpoints[axis] = NULL;
+        sap->endpoint_pos[axis] = NULL;
+    }
+    free( sap->moved );
+    free( sap->moved_flag );
+    free( sap->active );
+    free( sap->active_pos );
+    free( sap->pairs );
+    free( sap->pair_slots );
+    sap->bodies = NULL;
+    sap->alive = NULL;
+    sap->free_ids = NULL;
+    sap->moved = NULL;
+    sap->moved_flag = NULL;
+    sap->active = NULL;
+    sap->active_pos = NULL;
+    sap->pairs = NULL;
+    sap->pair_slots = NULL;
+    sap->num_bodies = 0;
+    sap->max_bodies = 0;
+    sap->num_endpoints = 0;
+    sap->num_free = 0;
+    sap->num_moved = 0;
+    sap->num_pairs = 0;
+    sap->max_pairs = 0;
+    sap->pair_mask = 0;
+    sap->rebuild = mfalse;
+}
+
+/*
+SapAddBody
+
+Добавить тело с ограничивающим параллелепипедом box.
+Возвращает номер тела или -1, если не хватило памяти.
+Новые конечные точки встают на место при следующем SapUpdate.
+*/
+int SapAddBody( sap_t* sap, const aabb_t* box ) {
+    int id;
+
+    if( sap->num_free > 0 ) {
+        id = sap->free_ids[--sap->num_free];
+    }
+    else {
+        if( ( sap->num_bodies == sap->max_bodies ) &&
+            !SapGrowBodies( sap, sap->max_bodies * 2 ) ) {
+            return -1;
+        }
+        id = sap->num_bodies++;
+        sap->moved_flag[id] = mfalse;
+
+        // точки нового тела ставятся в конец массивов, за точками всех
+        // остальных тел: ни с кем не пересекается, пары появятся при досортировке
+        for( int axis = 0; axis < 3; axis++ ) {
+            sapendpoint_t* e = &sap->endpoints[axis][sap->num_endpoints];
+            e[0].id = id << 1;
+            e[1].id = ( id << 1 ) | 1;
+            sap->endpoint_pos[axis][e[0].id] = sap->num_endpoints;
+            sap->endpoint_pos[axis][e[1].id] = sap->num_endpoints + 1;
+        }
+        sap->num_endpoints += 2;
+    }
+
+    sap->alive[id] = mtrue;
+    SapSetBody( sap, id, box );
+    return id;
+}
+
+/*
+SapRemoveBody
+
+Удалить тело id. Его номер будет выдан следующему добавленному телу.
+Конечные точки уходят в бесконечность, пары тела удаляются при следующем SapUpdate.
+*/
+void SapRemoveBody( sap_t* sap, int id ) {
+    if( !sap->alive[id] ) {
+        return;
+    }
+    sap->alive[id] = mfalse;
+    for( int axis = 0; axis < 3; axis++ ) {
+        sap->endpoints[axis][sap->endpoint_pos[axis][id << 1]].value = FLOAT_INFINITY;
+        sap->endpoints[axis][sap->endpoint_pos[axis][( id << 1 ) | 1]].value = FLOAT_INFINITY;
+    }
+    sap->free_ids[sap->num_free++] = id;
+    SapMarkMoved( sap, id );
+}
+
+/*
+SapSetBody
+
+Обновить ограничивающий параллелепипед тела id.
+Вызывается только для сдвинувшихся тел, координаты должны быть конечными.
+*/
+void SapSetBody( sap_t* sap, int id, const aabb_t* box ) {
+    sap->bodies[id] = *box;
+    if( !sap->alive[id] ) {
+        return;
+    }
+    for( int axis = 0; axis < 3; axis++ ) {
+        sap->endpoints[axis][sap->endpoint_pos[axis][id << 1]].value = box->min.m[axis];
+        sap->endpoints[axis][sap->endpoint_pos[axis][( id << 1 ) | 1]].value = box->max.m[axis];
+    }
+    SapMarkMoved( sap, id );
+}
+
+/*
+SapUpdate
+
+Досортировать конечные точки тел, изменённых после прошлого вызова,
+и по обменам обновить множество пересекающихся пар. Каждая пара
+хранится ровно один раз, порядок пар в списке не определён.
+Возвращает mfalse, если не хватило памяти под список пар;
+следующий вызов построит его заново.
+*/
+mbool_t SapUpdate( sap_t* sap ) {
+    // когда изменена большая часть тел (например, все только что добавлены),
+    // полная сортировка и проход дешевле досортировки с обменами по одному
+    if( sap->num_moved * SAP_FULL_SORT > sap->num_bodies ) {
+        for( int axis = 0; axis < 3; axis++ ) {
+            SapSortAll( sap, axis );
+        }
+        sap->rebuild = mtrue;
+    }
+    else {
+        for( int axis = 0; axis < 3; axis++ ) {
+            SapSortMoved( sap, axis );
+        }
+    }
+    for( int m = 0; m < sap->num_moved; m++ ) {
+        sap->moved_flag[sap->moved[m]] = mfalse;
+    }
+    sap->num_moved = 0;
+
+    if( sap->rebuild ) {
+        if( !SapRebuildPairs( sap ) ) {
+            return mfalse;
+        }
+        sap->rebuild = mfalse;
+    }
+    return mtrue;
+}
+
+/*
+SapNumPairs
+
+Количество пар, пересекающихся после последнего SapUpdate.
+*/
+int SapNumPairs( const sap_t* sap ) {
+    return sap->num_pairs;
+}
+
+/*
+SapPairs
+
+Пары, пересекающиеся после последнего SapUpdate.
+*/
+const sappair_t* SapPairs( const sap_t* sap ) {
+    return sap->pairs;
+}
+
+/*
+AabbOverlap
+
+Вернуть mtrue, если параллелепипеды a и b пересекаются или касаются.
+*/
+mbool_t AabbOverlap( const aabb_t* a, const aabb_t* b ) {
+    if( ( a->min.x > b->max.x ) || ( b->min.x > a->max.x ) ||
+        ( a->min.y > b->max.y ) || ( b->min.y > a->max.y ) ||
+        ( a->min.z > b->max.z ) || ( b->min.z > a->max.z ) ) {
+        return mfalse;
+    }
+    return mtrue;
+}
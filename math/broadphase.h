@@ -0,0 +1,69 @@
+#ifndef __BROADPHASE_H__
+#define __BROADPHASE_H__
+
+#include "vector.h"
+
+// пара пересекающихся тел, всегда a < b
+typedef struct {
+    int             a;
+    int             b;
+} sappair_t;
+
+// конечная точка интервала тела на оси
+typedef struct {
+    float           value;
+    int             id;             // ( номер тела << 1 ) | признак максимума
+} sapendpoint_t;
+
+/*
+Sweep-and-prune с сортировкой по всем трём осям. Множество пар хранится
+между кадрами: пара пересекается, только если интервалы тел пересекаются
+на каждой оси, а это меняется лишь тогда, когда при сортировке минимум
+одного тела меняется местами с максимумом другого. Поэтому SapUpdate
+досортировывает конечные точки только сдвинувшихся тел и по этим обменам
+добавляет и удаляет пары; время обновления зависит от количества
+сдвинувшихся тел и величины их сдвига, а не от общего числа тел и пар.
+Если изменено больше четверти тел, точки сортируются заново целиком.
+*/
+typedef struct {
+    aabb_t*         bodies;
+    mbool_t*        alive;
+    int*            free_ids;       // стек освободившихся номеров тел
+    int             num_free;
+    int             num_bodies;     // количество выданных номеров (включая свободные)
+    int             max_bodies;
+
+    sapendpoint_t*  endpoints[3];   // отсортированные конечные точки по осям, 2 на тело
+    int*            endpoint_pos[3];// позиция конечной точки в endpoints
+    int             num_endpoints;
+
+    int*            moved;          // тела, изменённые после последнего SapUpdate
+    mbool_t*        moved_flag;
+    int             num_moved;
+
+    int*            active;         // тела, интервалы которых открыты при полном проходе
+    int*            active_pos;
+
+    sappair_t*      pairs;
+    int             num_pairs;
+    int             max_pairs;
+    int*            pair_slots;     // хеш-таблица: номер пары в pairs или -1
+    int             pair_mask;      // размер таблицы - 1, 0 - таблицы нет
+    mbool_t         rebuild;        // пары потеряны из-за нехватки памяти, нужен полный проход
+} sap_t;
+
+
+mbool_t     SapInit( sap_t* sap, int max_bodies );
+void        SapRelease( sap_t* sap );
+int         SapAddBody( sap_t* sap, const aabb_t* box );
+void        SapRemoveBody( sap_t* sap, int id );
+void        SapSetBody( sap_t* sap, int id, const aabb_t* box );
+mbool_t     SapUpdate( sap_t* sap );
+int         SapNumPairs( const sap_t* sap );
+const sappair_t* SapPairs( const sap_t* sap );
+
+mbool_t     AabbOverlap( const aabb_t* a, const aabb_t* b );
+
+
+
+#endif //__BROADPHASE_H__
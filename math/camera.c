@@ -0,0 +1,179 @@
+#include "camera.h"
+#include "value.h"
+#include "pool.h"
+
+/*
+CameraPerspective
+
+Построение матрицы перспективной проекции proj и обратной к ней inv.
+Обратная матрица записывается по известной структуре проекции
+без вызова Mat4Inv. inv может быть NULL.
+*/
+void CameraPerspective( mat4_t* proj, mat4_t* inv, const perspective_t* p ) {
+    float sy = 1.0f / tan1f( p->fovy * 0.5f );
+    float sx = sy / p->aspect;
+    float zn = p->znear;
+    float zf = p->zfar;
+    float a, b; // z' = a * z + b * w
+
+    if( p->flags & CAMERA_INFINITE_FAR ) {
+        if( p->flags & CAMERA_REVERSED_Z ) {
+            a = 0.0f;
+            b = zn;
+        }
+        else {
+            a = -1.0f;
+            b = -zn;
+        }
+    }
+    else if( p->flags & CAMERA_REVERSED_Z ) {
+        a = zn / ( zf - zn );
+        b = zn * zf / ( zf - zn );
+    }
+    else {
+        a = zf / ( zn - zf );
+        b = zn * zf / ( zn - zf );
+    }
+
+    Mat4Set16f( proj, sx,   0.0f, 0.0f,  0.0f,
+                      0.0f, sy,   0.0f,  0.0f,
+                      0.0f, 0.0f, a,     b,
+                      0.0f, 0.0f, -1.0f, 0.0f );
+
+    if( inv != NULL ) {
+        // x = x' / sx, y = y' / sy, z = -w', w = ( z' + a * w' ) / b
+        float inv_b = 1.0f / b;
+        Mat4Set16f( inv, 1.0f / sx, 0.0f,      0.0f,  0.0f,
+                         0.0f,      1.0f / sy, 0.0f,  0.0f,
+                         0.0f,      0.0f,      0.0f,  -1.0f,
+                         0.0f,      0.0f,      inv_b, a * inv_b );
+    }
+}
+
+/*
+CameraOrtho
+
+Построение матрицы ортографической проекции proj и обратной к ней inv.
+Флаг CAMERA_INFINITE_FAR не используется. inv может быть NULL.
+*/
+void CameraOrtho( mat4_t* proj, mat4_t* inv, const ortho_t* p ) {
+    float inv_w = 1.0f / ( p->right - p->left );
+    float inv_h = 1.0f / ( p->top - p->bottom );
+    float inv_d = 1.0f / ( p->zfar - p->znear );
+
+    float sx = 2.0f * inv_w;
+    float sy = 2.0f * inv_h;
+    float tx = -( p->right + p->left ) * inv_w;
+    float ty = -( p->top + p->bottom ) * inv_h;
+    float sz, tz;
+
+    if( p->flags & CAMERA_REVERSED_Z ) {
+        sz = inv_d;
+        tz = p->zfar * inv_d;
+    }
+    else {
+        sz = -inv_d;
+        tz = -p->znear * inv_d;
+    }
+
+    Mat4Set16f( proj, sx,   0.0f, 0.0f, tx,
+                      0.0f, sy,   0.0f, ty,
+                      0.0f, 0.0f, sz,   tz,
+                      0.0f, 0.0f, 0.0f, 1.0f );
+
+    if( inv != NULL ) {
+        Mat4Set16f( inv, 1.0f / sx, 0.0f,      0.0f,      -tx / sx,
+                         0.0f,      1.0f / sy, 0.0f,      -ty / sy,
+                         0.0f,      0.0f,      1.0f / sz, -tz / sz,
+                         0.0f,      0.0f,      0.0f,      1.0f );
+    }
+}
+
+/*
+CameraLookAt
+
+Построение видовой матрицы view для камеры в точке eye, направленной на target,
+и обратной к ней inv. Видовая матрица - движение, поэтому обратная к ней -
+транспонированный поворот и позиция камеры. inv может быть NULL.
+*/
+void CameraLookAt( mat4_t* view, mat4_t* inv, const lookat_t* p ) {
+    vec3_t f = Vec3NormVal( Vec3SubVal( p->target, p->eye ) );
+    vec3_t s = Vec3NormVal( Vec3CrossVal( f, p->up ) );
+    vec3_t u = Vec3CrossVal( s, f );
+    vec3_t e = p->eye;
+
+    Mat4Set16f( view, s.x,  s.y,  s.z,  -Vec3DotVal( s, e ),
+                      u.x,  u.y,  u.z,  -Vec3DotVal( u, e ),
+                      -f.x, -f.y, -f.z, Vec3DotVal( f, e ),
+                      0.0f, 0.0f, 0.0f, 1.0f );
+
+    if( inv != NULL ) {
+        Mat4Set16f( inv, s.x, u.x, -f.x, e.x,
+                         s.y, u.y, -f.y, e.y,
+                         s.z, u.z, -f.z, e.z,
+                         0.0f, 0.0f, 0.0f, 1.0f );
+    }
+}
+
+// аргументы Camera*Array для PoolParallelFor: параметры одного вида в p
+typedef struct {
+    mat4_t*         proj;
+    mat4_t*         inv;
+    const void*     p;
+} cameraarray_t;
+
+static void CameraPerspectiveChunk( void* ctx, int begin, int end ) {
+    const cameraarray_t* job = ctx;
+    const perspective_t* p = job->p;
+    for( int i = begin; i < end; i++ ) {
+        CameraPerspective( &job->proj[i], job->inv != NULL ? &job->inv[i] : NULL, &p[i] );
+    }
+}
+
+static void CameraOrthoChunk( void* ctx, int begin, int end ) {
+    const cameraarray_t* job = ctx;
+    const ortho_t* p = job->p;
+    for( int i = begin; i < end; i++ ) {
+        CameraOrtho( &job->proj[i], job->inv != NULL ? &job->inv[i] : NULL, &p[i] );
+    }
+}
+
+static void CameraLookAtChunk( void* ctx, int begin, int end ) {
+    const cameraarray_t* job = ctx;
+    const lookat_t* p = job->p;
+    for( int i = begin; i < end; i++ ) {
+        CameraLookAt( &job->proj[i], job->inv != NULL ? &job->inv[i] : NULL, &p[i] );
+    }
+}
+
+/*
+CameraPerspectiveArray
+
+Построение count перспективных проекций, например для нескольких видов,
+чанками между потоками пула. inv может быть NULL.
+*/
+void CameraPerspectiveArray( mat4_t* proj, mat4_t* inv, const perspective_t* p, int count ) {
+    cameraarray_t job = { proj, inv, p };
+    PoolParallelFor( CameraPerspectiveChunk, &job, count, PoolChunk( 2 * sizeof( mat4_t ) + sizeof( perspective_t ) ) );
+}
+
+/*
+CameraOrthoArray
+
+Построение count ортографических проекций, например для каскадов теней,
+чанками между потоками пула. inv может быть NULL.
+*/
+void CameraOrthoArray( mat4_t* proj, mat4_t* inv, const ortho_t* p, int count ) {
+    cameraarray_t job = { proj, inv, p };
+    PoolParallelFor( CameraOrthoChunk, &job, count, PoolChunk( 2 * sizeof( mat4_t ) + sizeof( ortho_t ) ) );
+}
+
+/*
+CameraLookAtArray
+
+Построение count видовых матриц чанками между потоками пула. inv может быть NULL.
+*/
+void CameraLookAtArray( mat4_t* view, mat4_t* inv, const lookat_t* p, int count ) {
+    cameraarray_t job = { view, inv, p };
+    PoolParallelFor( CameraLookAtChunk, &job, count, PoolChunk( 2 * sizeof( mat4_t ) + sizeof( lookat_t ) ) );
+}
@@ -0,0 +1,52 @@
+#ifndef __CAMERA_H__
+#define __CAMERA_H__
+
+#include "matrix.h"
+
+/*
+Правая система координат, камера смотрит вдоль -z.
+Глубина в пространстве отсечения лежит в пределах [0, 1]
+(при CAMERA_REVERSED_Z ближняя плоскость - 1, дальняя - 0).
+*/
+
+#define CAMERA_REVERSED_Z       0x1     // обратная глубина
+#define CAMERA_INFINITE_FAR     0x2     // дальняя плоскость в бесконечности (только перспектива)
+
+// параметры перспективной проекции
+typedef struct {
+    float           fovy;       // вертикальный угол обзора в радианах
+    float           aspect;     // ширина / высота
+    float           znear;
+    float           zfar;       // не используется при CAMERA_INFINITE_FAR
+    int             flags;
+} perspective_t;
+
+// параметры ортографической проекции
+typedef struct {
+    float           left;
+    float           right;
+    float           bottom;
+    float           top;
+    float           znear;
+    float           zfar;
+    int             flags;
+} ortho_t;
+
+// параметры видовой матрицы
+typedef struct {
+    vec3_t          eye;
+    vec3_t          target;
+    vec3_t          up;
+} lookat_t;
+
+
+void        CameraPerspective( mat4_t* proj, mat4_t* inv, const perspective_t* p );
+void        CameraOrtho( mat4_t* proj, mat4_t* inv, const ortho_t* p );
+void        CameraLookAt( mat4_t* view, mat4_t* inv, const lookat_t* p );
+void        CameraPerspectiveArray( mat4_t* proj, mat4_t* inv, const perspective_t* p, int count );
+void        CameraOrthoArray( mat4_t* proj, mat4_t* inv, const ortho_t* p, int count );
+void        CameraLookAtArray( mat4_t* view, mat4_t* inv, const lookat_t* p, int count );
+
+
+
+#endif //__CAMERA_H__
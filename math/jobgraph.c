@@ -0,0 +1,316 @@
+#include <string.h>
+
+#include "jobgraph.h"
+
+#if defined( __GNUC__ )
+#define JOB_LOAD( p )           __atomic_load_n( p, __ATOMIC_ACQUIRE )
+#define JOB_STORE( p, v )       __atomic_store_n( p, v, __ATOMIC_RELEASE )
+#define JOB_FETCH_ADD( p, v )   __atomic_fetch_add( p, v, __ATOMIC_ACQ_REL )
+#define JOB_SUB_FETCH( p, v )   __atomic_sub_fetch( p, v, __ATOMIC_ACQ_REL )
+#define JOB_CAS( p, e, v )      __atomic_compare_exchange_n( p, e, v, 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE )
+#else
+// без GCC пул работает в одном потоке, атомарность не нужна
+#define JOB_LOAD( p )           ( *( p ) )
+#define JOB_STORE( p, v )       ( *( p ) = ( v ) )
+#define JOB_FETCH_ADD( p, v )   ( ( *( p ) += ( v ) ) - ( v ) )
+#define JOB_SUB_FETCH( p, v )   ( *( p ) -= ( v ) )
+#define JOB_CAS( p, e, v )      ( *( p ) == *( e ) ? ( *( p ) = ( v ), 1 ) : ( *( e ) = *( p ), 0 ) )
+#endif
+
+#if defined( __GNUC__ ) && !defined( _WIN32 )
+#include <sched.h>
+#define JOB_YIELD()             sched_yield()
+#else
+#define JOB_YIELD()
+#endif
+
+/*
+JobGraphInit
+
+Подготовка пустого графа на max_tasks заданий (чанков и барьеров) и
+max_edges зависимостей между заданиями. Память берётся из arena.
+Возвращает mfalse, если в арене не хватило места.
+*/
+mbool_t JobGraphInit( jobgraph_t* g, arena_t* arena, int max_tasks, int max_edges ) {
+    memset( g, 0, sizeof( jobgraph_t ) );
+    g->tasks = ArenaAlloc( arena, ( size_t )max_tasks * sizeof( jobtask_t ), ARENA_ALIGN );
+    g->edges = ArenaAlloc( arena, ( size_t )max_edges * 2 * sizeof( int ), ARENA_ALIGN );
+    g->succ = ArenaAlloc( arena, ( size_t )max_edges * sizeof( int ), ARENA_ALIGN );
+    g->queue = ArenaAlloc( arena, ( size_t )max_tasks * sizeof( int ), ARENA_ALIGN );
+    g->max_tasks = max_tasks;
+    g->max_edges = max_edges;
+    g->overflow = ( g->tasks == NULL ) || ( g->edges == NULL ) || ( g->succ == NULL ) || ( g->queue == NULL );
+    return !g->overflow;
+}
+
+static int JobGraphAddTask( jobgraph_t* g, int stage, int begin, int end ) {
+    if( g->num_tasks >= g->max_tasks ) {
+        g->overflow = mtrue;
+        return -1;
+    }
+    jobtask_t* t = &g->tasks[g->num_tasks];
+    t->stage = stage;
+    t->begin = begin;
+    t->end = end;
+    t->deps = 0;
+    t->num_succ = 0;
+    return g->num_tasks++;
+}
+
+static void JobGraphAddEdge( jobgraph_t* g, int from, int to ) {
+    if( ( from < 0 ) || ( to < 0 ) || ( g->num_edges >= g->max_edges ) ) {
+        g->overflow = mtrue;
+        return;
+    }
+    g->edges[2 * g->num_edges] = from;
+    g->edges[2 * g->num_edges + 1] = to;
+    g->num_edges++;
+    g->tasks[from].num_succ++;
+    g->tasks[to].deps++;
+}
+
+/*
+JobGraphStage
+
+Добавление этапа: kernel для [0, count) чанками по chunk элементов
+(chunk <= 0 - PoolChunk( 64 )). Возвращает номер этапа или -1 при переполнении.
+*/
+int JobGraphStage( jobgraph_t* g, poolkernel_t kernel, void* ctx, int count, int chunk ) {
+    if( g->num_stages >= JOB_MAX_STAGES ) {
+        g->overflow = mtrue;
+        return -1;
+    }
+    int s = g->num_stages++;
+    jobstage_t* st = &g->stages[s];
+    st->kernel = kernel;
+    st->ctx = ctx;
+    st->count = count > 0 ? count : 0;
+    st->chunk = chunk > 0 ? chunk : PoolChunk( 64 );
+    st->first_task = g->num_tasks;
+    st->num_tasks = 0;
+    st->barrier = -1;
+    for( int begin = 0; begin < st->count; begin += st->chunk ) {
+        if( JobGraphAddTask( g, s, begin, st->count - begin < st->chunk ? st->count : begin + st->chunk ) < 0 ) {
+            break;
+        }
+        st->num_tasks++;
+    }
+    return s;
+}
+
+/*
+JobGraphDepend
+
+Зависимость этапа stage от этапа on. JOB_DEP_CHUNK - чанк stage ждёт только
+чанки on с теми же номерами элементов (элементы за пределами on ни от чего
+не зависят); JOB_DEP_ALL - ждёт весь этап on (через одно задание-барьер,
+поэтому число зависимостей растёт линейно, а не как произведение числа чанков).
+*/
+void JobGraphDepend( jobgraph_t* g, int stage, int on, jobdep_t dep ) {
+    if( ( stage < 0 ) || ( on < 0 ) || ( stage >= g->num_stages ) || ( on >= g->num_stages ) ) {
+        g->overflow = mtrue;
+        return;
+    }
+    jobstage_t* st = &g->stages[stage];
+    jobstage_t* so = &g->stages[on];
+
+    if( dep == JOB_DEP_ALL ) {
+        if( so->barrier < 0 ) {
+            so->barrier = JobGraphAddTask( g, -1, 0, 0 );
+            for( int k = 0; k < so->num_tasks; k++ ) {
+                JobGraphAddEdge( g, so->first_task + k, so->barrier );
+            }
+        }
+        for( int k = 0; k < st->num_tasks; k++ ) {
+            JobGraphAddEdge( g, so->barrier, st->first_task + k );
+        }
+        return;
+    }
+
+    for( int k = 0; k < st->num_tasks; k++ ) {
+        const jobtask_t* t = &g->tasks[st->first_task + k];
+        int last = ( t->end < so->count ? t->end : so->count ) - 1;
+        for( int c = t->begin / so->chunk; ( t->begin < so->count ) && ( c <= last / so->chunk ); c++ ) {
+            JobGraphAddEdge( g, so->first_task + c, st->first_task + k );
+        }
+    }
+}
+
+/*
+JobGraphDependChunk
+
+Зависимость чанка chunk этапа stage от чанка on_chunk этапа on.
+*/
+void JobGraphDependChunk( jobgraph_t* g, int stage, int chunk, int on, int on_chunk ) {
+    if( ( stage < 0 ) || ( on < 0 ) || ( stage >= g->num_stages ) || ( on >= g->num_stages ) ||
+        ( chunk < 0 ) || ( chunk >= g->stages[stage].num_tasks ) || ( on_chunk < 0 ) || ( on_chunk >= g->stages[on].num_tasks ) ) {
+        g->overflow = mtrue;
+        return;
+    }
+    JobGraphAddEdge( g, g->stages[on].first_task + on_chunk, g->stages[stage].first_task + chunk );
+}
+
+/*
+JobGraphDependIndex
+
+Элемент i этапа stage зависит от элемента index[i] этапа on (отрицательные
+номера пропускаются), например, мировая матрица узла - от матрицы родителя.
+При stage == on зависимость внутри одного чанка не добавляется: ядро
+обрабатывает элементы по порядку, поэтому index[i] должен быть меньше i.
+*/
+void JobGraphDependIndex( jobgraph_t* g, int stage, int on, const int* index ) {
+    if( ( stage < 0 ) || ( on < 0 ) || ( stage >= g->num_stages ) || ( on >= g->num_stages ) ) {
+        g->overflow = mtrue;
+        return;
+    }
+    const jobstage_t* st = &g->stages[stage];
+    const jobstage_t* so = &g->stages[on];
+    for( int k = 0; k < st->num_tasks; k++ ) {
+        const jobtask_t* t = &g->tasks[st->first_task + k];
+        int prev = -1;
+        for( int i = t->begin; i < t->end; i++ ) {
+            if( ( index[i] < 0 ) || ( index[i] >= so->count ) ) {
+                continue;
+            }
+            int c = index[i] / so->chunk;
+            // соседние элементы обычно зависят от одного чанка - повтор не добавляется
+            if( ( c == prev ) || ( ( stage == on ) && ( c == k ) ) ) {
+                continue;
+            }
+            JobGraphAddEdge( g, so->first_task + c, st->first_task + k );
+            prev = c;
+        }
+    }
+}
+
+static void JobGraphPush( jobgraph_t* g, int task ) {
+    int pos = JOB_FETCH_ADD( &g->tail, 1 );
+    JOB_STORE( &g->queue[pos], task );
+}
+
+/*
+JobGraphPop
+
+Готовое задание из очереди или -1, если очередь пуста. Каждое задание
+кладётся в очередь не больше одного раза, поэтому очередь не зацикливается.
+*/
+static int JobGraphPop( jobgraph_t* g ) {
+    int h = JOB_LOAD( &g->head );
+    for( ;; ) {
+        if( h >= JOB_LOAD( &g->tail ) ) {
+            return -1;
+        }
+        if( JOB_CAS( &g->head, &h, h + 1 ) ) {
+            break;
+        }
+    }
+    // место уже занято писателем, но номер задания мог ещё не появиться
+    int task;
+    while( ( task = JOB_LOAD( &g->queue[h] ) ) < 0 ) {
+    }
+    return task;
+}
+
+static void JobGraphWorker( void* ctx, int thread ) {
+    jobgraph_t* g = ctx;
+    int task = -1;
+    int idle = 0;
+    ( void )thread;
+    for( ;; ) {
+        if( task < 0 ) {
+            task = JobGraphPop( g );
+        }
+        if( task < 0 ) {
+            if( JOB_LOAD( &g->done ) == g->num_tasks ) {
+                return;
+            }
+            if( ++idle > 64 ) {
+                JOB_YIELD();
+            }
+            continue;
+        }
+        idle = 0;
+
+        const jobtask_t* t = &g->tasks[task];
+        if( t->stage >= 0 ) {
+            const jobstage_t* st = &g->stages[t->stage];
+            st->kernel( st->ctx, t->begin, t->end );
+        }
+
+        // первый готовый последователь выполняется этим же потоком
+        int next = -1;
+        for( int i = 0; i < t->num_succ; i++ ) {
+            int s = g->succ[t->first_succ + i];
+            if( JOB_SUB_FETCH( &g->tasks[s].pending, 1 ) == 0 ) {
+                if( next < 0 ) {
+                    next = s;
+                }
+                else {
+                    JobGraphPush( g, s );
+                }
+            }
+        }
+        JOB_FETCH_ADD( &g->done, 1 );
+        task = next;
+    }
+}
+
+/*
+JobGraphRun
+
+Выполнение всех заданий графа на потоках пула и возврат после завершения.
+Возвращает mfalse, не выполнив ни одного задания, если при построении
+не хватило места или зависимости образуют цикл.
+*/
+mbool_t JobGraphRun( jobgraph_t* g ) {
+    if( g->overflow ) {
+        return mfalse;
+    }
+
+    // последователи каждого задания подряд в succ
+    int pos = 0;
+    for( int i = 0; i < g->num_tasks; i++ ) {
+        g->tasks[i].first_succ = pos;
+        pos += g->tasks[i].num_succ;
+        g->tasks[i].num_succ = 0;
+    }
+    for( int e = 0; e < g->num_edges; e++ ) {
+        jobtask_t* from = &g->tasks[g->edges[2 * e]];
+        g->succ[from->first_succ + from->num_succ++] = g->edges[2 * e + 1];
+    }
+
+    // проверка на циклы обходом Кана в том же порядке, в каком задания станут готовыми
+    int n = 0;
+    for( int i = 0; i < g->num_tasks; i++ ) {
+        g->tasks[i].pending = g->tasks[i].deps;
+        if( g->tasks[i].deps == 0 ) {
+            g->queue[n++] = i;
+        }
+    }
+    for( int q = 0; q < n; q++ ) {
+        const jobtask_t* t = &g->tasks[g->queue[q]];
+        for( int i = 0; i < t->num_succ; i++ ) {
+            if( --g->tasks[g->succ[t->first_succ + i]].pending == 0 ) {
+                g->queue[n++] = g->succ[t->first_succ + i];
+            }
+        }
+    }
+    if( n != g->num_tasks ) {
+        return mfalse;
+    }
+
+    g->head = 0;
+    g->tail = 0;
+    g->done = 0;
+    for( int i = 0; i < g->num_tasks; i++ ) {
+        g->tasks[i].pending = g->tasks[i].deps;
+        g->queue[i] = -1;
+    }
+    for( int i = 0; i < g->num_tasks; i++ ) {
+        if( g->tasks[i].deps == 0 ) {
+            g->queue[g->tail++] = i;
+        }
+    }
+    PoolRun( JobGraphWorker, g );
+    return mtrue;
+}
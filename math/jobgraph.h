@@ -0,0 +1,81 @@
+#ifndef __JOBGRAPH_H__
+#define __JOBGRAPH_H__
+
+#include "pool.h"
+#include "arena.h"
+
+#define JOB_MAX_STAGES  32
+
+/*
+Граф заданий кадра над чанками массивов. Этап - ядро poolkernel_t,
+разбитое на чанки, как в PoolParallelFor; зависимости задаются между
+этапами или между отдельными чанками. Задание запускается, как только
+выполнены все задания, от которых оно зависит, без общих барьеров
+между этапами: например, отсечение чанка k начинается сразу после
+вычисления мировых матриц этого чанка.
+
+Поток, закончивший задание, уменьшает счётчики зависимостей его
+последователей; первого готового он выполняет сам (продолжение),
+остальных кладёт в общую очередь для других потоков пула.
+
+Вся память графа берётся из арены (обычно ArenaFrame) при JobGraphInit
+и освобождается вместе с ней. Граф одноразовый: после JobGraphRun
+его можно только сбросить вместе с ареной.
+*/
+
+// вид зависимости этапа от другого этапа
+typedef enum {
+    JOB_DEP_CHUNK = 0,      // чанк зависит от чанков, покрывающих тот же диапазон элементов
+    JOB_DEP_ALL             // каждый чанк зависит от всего этапа
+} jobdep_t;
+
+// один этап графа
+typedef struct {
+    poolkernel_t    kernel;
+    void*           ctx;
+    int             count;
+    int             chunk;
+    int             first_task;
+    int             num_tasks;
+    int             barrier;    // задание-барьер после этапа для JOB_DEP_ALL, -1 - ещё нет
+} jobstage_t;
+
+// одно задание - чанк этапа или пустой барьер
+typedef struct {
+    int             stage;      // -1 для барьера
+    int             begin;
+    int             end;
+    int             deps;       // число заданий, от которых зависит
+    int             pending;    // невыполненные зависимости во время JobGraphRun
+    int             first_succ; // последователи в succ[first_succ .. first_succ + num_succ)
+    int             num_succ;
+} jobtask_t;
+
+typedef struct {
+    jobstage_t      stages[JOB_MAX_STAGES];
+    int             num_stages;
+    jobtask_t*      tasks;
+    int             num_tasks;
+    int             max_tasks;
+    int*            edges;      // пары ( от, к ) до JobGraphRun
+    int             num_edges;
+    int             max_edges;
+    int*            succ;
+    int*            queue;      // готовые задания, каждое попадает в очередь один раз
+    int             head;
+    int             tail;
+    int             done;
+    mbool_t         overflow;   // не хватило места под задания или зависимости
+} jobgraph_t;
+
+
+mbool_t     JobGraphInit( jobgraph_t* g, arena_t* arena, int max_tasks, int max_edges );
+int         JobGraphStage( jobgraph_t* g, poolkernel_t kernel, void* ctx, int count, int chunk );
+void        JobGraphDepend( jobgraph_t* g, int stage, int on, jobdep_t dep );
+void        JobGraphDependChunk( jobgraph_t* g, int stage, int chunk, int on, int on_chunk );
+void        JobGraphDependIndex( jobgraph_t* g, int stage, int on, const int* index );
+mbool_t     JobGraphRun( jobgraph_t* g );
+
+
+
+#endif //__JOBGRAPH_H__
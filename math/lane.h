@@ -0,0 +1,153 @@
+#ifndef __LANE_H__
+#define __LANE_H__
+
+#include "math_base.h"
+
+/*
+Полоса lanef_t - LANE_WIDTH чисел float, над которыми одна операция
+выполняется сразу: при сборке с AVX - 8, с SSE - 4, без них - 1.
+Ядра, записанные через функции Lane*, одинаково собираются на всех
+трёх уровнях. Ветвления заменяются масками сравнения (LaneLt) и
+выбором (LaneSel), поэтому все элементы полосы проходят одни и те же команды.
+*/
+
+#if defined( __SSE__ )
+#include <xmmintrin.h>
+
+#define LANE_FTZ_DAZ    0x8040          // биты FTZ и DAZ регистра MXCSR
+
+/*
+LaneFtzBegin
+
+Включение сброса денормализованных чисел в ноль. Возвращает прежнее
+состояние для LaneFtzEnd.
+*/
+static inline unsigned int LaneFtzBegin( void ) {
+    unsigned int csr = _mm_getcsr();
+    _mm_setcsr( csr | LANE_FTZ_DAZ );
+    return csr;
+}
+
+static inline void LaneFtzEnd( unsigned int csr ) {
+    _mm_setcsr( csr );
+}
+
+#else
+
+static inline unsigned int LaneFtzBegin( void ) { return 0; }
+static inline void LaneFtzEnd( unsigned int csr ) { ( void )csr; }
+
+#endif
+
+#if defined( __AVX__ )
+#include <immintrin.h>
+
+#define LANE_WIDTH      8
+
+typedef __m256 lanef_t;
+
+static inline lanef_t LaneSet1( float f )                       { return _mm256_set1_ps( f ); }
+static inline lanef_t LaneLoad( const float* p )                { return _mm256_loadu_ps( p ); }
+static inline void    LaneStore( float* p, lanef_t a )          { _mm256_storeu_ps( p, a ); }
+static inline lanef_t LaneAdd( lanef_t a, lanef_t b )           { return _mm256_add_ps( a, b ); }
+static inline lanef_t LaneSub( lanef_t a, lanef_t b )           { return _mm256_sub_ps( a, b ); }
+static inline lanef_t LaneMul( lanef_t a, lanef_t b )           { return _mm256_mul_ps( a, b ); }
+static inline lanef_t LaneDiv( lanef_t a, lanef_t b )           { return _mm256_div_ps( a, b ); }
+static inline lanef_t LaneLt( lanef_t a, lanef_t b )            { return _mm256_cmp_ps( a, b, _CMP_LT_OQ ); }
+static inline lanef_t LaneSel( lanef_t m, lanef_t a, lanef_t b ) { return _mm256_blendv_ps( b, a, m ); }
+static inline lanef_t LaneMin( lanef_t a, lanef_t b )           { return _mm256_min_ps( a, b ); }
+static inline lanef_t LaneMax( lanef_t a, lanef_t b )           { return _mm256_max_ps( a, b ); }
+static inline lanef_t LaneAbs( lanef_t a )                      { return _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), a ); }
+static inline lanef_t LaneFloor( lanef_t a )                    { return _mm256_floor_ps( a ); }
+static inline lanef_t LaneSqrt( lanef_t a )                     { return _mm256_sqrt_ps( a ); }
+static inline lanef_t LaneRsqrt( lanef_t a ) {
+    // приближение rsqrt уточняется одним шагом Ньютона
+    lanef_t r = _mm256_rsqrt_ps( a );
+    lanef_t h = _mm256_mul_ps( _mm256_mul_ps( _mm256_set1_ps( 0.5f ), a ), _mm256_mul_ps( r, r ) );
+    return _mm256_mul_ps( r, _mm256_sub_ps( _mm256_set1_ps( 1.5f ), h ) );
+}
+
+#elif defined( __SSE__ )
+#if defined( __SSE4_1__ )
+#include <smmintrin.h>
+#elif defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+#define LANE_WIDTH      4
+
+typedef __m128 lanef_t;
+
+static inline lanef_t LaneSet1( float f )                       { return _mm_set1_ps( f ); }
+static inline lanef_t LaneLoad( const float* p )                { return _mm_loadu_ps( p ); }
+static inline void    LaneStore( float* p, lanef_t a )          { _mm_storeu_ps( p, a ); }
+static inline lanef_t LaneAdd( lanef_t a, lanef_t b )           { return _mm_add_ps( a, b ); }
+static inline lanef_t LaneSub( lanef_t a, lanef_t b )           { return _mm_sub_ps( a, b ); }
+static inline lanef_t LaneMul( lanef_t a, lanef_t b )           { return _mm_mul_ps( a, b ); }
+static inline lanef_t LaneDiv( lanef_t a, lanef_t b )           { return _mm_div_ps( a, b ); }
+static inline lanef_t LaneLt( lanef_t a, lanef_t b )            { return _mm_cmplt_ps( a, b ); }
+static inline lanef_t LaneSel( lanef_t m, lanef_t a, lanef_t b ) { return _mm_or_ps( _mm_and_ps( m, a ), _mm_andnot_ps( m, b ) ); }
+static inline lanef_t LaneMin( lanef_t a, lanef_t b )           { return _mm_min_ps( a, b ); }
+static inline lanef_t LaneMax( lanef_t a, lanef_t b )           { return _mm_max_ps( a, b ); }
+static inline lanef_t LaneAbs( lanef_t a )                      { return _mm_andnot_ps( _mm_set1_ps( -0.0f ), a ); }
+static inline lanef_t LaneFloor( lanef_t a ) {
+#if defined( __SSE4_1__ )
+    return _mm_floor_ps( a );
+#elif defined( __SSE2__ )
+    // отбрасывание дробной части и поправка для отрицательных; числа
+    // с |a| >= 2^23 уже целые (и не влезли бы в int32), они и NaN возвращаются как есть
+    lanef_t t = _mm_cvtepi32_ps( _mm_cvttps_epi32( a ) );
+    t = _mm_sub_ps( t, _mm_and_ps( _mm_cmpgt_ps( t, a ), _mm_set1_ps( 1.0f ) ) );
+    lanef_t small = _mm_cmplt_ps( _mm_andnot_ps( _mm_set1_ps( -0.0f ), a ), _mm_set1_ps( 8388608.0f ) );
+    return _mm_or_ps( _mm_and_ps( small, t ), _mm_andnot_ps( small, a ) );
+#else
+    float buf[4];
+    _mm_storeu_ps( buf, a );
+    return _mm_setr_ps( floorf( buf[0] ), floorf( buf[1] ), floorf( buf[2] ), floorf( buf[3] ) );
+#endif
+}
+static inline lanef_t LaneSqrt( lanef_t a )                     { return _mm_sqrt_ps( a ); }
+static inline lanef_t LaneRsqrt( lanef_t a ) {
+    // приближение rsqrt уточняется одним шагом Ньютона
+    lanef_t r = _mm_rsqrt_ps( a );
+    lanef_t h = _mm_mul_ps( _mm_mul_ps( _mm_set1_ps( 0.5f ), a ), _mm_mul_ps( r, r ) );
+    return _mm_mul_ps( r, _mm_sub_ps( _mm_set1_ps( 1.5f ), h ) );
+}
+
+#else
+
+#define LANE_WIDTH      1
+
+typedef float lanef_t;
+
+static inline lanef_t LaneSet1( float f )                       { return f; }
+static inline lanef_t LaneLoad( const float* p )                { return *p; }
+static inline void    LaneStore( float* p, lanef_t a )          { *p = a; }
+static inline lanef_t LaneAdd( lanef_t a, lanef_t b )           { return a + b; }
+static inline lanef_t LaneSub( lanef_t a, lanef_t b )           { return a - b; }
+static inline lanef_t LaneMul( lanef_t a, lanef_t b )           { return a * b; }
+static inline lanef_t LaneDiv( lanef_t a, lanef_t b )           { return a / b; }
+static inline lanef_t LaneLt( lanef_t a, lanef_t b )            { return a < b ? 1.0f : 0.0f; }
+static inline lanef_t LaneSel( lanef_t m, lanef_t a, lanef_t b ) { return m != 0.0f ? a : b; }
+static inline lanef_t LaneMin( lanef_t a, lanef_t b )           { return a < b ? a : b; }
+static inline lanef_t LaneMax( lanef_t a, lanef_t b )           { return a > b ? a : b; }
+static inline lanef_t LaneAbs( lanef_t a )                      { return fabsf( a ); }
+static inline lanef_t LaneFloor( lanef_t a )                    { return floorf( a ); }
+static inline lanef_t LaneSqrt( lanef_t a )                     { return sqrtf( a ); }
+static inline lanef_t LaneRsqrt( lanef_t a )                    { return 1.0f / sqrtf( a ); }
+
+#endif
+
+// a + ( b - a ) * f
+static inline lanef_t LaneLerp( lanef_t a, lanef_t b, lanef_t f ) {
+    return LaneAdd( a, LaneMul( LaneSub( b, a ), f ) );
+}
+
+// дробная часть a - floor( a )
+static inline lanef_t LaneFrac( lanef_t a ) {
+    return LaneSub( a, LaneFloor( a ) );
+}
+
+
+
+#endif //__LANE_H__
@@ -0,0 +1,297 @@
+#include <float.h>
+
+#include "lu.h"
+#include "pool.h"
+
+#if defined( _MSC_VER )
+#include <windows.h>
+#endif
+
+/*
+LuFactorRows
+
+LU-разложение матрицы n x n с шагом строк stride на месте.
+Главный элемент выбирается по столбцу. Матрица считается вырожденной, если
+главный элемент нулевой, денормализованный (1 / pivot переполняется) или
+не конечный. Порог относительно наибольшего элемента матрицы не годится:
+он отвергал хорошо решаемые системы вроде поворота со сдвигом 1e6 или diag(1e7,1,1).
+*/
+static mbool_t LuFactorRows( float* a, int n, int stride, int* perm ) {
+    for( int i = 0; i < n; i++ ) {
+        perm[i] = i;
+    }
+
+    for( int k = 0; k < n; k++ ) {
+        // выбор главного элемента в столбце k
+        int p = k;
+        float best = abs1f( a[k * stride + k] );
+        for( int i = k + 1; i < n; i++ ) {
+            float v = abs1f( a[i * stride + k] );
+            if( v > best ) {
+                best = v;
+                p = i;
+            }
+        }
+        // NaN не проходит первое сравнение
+        if( !( best >= FLT_MIN ) || ( best > FLT_MAX ) ) {
+            return mfalse;
+        }
+
+        if( p != k ) {
+            for( int j = 0; j < n; j++ ) {
+                float buf = a[k * stride + j];
+                a[k * stride + j] = a[p * stride + j];
+                a[p * stride + j] = buf;
+            }
+            int buf = perm[k];
+            perm[k] = perm[p];
+            perm[p] = buf;
+        }
+
+        float inv_pivot = 1.0f / a[k * stride + k];
+        for( int i = k + 1; i < n; i++ ) {
+            float f = a[i * stride + k] * inv_pivot;
+            a[i * stride + k] = f;
+            for( int j = k + 1; j < n; j++ ) {
+                a[i * stride + j] -= f * a[k * stride + j];
+            }
+        }
+    }
+    return mtrue;
+}
+
+/*
+LuSolveRows
+
+Решение L * U * x = P * b прямой и обратной подстановкой.
+x не должен совпадать с b.
+*/
+static void LuSolveRows( float* x, const float* a, int n, int stride, const int* perm, const float* b ) {
+    for( int i = 0; i < n; i++ ) {
+        float s = b[perm[i]];
+        for( int j = 0; j < i; j++ ) {
+            s -= a[i * stride + j] * x[j];
+        }
+        x[i] = s;
+    }
+    for( int i = n - 1; i >= 0; i-- ) {
+        float s = x[i];
+        for( int j = i + 1; j < n; j++ ) {
+            s -= a[i * stride + j] * x[j];
+        }
+        x[i] = s / a[i * stride + i];
+    }
+}
+
+// аргументы Lu3SolveArray и Mat3SolveArray для PoolParallelFor
+typedef struct {
+    vec3_t*         x;
+    const lu3_t*    lu;
+    const mat3_t*   a;
+    const vec3_t*   b;
+    int             singular;   // вырожденных систем, суммируется из всех чанков
+} lusolve3_t;
+
+// аргументы Lu4SolveArray и Mat4SolveArray для PoolParallelFor
+typedef struct {
+    vec4_t*         x;
+    const lu4_t*    lu;
+    const mat4_t*   a;
+    const vec4_t*   b;
+    int             singular;   // вырожденных систем, суммируется из всех чанков
+} lusolve4_t;
+
+#if defined( _MSC_VER )
+
+static void LuAddSingular( int* singular, int n ) {
+    InterlockedExchangeAdd( ( volatile LONG* )singular, n );
+}
+
+#else
+
+static void LuAddSingular( int* singular, int n ) {
+    __atomic_add_fetch( singular, n, __ATOMIC_RELAXED );
+}
+
+#endif
+
+/*
+Lu3Factor
+
+LU-разложение матрицы m 3-го порядка.
+Возвращает mfalse, если матрица вырожденная.
+*/
+mbool_t Lu3Factor( lu3_t* lu, const mat3_t* m ) {
+    lu->lu = *m;
+    return LuFactorRows( lu->lu.m, 3, 3, lu->perm );
+}
+
+/*
+Lu3Solve
+
+Решение системы A * x = b по разложению lu. x может совпадать с b.
+*/
+void Lu3Solve( vec3_t* x, const lu3_t* lu, const vec3_t* b ) {
+    vec3_t rhs = *b;
+    LuSolveRows( x->m, lu->lu.m, 3, 3, lu->perm, rhs.m );
+}
+
+static void Lu3SolveChunk( void* ctx, int begin, int end ) {
+    lusolve3_t* job = ctx;
+    for( int i = begin; i < end; i++ ) {
+        Lu3Solve( &job->x[i], job->lu, &job->b[i] );
+    }
+}
+
+static void Mat3SolveChunk( void* ctx, int begin, int end ) {
+    lusolve3_t* job = ctx;
+    int singular = 0;
+    for( int i = begin; i < end; i++ ) {
+        lu3_t lu;
+        if( Lu3Factor( &lu, &job->a[i] ) ) {
+            Lu3Solve( &job->x[i], &lu, &job->b[i] );
+        }
+        else {
+            Vec3Zero( &job->x[i] );
+            singular++;
+        }
+    }
+    if( singular > 0 ) {
+        LuAddSingular( &job->singular, singular );
+    }
+}
+
+/*
+Lu3SolveArray
+
+Решение count систем с одной матрицей и правыми частями b[i],
+чанками между потоками пула.
+*/
+void Lu3SolveArray( vec3_t* x, const lu3_t* lu, const vec3_t* b, int count ) {
+    lusolve3_t job = { x, lu, NULL, b, 0 };
+    PoolParallelFor( Lu3SolveChunk, &job, count, PoolChunk( 2 * sizeof( vec3_t ) ) );
+}
+
+/*
+Mat3SolveArray
+
+Решение count независимых систем a[i] * x[i] = b[i], чанками между потоками пула.
+Для вырожденных систем x[i] обнуляется и возвращается mfalse.
+*/
+mbool_t Mat3SolveArray( vec3_t* x, const mat3_t* a, const vec3_t* b, int count ) {
+    lusolve3_t job = { x, NULL, a, b, 0 };
+    PoolParallelFor( Mat3SolveChunk, &job, count, PoolChunk( sizeof( mat3_t ) + 2 * sizeof( vec3_t ) ) );
+    MATH_METRIC( MATH_METRIC_MAT3_SOLVE, count, job.singular );
+    return job.singular == 0 ? mtrue : mfalse;
+}
+
+/*
+Lu4Factor
+
+LU-разложение матрицы m 4-ого порядка.
+Возвращает mfalse, если матрица вырожденная.
+*/
+mbool_t Lu4Factor( lu4_t* lu, const mat4_t* m ) {
+    lu->lu = *m;
+    return LuFactorRows( lu->lu.m, 4, 4, lu->perm );
+}
+
+/*
+Lu4Solve
+
+Решение системы A * x = b по разложению lu. x может совпадать с b.
+*/
+void Lu4Solve( vec4_t* x, const lu4_t* lu, const vec4_t* b ) {
+    vec4_t rhs = *b;
+    LuSolveRows( x->m, lu->lu.m, 4, 4, lu->perm, rhs.m );
+}
+
+static void Lu4SolveChunk( void* ctx, int begin, int end ) {
+    lusolve4_t* job = ctx;
+    for( int i = begin; i < end; i++ ) {
+        Lu4Solve( &job->x[i], job->lu, &job->b[i] );
+    }
+}
+
+static void Mat4SolveChunk( void* ctx, int begin, int end ) {
+    lusolve4_t* job = ctx;
+    int singular = 0;
+    for( int i = begin; i < end; i++ ) {
+        lu4_t lu;
+        if( Lu4Factor( &lu, &job->a[i] ) ) {
+            Lu4Solve( &job->x[i], &lu, &job->b[i] );
+        }
+        else {
+            Vec4Zero( &job->x[i] );
+            singular++;
+        }
+    }
+    if( singular > 0 ) {
+        LuAddSingular( &job->singular, singular );
+    }
+}
+
+/*
+Lu4SolveArray
+
+Решение count систем с одной матрицей и правыми частями b[i],
+чанками между потоками пула.
+*/
+void Lu4SolveArray( vec4_t* x, const lu4_t* lu, const vec4_t* b, int count ) {
+    lusolve4_t job = { x, lu, NULL, b, 0 };
+    PoolParallelFor( Lu4SolveChunk, &job, count, PoolChunk( 2 * sizeof( vec4_t ) ) );
+}
+
+/*
+Mat4SolveArray
+
+Решение count независимых систем a[i] * x[i] = b[i], чанками между потоками пула.
+Для вырожденных систем x[i] обнуляется и возвращается mfalse.
+*/
+mbool_t Mat4SolveArray( vec4_t* x, const mat4_t* a, const vec4_t* b, int count ) {
+    lusolve4_t job = { x, NULL, a, b, 0 };
+    PoolParallelFor( Mat4SolveChunk, &job, count, PoolChunk( sizeof( mat4_t ) + 2 * sizeof( vec4_t ) ) );
+    MATH_METRIC( MATH_METRIC_MAT4_SOLVE, count, job.singular );
+    return job.singular == 0 ? mtrue : mfalse;
+}
+
+/*
+LuNFactor
+
+LU-разложение квадратной матрицы m произвольного размера.
+Память разложения освобождается LuNRelease, в том числе при неудаче.
+Возвращает mfalse, если матрица не квадратная, вырожденная или не хватило памяти.
+*/
+mbool_t LuNFactor( luN_t* lu, const matN_t* m ) {
+    lu->perm = NULL;
+    if( ( m->rows != m->cols ) || !MatNInit( &lu->lu, m->rows, m->cols ) ) {
+        lu->lu.data = NULL;
+        return mfalse;
+    }
+    lu->perm = malloc( ( m->rows > 0 ? m->rows : 1 ) * sizeof( int ) );
+    if( lu->perm == NULL ) {
+        return mfalse;
+    }
+    MatNCopy( &lu->lu, m );
+    return LuFactorRows( lu->lu.data, m->rows, lu->lu.stride, lu->perm );
+}
+
+/*
+LuNSolve
+
+Решение системы A * x = b по разложению lu. x не должен совпадать с b.
+*/
+void LuNSolve( float* x, const luN_t* lu, const float* b ) {
+    LuSolveRows( x, lu->lu.data, lu->lu.rows, lu->lu.stride, lu->perm, b );
+}
+
+/*
+LuNRelease
+
+Освобождение памяти разложения.
+*/
+void LuNRelease( luN_t* lu ) {
+    MatNRelease( &lu->lu );
+    free( lu->perm );
+    lu->perm = NULL;
+}
@@ -0,0 +1,47 @@
+#ifndef __LU_H__
+#define __LU_H__
+
+#include "matrix.h"
+#include "matn.h"
+
+/*
+LU-разложение с выбором главного элемента по столбцу: P * A = L * U.
+L (с единицами на диагонали) и U хранятся в одной матрице,
+perm[i] - номер строки исходной матрицы, ставшей i-й.
+Разложение выполняется один раз, после чего решается любое количество
+систем A * x = b без построения обратной матрицы.
+*/
+
+typedef struct {
+    mat3_t          lu;
+    int             perm[3];
+} lu3_t;
+
+typedef struct {
+    mat4_t          lu;
+    int             perm[4];
+} lu4_t;
+
+typedef struct {
+    matN_t          lu;
+    int*            perm;
+} luN_t;
+
+
+mbool_t     Lu3Factor( lu3_t* lu, const mat3_t* m );
+void        Lu3Solve( vec3_t* x, const lu3_t* lu, const vec3_t* b );
+void        Lu3SolveArray( vec3_t* x, const lu3_t* lu, const vec3_t* b, int count );
+mbool_t     Mat3SolveArray( vec3_t* x, const mat3_t* a, const vec3_t* b, int count );
+
+mbool_t     Lu4Factor( lu4_t* lu, const mat4_t* m );
+void        Lu4Solve( vec4_t* x, const lu4_t* lu, const vec4_t* b );
+void        Lu4SolveArray( vec4_t* x, const lu4_t* lu, const vec4_t* b, int count );
+mbool_t     Mat4SolveArray( vec4_t* x, const mat4_t* a, const vec4_t* b, int count );
+
+mbool_t     LuNFactor( luN_t* lu, const matN_t* m );
+void        LuNSolve( float* x, const luN_t* lu, const float* b );
+void        LuNRelease( luN_t* lu );
+
+
+
+#endif //__LU_H__
@@ -1,5 +1,7 @@
 /* File math_base.c */
 #include "math_base.h"
+#include "arena.h"
+#include "pool.h"
 
 const float  PI = 3.14159265358979323846f;           // pi
 const float  TWO_PI = 6.283185307179586f;            // pi * 2
@@ -14,11 +16,56 @@ const float  FLOAT_EPSILON = 1.192092896e-07f;       // минимальное 
                                                      // выполняется условие 1.0f + FLOAT_EPSILON != 1.0f
 
 void MathInit( ) {
-
+    ArenaFrameInit();
+    PoolInit();
+#if defined( MATH_METRICS )
+    MathMetricsInit();
+#endif
 }
 
 void MathRelease( ) {
+    PoolRelease();
+#if defined( MATH_INSTRUMENT )
+    MathProbeRelease();
+#endif
+#if defined( MATH_METRICS )
+    MathMetricsRelease();
+#endif
+    ArenaFrameRelease();
+}
+
+/*
+MathAlignedAlloc
 
+Выделить size байт памяти, выровненной по align (степень двойки).
+Перед выровненным блоком хранится указатель, полученный от malloc.
+Память освобождается функцией MathAlignedFree.
+*/
+void* MathAlignedAlloc( size_t size, size_t align ) {
+    if( align < sizeof( void* ) ) {
+        align = sizeof( void* );
+    }
+
+    unsigned char* raw = malloc( size + align + sizeof( void* ) );
+    if( raw == NULL ) {
+        return NULL;
+    }
+
+    size_t addr = ( size_t )( raw + sizeof( void* ) );
+    addr = ( addr + align - 1 ) & ~( align - 1 );
+    ( ( void** )addr )[-1] = raw;
+    return ( void* )addr;
+}
+
+/*
+MathAlignedFree
+
+Освободить память, выделенную MathAlignedAlloc.
+*/
+void MathAlignedFree( void* p ) {
+    if( p != NULL ) {
+        free( ( ( void** )p )[-1] );
+    }
 }
 
 /*
@@ -28,12 +75,13 @@ isqrt1f
 Если x == 0.0f, то возвращаемое значение будет очень большим.
 */
 float isqrt1f( float x ) {
+    MATH_PROBE();
     const float x2 = x * 0.5f;
     const float threehalfs = 1.5f;
 
     union {
         float f;
-        unsigned long i;
+        unsigned int i;
     } conv = {x}; // member 'f' set to value of 'x'.
 
     conv.i = 0x5f3759df - ( conv.i >> 1 );
@@ -48,6 +96,7 @@ sqrt1f
 Возвращает квадрат числа x.
 */
 float sqr1f( float x ) {
+    MATH_PROBE();
     return x * x;
 }
 
@@ -57,6 +106,7 @@ sqrt1f
 Возвращает обратный квадратный корень числа x.
 */
 float sqrt1f( float x ) {
+    MATH_PROBE();
     return sqrt( x );
 }
 
@@ -68,6 +118,7 @@ sin1f
 Возвращаемое значение будет в пределах [-1, +1].
 */
 float sin1f( float a ) {
+    MATH_PROBE();
     return sinf( a );
 }
 
@@ -79,6 +130,7 @@ cos1f
 Возвращаемое значение будет в пределах [-1, +1].
 */
 float cos1f( float a ) {
+    MATH_PROBE();
     return cosf( a );
 }
 
@@ -91,8 +143,11 @@ sincosf
 s и c не должны быть NULL.
 */
 void sincosf( float a, float* s, float* c ) {
-    *s = sin1f( a );
-    *c = cos1f( a );
+    MATH_PROBE();
+    // не sinf и cosf: компилятор объединяет их в вызов sincosf, то есть этой же функции
+    double d = a;
+    *s = ( float )sin( d );
+    *c = ( float )cos( d );
 }
 
 /*
@@ -101,6 +156,7 @@ tan1f
 Возвращает тангенс угла a. Угол a задаётся в радианах.
 */
 float tan1f( float a ) {
+    MATH_PROBE();
     return tanf( a );
 }
 
@@ -112,6 +168,7 @@ a должно быть в пределах [-1, +1].
 Возвращаемое значение будет в пределах [-PI/2, +PI/2].
 */
 float asin1f( float a ) {
+    MATH_PROBE();
     return asinf( a );
 }
 
@@ -123,6 +180,7 @@ a должно быть в пределах [-1, +1].
 Возвращаемое значение будет в пределах [0, PI].
 */
 float acos1f( float a ) {
+    MATH_PROBE();
     return acosf( a );
 }
 
@@ -133,6 +191,7 @@ atan1f
 Возвращаемое значение будет в пределах [-PI/2, +PI/2].
 */
 float atan1f( float a ) {
+    MATH_PROBE();
     return atanf( a );
 }
 
@@ -143,6 +202,7 @@ atan2f
 Возвращаемое значение будет в пределах [-PI/2, +PI/2].
 */
 float atan2f( float y, float x ) {
+    MATH_PROBE();
     return atan2( y, x );
 }
 
@@ -152,6 +212,7 @@ pow2f
 Возвращает x возведённый в степень y.
 */
 float pow2f( float x, float y ) {
+    MATH_PROBE();
     return pow( x, y );
 }
 
@@ -162,7 +223,8 @@ exp1f
 Экспонента это число E возведённое в степень f.
 */
 float exp1f( float f ) {
-    return pow2f( f, E );
+    MATH_PROBE();
+    return exp( f );
 }
 
 /*
@@ -171,6 +233,7 @@ log1f
 Возвращает натуральный логарифм от f.
 */
 float log1f( float f ) {
+    MATH_PROBE();
     return log( f );
 }
 
@@ -180,6 +243,7 @@ pow2i
 Возвращает x возведённую в степень y. 
 */
 int pow2i( int x, int y ) {
+    MATH_PROBE();
     return pow( x, y );
 }
 
@@ -190,6 +254,7 @@ min2f
 Возвращает минимальное число из двух чисел a и b.
 */
 float min2f( float a, float b ) {
+    MATH_PROBE();
     if( a < b ) {
         return a;
     }
@@ -202,6 +267,7 @@ min2i
 Возвращает минимальное число из двух чисел a и b.
 */
 int min2i( int a, int b ) {
+    MATH_PROBE();
     if( a < b ) {
         return a;
     }
@@ -215,6 +281,7 @@ max2f
 Возвращает максимальное число из двух чисел a и b.
 */
 float max2f( float a, float b ) {
+    MATH_PROBE();
     if( a > b ) {
         return a;
     }
@@ -228,6 +295,7 @@ max2i
 Возвращает максимальное число из двух чисел a и b.
 */
 int max2i( int a, int b ) {
+    MATH_PROBE();
     if( a > b ) {
         return a;
     }
@@ -240,6 +308,7 @@ abs1i
 Возвращает абсолютное значение числа x.
 */
 int abs1i( int x ) {
+    MATH_PROBE();
     if( x < 0 ) {
         return -x;
     }
@@ -252,6 +321,7 @@ abs1f
 Возвращает абсолютное значение числа x.
 */
 float abs1f( float x ) {
+    MATH_PROBE();
     if( x < 0 ) {
         return -x;
     }
@@ -265,6 +335,7 @@ floor1f
 Округление к меньшему целому.
 */
 float floor1f( float f ) {
+    MATH_PROBE();
     return floor( f );
 }
 
@@ -275,6 +346,7 @@ ceil1f
 Округление к большему целому.
 */
 float ceil1f( float f ) {
+    MATH_PROBE();
     return ceil( f );
 }
 
@@ -284,6 +356,7 @@ round1f
 Возвращает целое число, округленное по математическим законам.
 */
 float round1f( float f ) {
+    MATH_PROBE();
     return round( f );
 }
 
@@ -293,6 +366,7 @@ trunc1f
 
 */
 float trunc1f( float f ) {
+    MATH_PROBE();
     return trunc( f );
 }
 
@@ -302,6 +376,7 @@ frac1f
 Отбрасывает дробную часть числа f и возвращает целое значение.
 */
 float frac1f( float f ) {
+    MATH_PROBE();
     return f - floor1f( f );
 }
 
@@ -313,6 +388,7 @@ clamp3i
 Иначе функция возвращает val.
 */
 int clamp3i( int min, int max, int val ) {
+    MATH_PROBE();
     if( val < min ) {
         return min;
     }
@@ -332,6 +408,7 @@ clamp3f
 Иначе функция возвращает val.
 */
 float clamp3f( float min, float max, float val ) {
+    MATH_PROBE();
     if( val < min ) {
         return min;
     }
@@ -349,7 +426,8 @@ lerpi
 Возвращает линейную между двумя числами a и b с коэффициентом scale.
 */
 int lerpi( int a, int b, float scale ) {
-    return scale * a + b;
+    MATH_PROBE();
+    return ( int )( a + ( b - a ) * scale );
 }
 
 
@@ -359,5 +437,6 @@ lerpf
 Возвращает линейную между двумя числами a и b с коэффициентом scale.
 */
 float lerpf( float a, float b, float scale ) {
-    return scale * a + b;
+    MATH_PROBE();
+    return a + ( b - a ) * scale;
 }
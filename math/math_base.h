@@ -5,12 +5,29 @@
 #include <stdlib.h>
 #include <math.h>
 
+#include "probe.h"
+#include "metrics.h"
+
 // math boolean
 typedef unsigned char   mbool_t;
 
 #define mtrue           ((mbool_t)1)
 #define mfalse          ((mbool_t)0)
 
+// указатель, который не пересекается с другими аргументами функции
+#if defined( _MSC_VER )
+#define mrestrict       __restrict
+#else
+#define mrestrict       __restrict__
+#endif
+
+// переменная, своя у каждого потока
+#if defined( _MSC_VER )
+#define mthreadlocal    __declspec( thread )
+#else
+#define mthreadlocal    __thread
+#endif
+
 
 const float  PI;                // pi
 const float  TWO_PI;            // pi * 2
@@ -28,6 +45,9 @@ const float  FLOAT_EPSILON;     // минимальное число, для к
 void    MathInit( void );           // init
 void    MathRelease( void );        // release
 
+void*   MathAlignedAlloc( size_t size, size_t align );
+void    MathAlignedFree( void* p );
+
 
 
 float   isqrt1f( float x );
@@ -0,0 +1,291 @@
+#include <string.h>
+
+#include "matn.h"
+#include "pool.h"
+
+#if defined( __AVX__ )
+#include <immintrin.h>
+#elif defined( __SSE__ )
+#include <xmmintrin.h>
+#endif
+
+// размеры блоков умножения: блок B размером KC x NC остаётся в кэше L2,
+// строка блока C длиной NC - в L1
+#define MATN_MC         64
+#define MATN_KC         128
+#define MATN_NC         256
+
+/*
+MatNAxpy
+
+c[0..n) += a * b[0..n). n кратно MATN_PAD, c и b выровнены.
+*/
+static void MatNAxpy( float* mrestrict c, float a, const float* mrestrict b, int n ) {
+#if defined( __AVX__ )
+    __m256 va = _mm256_set1_ps( a );
+    for( int j = 0; j < n; j += 8 ) {
+        __m256 vc = _mm256_load_ps( c + j );
+        vc = _mm256_add_ps( vc, _mm256_mul_ps( va, _mm256_load_ps( b + j ) ) );
+        _mm256_store_ps( c + j, vc );
+    }
+#elif defined( __SSE__ )
+    __m128 va = _mm_set1_ps( a );
+    for( int j = 0; j < n; j += 4 ) {
+        __m128 vc = _mm_load_ps( c + j );
+        vc = _mm_add_ps( vc, _mm_mul_ps( va, _mm_load_ps( b + j ) ) );
+        _mm_store_ps( c + j, vc );
+    }
+#else
+    for( int j = 0; j < n; j++ ) {
+        c[j] += a * b[j];
+    }
+#endif
+}
+
+/*
+MatNInit
+
+Создание матрицы rows x cols, заполненной нулями.
+*/
+mbool_t MatNInit( matN_t* m, int rows, int cols ) {
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = ( cols + MATN_PAD - 1 ) / MATN_PAD * MATN_PAD;
+    m->data = MathAlignedAlloc( ( size_t )rows * m->stride * sizeof( float ), MATN_ALIGN );
+    if( m->data == NULL ) {
+        m->rows = 0;
+        m->cols = 0;
+        m->stride = 0;
+        return mfalse;
+    }
+    MatNZero( m );
+    return mtrue;
+}
+
+/*
+MatNRelease
+
+Освобождение памяти матрицы.
+*/
+void MatNRelease( matN_t* m ) {
+    MathAlignedFree( m->data );
+    m->data = NULL;
+    m->rows = 0;
+    m->cols = 0;
+    m->stride = 0;
+}
+
+/*
+MatNZero
+
+Обнуление матрицы вместе с выравниванием строк.
+*/
+void MatNZero( matN_t* m ) {
+    memset( m->data, 0, ( size_t )m->rows * m->stride * sizeof( float ) );
+}
+
+/*
+MatNIdent
+
+Установка единичной матрицы (для неквадратной - единицы на главной диагонали).
+*/
+void MatNIdent( matN_t* m ) {
+    MatNZero( m );
+    for( int i = 0; i < m->rows && i < m->cols; i++ ) {
+        m->data[i * m->stride + i] = 1.0f;
+    }
+}
+
+/*
+MatNCopy
+
+Копирование матрицы a в m. Размеры матриц должны совпадать.
+*/
+mbool_t MatNCopy( matN_t* m, const matN_t* a ) {
+    if( ( m->rows != a->rows ) || ( m->cols != a->cols ) ) {
+        return mfalse;
+    }
+    memcpy( m->data, a->data, ( size_t )m->rows * m->stride * sizeof( float ) );
+    return mtrue;
+}
+
+/*
+MatNGet
+
+Вернуть элемент матрицы m в строке row и столбце col.
+*/
+float MatNGet( const matN_t* m, int row, int col ) {
+    return m->data[row * m->stride + col];
+}
+
+/*
+MatNSet
+
+Установить элемент матрицы m в строке row и столбце col.
+*/
+void MatNSet( matN_t* m, int row, int col, float f ) {
+    m->data[row * m->stride + col] = f;
+}
+
+/*
+MatNRow
+
+Вернуть указатель на начало строки row. Строка выровнена по MATN_ALIGN.
+*/
+float* MatNRow( const matN_t* m, int row ) {
+    return m->data + ( size_t )row * m->stride;
+}
+
+// аргументы MatNMul для PoolParallelFor
+typedef struct {
+    matN_t*         out;
+    const matN_t*   a;
+    const matN_t*   b;
+} matnmul_t;
+
+// блоки строк [begin, end) по MATN_MC строк, выполняется в потоке пула
+static void MatNMulChunk( void* ctx, int begin, int end ) {
+    const matnmul_t* job = ctx;
+    const matN_t* a = job->a;
+    const matN_t* b = job->b;
+    int rows = a->rows;
+    int inner = a->cols;
+    int width = job->out->stride;
+
+    for( int ib = begin * MATN_MC; ib < rows && ib < end * MATN_MC; ib += MATN_MC ) {
+        int ie = ib + MATN_MC < rows ? ib + MATN_MC : rows;
+        for( int kb = 0; kb < inner; kb += MATN_KC ) {
+            int ke = kb + MATN_KC < inner ? kb + MATN_KC : inner;
+            for( int jb = 0; jb < width; jb += MATN_NC ) {
+                int n = jb + MATN_NC < width ? MATN_NC : width - jb;
+                for( int i = ib; i < ie; i++ ) {
+                    const float* ar = MatNRow( a, i );
+                    float* cr = MatNRow( job->out, i ) + jb;
+                    for( int k = kb; k < ke; k++ ) {
+                        MatNAxpy( cr, ar[k], MatNRow( b, k ) + jb, n );
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*
+MatNMul
+
+Умножение матриц: out = a * b.
+out должна быть создана с размерами a->rows x b->cols и не совпадать с a и b.
+Умножение выполняется блоками, чтобы части b и out оставались в кэше;
+блоки строк распределяются между потоками пула. Каждая строка out
+считается одним потоком в одном порядке, поэтому результат не зависит
+от числа потоков.
+Возвращает mfalse, если размеры матриц не согласованы.
+*/
+mbool_t MatNMul( matN_t* out, const matN_t* a, const matN_t* b ) {
+    if( ( a->cols != b->rows ) || ( out->rows != a->rows ) || ( out->cols != b->cols ) ||
+        ( out == a ) || ( out == b ) ) {
+        return mfalse;
+    }
+
+    MatNZero( out );
+
+    matnmul_t job = { out, a, b };
+    MATH_METRIC( MATH_METRIC_MATN_MUL, ( uint64_t )a->rows * a->cols * out->cols, 0 );
+    PoolParallelFor( MatNMulChunk, &job, ( a->rows + MATN_MC - 1 ) / MATN_MC, 1 );
+    return mtrue;
+}
+
+// аргументы MatNMulVec для PoolParallelFor
+typedef struct {
+    float*          out;
+    const matN_t*   m;
+    const float*    v;
+} matnmulvec_t;
+
+// строки [begin, end), выполняется в потоке пула
+static void MatNMulVecChunk( void* ctx, int begin, int end ) {
+    const matnmulvec_t* job = ctx;
+    const matN_t* m = job->m;
+    const float* v = job->v;
+
+    for( int i = begin; i < end; i++ ) {
+        const float* r = MatNRow( m, i );
+        // четыре независимые суммы не ждут друг друга
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+        int j = 0;
+        for( ; j + 4 <= m->cols; j += 4 ) {
+            s0 += r[j]     * v[j];
+            s1 += r[j + 1] * v[j + 1];
+            s2 += r[j + 2] * v[j + 2];
+            s3 += r[j + 3] * v[j + 3];
+        }
+        for( ; j < m->cols; j++ ) {
+            s0 += r[j] * v[j];
+        }
+        job->out[i] = ( s0 + s1 ) + ( s2 + s3 );
+    }
+}
+
+/*
+MatNMulVec
+
+Умножение матрицы m на вектор-столбец v длиной m->cols.
+Результат длиной m->rows записывается в out. out не должен совпадать с v.
+Строки распределяются между потоками пула; каждая строка считается
+целиком одним потоком, поэтому результат не зависит от числа потоков.
+*/
+mbool_t MatNMulVec( float* out, const matN_t* m, const float* v ) {
+    if( out == v ) {
+        return mfalse;
+    }
+
+    matnmulvec_t job = { out, m, v };
+    PoolParallelFor( MatNMulVecChunk, &job, m->rows, PoolChunk( ( ( size_t )m->cols + 1 ) * sizeof( float ) ) );
+    return mtrue;
+}
+
+// аргументы MatNTransp для PoolParallelFor
+typedef struct {
+    matN_t*         out;
+    const matN_t*   m;
+} matntransp_t;
+
+// строки m [begin, end), begin кратно 8; выполняется в потоке пула
+static void MatNTranspChunk( void* ctx, int begin, int end ) {
+    const matntransp_t* job = ctx;
+    const matN_t* m = job->m;
+    matN_t* out = job->out;
+
+    for( int ib = begin; ib < end; ib += 8 ) {
+        int ie = ib + 8 < end ? ib + 8 : end;
+        for( int jb = 0; jb < m->cols; jb += 8 ) {
+            int je = jb + 8 < m->cols ? jb + 8 : m->cols;
+            for( int i = ib; i < ie; i++ ) {
+                const float* r = MatNRow( m, i );
+                for( int j = jb; j < je; j++ ) {
+                    out->data[j * out->stride + i] = r[j];
+                }
+            }
+        }
+    }
+}
+
+/*
+MatNTransp
+
+Транспонирование матрицы m в out.
+out должна быть создана с размерами m->cols x m->rows и не совпадать с m.
+Транспонирование выполняется блоками 8x8, чтобы чтение и запись шли по
+строкам кэша, а не через целую строку матрицы на каждый элемент.
+Полосы строк m распределяются между потоками пула; PoolChunk кратен 8,
+поэтому чанки не разрывают блоки.
+*/
+mbool_t MatNTransp( matN_t* out, const matN_t* m ) {
+    if( ( out->rows != m->cols ) || ( out->cols != m->rows ) || ( out == m ) ) {
+        return mfalse;
+    }
+
+    matntransp_t job = { out, m };
+    PoolParallelFor( MatNTranspChunk, &job, m->rows, PoolChunk( 2 * ( size_t )m->cols * sizeof( float ) ) );
+    return mtrue;
+}
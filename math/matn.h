@@ -0,0 +1,37 @@
+#ifndef __MATN_H__
+#define __MATN_H__
+
+#include "math_base.h"
+
+#define MATN_ALIGN      32      // выравнивание строк в байтах
+#define MATN_PAD        8       // длина строки кратна MATN_PAD элементам
+
+/*
+Плотная матрица произвольного размера.
+Строки хранятся подряд с шагом stride >= cols, начало каждой строки
+выровнено по MATN_ALIGN. Элементы за пределами cols (выравнивание)
+всегда равны 0: на этом основаны векторные циклы без хвостов.
+*/
+typedef struct {
+    int             rows;
+    int             cols;
+    int             stride;     // шаг между строками в элементах
+    float*          data;
+} matN_t;
+
+
+mbool_t     MatNInit( matN_t* m, int rows, int cols );
+void        MatNRelease( matN_t* m );
+void        MatNZero( matN_t* m );
+void        MatNIdent( matN_t* m );
+mbool_t     MatNCopy( matN_t* m, const matN_t* a );
+float       MatNGet( const matN_t* m, int row, int col );
+void        MatNSet( matN_t* m, int row, int col, float f );
+float*      MatNRow( const matN_t* m, int row );
+mbool_t     MatNMul( matN_t* out, const matN_t* a, const matN_t* b );
+mbool_t     MatNMulVec( float* out, const matN_t* m, const float* v );
+mbool_t     MatNTransp( matN_t* out, const matN_t* m );
+
+
+
+#endif //__MATN_H__
@@ -1,11 +1,16 @@
 #include "matrix.h"
 
+#if defined( __SSE__ )
+#include <xmmintrin.h>
+#endif
+
 /*
 Mat2Set
 
 Установка значений матрицы m из значений векторов.
 */
 void Mat2Set( mat2_t* m, const vec2_t* a, const vec2_t* b ) {
+    MATH_PROBE();
     m->a = *a;
     m->b = *b;
 }
@@ -16,6 +21,7 @@ Mat2Copy
 Установка значений из матрицы src в матрицу m.
 */
 void Mat2Copy( mat2_t* m, const mat2_t* a ) {
+    MATH_PROBE();
     m->m[0] = a->m[0];
     m->m[1] = a->m[1];
     m->m[2] = a->m[2];
@@ -28,6 +34,7 @@ Mat2Set4f
 Установить значения матрицы m.
 */
 void Mat2Set4f( mat2_t* m, float ax, float ay, float bx, float by ) {
+    MATH_PROBE();
     m->m[0] = ax;
     m->m[1] = ay;
     m->m[2] = bx;
@@ -40,6 +47,7 @@ Mat2Zero
 
 */
 void Mat2Zero( mat2_t* m ) {
+    MATH_PROBE();
     Vec2Zero( &m->a );
     Vec2Zero( &m->b );
 }
@@ -50,6 +58,7 @@ Mat2Ident
 
 */
 void Mat2Ident( mat2_t* m ) {
+    MATH_PROBE();
     // по главной диагонали ставим 1.0f
     m->a.x = 1.0f;
     m->b.y = 1.0f;
@@ -65,6 +74,7 @@ Mat2Neg
 
 */
 void Mat2Neg( mat2_t* m ) {
+    MATH_PROBE();
     m->m[0] = -m->m[0];
     m->m[1] = -m->m[1];
     m->m[2] = -m->m[2];
@@ -77,25 +87,39 @@ Mat2Inv
 Вычисление обратной матрицы
 */
 mbool_t Mat2Inv( mat2_t* m ) {
-    float det = Mat2Det( m );
+    MATH_PROBE();
+    return Mat2InvTo( m, m );
+}
+
+/*
+Mat2InvTo
+
+Вычисление обратной матрицы для in, результат записывается в out.
+out может совпадать с in. Если матрица вырожденная, out не изменяется.
+*/
+mbool_t Mat2InvTo( mat2_t* out, const mat2_t* in ) {
+    MATH_PROBE();
+    // все элементы читаются до первой записи в out
+    float a00 = in->m[0], a01 = in->m[1];
+    float a10 = in->m[2], a11 = in->m[3];
+
+    float det = a00 * a11 - a01 * a10;
 
     // если матрица является вырожденной
     if( det == 0.0f ) { 
+        MATH_METRIC( MATH_METRIC_MAT2_INV, 1, 1 );
         return mfalse;
     }
 
     float inv_det = 1 / det;
 
-    // делим алгебраическое дополнение на детерминант
-    mat2_t buf; 
-    buf.m[0] = m->b.y * inv_det;
-    buf.m[1] = (-m->b.x) * inv_det;
-    buf.m[2] = (-m->a.y) * inv_det; 
-    buf.m[3] = m->a.x * inv_det;
-
-    Mat2Transp( &buf ); // транспонируем матрицу
-    Mat2Copy( m, &buf ); // пишем результат в исходную матрицу
+    // присоединённая матрица пишется сразу в транспонированном виде
+    out->m[0] = a11 * inv_det;
+    out->m[1] = -a01 * inv_det;
+    out->m[2] = -a10 * inv_det;
+    out->m[3] = a00 * inv_det;
 
+    MATH_METRIC( MATH_METRIC_MAT2_INV, 1, 0 );
     return mtrue; // детерминант != 0, значит обратная матрица посчитана и не является вырожденной
 }
 
@@ -106,6 +130,7 @@ Mat2Scale
 Умножить каждое значение матрицы на s.
 */
 void Mat2Scale( mat2_t* m, float s ) {
+    MATH_PROBE();
     m->m[0] *= s;
     m->m[1] *= s;
     m->m[2] *= s;
@@ -118,6 +143,7 @@ Mat2MulVec2
 Умножение матрицы 2-ого порядка на вектор-столбец.
 */
 void Mat2MulVec2( vec2_t* out, const mat2_t* m, const vec2_t* v ) {
+    MATH_PROBE();
     out->x = m->m[0] * v->m[0] + m->m[1] * v->m[1];
     out->y = m->m[2] * v->m[0] + m->m[3] * v->m[1];
 }
@@ -128,11 +154,13 @@ Vec2MulMat2
 Умножение вектора-строки на матрицу 2-ого порядка.
 */
 void Vec2MulMat2( vec2_t* out, const vec2_t* v, const mat2_t* m ) {
+    MATH_PROBE();
     out->x = v->m[0] * m->m[0] + v->m[1] * m->m[2];
     out->y = v->m[0] * m->m[1] + v->m[1] * m->m[3];
 }
 
 void Mat2Mul( mat2_t* out, const mat2_t* a, const mat2_t* b ) {
+    MATH_PROBE();
     out->m[0] = a->m[0] * b->m[0];
     out->m[1] = a->m[1] * b->m[1];
     out->m[2] = a->m[2] * b->m[2];
@@ -140,6 +168,7 @@ void Mat2Mul( mat2_t* out, const mat2_t* a, const mat2_t* b ) {
 }
 
 void Mat2Add( mat2_t* out, const mat2_t* a, const mat2_t* b ) {
+    MATH_PROBE();
     out->m[0] = a->m[0] + b->m[0];
     out->m[1] = a->m[1] + b->m[1];
     out->m[2] = a->m[2] + b->m[2];
@@ -147,6 +176,7 @@ void Mat2Add( mat2_t* out, const mat2_t* a, const mat2_t* b ) {
 }
 
 void Mat2Sub( mat2_t* out, const mat2_t* a, const mat2_t* b ) {
+    MATH_PROBE();
     out->m[0] = a->m[0] - b->m[0];
     out->m[1] = a->m[1] - b->m[1];
     out->m[2] = a->m[2] - b->m[2];
@@ -159,10 +189,12 @@ Mat2Cmp
 Сравнение матриц.
 */
 mbool_t Mat2Cmp( const mat2_t* a, const mat2_t* b ) {
+    MATH_PROBE();
     return Vec2Cmp( &a->a, &b->a ) && Vec2Cmp( &a->b, &b->b );
 }
 
 mbool_t Mat2CmpEps( const mat2_t* a, const mat2_t* b, float eps ) {
+    MATH_PROBE();
     if( Vec2CmpEps( &a->a, &b->a, eps ) &&
         Vec2CmpEps( &a->b, &b->b, eps ) 
     ) {
@@ -171,8 +203,18 @@ mbool_t Mat2CmpEps( const mat2_t* a, const mat2_t* b, float eps ) {
     return mfalse;
 }
 
-mbool_t Mat2IsDiag( const mat2_t* m ) {
+/*
+Mat2IsDiag
 
+Возвращает mtrue если все элементы матрицы m вне главной диагонали равны 0.
+Иначе возвращает mfalse.
+*/
+mbool_t Mat2IsDiag( const mat2_t* m ) {
+    MATH_PROBE();
+    if( ( m->m[1] == 0.0f ) && ( m->m[2] == 0.0f ) ) {
+        return mtrue;
+    }
+    return mfalse;
 }
 
 /*
@@ -184,6 +226,7 @@ Mat2IsIdent
 диагонали равны 0.
 */
 mbool_t Mat2IsIdent( const mat2_t* m ) {
+    MATH_PROBE();
     if( ( ( ( m->a.x <= 1.0f + FLOAT_EPSILON ) && ( m->a.x >= 1.0f - FLOAT_EPSILON ) )
        && ( ( m->b.y <= 1.0f + FLOAT_EPSILON ) && ( m->b.y >= 1.0f - FLOAT_EPSILON ) ) )
       && ( ( m->m[1] == 0.0f ) && ( m->m[2] == 0.0f ) )
@@ -199,6 +242,7 @@ Mat2Det
 Вычисление детерминанта (определителя) матрицы 2-ого порядка.
 */
 float Mat2Det( const mat2_t* m ) {
+    MATH_PROBE();
     return m->m[0] * m->m[3] - m->m[1] * m->m[2];
 }
 
@@ -208,6 +252,7 @@ Mat2Transp
 Транспонирование матрицы второго порядка.
 */
 void Mat2Transp( mat2_t* m ) {
+    MATH_PROBE();
     // просто меняем местами элементы побочной диагонали
     float buf = m->a.y;
     m->a.y = m->b.x;
@@ -215,6 +260,7 @@ void Mat2Transp( mat2_t* m ) {
 }
 
 void Mat2ToStr( char* out, const mat2_t* m, int prec ) {
+    MATH_PROBE();
     sprintf( out, "%.*f %.*f %.*f %.*f", prec, m->m[0], prec, m->m[1], prec, m->m[2], prec, m->m[3] );
 }
 
@@ -225,16 +271,19 @@ Mat2ToPrettyStr
 Запись в строку out.
 */
 void Mat2ToPrettyStr( char* out, const mat2_t* m, int prec ) {
+    MATH_PROBE();
     sprintf( out, "%.*f %.*f\n%.*f %.*f", prec, m->m[0], prec, m->m[1], prec, m->m[2], prec, m->m[3] );
 }
 
 void Mat2ToMat3( mat3_t* out, const mat2_t* m ) {
+    MATH_PROBE();
     Vec2ToVec3(&out->a, &m->a);
     Vec2ToVec3(&out->b, &m->b);
     Vec3Zero(&out->c);
 }
 
 void Mat2ToMat4( mat4_t* out, const mat2_t* m ) {
+    MATH_PROBE();
     Vec2ToVec4(&out->a, &m->a);
     Vec2ToVec4(&out->b, &m->b);
     Vec4Zero(&out->c);
@@ -247,6 +296,7 @@ Mat3Set
 Установка значений матрицы из значений векторов.
 */
 void Mat3Set( mat3_t* m, const vec3_t* a, const vec3_t* b, const vec3_t* c ) {
+    MATH_PROBE();
     m->a = *a;
     m->b = *b;
     m->c = *c;
@@ -261,6 +311,7 @@ void Mat3Set9f( mat3_t* m,
                 float ax, float ay, float az, 
                 float bx, float by, float bz, 
                 float cx, float cy, float cz ) {
+    MATH_PROBE();
     m->m[0] = ax;
     m->m[1] = ay;
     m->m[2] = az;
@@ -278,6 +329,7 @@ Mat3Set9fv
 Установка значений матрицы m из массива src.
 */
 void Mat3Set9fv( mat3_t* m, const float* src ) {
+    MATH_PROBE();
     m->m[0]  = src[0];
     m->m[1]  = src[1];
     m->m[2]  = src[2];
@@ -295,6 +347,7 @@ Mat3Copy
 Устанавливает значения матрицы a в матрицу m.
 */
 void Mat3Copy( mat3_t* m, const mat3_t* a ) {
+    MATH_PROBE();
     m->m[0] = a->m[0];
     m->m[1] = a->m[1];
     m->m[2] = a->m[2];
@@ -312,6 +365,7 @@ Mat3Zero
 Установка нулевой матрицы.
 */
 void Mat3Zero( mat3_t* m ) {
+    MATH_PROBE();
     Vec3Zero( &m->a );
     Vec3Zero( &m->b );
     Vec3Zero( &m->c );
@@ -323,6 +377,7 @@ Mat3Ident
 Установка единичной матрицы.
 */
 void Mat3Ident( mat3_t* m ) {
+    MATH_PROBE();
     // устанавливаем 1.0f по главной диагонали
     m->a.x = 1.0f;
     m->b.y = 1.0f;
@@ -342,6 +397,7 @@ Mat3Neg
 Смена знака для каждого элемента матрицы.
 */
 void Mat3Neg( mat3_t* m ) {
+    MATH_PROBE();
     m->m[0] = -m->m[0];
     m->m[1] = -m->m[1];
     m->m[2] = -m->m[2];
@@ -359,30 +415,49 @@ Mat3Inv
 Вычисление обратной матрицы.
 */
 mbool_t Mat3Inv( mat3_t* m ) {
-    // вычисление определителя матрицы ( детерминант )
-    float det = Mat3Det( m );
+    MATH_PROBE();
+    return Mat3InvTo( m, m );
+}
+
+/*
+Mat3InvTo
+
+Вычисление обратной матрицы для in, результат записывается в out.
+out может совпадать с in. Если матрица вырожденная, out не изменяется.
+*/
+mbool_t Mat3InvTo( mat3_t* out, const mat3_t* in ) {
+    MATH_PROBE();
+    // все элементы читаются до первой записи в out
+    float a00 = in->m[0], a01 = in->m[1], a02 = in->m[2];
+    float a10 = in->m[3], a11 = in->m[4], a12 = in->m[5];
+    float a20 = in->m[6], a21 = in->m[7], a22 = in->m[8];
+
+    // алгебраические дополнения первой строки, они же дают определитель
+    float c00 = a11 * a22 - a12 * a21;
+    float c01 = a12 * a20 - a10 * a22;
+    float c02 = a10 * a21 - a11 * a20;
+
+    float det = a00 * c00 + a01 * c01 + a02 * c02;
 
     if( det == 0.0f ) {
+        MATH_METRIC( MATH_METRIC_MAT3_INV, 1, 1 );
         return mfalse;
     }
 
     float inv_det = 1 / det;
 
-    // деление алгебраического дополнения на определитель
-    mat3_t buf;
-    buf.m[0] = ( m->b.y * m->c.z - m->b.z * m->c.y ) * inv_det;
-    buf.m[1] = -( m->b.x * m->c.z - m->b.z * m->c.x ) * inv_det;
-    buf.m[2] = ( m->b.x * m->c.y - m->b.y * m->c.x ) * inv_det;
-    buf.m[3] = -( m->a.y * m->c.z - m->a.z * m->c.y ) * inv_det;
-    buf.m[4] = ( m->a.x * m->c.z - m->a.z * m->c.x ) * inv_det;
-    buf.m[5] = -( m->a.x * m->c.y - m->a.y * m->c.x ) * inv_det;
-    buf.m[6] = ( m->a.y * m->b.z - m->a.z * m->b.y ) * inv_det;
-    buf.m[7] = -( m->a.x * m->b.z - m->a.z * m->b.x ) * inv_det;
-    buf.m[8] = ( m->a.x * m->b.y - m->a.y * m->b.x ) * inv_det;
-
-    Mat3Transp( &buf ); // транспонирование матрицы
-    Mat3Copy( m, &buf ); // запись результата в исходную матрицу
-
+    // присоединённая матрица пишется сразу в транспонированном виде
+    out->m[0] = c00 * inv_det;
+    out->m[1] = ( a02 * a21 - a01 * a22 ) * inv_det;
+    out->m[2] = ( a01 * a12 - a02 * a11 ) * inv_det;
+    out->m[3] = c01 * inv_det;
+    out->m[4] = ( a00 * a22 - a02 * a20 ) * inv_det;
+    out->m[5] = ( a02 * a10 - a00 * a12 ) * inv_det;
+    out->m[6] = c02 * inv_det;
+    out->m[7] = ( a01 * a20 - a00 * a21 ) * inv_det;
+    out->m[8] = ( a00 * a11 - a01 * a10 ) * inv_det;
+
+    MATH_METRIC( MATH_METRIC_MAT3_INV, 1, 0 );
     return mtrue;
 }
 
@@ -392,6 +467,7 @@ Mat3Scale
 Умножает каждый элемент матрицы m на s.
 */
 void Mat3Scale( mat3_t* m, float s ) {
+    MATH_PROBE();
     m->m[0] *= s;
     m->m[1] *= s;
     m->m[2] *= s;
@@ -409,6 +485,7 @@ Mat3MulVec3
 Умножение матрицы 3-го порядка на вектор-столбец.
 */
 void Mat3MulVec3( vec3_t* out, const mat3_t* m, const vec3_t* v ) {
+    MATH_PROBE();
     out->x = m->m[0] * v->m[0] + m->m[1] * v->m[1] + m->m[2] * v->m[2];
     out->y = m->m[3] * v->m[0] + m->m[4] * v->m[1] + m->m[5] * v->m[2];
     out->z = m->m[6] * v->m[0] + m->m[7] * v->m[1] + m->m[8] * v->m[2];
@@ -420,6 +497,7 @@ Vec3MulMat3
 Умножение вектора-строки на матрицу 3-го порядка.
 */
 void Vec3MulMat3( vec3_t* out, const vec3_t* v, const mat3_t* m ) {
+    MATH_PROBE();
     out->x = v->m[0] * m->m[0] + v->m[1] * m->m[3] + v->m[2] * m->m[6];
     out->y = v->m[0] * m->m[1] + v->m[1] * m->m[4] + v->m[2] * m->m[7];
     out->z = v->m[0] * m->m[2] + v->m[1] * m->m[5] + v->m[2] * m->m[8];
@@ -431,6 +509,7 @@ Mat3Mul
 Умножение матриц.
 */
 void Mat3Mul( mat3_t* out, const mat3_t* a, const mat3_t* b ) {
+    MATH_PROBE();
     out->m[0] = a->m[0] * b->m[0];
     out->m[1] = a->m[1] * b->m[1];
     out->m[2] = a->m[2] * b->m[2];
@@ -448,6 +527,7 @@ Mat3Add
 Сложение матриц.
 */
 void Mat3Add( mat3_t* out, const mat3_t* a, const mat3_t* b ) {
+    MATH_PROBE();
     out->m[0] = a->m[0] + b->m[0];
     out->m[1] = a->m[1] + b->m[1];
     out->m[2] = a->m[2] + b->m[2];
@@ -465,6 +545,7 @@ Mat3Sub
 Вычитание матрицы a из матрицы b;
 */
 void Mat3Sub( mat3_t* out, const mat3_t* a, const mat3_t* b ) {
+    MATH_PROBE();
     out->m[0] = b->m[0] - a->m[0];
     out->m[1] = b->m[1] - a->m[1];
     out->m[2] = b->m[2] - a->m[2];
@@ -482,6 +563,7 @@ Mat3Cmp
 Сравнение матриц a и b.
 */
 mbool_t Mat3Cmp( const mat3_t* a, const mat3_t* b ) {
+    MATH_PROBE();
     return Vec3Cmp(&a->a, &b->a) && Vec3Cmp(&a->b, &b->b) && Vec3Cmp(&a->c, &b->c);
 }
 
@@ -493,6 +575,7 @@ Mat3CmpEps
 то результат - mtrue, иначе - mfalse.
 */
 mbool_t Mat3CmpEps( const mat3_t* a, const mat3_t* b, float eps ) {
+    MATH_PROBE();
     if( Vec3CmpEps( &a->a, &b->a, eps ) &&
         Vec3CmpEps( &a->b, &b->b, eps ) && 
         Vec3CmpEps( &a->c, &b->c, eps ) 
@@ -505,11 +588,18 @@ mbool_t Mat3CmpEps( const mat3_t* a, const mat3_t* b, float eps ) {
 /*
 Mat3IsDiag
 
-Возвращает mtrue если матрица m является диагональной (используется eps).
+Возвращает mtrue если матрица m является диагональной.
 Иначе возвращает mfalse.
 */
 mbool_t Mat3IsDiag( const mat3_t* m ) {
-
+    MATH_PROBE();
+    if( ( m->m[1] == 0.0f ) && ( m->m[2] == 0.0f )
+     && ( m->m[3] == 0.0f ) && ( m->m[5] == 0.0f )
+     && ( m->m[6] == 0.0f ) && ( m->m[7] == 0.0f )
+    ) {
+        return mtrue;
+    }
+    return mfalse;
 }
 
 /*
@@ -518,6 +608,7 @@ Mat3IsIdent
 Вернуть mtrue если матрица m является единичной (используется eps). Иначе вернуть mfalse.
 */
 mbool_t Mat3IsIdent( const mat3_t* m ) {
+    MATH_PROBE();
     if( ( ( ( m->a.x <= 1.0f + FLOAT_EPSILON ) && ( m->a.x >= 1.0f - FLOAT_EPSILON ) )
        && ( ( m->b.y <= 1.0f + FLOAT_EPSILON ) && ( m->b.y >= 1.0f - FLOAT_EPSILON ) )
        && ( ( m->c.z <= 1.0f + FLOAT_EPSILON ) && ( m->c.z >= 1.0f - FLOAT_EPSILON ) ) )
@@ -536,6 +627,7 @@ Mat3Det
 Вычисление определителя матрицы (детерминанта).
 */
 float Mat3Det( const mat3_t* m ) {
+    MATH_PROBE();
     return m->m[0] * m->m[4] * m->m[8] + m->m[1] * m->m[5] * m->m[6] + m->m[2] * m->m[3] * m->m[7]
            - m->m[2] * m->m[4] * m->m[6] - m->m[3] * m->m[1] * m->m[8] - m->m[0] * m->m[5] * m->m[7];
 }
@@ -546,17 +638,12 @@ Mat3Transp
 Транспонирование матрицы 3-го порядка.
 */
 void Mat3Transp( mat3_t* m ) {
-    mat3_t buf;
-    buf.m[0] = m->m[0];
-    buf.m[1] = m->m[3];
-    buf.m[2] = m->m[6];
-    buf.m[3] = m->m[1];
-    buf.m[4] = m->m[4];
-    buf.m[5] = m->m[7];
-    buf.m[6] = m->m[2];
-    buf.m[7] = m->m[5];
-    buf.m[8] = m->m[8];
-    Mat3Copy( m, &buf );
+    MATH_PROBE();
+    // меняем местами элементы, симметричные относительно главной диагонали
+    float buf;
+    buf = m->m[1]; m->m[1] = m->m[3]; m->m[3] = buf;
+    buf = m->m[2]; m->m[2] = m->m[6]; m->m[6] = buf;
+    buf = m->m[5]; m->m[5] = m->m[7]; m->m[7] = buf;
 }
 
 /*
@@ -566,6 +653,7 @@ Mat3ToStr
 Вывод элементов матрицы осуществляется в одну строку.
 */
 void Mat3ToStr( char* out, const mat3_t* m, int prec ) {
+    MATH_PROBE();
     sprintf( out, "%.*f %.*f %.*f %.*f %.*f %.*f %.*f %.*f %.*f", 
              prec, m->m[0], prec, m->m[1], prec, m->m[2],
              prec, m->m[3], prec, m->m[4], prec, m->m[5],
@@ -579,6 +667,7 @@ Mat3ToPrettyStr
 Строка будет выводиться в виде кватратной матрицы.
 */
 void Mat3ToPrettyStr( char* out, const mat3_t* m, int prec ) {
+    MATH_PROBE();
     sprintf( out, "%.*f %.*f %.*f\n%.*f %.*f %.*f\n%.*f %.*f %.*f", 
              prec, m->m[0], prec, m->m[1], prec, m->m[2],
              prec, m->m[3], prec, m->m[4], prec, m->m[5],
@@ -591,6 +680,7 @@ Mat3ToMat2
 Преобразование матрицы из типа mat3_t в mat2_t.
 */
 void Mat3ToMat2( mat2_t* out, const mat3_t* m ) {
+    MATH_PROBE();
     Vec3ToVec2(&out->a, &m->a);
     Vec3ToVec2(&out->b, &m->b);
 }
@@ -601,6 +691,7 @@ Mat3ToMat2
 Преобразование матрицы из типа mat3_t в mat4_t.
 */
 void Mat3ToMat4( mat4_t* out, const mat3_t* m ) {
+    MATH_PROBE();
     Vec3ToVec4(&out->a, &m->a);
     Vec3ToVec4(&out->b, &m->b);
     Vec3ToVec4(&out->c, &m->c);
@@ -613,6 +704,7 @@ Mat4Set
 Установка матрицы из значений векторов
 */
 void Mat4Set( mat4_t* m, const vec4_t* a, const vec4_t* b, const vec4_t* c, const vec4_t* d ) {
+    MATH_PROBE();
     m->a = *a;
     m->b = *b;
     m->c = *c;
@@ -628,6 +720,7 @@ void Mat4Set16f( mat4_t* m, float ax, float ay, float az, float aw,
                             float bx, float by, float bz, float bw,
                             float cx, float cy, float cz, float cw,
                             float dx, float dy, float dz, float dw ) {
+    MATH_PROBE();
     m->m[0]  = ax;
     m->m[1]  = ay;
     m->m[2]  = az;
@@ -652,6 +745,7 @@ Mat4Set16fv
 Заполнение матрицы 4-ого порядка из массива src.
 */
 void Mat4Set16fv( mat4_t* m, const float* src ) {
+    MATH_PROBE();
     m->m[0]  = src[0];
     m->m[1]  = src[1];
     m->m[2]  = src[2];
@@ -676,6 +770,7 @@ Mat4Zero
 Обнуление матрицы.
 */
 void Mat4Zero( mat4_t* m ) {
+    MATH_PROBE();
     Vec4Zero( &m->a );
     Vec4Zero( &m->b );
     Vec4Zero( &m->c );
@@ -688,6 +783,7 @@ Mat4Ident
 Установка единичной матрицы.
 */
 void Mat4Ident( mat4_t* m ) {
+    MATH_PROBE();
     // 1.0f по главной диагонали
     m->m[0]  = 1.0f;
     m->m[5]  = 1.0f;
@@ -714,6 +810,7 @@ Mat4Neg
 Сделать каждое значение отрицательным
 */
 void Mat4Neg( mat4_t* m ) {
+    MATH_PROBE();
     m->m[0]  = -m->m[0];
     m->m[1]  = -m->m[1];
     m->m[2]  = -m->m[2];
@@ -738,50 +835,71 @@ Mat4Inv
 Вычисление обратной матрицы 4-ого порядка.
 */
 mbool_t Mat4Inv( mat4_t* m ) { 
-    float det = Mat4Det( m ); // определитель матрицы
+    MATH_PROBE();
+    return Mat4InvTo( m, m );
+}
+
+/*
+Mat4InvTo
+
+Вычисление обратной матрицы 4-ого порядка для in, результат записывается в out.
+out может совпадать с in. Если матрица вырожденная, out не изменяется.
+
+Алгебраические дополнения собираются из двенадцати определителей 2-ого порядка:
+шести из двух верхних строк и шести из двух нижних.
+*/
+mbool_t Mat4InvTo( mat4_t* out, const mat4_t* in ) {
+    MATH_PROBE();
+    // все элементы читаются до первой записи в out
+    float a00 = in->m[0],  a01 = in->m[1],  a02 = in->m[2],  a03 = in->m[3];
+    float a10 = in->m[4],  a11 = in->m[5],  a12 = in->m[6],  a13 = in->m[7];
+    float a20 = in->m[8],  a21 = in->m[9],  a22 = in->m[10], a23 = in->m[11];
+    float a30 = in->m[12], a31 = in->m[13], a32 = in->m[14], a33 = in->m[15];
+
+    // определители 2-ого порядка из строк 0 и 1
+    float s0 = a00 * a11 - a10 * a01;
+    float s1 = a00 * a12 - a10 * a02;
+    float s2 = a00 * a13 - a10 * a03;
+    float s3 = a01 * a12 - a11 * a02;
+    float s4 = a01 * a13 - a11 * a03;
+    float s5 = a02 * a13 - a12 * a03;
+
+    // определители 2-ого порядка из строк 2 и 3
+    float c0 = a20 * a31 - a30 * a21;
+    float c1 = a20 * a32 - a30 * a22;
+    float c2 = a20 * a33 - a30 * a23;
+    float c3 = a21 * a32 - a31 * a22;
+    float c4 = a21 * a33 - a31 * a23;
+    float c5 = a22 * a33 - a32 * a23;
+
+    float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
 
     if( det == 0.0f ) {
+        MATH_METRIC( MATH_METRIC_MAT4_INV, 1, 1 );
         return mfalse;
     }
 
     float inv_det = 1 / det;
 
-    mat4_t buf; // матрица алгебраических дополнений
-    buf.m[0] = ( m->m[5] * m->m[10] * m->m[15] + m->m[6] * m->m[11] * m->m[13] + m->m[7] * m->m[9] * m->m[14] 
-               - m->m[7] * m->m[10] * m->m[13] - m->m[6] * m->m[9] * m->m[15] - m->m[5] * m->m[11] * m->m[14] ) * inv_det;
-    buf.m[1] = -( m->m[4] * m->m[10] * m->m[15] + m->m[6] * m->m[11] * m->m[12] + m->m[7] * m->m[8] * m->m[14] 
-                - m->m[7] * m->m[10] * m->m[12] - m->m[6] * m->m[8] * m->m[15] - m->m[4] * m->m[11] * m->m[14] ) * inv_det;
-    buf.m[2] = ( m->m[4] * m->m[9] * m->m[15] + m->m[5] * m->m[11] * m->m[12] + m->m[7] * m->m[8] * m->m[13] 
-               - m->m[7] * m->m[9] * m->m[12] - m->m[5] * m->m[8] * m->m[15] - m->m[4] * m->m[11] * m->m[13] ) * inv_det;
-    buf.m[3] = -( m->m[4] * m->m[9] * m->m[14] + m->m[5] * m->m[10] * m->m[12] + m->m[6] * m->m[8] * m->m[13] 
-                - m->m[6] * m->m[9] * m->m[12] - m->m[5] * m->m[8] * m->m[14] - m->m[4] * m->m[10] * m->m[13] ) * inv_det;
-    buf.m[4] = -( m->m[1] * m->m[10] * m->m[15] + m->m[2] * m->m[11] * m->m[13] + m->m[3] * m->m[9] * m->m[14] 
-                - m->m[3] * m->m[10] * m->m[13] - m->m[2] * m->m[9] * m->m[15] - m->m[1] * m->m[11] * m->m[14] ) * inv_det;
-    buf.m[5] = ( m->m[0] * m->m[10] * m->m[15] + m->m[2] * m->m[11] * m->m[12] + m->m[3] * m->m[8] * m->m[14] 
-               - m->m[3] * m->m[10] * m->m[12] - m->m[2] * m->m[8] * m->m[15] - m->m[0] * m->m[11] * m->m[14] ) * inv_det;
-    buf.m[6] = -( m->m[0] * m->m[9] * m->m[15] + m->m[1] * m->m[11] * m->m[12] + m->m[3] * m->m[8] * m->m[13] 
-                - m->m[3] * m->m[9] * m->m[12] - m->m[1] * m->m[8] * m->m[15] - m->m[0] * m->m[11] * m->m[13] ) * inv_det;
-    buf.m[7] = ( m->m[0] * m->m[9] * m->m[14] + m->m[1] * m->m[10] * m->m[12] + m->m[2] * m->m[8] * m->m[13] 
-               - m->m[2] * m->m[9] * m->m[12] - m->m[1] * m->m[8] * m->m[14] - m->m[0] * m->m[10] * m->m[13] ) * inv_det;
-    buf.m[8] = ( m->m[1] * m->m[6] * m->m[15] + m->m[2] * m->m[7] * m->m[13] + m->m[3] * m->m[5] * m->m[14] 
-               - m->m[3] * m->m[6] * m->m[13] - m->m[2] * m->m[5] * m->m[15] - m->m[1] * m->m[7] * m->m[14] ) * inv_det;
-    buf.m[9] = -( m->m[0] * m->m[6] * m->m[15] + m->m[2] * m->m[7] * m->m[12] + m->m[3] * m->m[4] * m->m[14] 
-                - m->m[3] * m->m[6] * m->m[12] - m->m[2] * m->m[4] * m->m[15] - m->m[0] * m->m[7] * m->m[14] ) * inv_det;
-    buf.m[10] = ( m->m[0] * m->m[5] * m->m[15] + m->m[1] * m->m[7] * m->m[12] + m->m[3] * m->m[4] * m->m[13] 
-                - m->m[3] * m->m[5] * m->m[12] - m->m[1] * m->m[4] * m->m[15] - m->m[0] * m->m[7] * m->m[13] ) * inv_det;
-    buf.m[11] = -( m->m[0] * m->m[5] * m->m[14] + m->m[1] * m->m[6] * m->m[12] + m->m[2] * m->m[4] * m->m[13]
-                 - m->m[2] * m->m[5] * m->m[12] - m->m[1] * m->m[4] * m->m[14] - m->m[0] * m->m[6] * m->m[13] ) * inv_det;   
-    buf.m[12] = -( m->m[1] * m->m[6] * m->m[11] + m->m[2] * m->m[7] * m->m[9] + m->m[3] * m->m[5] * m->m[10]
-                 - m->m[3] * m->m[6] * m->m[9] - m->m[2] * m->m[5] * m->m[11] - m->m[1] * m->m[7] * m->m[10] ) * inv_det;
-    buf.m[13] = ( m->m[0] * m->m[6] * m->m[11] + m->m[2] * m->m[7] * m->m[8] + m->m[3] * m->m[4] * m->m[10] 
-                - m->m[3] * m->m[6] * m->m[8] - m->m[2] * m->m[4] * m->m[11] - m->m[0] * m->m[7] * m->m[10] ) * inv_det;
-    buf.m[14] = -( m->m[0] * m->m[5] * m->m[11] + m->m[1] * m->m[7] * m->m[8] + m->m[3] * m->m[4] * m->m[9] 
-                 - m->m[3] * m->m[5] * m->m[8] - m->m[1] * m->m[4] * m->m[11] - m->m[0] * m->m[9] * m->m[7] ) * inv_det;
-    buf.m[15] = ( m->m[0] * m->m[5] * m->m[10] + m->m[1] * m->m[6] * m->m[8] + m->m[2] * m->m[4] * m->m[9] 
-                - m->m[2] * m->m[5] * m->m[8] - m->m[1] * m->m[4] * m->m[10] - m->m[0] * m->m[6] * m->m[9] ) * inv_det;
-
-    Mat4Transp( &buf );
-    Mat4Copy( m, &buf);
+    // присоединённая матрица пишется сразу в транспонированном виде
+    out->m[0]  = (  a11 * c5 - a12 * c4 + a13 * c3 ) * inv_det;
+    out->m[1]  = ( -a01 * c5 + a02 * c4 - a03 * c3 ) * inv_det;
+    out->m[2]  = (  a31 * s5 - a32 * s4 + a33 * s3 ) * inv_det;
+    out->m[3]  = ( -a21 * s5 + a22 * s4 - a23 * s3 ) * inv_det;
+    out->m[4]  = ( -a10 * c5 + a12 * c2 - a13 * c1 ) * inv_det;
+    out->m[5]  = (  a00 * c5 - a02 * c2 + a03 * c1 ) * inv_det;
+    out->m[6]  = ( -a30 * s5 + a32 * s2 - a33 * s1 ) * inv_det;
+    out->m[7]  = (  a20 * s5 - a22 * s2 + a23 * s1 ) * inv_det;
+    out->m[8]  = (  a10 * c4 - a11 * c2 + a13 * c0 ) * inv_det;
+    out->m[9]  = ( -a00 * c4 + a01 * c2 - a03 * c0 ) * inv_det;
+    out->m[10] = (  a30 * s4 - a31 * s2 + a33 * s0 ) * inv_det;
+    out->m[11] = ( -a20 * s4 + a21 * s2 - a23 * s0 ) * inv_det;
+    out->m[12] = ( -a10 * c3 + a11 * c1 - a12 * c0 ) * inv_det;
+    out->m[13] = (  a00 * c3 - a01 * c1 + a02 * c0 ) * inv_det;
+    out->m[14] = ( -a30 * s3 + a31 * s1 - a32 * s0 ) * inv_det;
+    out->m[15] = (  a20 * s3 - a21 * s1 + a22 * s0 ) * inv_det;
+
+    MATH_METRIC( MATH_METRIC_MAT4_INV, 1, 0 );
     return mtrue;
 }
 
@@ -792,6 +910,7 @@ Mat4Scale
 Умножить каждый элемент матрицы на s.
 */
 void Mat4Scale( mat4_t* m, float s ) {
+    MATH_PROBE();
     m->m[0]  *= s;
     m->m[1]  *= s;
     m->m[2]  *= s;
@@ -816,6 +935,7 @@ Mat4MulVec4
 Умножить матрицу 4-ого порядка на вектор столбец 4-ого порядка.
 */
 void Mat4MulVec4( vec4_t* out, const mat4_t* m, const vec4_t* v ) {
+    MATH_PROBE();
     out->x = m->m[0] * v->m[0] + m->m[1] * v->m[1] + m->m[2] * v->m[2] + m->m[3] * v->m[3];
     out->y = m->m[4] * v->m[0] + m->m[5] * v->m[1] + m->m[6] * v->m[2] + m->m[7] * v->m[3]; 
     out->z = m->m[8] * v->m[0] + m->m[9] * v->m[1] + m->m[10] * v->m[2] + m->m[11] * v->m[3]; 
@@ -828,6 +948,7 @@ Mat4MulVec3
 Умножить матрицу 4-ого порядка на вектор-столбец 3-го порядка.
 */
 void Mat4MulVec3( vec3_t* out, const mat4_t* m, const vec3_t* v ) {
+    MATH_PROBE();
     vec4_t buf;
 
     buf.x = m->a.x * v->x + m->a.y * v->y + m->a.z * v->z + m->a.w * 1.0f;
@@ -848,6 +969,7 @@ Vec4MulMat4
 Умножить вектор-строку 4-ого порядка на матрицу 4-ого порядка.
 */
 void Vec4MulMat4( vec4_t* out, const vec4_t* v, const mat4_t* m ) {
+    MATH_PROBE();
     out->x = v->m[0] * m->m[0] + v->m[1] * m->m[4] + v->m[0] * m->m[8] + v->m[0] * m->m[12];
     out->y = v->m[0] * m->m[1] + v->m[1] * m->m[5] + v->m[0] * m->m[9] + v->m[0] * m->m[13];
     out->z = v->m[0] * m->m[2] + v->m[1] * m->m[6] + v->m[0] * m->m[10] + v->m[0] * m->m[14];
@@ -861,22 +983,17 @@ Mat4Mul
 Умножить матрицу a на матрицу b.
 */
 void Mat4Mul( mat4_t* out, const mat4_t* a, const mat4_t* b ) {
-    out->m[0]  = a->m[0] * b->m[0];
-    out->m[1]  = a->m[1] * b->m[1];
-    out->m[2]  = a->m[2] * b->m[2];
-    out->m[3]  = a->m[3] * b->m[3];
-    out->m[4]  = a->m[4] * b->m[4];
-    out->m[5]  = a->m[5] * b->m[5];
-    out->m[6]  = a->m[6] * b->m[6];
-    out->m[7]  = a->m[7] * b->m[7];
-    out->m[8]  = a->m[8] * b->m[8];
-    out->m[9]  = a->m[9] * b->m[9];
-    out->m[10] = a->m[10] * b->m[10];
-    out->m[11] = a->m[11] * b->m[11];
-    out->m[12] = a->m[12] * b->m[12];
-    out->m[13] = a->m[13] * b->m[13];
-    out->m[14] = a->m[14] * b->m[14];
-    out->m[15] = a->m[15] * b->m[15];
+    MATH_PROBE();
+    // результат собирается в buf, чтобы out мог совпадать с a или b
+    mat4_t buf;
+    for( int i = 0; i < 4; i++ ) {
+        const float* r = &a->m[i * 4];
+        buf.m[i * 4 + 0] = r[0] * b->m[0] + r[1] * b->m[4] + r[2] * b->m[8]  + r[3] * b->m[12];
+        buf.m[i * 4 + 1] = r[0] * b->m[1] + r[1] * b->m[5] + r[2] * b->m[9]  + r[3] * b->m[13];
+        buf.m[i * 4 + 2] = r[0] * b->m[2] + r[1] * b->m[6] + r[2] * b->m[10] + r[3] * b->m[14];
+        buf.m[i * 4 + 3] = r[0] * b->m[3] + r[1] * b->m[7] + r[2] * b->m[11] + r[3] * b->m[15];
+    }
+    *out = buf;
 }
 
 /*
@@ -885,6 +1002,7 @@ Mat3Add
 Сложение матриц.
 */
 void Mat4Add( mat4_t* out, const mat4_t* a, const mat4_t* b ) {
+    MATH_PROBE();
     out->m[0]  = a->m[0] + b->m[0];
     out->m[1]  = a->m[1] + b->m[1];
     out->m[2]  = a->m[2] + b->m[2];
@@ -909,6 +1027,7 @@ Mat4Sub
 Вычитание из матрицы b матрицы a.
 */
 void Mat4Sub( mat4_t* out, const mat4_t* a, const mat4_t* b ) {
+    MATH_PROBE();
     out->m[0]  = b->m[0] - a->m[0];
     out->m[1]  = b->m[1] - a->m[1];
     out->m[2]  = b->m[2] - a->m[2];
@@ -933,6 +1052,7 @@ Mat4Copy
 Установка значений матрицы a в матрицу m.
 */
 void Mat4Copy( mat4_t* m, const mat4_t* a ) {
+    MATH_PROBE();
     m->m[0]  = a->m[0];
     m->m[1]  = a->m[1];
     m->m[2]  = a->m[2];
@@ -957,6 +1077,7 @@ Mat4Cmp
 Сравнение матриц a и b.
 */
 mbool_t Mat4Cmp( const mat4_t* a, const mat4_t* b ) {
+    MATH_PROBE();
     return Vec4Cmp(&a->a, &b->a) && Vec4Cmp(&a->b, &b->b) && Vec4Cmp(&a->c, &b->c) && Vec4Cmp(&a->d, &b->d);
 }
 
@@ -968,6 +1089,7 @@ Mat4CmpEps
 то результат - mtrue, иначе - mfalse.
 */
 mbool_t Mat4CmpEps( const mat4_t* a, const mat4_t* b, float eps ) {
+    MATH_PROBE();
     if( Vec4CmpEps( &a->a, &b->a, eps ) &&
         Vec4CmpEps( &a->b, &b->b, eps ) && 
         Vec4CmpEps( &a->c, &b->c, eps ) &&
@@ -981,11 +1103,19 @@ mbool_t Mat4CmpEps( const mat4_t* a, const mat4_t* b, float eps ) {
 /*
 Mat4IsDiag
 
-Возвращает mtrue если матрица m является диагональной (используется eps). 
+Возвращает mtrue если матрица m является диагональной.
 Иначе возвращает mfalse.
 */
 mbool_t Mat4IsDiag( const mat4_t* m ) {
-
+    MATH_PROBE();
+    if( ( m->m[1] == 0.0f ) && ( m->m[2] == 0.0f ) && ( m->m[3] == 0.0f )
+     && ( m->m[4] == 0.0f ) && ( m->m[6] == 0.0f ) && ( m->m[7] == 0.0f )
+     && ( m->m[8] == 0.0f ) && ( m->m[9] == 0.0f ) && ( m->m[11] == 0.0f )
+     && ( m->m[12] == 0.0f ) && ( m->m[13] == 0.0f ) && ( m->m[14] == 0.0f )
+    ) {
+        return mtrue;
+    }
+    return mfalse;
 }
 
 /*
@@ -995,6 +1125,7 @@ Mat4IsIdent
 Иначе вернуть mfalse.
 */
 mbool_t Mat4IsIdent( const mat4_t* m ) {
+    MATH_PROBE();
     if( ( ( ( m->a.x <= 1.0f + FLOAT_EPSILON ) && ( m->a.x >= 1.0f - FLOAT_EPSILON ) )
        && ( ( m->b.y <= 1.0f + FLOAT_EPSILON ) && ( m->b.y >= 1.0f - FLOAT_EPSILON ) )
        && ( ( m->c.z <= 1.0f + FLOAT_EPSILON ) && ( m->c.z >= 1.0f - FLOAT_EPSILON ) )
@@ -1018,6 +1149,7 @@ Mat4Det
 их алгебраических дополнений.
 */
 float Mat4Det( const mat4_t* m ) {
+    MATH_PROBE();
     // можно вычислять алгебраические дополнения из любой строки или столбца
     // я начну с 3-ей строки, потому что я так хочу
 
@@ -1040,26 +1172,30 @@ float Mat4Det( const mat4_t* m ) {
 Mat4Transp
 
 Транспонирование матрицы 4-ого порядка.
+При наличии SSE строки транспонируются перестановками в регистрах.
 */
 void Mat4Transp( mat4_t* m ) {
-    mat4_t buf;
-    buf.m[0] = m->m[0];
-    buf.m[1] = m->m[4];
-    buf.m[2] = m->m[8];
-    buf.m[3] = m->m[12];
-    buf.m[4] = m->m[1];
-    buf.m[5] = m->m[5];
-    buf.m[6] = m->m[9];
-    buf.m[7] = m->m[13];
-    buf.m[8] = m->m[2];
-    buf.m[9] = m->m[6];
-    buf.m[10] = m->m[10];
-    buf.m[11] = m->m[14];
-    buf.m[12] = m->m[3];
-    buf.m[13] = m->m[7];
-    buf.m[14] = m->m[11];
-    buf.m[15] = m->m[15];
-    Mat4Copy( m, &buf );
+    MATH_PROBE();
+#if defined( __SSE__ )
+    __m128 r0 = _mm_loadu_ps( &m->m[0] );
+    __m128 r1 = _mm_loadu_ps( &m->m[4] );
+    __m128 r2 = _mm_loadu_ps( &m->m[8] );
+    __m128 r3 = _mm_loadu_ps( &m->m[12] );
+    _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+    _mm_storeu_ps( &m->m[0],  r0 );
+    _mm_storeu_ps( &m->m[4],  r1 );
+    _mm_storeu_ps( &m->m[8],  r2 );
+    _mm_storeu_ps( &m->m[12], r3 );
+#else
+    // меняем местами элементы, симметричные относительно главной диагонали
+    float buf;
+    buf = m->m[1];  m->m[1]  = m->m[4];  m->m[4]  = buf;
+    buf = m->m[2];  m->m[2]  = m->m[8];  m->m[8]  = buf;
+    buf = m->m[3];  m->m[3]  = m->m[12]; m->m[12] = buf;
+    buf = m->m[6];  m->m[6]  = m->m[9];  m->m[9]  = buf;
+    buf = m->m[7];  m->m[7]  = m->m[13]; m->m[13] = buf;
+    buf = m->m[11]; m->m[11] = m->m[14]; m->m[14] = buf;
+#endif
 }
 
 /*
@@ -1070,6 +1206,7 @@ Mat4ToStr
 Память под указатель out необходимо выделять вручную.
 */
 void Mat4ToStr( char* out, const mat4_t* m, int prec ) {
+    MATH_PROBE();
     sprintf( out, "%.*f %.*f %.*f %.*f %.*f %.*f %.*f %.*f %.*f %.*f %.*f %.*f %.*f %.*f %.*f %.*f",
              prec, m->m[0],  prec, m->m[1],  prec, m->m[2],  prec, m->m[3],
              prec, m->m[4],  prec, m->m[5],  prec, m->m[6],  prec, m->m[7],
@@ -1085,6 +1222,7 @@ Mat4ToPrettyStr
 Память под указатель out необходимо выделять вручную.
 */
 void Mat4ToPrettyStr( char* out, const mat4_t* m, int prec ) {
+    MATH_PROBE();
     sprintf( out, "%.*f %.*f %.*f %.*f\n%.*f %.*f %.*f %.*f\n%.*f %.*f %.*f %.*f\n%.*f %.*f %.*f %.*f",
              prec, m->m[0],  prec, m->m[1],  prec, m->m[2],  prec, m->m[3],
              prec, m->m[4],  prec, m->m[5],  prec, m->m[6],  prec, m->m[7],
@@ -1093,12 +1231,81 @@ void Mat4ToPrettyStr( char* out, const mat4_t* m, int prec ) {
 }
 
 void Mat4ToMat2( mat2_t* out, const mat4_t* m ) {
+    MATH_PROBE();
     Vec4ToVec2(&out->a, &m->a);
     Vec4ToVec2(&out->b, &m->b);
 }
 
 void Mat4ToMat3( mat3_t* out, const mat4_t* m ) {
+    MATH_PROBE();
     Vec4ToVec3(&out->a, &m->a);
     Vec4ToVec3(&out->b, &m->b);
     Vec4ToVec3(&out->c, &m->c);
 }
+
+/*
+Mat3MulVec3R
+
+Умножение матрицы 3-го порядка на вектор-столбец.
+out не должен совпадать с m и v.
+*/
+void Mat3MulVec3R( vec3_t* mrestrict out, const mat3_t* mrestrict m, const vec3_t* mrestrict v ) {
+    MATH_PROBE();
+    out->x = m->m[0] * v->m[0] + m->m[1] * v->m[1] + m->m[2] * v->m[2];
+    out->y = m->m[3] * v->m[0] + m->m[4] * v->m[1] + m->m[5] * v->m[2];
+    out->z = m->m[6] * v->m[0] + m->m[7] * v->m[1] + m->m[8] * v->m[2];
+}
+
+/*
+Mat4MulR
+
+Умножить матрицу a на матрицу b.
+out не должен совпадать с a и b, поэтому результат пишется сразу в out.
+*/
+void Mat4MulR( mat4_t* mrestrict out, const mat4_t* mrestrict a, const mat4_t* mrestrict b ) {
+    MATH_PROBE();
+    for( int i = 0; i < 4; i++ ) {
+        const float* r = &a->m[i * 4];
+        out->m[i * 4 + 0] = r[0] * b->m[0] + r[1] * b->m[4] + r[2] * b->m[8]  + r[3] * b->m[12];
+        out->m[i * 4 + 1] = r[0] * b->m[1] + r[1] * b->m[5] + r[2] * b->m[9]  + r[3] * b->m[13];
+        out->m[i * 4 + 2] = r[0] * b->m[2] + r[1] * b->m[6] + r[2] * b->m[10] + r[3] * b->m[14];
+        out->m[i * 4 + 3] = r[0] * b->m[3] + r[1] * b->m[7] + r[2] * b->m[11] + r[3] * b->m[15];
+    }
+}
+
+/*
+Mat4MulVec4R
+
+Умножить матрицу 4-ого порядка на вектор-столбец 4-ого порядка.
+out не должен совпадать с m и v.
+*/
+void Mat4MulVec4R( vec4_t* mrestrict out, const mat4_t* mrestrict m, const vec4_t* mrestrict v ) {
+    MATH_PROBE();
+    out->x = m->m[0]  * v->m[0] + m->m[1]  * v->m[1] + m->m[2]  * v->m[2] + m->m[3]  * v->m[3];
+    out->y = m->m[4]  * v->m[0] + m->m[5]  * v->m[1] + m->m[6]  * v->m[2] + m->m[7]  * v->m[3];
+    out->z = m->m[8]  * v->m[0] + m->m[9]  * v->m[1] + m->m[10] * v->m[2] + m->m[11] * v->m[3];
+    out->w = m->m[12] * v->m[0] + m->m[13] * v->m[1] + m->m[14] * v->m[2] + m->m[15] * v->m[3];
+}
+
+/*
+Mat4MulVec3R
+
+Умножить матрицу 4-ого порядка на вектор-столбец 3-го порядка (w = 1)
+с делением на w. out не должен совпадать с m и v.
+*/
+void Mat4MulVec3R( vec3_t* mrestrict out, const mat4_t* mrestrict m, const vec3_t* mrestrict v ) {
+    MATH_PROBE();
+    float x = m->m[0]  * v->x + m->m[1]  * v->y + m->m[2]  * v->z + m->m[3];
+    float y = m->m[4]  * v->x + m->m[5]  * v->y + m->m[6]  * v->z + m->m[7];
+    float z = m->m[8]  * v->x + m->m[9]  * v->y + m->m[10] * v->z + m->m[11];
+    float w = m->m[12] * v->x + m->m[13] * v->y + m->m[14] * v->z + m->m[15];
+
+    if( w == 0.0f ) {
+        w = 1.0f;
+    }
+
+    float inv_w = 1.0f / w;
+    out->x = x * inv_w;
+    out->y = y * inv_w;
+    out->z = z * inv_w;
+}
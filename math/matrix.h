@@ -55,6 +55,7 @@ void        Mat2Zero( mat2_t* m );
 void        Mat2Ident( mat2_t* m );
 void        Mat2Neg( mat2_t* m );
 mbool_t     Mat2Inv( mat2_t* m );
+mbool_t     Mat2InvTo( mat2_t* out, const mat2_t* in );
 void        Mat2Scale( mat2_t* m, float s );
 void        Mat2MulVec2( vec2_t* out, const mat2_t* m, const vec2_t* v );
 void        Vec2MulMat2( vec2_t* out, const vec2_t* v, const mat2_t* m );
@@ -82,6 +83,7 @@ void        Mat3Zero( mat3_t* m );
 void        Mat3Ident( mat3_t* m );
 void        Mat3Neg( mat3_t* m );
 mbool_t     Mat3Inv( mat3_t* m );
+mbool_t     Mat3InvTo( mat3_t* out, const mat3_t* in );
 void        Mat3Scale( mat3_t* m, float s );
 void        Mat3MulVec3( vec3_t* out, const mat3_t* m, const vec3_t* v );
 void        Vec3MulMat3( vec3_t* out, const vec3_t* v, const mat3_t* m );
@@ -110,6 +112,7 @@ void        Mat4Zero( mat4_t* m );
 void        Mat4Ident( mat4_t* m );
 void        Mat4Neg( mat4_t* m );
 mbool_t     Mat4Inv( mat4_t* m );
+mbool_t     Mat4InvTo( mat4_t* out, const mat4_t* in );
 void        Mat4Scale( mat4_t* m, float s );
 void        Mat4MulVec4( vec4_t* out, const mat4_t* m, const vec4_t* v );
 void        Mat4MulVec3( vec3_t* out, const mat4_t* m, const vec3_t* v );
@@ -130,4 +133,12 @@ void        Mat4ToMat3( mat3_t* out, const mat4_t* m );
 
 
 
+// варианты без пересечения аргументов: out не может совпадать с входными данными
+void        Mat3MulVec3R( vec3_t* mrestrict out, const mat3_t* mrestrict m, const vec3_t* mrestrict v );
+void        Mat4MulR( mat4_t* mrestrict out, const mat4_t* mrestrict a, const mat4_t* mrestrict b );
+void        Mat4MulVec4R( vec4_t* mrestrict out, const mat4_t* mrestrict m, const vec4_t* mrestrict v );
+void        Mat4MulVec3R( vec3_t* mrestrict out, const mat4_t* mrestrict m, const vec3_t* mrestrict v );
+
+
+
 #endif //__MATRIX_H__
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "metrics.h"
+
+#if defined( MATH_METRICS )
+
+#if !defined( __GNUC__ ) || defined( _WIN32 )
+#error "MATH_METRICS requires GCC or Clang on a POSIX system"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static const char* math_metric_names[MATH_METRIC_COUNT] = {
+    "Mat2Inv",
+    "Mat3Inv",
+    "Mat4Inv",
+    "Mat3SolveArray",
+    "Mat4SolveArray",
+    "Mat3SvdArray",
+    "Mat3PolarArray",
+    "Mat3SymEigenArray",
+    "MatNMul",
+    "AnimSampleLayers",
+    "Noise*Array"
+};
+
+static mathmetricshm_t*     math_metrics;
+static char                 math_metrics_name[64];
+static int                  math_metrics_gen;       // меняется при каждом MathMetricsInit
+
+static __thread mathmetricrow_t*    math_metrics_row;
+static __thread int                 math_metrics_row_gen;
+
+/*
+MathMetricsInit
+
+Создание сегмента разделяемой памяти. При ошибке счётчики просто не ведутся.
+*/
+void MathMetricsInit( void ) {
+    const char* name = getenv( "MATH_METRICS_NAME" );
+    if( name != NULL ) {
+        snprintf( math_metrics_name, sizeof( math_metrics_name ), "%s", name );
+    }
+    else {
+        snprintf( math_metrics_name, sizeof( math_metrics_name ), "/math_metrics.%d", ( int )getpid() );
+    }
+
+    int fd = shm_open( math_metrics_name, O_CREAT | O_RDWR | O_TRUNC, 0644 );
+    if( fd < 0 ) {
+        return;
+    }
+    if( ftruncate( fd, sizeof( mathmetricshm_t ) ) != 0 ) {
+        close( fd );
+        shm_unlink( math_metrics_name );
+        return;
+    }
+    void* p = mmap( NULL, sizeof( mathmetricshm_t ), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close( fd );
+    if( p == MAP_FAILED ) {
+        shm_unlink( math_metrics_name );
+        return;
+    }
+
+    mathmetricshm_t* shm = p;
+    memset( shm, 0, sizeof( mathmetricshm_t ) );
+    shm->version = MATH_METRICS_VERSION;
+    shm->num_metrics = MATH_METRIC_COUNT;
+    shm->pid = ( uint32_t )getpid();
+    for( int i = 0; i < MATH_METRIC_COUNT; i++ ) {
+        snprintf( shm->names[i], MATH_METRICS_NAME_LEN, "%s", math_metric_names[i] );
+    }
+    // magic записывается последним: читатель не смотрит в сегмент без него
+    __atomic_store_n( &shm->magic, MATH_METRICS_MAGIC, __ATOMIC_RELEASE );
+    __atomic_add_fetch( &math_metrics_gen, 1, __ATOMIC_RELEASE );
+    __atomic_store_n( &math_metrics, shm, __ATOMIC_RELEASE );
+}
+
+/*
+MathMetricsRelease
+
+Удаление сегмента. Вызывается из MathRelease после остановки других потоков.
+*/
+void MathMetricsRelease( void ) {
+    mathmetricshm_t* shm = __atomic_exchange_n( &math_metrics, NULL, __ATOMIC_ACQ_REL );
+    if( shm == NULL ) {
+        return;
+    }
+    munmap( shm, sizeof( mathmetricshm_t ) );
+    shm_unlink( math_metrics_name );
+}
+
+/*
+MathMetricRow
+
+Строка текущего потока, занимается при первой записи после MathMetricsInit.
+Если строк не хватило, поток учитывается в dropped и больше не пишет.
+*/
+static mathmetricrow_t* MathMetricRow( mathmetricshm_t* shm ) {
+    int gen = __atomic_load_n( &math_metrics_gen, __ATOMIC_ACQUIRE );
+    if( math_metrics_row_gen == gen ) {
+        return math_metrics_row;
+    }
+    uint32_t r = __atomic_fetch_add( &shm->num_rows, 1, __ATOMIC_RELAXED );
+    if( r < MATH_METRICS_ROWS ) {
+        math_metrics_row = &shm->rows[r];
+        __atomic_store_n( &math_metrics_row->used, 1, __ATOMIC_RELEASE );
+    }
+    else {
+        math_metrics_row = NULL;
+        __atomic_add_fetch( &shm->dropped, 1, __ATOMIC_RELAXED );
+    }
+    math_metrics_row_gen = gen;
+    return math_metrics_row;
+}
+
+/*
+MathMetricAdd
+
+Вызов ядра m над elements элементами, events - число особых случаев
+(например, вырожденных матриц).
+*/
+void MathMetricAdd( mathmetric_t m, uint64_t elements, uint64_t events ) {
+    mathmetricshm_t* shm = __atomic_load_n( &math_metrics, __ATOMIC_ACQUIRE );
+    if( shm == NULL ) {
+        return;
+    }
+    mathmetricrow_t* row = MathMetricRow( shm );
+    if( row == NULL ) {
+        return;
+    }
+
+    // строку меняет только этот поток, поэтому хватает обычного чтения seq
+    uint32_t seq = row->seq;
+    __atomic_store_n( &row->seq, seq + 1, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+
+    mathcounter_t* c = &row->c[m];
+    __atomic_store_n( &c->calls, c->calls + 1, __ATOMIC_RELAXED );
+    __atomic_store_n( &c->elements, c->elements + elements, __ATOMIC_RELAXED );
+    __atomic_store_n( &c->events, c->events + events, __ATOMIC_RELAXED );
+    if( elements > c->max_batch ) {
+        __atomic_store_n( &c->max_batch, elements, __ATOMIC_RELAXED );
+    }
+
+    __atomic_store_n( &row->seq, seq + 2, __ATOMIC_RELEASE );
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <stdint.h>
+
+/*
+Счётчики пакетных ядер в разделяемой памяти. Включаются сборкой
+с -DMATH_METRICS (только POSIX): MathInit создаёт сегмент с именем из
+переменной окружения MATH_METRICS_NAME (по умолчанию /math_metrics.<pid>),
+MathRelease удаляет его. Ядра отмечают каждый вызов через MATH_METRIC,
+а внешняя программа (tools/mathtop.c) читает сегмент, не останавливая процесс.
+
+Каждый поток пишет в свою строку сегмента под собственным seqlock:
+запись не ждёт ни других потоков, ни читателя, читатель повторяет
+чтение строки, если во время копирования счётчик seq изменился.
+В обычной сборке MATH_METRIC раскрывается в пустоту.
+*/
+
+#define MATH_METRICS_MAGIC      0x4D4D5452u     // "MMTR"
+#define MATH_METRICS_VERSION    1
+#define MATH_METRICS_ROWS       64              // потоков с собственной строкой
+#define MATH_METRICS_NAME_LEN   24
+
+// замеряемые ядра
+typedef enum {
+    MATH_METRIC_MAT2_INV = 0,   // события - вырожденные матрицы
+    MATH_METRIC_MAT3_INV,
+    MATH_METRIC_MAT4_INV,
+    MATH_METRIC_MAT3_SOLVE,     // Mat3SolveArray, события - вырожденные системы
+    MATH_METRIC_MAT4_SOLVE,
+    MATH_METRIC_MAT3_SVD,
+    MATH_METRIC_MAT3_POLAR,
+    MATH_METRIC_MAT3_EIGEN,
+    MATH_METRIC_MATN_MUL,       // элементы - умножения-сложения
+    MATH_METRIC_ANIM_SAMPLE,    // элементы - кости
+    MATH_METRIC_NOISE,
+    MATH_METRIC_COUNT
+} mathmetric_t;
+
+// счётчики одного ядра
+typedef struct {
+    uint64_t        calls;
+    uint64_t        elements;
+    uint64_t        events;
+    uint64_t        max_batch;
+} mathcounter_t;
+
+// строка одного потока: seq нечётный, пока поток её меняет
+typedef struct {
+    uint32_t        seq;
+    uint32_t        used;
+    mathcounter_t   c[MATH_METRIC_COUNT];
+} mathmetricrow_t;
+
+// раскладка сегмента
+typedef struct {
+    uint32_t        magic;
+    uint32_t        version;
+    uint32_t        num_metrics;
+    uint32_t        num_rows;       // занятые строки
+    uint32_t        dropped;        // потоки, которым не хватило строки
+    uint32_t        pid;
+    char            names[MATH_METRIC_COUNT][MATH_METRICS_NAME_LEN];
+    mathmetricrow_t rows[MATH_METRICS_ROWS];
+} mathmetricshm_t;
+
+#if defined( MATH_METRICS )
+
+void        MathMetricsInit( void );
+void        MathMetricsRelease( void );
+void        MathMetricAdd( mathmetric_t m, uint64_t elements, uint64_t events );
+
+#define MATH_METRIC( m, elements, events )  MathMetricAdd( m, elements, events )
+
+#else
+
+// аргументы не вычисляются, но считаются использованными
+#define MATH_METRIC( m, elements, events )  ( ( void )sizeof( ( elements ) + ( events ) ) )
+
+#endif
+
+
+
+#endif //__METRICS_H__
@@ -0,0 +1,672 @@
+#include <string.h>
+
+#include "noise.h"
+#include "lane.h"
+#include "pool.h"
+
+/*
+Хеш узлов решётки считается полиномом permute( x ) = ( 34 * x * x + x ) mod 289
+над целыми числами, записанными во float: все промежуточные значения меньше 2^24,
+поэтому вычисления точные и одинаковые на всех ширинах полосы, а целочисленные
+команды AVX2 не нужны. Отсюда же период решётки 289.
+*/
+
+#define NOISE_PERIOD        289.0f
+#define NOISE_MAX_OCTAVES   16
+
+// масштабы, приводящие размах каждого вида шума примерно к [-1, 1]
+#define NOISE_PERLIN2_SCALE     1.41f
+#define NOISE_PERLIN3_SCALE     1.15f
+#define NOISE_PERLIN4_SCALE     1.0f
+#define NOISE_SIMPLEX2_SCALE    99.0f
+#define NOISE_SIMPLEX3_SCALE    107.0f
+#define NOISE_SIMPLEX4_SCALE    108.0f
+
+// сдвиг между октавами fBm и между компонентами смещения при искажении
+#define NOISE_OCTAVE_SHIFT      17.31f
+#define NOISE_WARP_SHIFT        5.27f
+
+typedef lanef_t ( *noisefn_t )( const lanef_t* p );
+
+// x mod 289
+static inline lanef_t NoiseMod( lanef_t x ) {
+    lanef_t q = LaneFloor( LaneMul( x, LaneSet1( 1.0f / NOISE_PERIOD ) ) );
+    return LaneSub( x, LaneMul( q, LaneSet1( NOISE_PERIOD ) ) );
+}
+
+static inline lanef_t NoisePermute( lanef_t x ) {
+    return NoiseMod( LaneMul( LaneAdd( LaneMul( x, LaneSet1( 34.0f ) ), LaneSet1( 1.0f ) ), x ) );
+}
+
+// 1, если edge <= x, иначе 0
+static inline lanef_t NoiseStep( lanef_t edge, lanef_t x ) {
+    return LaneSel( LaneLt( x, edge ), LaneSet1( 0.0f ), LaneSet1( 1.0f ) );
+}
+
+// -1 для отрицательных, 1 для остальных
+static inline lanef_t NoiseSign( lanef_t x ) {
+    return LaneSel( LaneLt( x, LaneSet1( 0.0f ) ), LaneSet1( -1.0f ), LaneSet1( 1.0f ) );
+}
+
+// сглаживание 6t^5 - 15t^4 + 10t^3
+static inline lanef_t NoiseFade( lanef_t t ) {
+    lanef_t p = LaneAdd( LaneMul( t, LaneSub( LaneMul( t, LaneSet1( 6.0f ) ), LaneSet1( 15.0f ) ) ), LaneSet1( 10.0f ) );
+    return LaneMul( LaneMul( LaneMul( t, t ), t ), p );
+}
+
+// вес вершины симплекса max( r - |d|^2, 0 )^4
+static inline lanef_t NoiseFalloff( lanef_t r, lanef_t d2 ) {
+    lanef_t t = LaneMax( LaneSub( r, d2 ), LaneSet1( 0.0f ) );
+    t = LaneMul( t, t );
+    return LaneMul( t, t );
+}
+
+/*
+NoiseDigit7
+
+Младшая цифра семеричной записи целого h из [0, 289) и h без неё в rest.
+Частное округляется от середины между целыми, поэтому ошибка умножения
+на 1/7 не переносит кратные 7 в соседнюю цифру.
+*/
+static inline lanef_t NoiseDigit7( lanef_t h, lanef_t* rest ) {
+    *rest = LaneFloor( LaneMul( LaneAdd( h, LaneSet1( 0.5f ) ), LaneSet1( 1.0f / 7.0f ) ) );
+    return LaneSub( h, LaneMul( *rest, LaneSet1( 7.0f ) ) );
+}
+
+/*
+NoiseGrad2
+
+Скалярное произведение единичного градиента узла с хешем h на смещение ( x, y ).
+Градиенты - 41 направление, равномерно разнесённые по окружности.
+*/
+static inline lanef_t NoiseGrad2( lanef_t h, lanef_t x, lanef_t y ) {
+    lanef_t gx = LaneSub( LaneMul( LaneFrac( LaneMul( h, LaneSet1( 1.0f / 41.0f ) ) ), LaneSet1( 2.0f ) ), LaneSet1( 1.0f ) );
+    lanef_t gy = LaneSub( LaneAbs( gx ), LaneSet1( 0.5f ) );
+    gx = LaneSub( gx, LaneFloor( LaneAdd( gx, LaneSet1( 0.5f ) ) ) );
+    lanef_t d = LaneAdd( LaneMul( gx, x ), LaneMul( gy, y ) );
+    return LaneMul( d, LaneRsqrt( LaneAdd( LaneMul( gx, gx ), LaneMul( gy, gy ) ) ) );
+}
+
+/*
+NoiseGrad3
+
+Градиент берётся из сетки 7x7 на октаэдре |u| + |v| + |w| = 1
+(точки с w < 0 отражаются за грани) и нормируется.
+*/
+static inline lanef_t NoiseGrad3( lanef_t h, lanef_t x, lanef_t y, lanef_t z ) {
+    // две цифры h в семеричной записи дают u, v из { -1, -2/3, ..., 1 }
+    lanef_t q;
+    lanef_t u = LaneSub( LaneMul( NoiseDigit7( h, &q ), LaneSet1( 1.0f / 3.0f ) ), LaneSet1( 1.0f ) );
+    lanef_t v = LaneSub( LaneMul( NoiseDigit7( q, &q ), LaneSet1( 1.0f / 3.0f ) ), LaneSet1( 1.0f ) );
+    lanef_t au = LaneAbs( u );
+    lanef_t av = LaneAbs( v );
+    lanef_t w = LaneSub( LaneSub( LaneSet1( 1.0f ), au ), av );
+    lanef_t m = LaneLt( w, LaneSet1( 0.0f ) );
+    lanef_t fu = LaneMul( LaneSub( LaneSet1( 1.0f ), av ), NoiseSign( u ) );
+    lanef_t fv = LaneMul( LaneSub( LaneSet1( 1.0f ), au ), NoiseSign( v ) );
+    u = LaneSel( m, fu, u );
+    v = LaneSel( m, fv, v );
+    lanef_t d = LaneAdd( LaneAdd( LaneMul( u, x ), LaneMul( v, y ) ), LaneMul( w, z ) );
+    lanef_t n = LaneAdd( LaneAdd( LaneMul( u, u ), LaneMul( v, v ) ), LaneMul( w, w ) );
+    return LaneMul( d, LaneRsqrt( n ) );
+}
+
+/*
+NoiseGrad4
+
+Градиент из сетки 7x7x7 в кубе [-1, 1]^3: по x - floor( h / 42 ), по y и z -
+две младшие цифры h в семеричной записи. Четвёртая компонента
+1.5 - |x| - |y| - |z|; при её отрицательном значении первые три
+сдвигаются к центру. Результат нормируется.
+*/
+static inline lanef_t NoiseGrad4( lanef_t h, lanef_t x, lanef_t y, lanef_t z, lanef_t w ) {
+    lanef_t g[3], c[3], q;
+    c[2] = NoiseDigit7( h, &q );
+    c[1] = NoiseDigit7( q, &q );
+    c[0] = LaneFloor( LaneMul( LaneAdd( h, LaneSet1( 0.5f ) ), LaneSet1( 1.0f / 42.0f ) ) );
+    for( int k = 0; k < 3; k++ ) {
+        g[k] = LaneSub( LaneMul( c[k], LaneSet1( 1.0f / 3.0f ) ), LaneSet1( 1.0f ) );
+    }
+    lanef_t gw = LaneSub( LaneSet1( 1.5f ), LaneAdd( LaneAdd( LaneAbs( g[0] ), LaneAbs( g[1] ) ), LaneAbs( g[2] ) ) );
+    lanef_t m = LaneLt( gw, LaneSet1( 0.0f ) );
+    for( int k = 0; k < 3; k++ ) {
+        g[k] = LaneSel( m, LaneSub( g[k], NoiseSign( g[k] ) ), g[k] );
+    }
+    lanef_t d = LaneAdd( LaneAdd( LaneMul( g[0], x ), LaneMul( g[1], y ) ), LaneAdd( LaneMul( g[2], z ), LaneMul( gw, w ) ) );
+    lanef_t n = LaneAdd( LaneAdd( LaneMul( g[0], g[0] ), LaneMul( g[1], g[1] ) ), LaneAdd( LaneMul( g[2], g[2] ), LaneMul( gw, gw ) ) );
+    return LaneMul( d, LaneRsqrt( n ) );
+}
+
+/*
+NoisePerlin2Lane
+
+Шум Перлина: градиенты четырёх углов клетки смешиваются с весами NoiseFade.
+*/
+static lanef_t NoisePerlin2Lane( const lanef_t* p ) {
+    lanef_t i0[2], i1[2], f0[2], f1[2];
+    for( int d = 0; d < 2; d++ ) {
+        lanef_t fl = LaneFloor( p[d] );
+        f0[d] = LaneSub( p[d], fl );
+        f1[d] = LaneSub( f0[d], LaneSet1( 1.0f ) );
+        i0[d] = NoiseMod( fl );
+        i1[d] = LaneAdd( i0[d], LaneSet1( 1.0f ) );
+    }
+    lanef_t hx0 = NoisePermute( i0[0] );
+    lanef_t hx1 = NoisePermute( i1[0] );
+    lanef_t n00 = NoiseGrad2( NoisePermute( LaneAdd( hx0, i0[1] ) ), f0[0], f0[1] );
+    lanef_t n10 = NoiseGrad2( NoisePermute( LaneAdd( hx1, i0[1] ) ), f1[0], f0[1] );
+    lanef_t n01 = NoiseGrad2( NoisePermute( LaneAdd( hx0, i1[1] ) ), f0[0], f1[1] );
+    lanef_t n11 = NoiseGrad2( NoisePermute( LaneAdd( hx1, i1[1] ) ), f1[0], f1[1] );
+    lanef_t u = NoiseFade( f0[0] );
+    lanef_t r = LaneLerp( LaneLerp( n00, n10, u ), LaneLerp( n01, n11, u ), NoiseFade( f0[1] ) );
+    return LaneMul( r, LaneSet1( NOISE_PERLIN2_SCALE ) );
+}
+
+static lanef_t NoisePerlin3Lane( const lanef_t* p ) {
+    lanef_t i[2][3], f[2][3], n[8];
+    for( int d = 0; d < 3; d++ ) {
+        lanef_t fl = LaneFloor( p[d] );
+        f[0][d] = LaneSub( p[d], fl );
+        f[1][d] = LaneSub( f[0][d], LaneSet1( 1.0f ) );
+        i[0][d] = NoiseMod( fl );
+        i[1][d] = LaneAdd( i[0][d], LaneSet1( 1.0f ) );
+    }
+    // угол c: бит 0 - x, бит 1 - y, бит 2 - z
+    for( int a = 0; a < 2; a++ ) {
+        lanef_t hx = NoisePermute( i[a][0] );
+        for( int b = 0; b < 2; b++ ) {
+            lanef_t hy = NoisePermute( LaneAdd( hx, i[b][1] ) );
+            for( int c = 0; c < 2; c++ ) {
+                lanef_t h = NoisePermute( LaneAdd( hy, i[c][2] ) );
+                n[a | ( b << 1 ) | ( c << 2 )] = NoiseGrad3( h, f[a][0], f[b][1], f[c][2] );
+            }
+        }
+    }
+    lanef_t u = NoiseFade( f[0][0] );
+    lanef_t v = NoiseFade( f[0][1] );
+    lanef_t z0 = LaneLerp( LaneLerp( n[0], n[1], u ), LaneLerp( n[2], n[3], u ), v );
+    lanef_t z1 = LaneLerp( LaneLerp( n[4], n[5], u ), LaneLerp( n[6], n[7], u ), v );
+    return LaneMul( LaneLerp( z0, z1, NoiseFade( f[0][2] ) ), LaneSet1( NOISE_PERLIN3_SCALE ) );
+}
+
+static lanef_t NoisePerlin4Lane( const lanef_t* p ) {
+    lanef_t i[2][4], f[2][4], n[16], t[4];
+    for( int d = 0; d < 4; d++ ) {
+        lanef_t fl = LaneFloor( p[d] );
+        f[0][d] = LaneSub( p[d], fl );
+        f[1][d] = LaneSub( f[0][d], LaneSet1( 1.0f ) );
+        i[0][d] = NoiseMod( fl );
+        i[1][d] = LaneAdd( i[0][d], LaneSet1( 1.0f ) );
+        t[d] = NoiseFade( f[0][d] );
+    }
+    for( int a = 0; a < 2; a++ ) {
+        lanef_t hx = NoisePermute( i[a][0] );
+        for( int b = 0; b < 2; b++ ) {
+            lanef_t hy = NoisePermute( LaneAdd( hx, i[b][1] ) );
+            for( int c = 0; c < 2; c++ ) {
+                lanef_t hz = NoisePermute( LaneAdd( hy, i[c][2] ) );
+                for( int e = 0; e < 2; e++ ) {
+                    lanef_t h = NoisePermute( LaneAdd( hz, i[e][3] ) );
+                    n[a | ( b << 1 ) | ( c << 2 ) | ( e << 3 )] = NoiseGrad4( h, f[a][0], f[b][1], f[c][2], f[e][3] );
+                }
+            }
+        }
+    }
+    // свёртка по осям: на каждом шаге число значений уменьшается вдвое
+    for( int d = 0, len = 16; d < 4; d++ ) {
+        len >>= 1;
+        for( int k = 0; k < len; k++ ) {
+            n[k] = LaneLerp( n[2 * k], n[2 * k + 1], t[d] );
+        }
+    }
+    return LaneMul( n[0], LaneSet1( NOISE_PERLIN4_SCALE ) );
+}
+
+/*
+NoiseSimplex2Lane
+
+Симплексный шум: плоскость разбита на треугольники, в точке суммируются
+вклады трёх вершин своего треугольника с весом, убывающим до нуля
+на расстоянии sqrt( 0.5 ).
+*/
+static lanef_t NoiseSimplex2Lane( const lanef_t* p ) {
+    const float F2 = 0.366025403784439f;    // ( sqrt( 3 ) - 1 ) / 2
+    const float G2 = 0.211324865405187f;    // ( 3 - sqrt( 3 ) ) / 6
+    lanef_t s = LaneMul( LaneAdd( p[0], p[1] ), LaneSet1( F2 ) );
+    lanef_t i = LaneFloor( LaneAdd( p[0], s ) );
+    lanef_t j = LaneFloor( LaneAdd( p[1], s ) );
+    lanef_t t = LaneMul( LaneAdd( i, j ), LaneSet1( G2 ) );
+    lanef_t x0 = LaneAdd( LaneSub( p[0], i ), t );
+    lanef_t y0 = LaneAdd( LaneSub( p[1], j ), t );
+    // нижний или верхний треугольник клетки
+    lanef_t i1 = NoiseStep( y0, x0 );
+    lanef_t j1 = LaneSub( LaneSet1( 1.0f ), i1 );
+    lanef_t x1 = LaneAdd( LaneSub( x0, i1 ), LaneSet1( G2 ) );
+    lanef_t y1 = LaneAdd( LaneSub( y0, j1 ), LaneSet1( G2 ) );
+    lanef_t x2 = LaneSub( x0, LaneSet1( 1.0f - 2.0f * G2 ) );
+    lanef_t y2 = LaneSub( y0, LaneSet1( 1.0f - 2.0f * G2 ) );
+    i = NoiseMod( i );
+    j = NoiseMod( j );
+    lanef_t h0 = NoisePermute( LaneAdd( NoisePermute( i ), j ) );
+    lanef_t h1 = NoisePermute( LaneAdd( NoisePermute( LaneAdd( i, i1 ) ), LaneAdd( j, j1 ) ) );
+    lanef_t h2 = NoisePermute( LaneAdd( NoisePermute( LaneAdd( i, LaneSet1( 1.0f ) ) ), LaneAdd( j, LaneSet1( 1.0f ) ) ) );
+    lanef_t r = LaneSet1( 0.5f );
+    lanef_t n0 = LaneMul( NoiseFalloff( r, LaneAdd( LaneMul( x0, x0 ), LaneMul( y0, y0 ) ) ), NoiseGrad2( h0, x0, y0 ) );
+    lanef_t n1 = LaneMul( NoiseFalloff( r, LaneAdd( LaneMul( x1, x1 ), LaneMul( y1, y1 ) ) ), NoiseGrad2( h1, x1, y1 ) );
+    lanef_t n2 = LaneMul( NoiseFalloff( r, LaneAdd( LaneMul( x2, x2 ), LaneMul( y2, y2 ) ) ), NoiseGrad2( h2, x2, y2 ) );
+    return LaneMul( LaneAdd( LaneAdd( n0, n1 ), n2 ), LaneSet1( NOISE_SIMPLEX2_SCALE ) );
+}
+
+static lanef_t NoiseSimplex3Lane( const lanef_t* p ) {
+    const float F3 = 1.0f / 3.0f;
+    const float G3 = 1.0f / 6.0f;
+    lanef_t s = LaneMul( LaneAdd( LaneAdd( p[0], p[1] ), p[2] ), LaneSet1( F3 ) );
+    lanef_t i[3], x0[3], o1[3], o2[3], rank[3];
+    for( int d = 0; d < 3; d++ ) {
+        i[d] = LaneFloor( LaneAdd( p[d], s ) );
+    }
+    lanef_t t = LaneMul( LaneAdd( LaneAdd( i[0], i[1] ), i[2] ), LaneSet1( G3 ) );
+    for( int d = 0; d < 3; d++ ) {
+        x0[d] = LaneAdd( LaneSub( p[d], i[d] ), t );
+        rank[d] = LaneSet1( 0.0f );
+    }
+    // порядок координат внутри куба определяет вершины симплекса; ранг - как в
+    // NoiseSimplex4Lane, чтобы при равных координатах вершины не совпадали
+    for( int a = 0; a < 3; a++ ) {
+        for( int b = a + 1; b < 3; b++ ) {
+            lanef_t ge = NoiseStep( x0[b], x0[a] );
+            rank[a] = LaneAdd( rank[a], ge );
+            rank[b] = LaneAdd( rank[b], LaneSub( LaneSet1( 1.0f ), ge ) );
+        }
+    }
+    for( int d = 0; d < 3; d++ ) {
+        o1[d] = NoiseStep( LaneSet1( 2.0f ), rank[d] );
+        o2[d] = NoiseStep( LaneSet1( 1.0f ), rank[d] );
+    }
+    lanef_t x1[3], x2[3], x3[3];
+    for( int d = 0; d < 3; d++ ) {
+        x1[d] = LaneAdd( LaneSub( x0[d], o1[d] ), LaneSet1( G3 ) );
+        x2[d] = LaneAdd( LaneSub( x0[d], o2[d] ), LaneSet1( 2.0f * G3 ) );
+        x3[d] = LaneSub( x0[d], LaneSet1( 1.0f - 3.0f * G3 ) );
+        i[d] = NoiseMod( i[d] );
+    }
+    const lanef_t* xs[4] = { x0, x1, x2, x3 };
+    lanef_t one = LaneSet1( 1.0f );
+    lanef_t zero = LaneSet1( 0.0f );
+    lanef_t r = LaneSet1( 0.5f );
+    lanef_t sum = zero;
+    for( int v = 0; v < 4; v++ ) {
+        lanef_t h = zero;
+        for( int d = 0; d < 3; d++ ) {
+            lanef_t o = v == 0 ? zero : v == 1 ? o1[d] : v == 2 ? o2[d] : one;
+            h = NoisePermute( LaneAdd( h, LaneAdd( i[d], o ) ) );
+        }
+        const lanef_t* x = xs[v];
+        lanef_t d2 = LaneAdd( LaneAdd( LaneMul( x[0], x[0] ), LaneMul( x[1], x[1] ) ), LaneMul( x[2], x[2] ) );
+        sum = LaneAdd( sum, LaneMul( NoiseFalloff( r, d2 ), NoiseGrad3( h, x[0], x[1], x[2] ) ) );
+    }
+    return LaneMul( sum, LaneSet1( NOISE_SIMPLEX3_SCALE ) );
+}
+
+static lanef_t NoiseSimplex4Lane( const lanef_t* p ) {
+    const float F4 = 0.309016994374947f;    // ( sqrt( 5 ) - 1 ) / 4
+    const float G4 = 0.138196601125011f;    // ( 5 - sqrt( 5 ) ) / 20
+    lanef_t s = LaneMul( LaneAdd( LaneAdd( p[0], p[1] ), LaneAdd( p[2], p[3] ) ), LaneSet1( F4 ) );
+    lanef_t i[4], x0[4], rank[4];
+    for( int d = 0; d < 4; d++ ) {
+        i[d] = LaneFloor( LaneAdd( p[d], s ) );
+    }
+    lanef_t t = LaneMul( LaneAdd( LaneAdd( i[0], i[1] ), LaneAdd( i[2], i[3] ) ), LaneSet1( G4 ) );
+    for( int d = 0; d < 4; d++ ) {
+        x0[d] = LaneAdd( LaneSub( p[d], i[d] ), t );
+        rank[d] = LaneSet1( 0.0f );
+    }
+    // ранг координаты - число координат, не больших её (при равенстве выигрывает меньший индекс)
+    for( int a = 0; a < 4; a++ ) {
+        for( int b = a + 1; b < 4; b++ ) {
+            lanef_t ge = NoiseStep( x0[b], x0[a] );
+            rank[a] = LaneAdd( rank[a], ge );
+            rank[b] = LaneAdd( rank[b], LaneSub( LaneSet1( 1.0f ), ge ) );
+        }
+    }
+    lanef_t one = LaneSet1( 1.0f );
+    lanef_t zero = LaneSet1( 0.0f );
+    lanef_t r = LaneSet1( 0.5f );
+    lanef_t sum = zero;
+    for( int d = 0; d < 4; d++ ) {
+        i[d] = NoiseMod( i[d] );
+    }
+    // вершина v сдвинута на 1 по координатам с рангом не меньше 4 - v
+    for( int v = 0; v < 5; v++ ) {
+        lanef_t x[4];
+        lanef_t h = zero;
+        lanef_t d2 = zero;
+        for( int d = 0; d < 4; d++ ) {
+            lanef_t o = v == 0 ? zero : v == 4 ? one : NoiseStep( LaneSet1( ( float )( 4 - v ) ), rank[d] );
+            x[d] = LaneAdd( LaneSub( x0[d], o ), LaneSet1( v * G4 ) );
+            h = NoisePermute( LaneAdd( h, LaneAdd( i[d], o ) ) );
+            d2 = LaneAdd( d2, LaneMul( x[d], x[d] ) );
+        }
+        sum = LaneAdd( sum, LaneMul( NoiseFalloff( r, d2 ), NoiseGrad4( h, x[0], x[1], x[2], x[3] ) ) );
+    }
+    return LaneMul( sum, LaneSet1( NOISE_SIMPLEX4_SCALE ) );
+}
+
+// ядра по виду шума и размерности 2..4
+static const noisefn_t noise_fns[2][3] = {
+    { NoisePerlin2Lane, NoisePerlin3Lane, NoisePerlin4Lane },
+    { NoiseSimplex2Lane, NoiseSimplex3Lane, NoiseSimplex4Lane }
+};
+
+// задание для пакетного вычисления: один вид шума, fBm или fBm с искажением
+typedef struct {
+    int             dim;
+    noisefn_t       fn;         // при fbm == NULL
+    const fbm_t*    fbm;
+    float           warp;       // при ненулевом - искажение fBm
+} noisejob_t;
+
+/*
+NoiseFbmLane
+
+Сумма октав fBm, делённая на сумму амплитуд. Каждая октава сдвинута
+на NOISE_OCTAVE_SHIFT, чтобы узлы решёток разных октав не совпадали в нуле.
+*/
+static lanef_t NoiseFbmLane( const fbm_t* f, int dim, const lanef_t* p ) {
+    noisefn_t fn = noise_fns[f->kind == NOISE_SIMPLEX][dim - 2];
+    int octaves = f->octaves < NOISE_MAX_OCTAVES ? f->octaves : NOISE_MAX_OCTAVES;
+    float freq = f->frequency;
+    float amp = 1.0f;
+    float norm = 0.0f;
+    lanef_t sum = LaneSet1( 0.0f );
+    for( int o = 0; o < octaves; o++ ) {
+        lanef_t q[4];
+        for( int d = 0; d < dim; d++ ) {
+            q[d] = LaneAdd( LaneMul( p[d], LaneSet1( freq ) ), LaneSet1( o * NOISE_OCTAVE_SHIFT ) );
+        }
+        sum = LaneAdd( sum, LaneMul( fn( q ), LaneSet1( amp ) ) );
+        norm += amp;
+        freq *= f->lacunarity;
+        amp *= f->gain;
+    }
+    return norm > 0.0f ? LaneMul( sum, LaneSet1( 1.0f / norm ) ) : sum;
+}
+
+/*
+NoiseWarpLane
+
+Искажение области: точка сдвигается на strength * ( fbm( p + c_0 ), ..., fbm( p + c_n ) ),
+где c_k - разные постоянные сдвиги, и в сдвинутой точке снова берётся fbm.
+*/
+static lanef_t NoiseWarpLane( const fbm_t* f, float strength, int dim, const lanef_t* p ) {
+    lanef_t q[4], s[4];
+    for( int k = 0; k < dim; k++ ) {
+        for( int d = 0; d < dim; d++ ) {
+            s[d] = LaneAdd( p[d], LaneSet1( ( k + 1 ) * ( d + 1 ) * NOISE_WARP_SHIFT ) );
+        }
+        q[k] = NoiseFbmLane( f, dim, s );
+    }
+    for( int d = 0; d < dim; d++ ) {
+        s[d] = LaneAdd( p[d], LaneMul( q[d], LaneSet1( strength ) ) );
+    }
+    return NoiseFbmLane( f, dim, s );
+}
+
+static inline lanef_t NoiseJobLane( const noisejob_t* job, const lanef_t* p ) {
+    if( job->fbm == NULL ) {
+        return job->fn( p );
+    }
+    if( job->warp != 0.0f ) {
+        return NoiseWarpLane( job->fbm, job->warp, job->dim, p );
+    }
+    return NoiseFbmLane( job->fbm, job->dim, p );
+}
+
+/*
+NoiseJob
+
+Значение в одной точке: координаты размножаются на всю полосу,
+берётся первый элемент. Денормализованные числа сбрасываются в ноль
+так же, как в NoiseJobLanes, поэтому результат совпадает с пакетной версией.
+*/
+static float NoiseJob( const noisejob_t* job, const float* p ) {
+    lanef_t lp[4];
+    float buf[LANE_WIDTH];
+    unsigned int csr = LaneFtzBegin();
+    for( int d = 0; d < job->dim; d++ ) {
+        lp[d] = LaneSet1( p[d] );
+    }
+    LaneStore( buf, NoiseJobLane( job, lp ) );
+    LaneFtzEnd( csr );
+    return buf[0];
+}
+
+/*
+NoiseJobLanes
+
+Пакетное вычисление по LANE_WIDTH точек. Хвост массива дополняется нулями
+во временных буферах, поэтому размер count может быть любым.
+*/
+static void NoiseJobLanes( float* mrestrict out, const noisejob_t* job, const float* const* in, int count ) {
+    lanef_t lp[4];
+    unsigned int csr = LaneFtzBegin();
+    int i = 0;
+    for( ; i + LANE_WIDTH <= count; i += LANE_WIDTH ) {
+        for( int d = 0; d < job->dim; d++ ) {
+            lp[d] = LaneLoad( in[d] + i );
+        }
+        LaneStore( out + i, NoiseJobLane( job, lp ) );
+    }
+    if( i < count ) {
+        float tail[4][LANE_WIDTH];
+        float res[LANE_WIDTH];
+        int n = count - i;
+        memset( tail, 0, sizeof( tail ) );
+        for( int d = 0; d < job->dim; d++ ) {
+            memcpy( tail[d], in[d] + i, n * sizeof( float ) );
+            lp[d] = LaneLoad( tail[d] );
+        }
+        LaneStore( res, NoiseJobLane( job, lp ) );
+        memcpy( out + i, res, n * sizeof( float ) );
+    }
+    LaneFtzEnd( csr );
+}
+
+// аргументы NoiseJobArray для PoolParallelFor
+typedef struct {
+    float*              out;
+    const noisejob_t*   job;
+    const float* const* in;
+} noisearray_t;
+
+static void NoiseArrayChunk( void* ctx, int begin, int end ) {
+    const noisearray_t* a = ctx;
+    const float* in[4];
+    for( int d = 0; d < a->job->dim; d++ ) {
+        in[d] = a->in[d] + begin;
+    }
+    NoiseJobLanes( a->out + begin, a->job, in, end - begin );
+}
+
+/*
+NoiseJobArray
+
+Вычисление count точек чанками между потоками пула. Значение в точке
+не зависит от границ чанков, поэтому результат не зависит от числа потоков.
+*/
+static void NoiseJobArray( float* out, const noisejob_t* job, const float* const* in, int count ) {
+    noisearray_t a = { out, job, in };
+    MATH_METRIC( MATH_METRIC_NOISE, count, 0 );
+    PoolParallelFor( NoiseArrayChunk, &a, count, PoolChunk( ( job->dim + 1 ) * sizeof( float ) ) );
+}
+
+static float NoiseSingle( noisekind_t kind, int dim, const float* p ) {
+    noisejob_t job = { dim, noise_fns[kind == NOISE_SIMPLEX][dim - 2], NULL, 0.0f };
+    return NoiseJob( &job, p );
+}
+
+static void NoiseArray( noisekind_t kind, int dim, float* out, const float* const* in, int count ) {
+    noisejob_t job = { dim, noise_fns[kind == NOISE_SIMPLEX][dim - 2], NULL, 0.0f };
+    NoiseJobArray( out, &job, in, count );
+}
+
+/*
+NoisePerlin2
+
+Градиентный шум Перлина в точке p.
+*/
+float NoisePerlin2( const vec2_t* p ) {
+    const float v[2] = { p->x, p->y };
+    return NoiseSingle( NOISE_PERLIN, 2, v );
+}
+
+float NoisePerlin3( const vec3_t* p ) {
+    const float v[3] = { p->x, p->y, p->z };
+    return NoiseSingle( NOISE_PERLIN, 3, v );
+}
+
+float NoisePerlin4( const vec4_t* p ) {
+    const float v[4] = { p->x, p->y, p->z, p->w };
+    return NoiseSingle( NOISE_PERLIN, 4, v );
+}
+
+/*
+NoiseSimplex2
+
+Симплексный шум в точке p.
+*/
+float NoiseSimplex2( const vec2_t* p ) {
+    const float v[2] = { p->x, p->y };
+    return NoiseSingle( NOISE_SIMPLEX, 2, v );
+}
+
+float NoiseSimplex3( const vec3_t* p ) {
+    const float v[3] = { p->x, p->y, p->z };
+    return NoiseSingle( NOISE_SIMPLEX, 3, v );
+}
+
+float NoiseSimplex4( const vec4_t* p ) {
+    const float v[4] = { p->x, p->y, p->z, p->w };
+    return NoiseSingle( NOISE_SIMPLEX, 4, v );
+}
+
+/*
+NoisePerlin2Array
+
+Шум Перлина в count точках ( x[i], y[i] ).
+*/
+void NoisePerlin2Array( float* out, const float* x, const float* y, int count ) {
+    const float* in[2] = { x, y };
+    NoiseArray( NOISE_PERLIN, 2, out, in, count );
+}
+
+void NoisePerlin3Array( float* out, const float* x, const float* y, const float* z, int count ) {
+    const float* in[3] = { x, y, z };
+    NoiseArray( NOISE_PERLIN, 3, out, in, count );
+}
+
+void NoisePerlin4Array( float* out, const float* x, const float* y, const float* z, const float* w, int count ) {
+    const float* in[4] = { x, y, z, w };
+    NoiseArray( NOISE_PERLIN, 4, out, in, count );
+}
+
+/*
+NoiseSimplex2Array
+
+Симплексный шум в count точках ( x[i], y[i] ).
+*/
+void NoiseSimplex2Array( float* out, const float* x, const float* y, int count ) {
+    const float* in[2] = { x, y };
+    NoiseArray( NOISE_SIMPLEX, 2, out, in, count );
+}
+
+void NoiseSimplex3Array( float* out, const float* x, const float* y, const float* z, int count ) {
+    const float* in[3] = { x, y, z };
+    NoiseArray( NOISE_SIMPLEX, 3, out, in, count );
+}
+
+void NoiseSimplex4Array( float* out, const float* x, const float* y, const float* z, const float* w, int count ) {
+    const float* in[4] = { x, y, z, w };
+    NoiseArray( NOISE_SIMPLEX, 4, out, in, count );
+}
+
+/*
+NoiseFbm2
+
+Фрактальный шум с параметрами f в точке p.
+*/
+float NoiseFbm2( const fbm_t* f, const vec2_t* p ) {
+    const float v[2] = { p->x, p->y };
+    noisejob_t job = { 2, NULL, f, 0.0f };
+    return NoiseJob( &job, v );
+}
+
+float NoiseFbm3( const fbm_t* f, const vec3_t* p ) {
+    const float v[3] = { p->x, p->y, p->z };
+    noisejob_t job = { 3, NULL, f, 0.0f };
+    return NoiseJob( &job, v );
+}
+
+float NoiseFbm4( const fbm_t* f, const vec4_t* p ) {
+    const float v[4] = { p->x, p->y, p->z, p->w };
+    noisejob_t job = { 4, NULL, f, 0.0f };
+    return NoiseJob( &job, v );
+}
+
+/*
+NoiseFbm2Array
+
+Фрактальный шум с параметрами f в count точках.
+*/
+void NoiseFbm2Array( float* out, const fbm_t* f, const float* x, const float* y, int count ) {
+    const float* in[2] = { x, y };
+    noisejob_t job = { 2, NULL, f, 0.0f };
+    NoiseJobArray( out, &job, in, count );
+}
+
+void NoiseFbm3Array( float* out, const fbm_t* f, const float* x, const float* y, const float* z, int count ) {
+    const float* in[3] = { x, y, z };
+    noisejob_t job = { 3, NULL, f, 0.0f };
+    NoiseJobArray( out, &job, in, count );
+}
+
+void NoiseFbm4Array( float* out, const fbm_t* f, const float* x, const float* y, const float* z, const float* w, int count ) {
+    const float* in[4] = { x, y, z, w };
+    noisejob_t job = { 4, NULL, f, 0.0f };
+    NoiseJobArray( out, &job, in, count );
+}
+
+/*
+NoiseWarp2
+
+Фрактальный шум f в точке p, сдвинутой на strength * fBm (искажение области).
+При strength = 0 совпадает с NoiseFbm2.
+*/
+float NoiseWarp2( const fbm_t* f, float strength, const vec2_t* p ) {
+    const float v[2] = { p->x, p->y };
+    noisejob_t job = { 2, NULL, f, strength };
+    return NoiseJob( &job, v );
+}
+
+float NoiseWarp3( const fbm_t* f, float strength, const vec3_t* p ) {
+    const float v[3] = { p->x, p->y, p->z };
+    noisejob_t job = { 3, NULL, f, strength };
+    return NoiseJob( &job, v );
+}
+
+/*
+NoiseWarp2Array
+
+Искажённый фрактальный шум в count точках.
+*/
+void NoiseWarp2Array( float* out, const fbm_t* f, float strength, const float* x, const float* y, int count ) {
+    const float* in[2] = { x, y };
+    noisejob_t job = { 2, NULL, f, strength };
+    NoiseJobArray( out, &job, in, count );
+}
+
+void NoiseWarp3Array( float* out, const fbm_t* f, float strength, const float* x, const float* y, const float* z, int count ) {
+    const float* in[3] = { x, y, z };
+    noisejob_t job = { 3, NULL, f, strength };
+    NoiseJobArray( out, &job, in, count );
+}
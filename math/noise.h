@@ -0,0 +1,65 @@
+#ifndef __NOISE_H__
+#define __NOISE_H__
+
+#include "vector.h"
+
+/*
+Градиентный шум Перлина и симплексный шум в 2, 3 и 4 измерениях.
+Значения лежат примерно в [-1, 1]. Хеш узлов вычисляется в float без таблиц
+по модулю 289, поэтому шум Перлина повторяется с периодом 289 по каждой
+координате, а симплексный - с тем же периодом вдоль диагонали ( 1, 1, ... ).
+
+Скалярные функции принимают точку vecN_t, функции *Array - массивы
+координат (структура массивов) и вычисляют по 8 точек за раз при
+сборке с AVX, по 4 - с SSE. Результаты обеих версий совпадают.
+*/
+
+typedef enum {
+    NOISE_PERLIN = 0,
+    NOISE_SIMPLEX
+} noisekind_t;
+
+/*
+Параметры фрактального шума (fBm): сумма octaves октав, частота каждой
+следующей умножается на lacunarity, амплитуда - на gain. Сумма делится
+на сумму амплитуд, поэтому остаётся в [-1, 1].
+Обычные значения: octaves = 4..8, lacunarity = 2, gain = 0.5.
+*/
+typedef struct {
+    noisekind_t     kind;
+    int             octaves;
+    float           frequency;  // частота первой октавы
+    float           lacunarity;
+    float           gain;
+} fbm_t;
+
+
+float       NoisePerlin2( const vec2_t* p );
+float       NoisePerlin3( const vec3_t* p );
+float       NoisePerlin4( const vec4_t* p );
+float       NoiseSimplex2( const vec2_t* p );
+float       NoiseSimplex3( const vec3_t* p );
+float       NoiseSimplex4( const vec4_t* p );
+
+void        NoisePerlin2Array( float* out, const float* x, const float* y, int count );
+void        NoisePerlin3Array( float* out, const float* x, const float* y, const float* z, int count );
+void        NoisePerlin4Array( float* out, const float* x, const float* y, const float* z, const float* w, int count );
+void        NoiseSimplex2Array( float* out, const float* x, const float* y, int count );
+void        NoiseSimplex3Array( float* out, const float* x, const float* y, const float* z, int count );
+void        NoiseSimplex4Array( float* out, const float* x, const float* y, const float* z, const float* w, int count );
+
+float       NoiseFbm2( const fbm_t* f, const vec2_t* p );
+float       NoiseFbm3( const fbm_t* f, const vec3_t* p );
+float       NoiseFbm4( const fbm_t* f, const vec4_t* p );
+void        NoiseFbm2Array( float* out, const fbm_t* f, const float* x, const float* y, int count );
+void        NoiseFbm3Array( float* out, const fbm_t* f, const float* x, const float* y, const float* z, int count );
+void        NoiseFbm4Array( float* out, const fbm_t* f, const float* x, const float* y, const float* z, const float* w, int count );
+
+float       NoiseWarp2( const fbm_t* f, float strength, const vec2_t* p );
+float       NoiseWarp3( const fbm_t* f, float strength, const vec3_t* p );
+void        NoiseWarp2Array( float* out, const fbm_t* f, float strength, const float* x, const float* y, int count );
+void        NoiseWarp3Array( float* out, const fbm_t* f, float strength, const float* x, const float* y, const float* z, int count );
+
+
+
+#endif //__NOISE_H__
@@ -0,0 +1,287 @@
+#include <stdint.h>
+
+#include "pool.h"
+
+#if defined( __GNUC__ ) && !defined( _WIN32 ) && !defined( MATH_NO_THREADS )
+#define POOL_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// полоса чанков [begin, end) одного потока: begin в младших 32 битах, end в старших;
+// своя строка кэша, чтобы потоки не мешали друг другу
+typedef struct {
+    uint64_t        range;
+    unsigned char   pad[64 - sizeof( uint64_t )];
+} poolrange_t;
+
+// состояние одного вызова PoolParallelFor
+typedef struct {
+    poolkernel_t    kernel;
+    void*           ctx;
+    int             count;
+    int             chunk;
+    poolrange_t     ranges[POOL_MAX_THREADS];
+} poolfor_t;
+
+static mthreadlocal int     pool_inside;    // поток выполняет тело пула
+
+static void PoolSerialFor( poolkernel_t kernel, void* ctx, int count, int chunk ) {
+    for( int begin = 0; begin < count; begin += chunk ) {
+        kernel( ctx, begin, count - begin < chunk ? count : begin + chunk );
+    }
+}
+
+#if defined( POOL_THREADS )
+
+static struct {
+    int                 num_threads;        // вместе с вызывающим, 1 - пул не запущен
+    pthread_t           threads[POOL_MAX_THREADS];
+    pthread_mutex_t     lock;
+    pthread_cond_t      wake;               // новое задание или завершение
+    pthread_cond_t      done;               // все потоки закончили задание
+    pthread_mutex_t     submit;             // одно задание одновременно
+    int                 gen;                // номер текущего задания
+    int                 start_gen;          // номер задания при запуске потоков
+    int                 pending;            // потоков, ещё выполняющих задание
+    int                 quit;
+    poolworker_t        worker;
+    void*               ctx;
+} pool = { 1, { 0 }, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
+           PTHREAD_MUTEX_INITIALIZER, 0, 0, 0, 0, NULL, NULL };
+
+static void* PoolThread( void* arg ) {
+    int thread = ( int )( intptr_t )arg;
+    int seen = pool.start_gen;      // задания до запуска потока уже выполнены
+    pool_inside = 1;
+    for( ;; ) {
+        pthread_mutex_lock( &pool.lock );
+        while( !pool.quit && ( pool.gen == seen ) ) {
+            pthread_cond_wait( &pool.wake, &pool.lock );
+        }
+        if( pool.quit ) {
+            pthread_mutex_unlock( &pool.lock );
+            return NULL;
+        }
+        seen = pool.gen;
+        poolworker_t worker = pool.worker;
+        void* ctx = pool.ctx;
+        pthread_mutex_unlock( &pool.lock );
+
+        worker( ctx, thread );
+
+        pthread_mutex_lock( &pool.lock );
+        if( --pool.pending == 0 ) {
+            pthread_cond_signal( &pool.done );
+        }
+        pthread_mutex_unlock( &pool.lock );
+    }
+}
+
+static inline uint64_t PoolRange( uint32_t begin, uint32_t end ) {
+    return ( uint64_t )begin | ( ( uint64_t )end << 32 );
+}
+
+/*
+PoolTake
+
+Следующий чанк из своей полосы (с начала) или -1, если полоса пуста.
+*/
+static int PoolTake( poolrange_t* own ) {
+    uint64_t r = __atomic_load_n( &own->range, __ATOMIC_ACQUIRE );
+    for( ;; ) {
+        uint32_t begin = ( uint32_t )r;
+        uint32_t end = ( uint32_t )( r >> 32 );
+        if( begin >= end ) {
+            return -1;
+        }
+        if( __atomic_compare_exchange_n( &own->range, &r, PoolRange( begin + 1, end ), 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) ) {
+            return ( int )begin;
+        }
+    }
+}
+
+/*
+PoolSteal
+
+Перенос второй половины чужой полосы victim в пустую полосу own.
+Возвращает первый чанк забранной половины или -1, если полоса victim пуста.
+Номер чанка выполняется ровно один раз, поэтому повторное появление
+того же значения полосы (ABA) невозможно.
+*/
+static int PoolSteal( poolrange_t* own, poolrange_t* victim ) {
+    uint64_t r = __atomic_load_n( &victim->range, __ATOMIC_ACQUIRE );
+    for( ;; ) {
+        uint32_t begin = ( uint32_t )r;
+        uint32_t end = ( uint32_t )( r >> 32 );
+        if( begin >= end ) {
+            return -1;
+        }
+        uint32_t mid = end - ( end - begin + 1 ) / 2;
+        if( __atomic_compare_exchange_n( &victim->range, &r, PoolRange( begin, mid ), 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) ) {
+            __atomic_store_n( &own->range, PoolRange( mid + 1, end ), __ATOMIC_RELEASE );
+            return ( int )mid;
+        }
+    }
+}
+
+static void PoolForWorker( void* ctx, int thread ) {
+    poolfor_t* job = ctx;
+    int num_threads = PoolNumThreads();
+    poolrange_t* own = &job->ranges[thread];
+    for( ;; ) {
+        int c = PoolTake( own );
+        for( int v = 1; ( c < 0 ) && ( v < num_threads ); v++ ) {
+            c = PoolSteal( own, &job->ranges[( thread + v ) % num_threads] );
+        }
+        if( c < 0 ) {
+            return;
+        }
+        int begin = c * job->chunk;
+        int end = job->count - begin < job->chunk ? job->count : begin + job->chunk;
+        job->kernel( job->ctx, begin, end );
+    }
+}
+
+#endif
+
+/*
+PoolInit
+
+Запуск потоков пула. Вызывается из MathInit.
+*/
+void PoolInit( void ) {
+#if defined( POOL_THREADS )
+    if( pool.num_threads > 1 ) {
+        return;
+    }
+    const char* env = getenv( "MATH_THREADS" );
+    int n = env != NULL ? atoi( env ) : ( int )sysconf( _SC_NPROCESSORS_ONLN );
+    n = n < 1 ? 1 : n > POOL_MAX_THREADS ? POOL_MAX_THREADS : n;
+
+    pool.quit = 0;
+    pool.start_gen = pool.gen;
+    pool.num_threads = 1;
+    for( int i = 1; i < n; i++ ) {
+        if( pthread_create( &pool.threads[i], NULL, PoolThread, ( void* )( intptr_t )i ) != 0 ) {
+            break;
+        }
+        pool.num_threads++;
+    }
+#endif
+}
+
+/*
+PoolRelease
+
+Остановка потоков пула. Вызывается из MathRelease.
+*/
+void PoolRelease( void ) {
+#if defined( POOL_THREADS )
+    if( pool.num_threads <= 1 ) {
+        return;
+    }
+    pthread_mutex_lock( &pool.lock );
+    pool.quit = 1;
+    pthread_cond_broadcast( &pool.wake );
+    pthread_mutex_unlock( &pool.lock );
+    for( int i = 1; i < pool.num_threads; i++ ) {
+        pthread_join( pool.threads[i], NULL );
+    }
+    pool.num_threads = 1;
+#endif
+}
+
+/*
+PoolNumThreads
+
+Число потоков, выполняющих задания, вместе с вызывающим.
+*/
+int PoolNumThreads( void ) {
+#if defined( POOL_THREADS )
+    return pool.num_threads;
+#else
+    return 1;
+#endif
+}
+
+/*
+PoolChunk
+
+Число элементов размером elem_bytes (вход и выход вместе) в чанке
+на POOL_CHUNK_BYTES байт, кратное 8, чтобы чанки не разрывали группы LANE_WIDTH.
+*/
+int PoolChunk( size_t elem_bytes ) {
+    size_t n = POOL_CHUNK_BYTES / ( elem_bytes > 0 ? elem_bytes : 1 );
+    return n < 8 ? 8 : ( int )( n & ~( size_t )7 );
+}
+
+/*
+PoolRun
+
+Выполнение worker на всех потоках пула и в вызывающем потоке (номер 0),
+возврат после завершения всех вызовов. Если пул не запущен, занят или
+PoolRun вызван изнутри пула, worker выполняется только в вызывающем
+потоке, поэтому он должен уметь выполнить всю работу в одиночку.
+*/
+void PoolRun( poolworker_t worker, void* ctx ) {
+#if defined( POOL_THREADS )
+    if( ( pool.num_threads > 1 ) && !pool_inside && ( pthread_mutex_trylock( &pool.submit ) == 0 ) ) {
+        pthread_mutex_lock( &pool.lock );
+        pool.worker = worker;
+        pool.ctx = ctx;
+        pool.pending = pool.num_threads - 1;
+        pool.gen++;
+        pthread_cond_broadcast( &pool.wake );
+        pthread_mutex_unlock( &pool.lock );
+
+        pool_inside = 1;
+        worker( ctx, 0 );
+        pool_inside = 0;
+
+        pthread_mutex_lock( &pool.lock );
+        while( pool.pending > 0 ) {
+            pthread_cond_wait( &pool.done, &pool.lock );
+        }
+        pthread_mutex_unlock( &pool.lock );
+        pthread_mutex_unlock( &pool.submit );
+        return;
+    }
+#endif
+    int inside = pool_inside;
+    pool_inside = 1;
+    worker( ctx, 0 );
+    pool_inside = inside;
+}
+
+/*
+PoolParallelFor
+
+Вызов kernel для всех чанков [0, count) по chunk элементов (chunk <= 0 -
+PoolChunk( 64 )). Возврат после обработки всех чанков.
+*/
+void PoolParallelFor( poolkernel_t kernel, void* ctx, int count, int chunk ) {
+    if( chunk <= 0 ) {
+        chunk = PoolChunk( 64 );
+    }
+    int num_chunks = count > 0 ? ( int )( ( ( int64_t )count + chunk - 1 ) / chunk ) : 0;
+    int num_threads = PoolNumThreads();
+
+    if( ( num_chunks < 2 ) || ( num_threads <= 1 ) || pool_inside ) {
+        PoolSerialFor( kernel, ctx, count, chunk );
+        return;
+    }
+#if defined( POOL_THREADS )
+    poolfor_t job __attribute__(( aligned( 64 ) ));
+    job.kernel = kernel;
+    job.ctx = ctx;
+    job.count = count;
+    job.chunk = chunk;
+    for( int t = 0; t < num_threads; t++ ) {
+        uint32_t begin = ( uint32_t )( ( int64_t )num_chunks * t / num_threads );
+        uint32_t end = ( uint32_t )( ( int64_t )num_chunks * ( t + 1 ) / num_threads );
+        job.ranges[t].range = PoolRange( begin, end );
+    }
+    PoolRun( PoolForWorker, &job );
+#endif
+}
@@ -0,0 +1,42 @@
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include "math_base.h"
+
+#define POOL_MAX_THREADS    64
+#define POOL_CHUNK_BYTES    ( 16 << 10 )    // данных на чанк по умолчанию: вход и выход остаются в L1/L2
+
+/*
+Пул потоков для пакетных ядер. MathInit запускает потоки пула, MathRelease
+дожидается их завершения. Число потоков вместе с вызывающим берётся из
+переменной окружения MATH_THREADS, по умолчанию - число процессоров.
+Потоки есть только в POSIX-сборке GCC/Clang, в остальных сборках
+(и при -DMATH_NO_THREADS) всё выполняется в вызывающем потоке.
+
+PoolParallelFor делит [0, count) на чанки по chunk элементов. Границы чанков
+зависят только от count и chunk, а не от числа потоков, поэтому ядро,
+результат которого зависит лишь от своего диапазона, даёт одинаковый
+результат при любом числе потоков. Каждому потоку достаётся непрерывная
+полоса чанков; закончив свою, поток забирает половину оставшихся чанков
+у другого (work stealing). Если чанков меньше двух, пул не запущен,
+занят другим вызовом или PoolParallelFor вызван изнутри ядра, чанки
+выполняются по порядку в вызывающем потоке.
+*/
+
+// ядро обрабатывает элементы [begin, end)
+typedef void ( *poolkernel_t )( void* ctx, int begin, int end );
+
+// тело, которое выполняется на каждом потоке пула; thread - номер потока, 0 - вызывающий
+typedef void ( *poolworker_t )( void* ctx, int thread );
+
+
+void        PoolInit( void );
+void        PoolRelease( void );
+int         PoolNumThreads( void );
+int         PoolChunk( size_t elem_bytes );
+void        PoolParallelFor( poolkernel_t kernel, void* ctx, int count, int chunk );
+void        PoolRun( poolworker_t worker, void* ctx );
+
+
+
+#endif //__POOL_H__
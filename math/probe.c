@@ -0,0 +1,184 @@
+#include "probe.h"
+
+#if defined( MATH_INSTRUMENT )
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+// счётчики одного потока
+typedef struct mathprobethread_s {
+    uint64_t                    calls[MATH_PROBE_MAX];
+    uint64_t                    cycles[MATH_PROBE_MAX];
+    uint64_t                    hist[MATH_PROBE_MAX][MATH_PROBE_BUCKETS];
+    struct mathprobethread_s*   next;
+} mathprobethread_t;
+
+static const char*          math_probe_names[MATH_PROBE_MAX];
+static int                  math_probe_count;       // последний выданный номер
+static mathprobethread_t*   math_probe_threads;     // все потоки, делавшие замеры
+static int                  math_probe_gen = 1;     // меняется в MathProbeRelease
+
+static __thread mathprobethread_t*  math_probe_local;
+static __thread int                 math_probe_local_gen;
+
+static inline uint64_t MathProbeTicks( void ) {
+#if defined( __x86_64__ ) || defined( __i386__ )
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( uint64_t )ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+}
+
+/*
+MathProbeThread
+
+Счётчики текущего потока. При первом замере в потоке (или после
+MathProbeRelease) создаются и добавляются в общий список без блокировок.
+*/
+static mathprobethread_t* MathProbeThread( void ) {
+    int gen = __atomic_load_n( &math_probe_gen, __ATOMIC_ACQUIRE );
+    if( ( math_probe_local != NULL ) && ( math_probe_local_gen == gen ) ) {
+        return math_probe_local;
+    }
+    mathprobethread_t* t = calloc( 1, sizeof( mathprobethread_t ) );
+    if( t == NULL ) {
+        return NULL;
+    }
+    t->next = __atomic_load_n( &math_probe_threads, __ATOMIC_RELAXED );
+    while( !__atomic_compare_exchange_n( &math_probe_threads, &t->next, t, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED ) ) {
+    }
+    math_probe_local = t;
+    math_probe_local_gen = gen;
+    return t;
+}
+
+/*
+MathProbeBegin
+
+Начало замера: выдача номера месту замера при первом вызове и чтение счётчика тактов.
+*/
+mathprobescope_t MathProbeBegin( mathprobe_t* site ) {
+    mathprobescope_t scope;
+    if( __atomic_load_n( &site->id, __ATOMIC_ACQUIRE ) == 0 ) {
+        int id = __atomic_add_fetch( &math_probe_count, 1, __ATOMIC_RELAXED );
+        int expected = 0;
+        if( id < MATH_PROBE_MAX ) {
+            math_probe_names[id] = site->name;
+        }
+        else {
+            id = -1;
+        }
+        // при гонке побеждает первый номер, выданный номер остаётся пустым
+        __atomic_compare_exchange_n( &site->id, &expected, id, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED );
+    }
+    scope.site = site;
+    scope.start = MathProbeTicks();
+    return scope;
+}
+
+/*
+MathProbeEnd
+
+Конец замера: вызывается автоматически при выходе из функции.
+*/
+void MathProbeEnd( mathprobescope_t* scope ) {
+    uint64_t dt = MathProbeTicks() - scope->start;
+    int id = scope->site->id;
+    mathprobethread_t* t = MathProbeThread();
+    if( ( t == NULL ) || ( id <= 0 ) ) {
+        return;
+    }
+    int bucket = dt > 0 ? 63 - __builtin_clzll( dt ) : 0;
+    t->calls[id]++;
+    t->cycles[id] += dt;
+    t->hist[id][bucket < MATH_PROBE_BUCKETS ? bucket : MATH_PROBE_BUCKETS - 1]++;
+}
+
+static mathprobethread_t*   math_probe_sum;     // для сортировки в MathProbeWrite
+
+static int MathProbeCmp( const void* a, const void* b ) {
+    uint64_t ca = math_probe_sum->cycles[*( const int* )a];
+    uint64_t cb = math_probe_sum->cycles[*( const int* )b];
+    return ca < cb ? 1 : ca > cb ? -1 : 0;
+}
+
+/*
+MathProbeWrite
+
+Сложение счётчиков всех потоков и запись в f в виде JSON.
+Функции идут по убыванию суммарного числа тактов.
+*/
+void MathProbeWrite( FILE* f ) {
+    mathprobethread_t* sum = calloc( 1, sizeof( mathprobethread_t ) );
+    int order[MATH_PROBE_MAX];
+    int count = 0;
+    if( sum == NULL ) {
+        return;
+    }
+    for( mathprobethread_t* t = __atomic_load_n( &math_probe_threads, __ATOMIC_ACQUIRE ); t != NULL; t = t->next ) {
+        for( int i = 1; i < MATH_PROBE_MAX; i++ ) {
+            sum->calls[i] += t->calls[i];
+            sum->cycles[i] += t->cycles[i];
+            for( int k = 0; k < MATH_PROBE_BUCKETS; k++ ) {
+                sum->hist[i][k] += t->hist[i][k];
+            }
+        }
+    }
+    for( int i = 1; i < MATH_PROBE_MAX; i++ ) {
+        if( ( sum->calls[i] > 0 ) && ( math_probe_names[i] != NULL ) ) {
+            order[count++] = i;
+        }
+    }
+    math_probe_sum = sum;
+    qsort( order, count, sizeof( int ), MathProbeCmp );
+
+    fprintf( f, "{\n  \"probes\": [\n" );
+    for( int n = 0; n < count; n++ ) {
+        int i = order[n];
+        int last = MATH_PROBE_BUCKETS - 1;
+        while( ( last > 0 ) && ( sum->hist[i][last] == 0 ) ) {
+            last--;
+        }
+        fprintf( f, "    { \"name\": \"%s\", \"calls\": %llu, \"cycles\": %llu, \"mean\": %.1f, \"hist\": [",
+                 math_probe_names[i], ( unsigned long long )sum->calls[i], ( unsigned long long )sum->cycles[i],
+                 ( double )sum->cycles[i] / sum->calls[i] );
+        for( int k = 0; k <= last; k++ ) {
+            fprintf( f, k == 0 ? "%llu" : ", %llu", ( unsigned long long )sum->hist[i][k] );
+        }
+        fprintf( f, "] }%s\n", n + 1 < count ? "," : "" );
+    }
+    fprintf( f, "  ]\n}\n" );
+    free( sum );
+}
+
+/*
+MathProbeRelease
+
+Запись итогов в файл MATH_PROBE_FILE и освобождение счётчиков потоков.
+Вызывается из MathRelease, когда другие потоки уже не вызывают функции библиотеки.
+*/
+void MathProbeRelease( void ) {
+    const char* path = getenv( "MATH_PROBE_FILE" );
+    FILE* f = fopen( path != NULL ? path : "math_probe.json", "w" );
+    if( f != NULL ) {
+        MathProbeWrite( f );
+        fclose( f );
+    }
+    __atomic_add_fetch( &math_probe_gen, 1, __ATOMIC_RELEASE );
+    mathprobethread_t* t = __atomic_exchange_n( &math_probe_threads, NULL, __ATOMIC_ACQ_REL );
+    while( t != NULL ) {
+        mathprobethread_t* next = t->next;
+        free( t );
+        t = next;
+    }
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef __PROBE_H__
+#define __PROBE_H__
+
+/*
+Замеры функций библиотеки. Включаются только при сборке с -DMATH_INSTRUMENT:
+тогда MATH_PROBE() в начале функции считает её вызовы и такты rdtsc
+(вместе с вложенными вызовами) с гистограммой по степеням двойки.
+Счётчики ведутся отдельно в каждом потоке, в MathRelease складываются
+и записываются в JSON-файл из переменной окружения MATH_PROBE_FILE
+(по умолчанию math_probe.json).
+
+В обычной сборке MATH_PROBE() раскрывается в пустоту.
+*/
+
+#if defined( MATH_INSTRUMENT )
+
+#if !defined( __GNUC__ )
+#error "MATH_INSTRUMENT requires GCC or Clang (cleanup attribute)"
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define MATH_PROBE_MAX      512     // замеряемых функций
+#define MATH_PROBE_BUCKETS  32      // корзина k - от 2^k до 2^(k+1) тактов
+
+// место замера: одно на функцию, номер выдаётся при первом вызове
+typedef struct {
+    const char*     name;
+    int             id;
+} mathprobe_t;
+
+// открытый замер, закрывается при выходе из функции
+typedef struct {
+    mathprobe_t*    site;
+    uint64_t        start;
+} mathprobescope_t;
+
+mathprobescope_t    MathProbeBegin( mathprobe_t* site );
+void                MathProbeEnd( mathprobescope_t* scope );
+void                MathProbeWrite( FILE* f );
+void                MathProbeRelease( void );
+
+#define MATH_PROBE() \
+    static mathprobe_t math_probe_site = { __func__, 0 }; \
+    mathprobescope_t math_probe_scope __attribute__(( cleanup( MathProbeEnd ), unused )) = MathProbeBegin( &math_probe_site )
+
+#else
+
+#define MATH_PROBE()
+
+#endif
+
+
+
+#endif //__PROBE_H__
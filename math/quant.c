@@ -0,0 +1,438 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "quant.h"
+#include "lane.h"
+#include "pool.h"
+
+#define QUANT_MAX_FIELDS    4
+#define QUANT_SQRT1_2       0.70710678f     // 1 / sqrt( 2 )
+#define QUANT_TINY          1e-30f          // защита от деления на ноль для нулевых векторов
+
+#if defined( _M_IX86 ) || defined( _M_X64 ) || \
+    ( defined( __BYTE_ORDER__ ) && ( __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ) )
+#define QUANT_LITTLE_ENDIAN
+#endif
+
+// раскладка закодированного элемента: поля от младших битов к старшим
+typedef struct {
+    int             bytes;
+    int             num_fields;
+    int             bits[QUANT_MAX_FIELDS];
+} quantlayout_t;
+
+static const quantlayout_t quant_oct16 = { 2, 2, { 8, 8 } };
+static const quantlayout_t quant_oct24 = { 3, 2, { 12, 12 } };
+static const quantlayout_t quant_oct32 = { 4, 2, { 16, 16 } };
+static const quantlayout_t quant_pos32 = { 4, 3, { 11, 11, 10 } };
+static const quantlayout_t quant_pos48 = { 6, 3, { 16, 16, 16 } };
+static const quantlayout_t quant_quat32 = { 4, 4, { 2, 10, 10, 10 } };
+static const quantlayout_t quant_quat48 = { 6, 4, { 2, 15, 15, 15 } };
+
+/*
+Аргументы Quant*Array для PoolParallelFor. Чанк кодируется как отдельный
+массив: room в QuantPut считается до конца чанка, поэтому запись 8 байт
+не задевает первый элемент соседнего чанка, который пишет другой поток.
+PoolChunk кратен 8, полосы LANE_WIDTH не разрываются на границе чанка.
+*/
+typedef struct {
+    void*                   out;
+    const void*             in;
+    const aabb_t*           box;
+    const quantlayout_t*    l;
+} quantjob_t;
+
+/*
+QuantPut
+
+Запись младших bytes байт code от младшего к старшему. room - байт до конца
+массива: если их не меньше 8, на little-endian пишется сразу 8 байт, лишние
+перезапишет следующий элемент.
+*/
+static inline void QuantPut( unsigned char* p, uint64_t code, int bytes, size_t room ) {
+#if defined( QUANT_LITTLE_ENDIAN )
+    if( room >= 8 ) {
+        memcpy( p, &code, 8 );
+        return;
+    }
+#endif
+    ( void )room;
+    for( int b = 0; b < bytes; b++ ) {
+        p[b] = ( unsigned char )( code >> ( b * 8 ) );
+    }
+}
+
+// чтение элемента; при room >= 8 старшие байты кода - мусор за элементом
+static inline uint64_t QuantGet( const unsigned char* p, int bytes, size_t room ) {
+    uint64_t code = 0;
+#if defined( QUANT_LITTLE_ENDIAN )
+    if( room >= 8 ) {
+        memcpy( &code, p, 8 );
+        return code;
+    }
+#endif
+    ( void )room;
+    for( int b = 0; b < bytes; b++ ) {
+        code |= ( uint64_t )p[b] << ( b * 8 );
+    }
+    return code;
+}
+
+/*
+QuantPack
+
+Упаковка n элементов полосы: поле c элемента i - целое число f[c][i],
+уже округлённое и лежащее в пределах своего числа бит.
+room - байт от out до конца выходного массива.
+*/
+static inline void QuantPack( unsigned char* out, size_t room, const quantlayout_t* l, float ( *f )[LANE_WIDTH], int n ) {
+    for( int i = 0; i < n; i++ ) {
+        uint64_t code = 0;
+        int shift = 0;
+        for( int c = 0; c < l->num_fields; c++ ) {
+            code |= ( uint64_t )( uint32_t )f[c][i] << shift;
+            shift += l->bits[c];
+        }
+        QuantPut( out + i * l->bytes, code, l->bytes, room - i * l->bytes );
+    }
+}
+
+/*
+QuantUnpack
+
+Распаковка n элементов в поля полосы, остаток полосы заполняется нулями.
+*/
+static inline void QuantUnpack( float ( *f )[LANE_WIDTH], const unsigned char* in, size_t room, const quantlayout_t* l, int n ) {
+    if( n < LANE_WIDTH ) {
+        memset( f, 0, l->num_fields * sizeof( f[0] ) );
+    }
+    for( int i = 0; i < n; i++ ) {
+        uint64_t code = QuantGet( in + i * l->bytes, l->bytes, room - i * l->bytes );
+        for( int c = 0; c < l->num_fields; c++ ) {
+            f[c][i] = ( float )( uint32_t )( code & ( ( ( uint64_t )1 << l->bits[c] ) - 1 ) );
+            code >>= l->bits[c];
+        }
+    }
+}
+
+// перекладка до LANE_WIDTH векторов в структуру массивов, хвост полосы - нули
+static inline int QuantLoadVec3( float ( *v )[LANE_WIDTH], const vec3_t* p, int count ) {
+    int n = count < LANE_WIDTH ? count : LANE_WIDTH;
+    if( n < LANE_WIDTH ) {
+        memset( v, 0, 3 * sizeof( v[0] ) );
+    }
+    for( int i = 0; i < n; i++ ) {
+        v[0][i] = p[i].x;
+        v[1][i] = p[i].y;
+        v[2][i] = p[i].z;
+    }
+    return n;
+}
+
+static inline void QuantStoreVec3( vec3_t* p, float ( *v )[LANE_WIDTH], int n ) {
+    for( int i = 0; i < n; i++ ) {
+        p[i].x = v[0][i];
+        p[i].y = v[1][i];
+        p[i].z = v[2][i];
+    }
+}
+
+/*
+QuantRound
+
+Округление a, прижатого к [0, maxq], до целого. Для симметричных
+диапазонов [-r, r] maxq = 2^бит - 2: чётное число шагов даёт точный ноль,
+поэтому оси и единичный кватернион восстанавливаются без ошибки.
+*/
+static inline lanef_t QuantRound( lanef_t a, float maxq ) {
+    a = LaneMin( LaneMax( a, LaneSet1( 0.0f ) ), LaneSet1( maxq ) );
+    return LaneFloor( LaneAdd( a, LaneSet1( 0.5f ) ) );
+}
+
+// +1 для неотрицательных, -1 для отрицательных
+static inline lanef_t QuantSign( lanef_t a ) {
+    return LaneSel( LaneLt( a, LaneSet1( 0.0f ) ), LaneSet1( -1.0f ), LaneSet1( 1.0f ) );
+}
+
+// 1 / длина вектора; деление и корень точные (не LaneRsqrt), поэтому
+// для декодированных осей и единичного кватерниона множитель равен ровно 1
+static inline lanef_t QuantNormScale( lanef_t x, lanef_t y, lanef_t z, lanef_t w ) {
+    lanef_t d = LaneAdd( LaneAdd( LaneMul( x, x ), LaneMul( y, y ) ), LaneAdd( LaneMul( z, z ), LaneMul( w, w ) ) );
+    return LaneDiv( LaneSet1( 1.0f ), LaneSqrt( LaneMax( d, LaneSet1( QUANT_TINY ) ) ) );
+}
+
+/*
+QuantOctEncode
+
+Единичные векторы n в октаэдрический код. Векторы не обязаны быть
+нормализованными, нулевой вектор кодируется как ( 0, 0, 1 ).
+*/
+static inline void QuantOctEncode( void* out, const vec3_t* n, int count, const quantlayout_t* l ) {
+    float maxq = ( float )( ( 1 << l->bits[0] ) - 2 );
+    float v[3][LANE_WIDTH];
+    float f[2][LANE_WIDTH];
+    lanef_t one = LaneSet1( 1.0f );
+    lanef_t half = LaneSet1( 0.5f * maxq );
+
+    for( int i = 0; i < count; i += LANE_WIDTH ) {
+        int num = QuantLoadVec3( v, n + i, count - i );
+        lanef_t x = LaneLoad( v[0] );
+        lanef_t y = LaneLoad( v[1] );
+        lanef_t z = LaneLoad( v[2] );
+
+        // проекция на октаэдр, нижняя половина отворачивается к углам квадрата
+        lanef_t s = LaneMax( LaneAdd( LaneAdd( LaneAbs( x ), LaneAbs( y ) ), LaneAbs( z ) ), LaneSet1( QUANT_TINY ) );
+        lanef_t inv = LaneDiv( one, s );
+        x = LaneMul( x, inv );
+        y = LaneMul( y, inv );
+        lanef_t lower = LaneLt( z, LaneSet1( 0.0f ) );
+        lanef_t fx = LaneMul( LaneSub( one, LaneAbs( y ) ), QuantSign( x ) );
+        lanef_t fy = LaneMul( LaneSub( one, LaneAbs( x ) ), QuantSign( y ) );
+        x = LaneSel( lower, fx, x );
+        y = LaneSel( lower, fy, y );
+
+        // [-1, 1] -> [0, maxq]
+        LaneStore( f[0], QuantRound( LaneMul( LaneAdd( x, one ), half ), maxq ) );
+        LaneStore( f[1], QuantRound( LaneMul( LaneAdd( y, one ), half ), maxq ) );
+        QuantPack( ( unsigned char* )out + ( size_t )i * l->bytes, ( size_t )( count - i ) * l->bytes, l, f, num );
+    }
+}
+
+static const quantlayout_t* QuantOctLayout( quantoct_t fmt ) {
+    if( fmt == QUANT_OCT16 ) {
+        return &quant_oct16;
+    }
+    else if( fmt == QUANT_OCT24 ) {
+        return &quant_oct24;
+    }
+    return &quant_oct32;
+}
+
+static void QuantOctEncodeChunk( void* ctx, int begin, int end ) {
+    const quantjob_t* job = ctx;
+    QuantOctEncode( ( unsigned char* )job->out + ( size_t )begin * job->l->bytes, ( const vec3_t* )job->in + begin, end - begin, job->l );
+}
+
+void QuantOctEncodeArray( void* out, const vec3_t* n, int count, quantoct_t fmt ) {
+    quantjob_t job = { out, n, NULL, QuantOctLayout( fmt ) };
+    PoolParallelFor( QuantOctEncodeChunk, &job, count, PoolChunk( sizeof( vec3_t ) + job.l->bytes ) );
+}
+
+static inline void QuantOctDecode( vec3_t* n, const void* in, int count, const quantlayout_t* l ) {
+    float maxq = ( float )( ( 1 << l->bits[0] ) - 2 );
+    float v[3][LANE_WIDTH];
+    float f[2][LANE_WIDTH];
+    lanef_t one = LaneSet1( 1.0f );
+    lanef_t zero = LaneSet1( 0.0f );
+    lanef_t scale = LaneSet1( 2.0f / maxq );
+
+    for( int i = 0; i < count; i += LANE_WIDTH ) {
+        int num = count - i < LANE_WIDTH ? count - i : LANE_WIDTH;
+        QuantUnpack( f, ( const unsigned char* )in + ( size_t )i * l->bytes, ( size_t )( count - i ) * l->bytes, l, num );
+        lanef_t x = LaneSub( LaneMul( LaneLoad( f[0] ), scale ), one );
+        lanef_t y = LaneSub( LaneMul( LaneLoad( f[1] ), scale ), one );
+        lanef_t z = LaneSub( LaneSub( one, LaneAbs( x ) ), LaneAbs( y ) );
+
+        // точки за пределами ромба |x| + |y| <= 1 возвращаются на нижнюю половину
+        lanef_t t = LaneMax( LaneSub( zero, z ), zero );
+        x = LaneAdd( x, LaneSel( LaneLt( x, zero ), t, LaneSub( zero, t ) ) );
+        y = LaneAdd( y, LaneSel( LaneLt( y, zero ), t, LaneSub( zero, t ) ) );
+
+        lanef_t r = QuantNormScale( x, y, z, zero );
+        LaneStore( v[0], LaneMul( x, r ) );
+        LaneStore( v[1], LaneMul( y, r ) );
+        LaneStore( v[2], LaneMul( z, r ) );
+        QuantStoreVec3( n + i, v, num );
+    }
+}
+
+static void QuantOctDecodeChunk( void* ctx, int begin, int end ) {
+    const quantjob_t* job = ctx;
+    QuantOctDecode( ( vec3_t* )job->out + begin, ( const unsigned char* )job->in + ( size_t )begin * job->l->bytes, end - begin, job->l );
+}
+
+void QuantOctDecodeArray( vec3_t* n, const void* in, int count, quantoct_t fmt ) {
+    quantjob_t job = { n, in, NULL, QuantOctLayout( fmt ) };
+    PoolParallelFor( QuantOctDecodeChunk, &job, count, PoolChunk( sizeof( vec3_t ) + job.l->bytes ) );
+}
+
+/*
+QuantPosEncode
+
+Позиции p в код относительно box. Точки вне box прижимаются к его
+границе, по вырожденной оси (min == max) кодируется 0.
+*/
+static inline void QuantPosEncode( void* out, const vec3_t* p, int count, const aabb_t* box, const quantlayout_t* l ) {
+    float v[3][LANE_WIDTH];
+    float f[3][LANE_WIDTH];
+    lanef_t lo[3], scale[3];
+    float maxq[3];
+    for( int c = 0; c < 3; c++ ) {
+        float extent = box->max.m[c] - box->min.m[c];
+        maxq[c] = ( float )( ( 1 << l->bits[c] ) - 1 );
+        lo[c] = LaneSet1( box->min.m[c] );
+        scale[c] = LaneSet1( extent > 0.0f ? maxq[c] / extent : 0.0f );
+    }
+
+    for( int i = 0; i < count; i += LANE_WIDTH ) {
+        int num = QuantLoadVec3( v, p + i, count - i );
+        for( int c = 0; c < 3; c++ ) {
+            LaneStore( f[c], QuantRound( LaneMul( LaneSub( LaneLoad( v[c] ), lo[c] ), scale[c] ), maxq[c] ) );
+        }
+        QuantPack( ( unsigned char* )out + ( size_t )i * l->bytes, ( size_t )( count - i ) * l->bytes, l, f, num );
+    }
+}
+
+static void QuantPosEncodeChunk( void* ctx, int begin, int end ) {
+    const quantjob_t* job = ctx;
+    QuantPosEncode( ( unsigned char* )job->out + ( size_t )begin * job->l->bytes, ( const vec3_t* )job->in + begin, end - begin, job->box, job->l );
+}
+
+void QuantPosEncodeArray( void* out, const vec3_t* p, int count, const aabb_t* box, quantpos_t fmt ) {
+    quantjob_t job = { out, p, box, fmt == QUANT_POS32 ? &quant_pos32 : &quant_pos48 };
+    PoolParallelFor( QuantPosEncodeChunk, &job, count, PoolChunk( sizeof( vec3_t ) + job.l->bytes ) );
+}
+
+static inline void QuantPosDecode( vec3_t* p, const void* in, int count, const aabb_t* box, const quantlayout_t* l ) {
+    float v[3][LANE_WIDTH];
+    float f[3][LANE_WIDTH];
+    lanef_t lo[3], step[3];
+    for( int c = 0; c < 3; c++ ) {
+        lo[c] = LaneSet1( box->min.m[c] );
+        step[c] = LaneSet1( ( box->max.m[c] - box->min.m[c] ) / ( float )( ( 1 << l->bits[c] ) - 1 ) );
+    }
+
+    for( int i = 0; i < count; i += LANE_WIDTH ) {
+        int num = count - i < LANE_WIDTH ? count - i : LANE_WIDTH;
+        QuantUnpack( f, ( const unsigned char* )in + ( size_t )i * l->bytes, ( size_t )( count - i ) * l->bytes, l, num );
+        for( int c = 0; c < 3; c++ ) {
+            LaneStore( v[c], LaneAdd( lo[c], LaneMul( LaneLoad( f[c] ), step[c] ) ) );
+        }
+        QuantStoreVec3( p + i, v, num );
+    }
+}
+
+static void QuantPosDecodeChunk( void* ctx, int begin, int end ) {
+    const quantjob_t* job = ctx;
+    QuantPosDecode( ( vec3_t* )job->out + begin, ( const unsigned char* )job->in + ( size_t )begin * job->l->bytes, end - begin, job->box, job->l );
+}
+
+void QuantPosDecodeArray( vec3_t* p, const void* in, int count, const aabb_t* box, quantpos_t fmt ) {
+    quantjob_t job = { p, in, box, fmt == QUANT_POS32 ? &quant_pos32 : &quant_pos48 };
+    PoolParallelFor( QuantPosDecodeChunk, &job, count, PoolChunk( sizeof( vec3_t ) + job.l->bytes ) );
+}
+
+/*
+QuantQuatEncode
+
+Кватернионы q в код "три наименьших". Кватернионы нормализуются
+перед кодированием.
+*/
+static inline void QuantQuatEncode( void* out, const vec4_t* q, int count, const quantlayout_t* l ) {
+    float maxq = ( float )( ( 1 << l->bits[1] ) - 2 );
+    float v[4][LANE_WIDTH];
+    float f[4][LANE_WIDTH];
+    lanef_t zero = LaneSet1( 0.0f );
+    lanef_t scale = LaneSet1( QUANT_SQRT1_2 * maxq );
+    lanef_t bias = LaneSet1( 0.5f * maxq );
+
+    for( int i = 0; i < count; i += LANE_WIDTH ) {
+        int num = count - i < LANE_WIDTH ? count - i : LANE_WIDTH;
+        if( num < LANE_WIDTH ) {
+            memset( v, 0, sizeof( v ) );
+        }
+        for( int k = 0; k < num; k++ ) {
+            for( int c = 0; c < 4; c++ ) {
+                v[c][k] = q[i + k].m[c];
+            }
+        }
+        lanef_t c[4];
+        for( int k = 0; k < 4; k++ ) {
+            c[k] = LaneLoad( v[k] );
+        }
+        lanef_t r = QuantNormScale( c[0], c[1], c[2], c[3] );
+
+        // номер и значение наибольшей по модулю компоненты
+        lanef_t index = zero;
+        lanef_t big = c[0];
+        for( int k = 1; k < 4; k++ ) {
+            lanef_t more = LaneLt( LaneAbs( big ), LaneAbs( c[k] ) );
+            index = LaneSel( more, LaneSet1( ( float )k ), index );
+            big = LaneSel( more, c[k], big );
+        }
+
+        // три остальные по порядку, со знаком, при котором наибольшая положительна
+        r = LaneMul( r, QuantSign( big ) );
+        lanef_t o[3];
+        o[0] = LaneSel( LaneLt( index, LaneSet1( 0.5f ) ), c[1], c[0] );
+        o[1] = LaneSel( LaneLt( index, LaneSet1( 1.5f ) ), c[2], c[1] );
+        o[2] = LaneSel( LaneLt( index, LaneSet1( 2.5f ) ), c[3], c[2] );
+
+        LaneStore( f[0], index );
+        for( int k = 0; k < 3; k++ ) {
+            LaneStore( f[k + 1], QuantRound( LaneAdd( LaneMul( LaneMul( o[k], r ), scale ), bias ), maxq ) );
+        }
+        QuantPack( ( unsigned char* )out + ( size_t )i * l->bytes, ( size_t )( count - i ) * l->bytes, l, f, num );
+    }
+}
+
+static void QuantQuatEncodeChunk( void* ctx, int begin, int end ) {
+    const quantjob_t* job = ctx;
+    QuantQuatEncode( ( unsigned char* )job->out + ( size_t )begin * job->l->bytes, ( const vec4_t* )job->in + begin, end - begin, job->l );
+}
+
+void QuantQuatEncodeArray( void* out, const vec4_t* q, int count, quantquat_t fmt ) {
+    quantjob_t job = { out, q, NULL, fmt == QUANT_QUAT32 ? &quant_quat32 : &quant_quat48 };
+    PoolParallelFor( QuantQuatEncodeChunk, &job, count, PoolChunk( sizeof( vec4_t ) + job.l->bytes ) );
+}
+
+static inline void QuantQuatDecode( vec4_t* q, const void* in, int count, const quantlayout_t* l ) {
+    float maxq = ( float )( ( 1 << l->bits[1] ) - 2 );
+    float f[4][LANE_WIDTH];
+    float v[4][LANE_WIDTH];
+    lanef_t zero = LaneSet1( 0.0f );
+    lanef_t scale = LaneSet1( 2.0f * QUANT_SQRT1_2 / maxq );
+    lanef_t bias = LaneSet1( QUANT_SQRT1_2 );
+
+    for( int i = 0; i < count; i += LANE_WIDTH ) {
+        int num = count - i < LANE_WIDTH ? count - i : LANE_WIDTH;
+        QuantUnpack( f, ( const unsigned char* )in + ( size_t )i * l->bytes, ( size_t )( count - i ) * l->bytes, l, num );
+        lanef_t index = LaneLoad( f[0] );
+        lanef_t o[3];
+        for( int k = 0; k < 3; k++ ) {
+            o[k] = LaneSub( LaneMul( LaneLoad( f[k + 1] ), scale ), bias );
+        }
+        lanef_t rest = LaneAdd( LaneAdd( LaneMul( o[0], o[0] ), LaneMul( o[1], o[1] ) ), LaneMul( o[2], o[2] ) );
+        lanef_t big = LaneSqrt( LaneMax( LaneSub( LaneSet1( 1.0f ), rest ), zero ) );
+
+        // наибольшая компонента встаёт на место index, остальные сдвигаются за ней
+        lanef_t lt0 = LaneLt( index, LaneSet1( 0.5f ) );
+        lanef_t lt1 = LaneLt( index, LaneSet1( 1.5f ) );
+        lanef_t lt2 = LaneLt( index, LaneSet1( 2.5f ) );
+        lanef_t c[4];
+        c[0] = LaneSel( lt0, big, o[0] );
+        c[1] = LaneSel( lt0, o[0], LaneSel( lt1, big, o[1] ) );
+        c[2] = LaneSel( lt1, o[1], LaneSel( lt2, big, o[2] ) );
+        c[3] = LaneSel( lt2, o[2], big );
+
+        lanef_t r = QuantNormScale( c[0], c[1], c[2], c[3] );
+        for( int k = 0; k < 4; k++ ) {
+            LaneStore( v[k], LaneMul( c[k], r ) );
+        }
+        for( int k = 0; k < num; k++ ) {
+            for( int c = 0; c < 4; c++ ) {
+                q[i + k].m[c] = v[c][k];
+            }
+        }
+    }
+}
+
+static void QuantQuatDecodeChunk( void* ctx, int begin, int end ) {
+    const quantjob_t* job = ctx;
+    QuantQuatDecode( ( vec4_t* )job->out + begin, ( const unsigned char* )job->in + ( size_t )begin * job->l->bytes, end - begin, job->l );
+}
+
+void QuantQuatDecodeArray( vec4_t* q, const void* in, int count, quantquat_t fmt ) {
+    quantjob_t job = { q, in, NULL, fmt == QUANT_QUAT32 ? &quant_quat32 : &quant_quat48 };
+    PoolParallelFor( QuantQuatDecodeChunk, &job, count, PoolChunk( sizeof( vec4_t ) + job.l->bytes ) );
+}
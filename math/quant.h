@@ -0,0 +1,63 @@
+#ifndef __QUANT_H__
+#define __QUANT_H__
+
+#include "vector.h"
+
+/*
+Квантованное хранение векторов для вершинных буферов и сетевых снимков.
+Закодированный элемент занимает столько байт, сколько указано значением
+формата, байты записываются от младшего к старшему независимо от
+порядка байт процессора. Функции *Array обрабатывают по LANE_WIDTH
+элементов за раз, большие массивы - чанками между потоками пула;
+для одного элемента - count = 1.
+
+Единичные векторы - октаэдрическое кодирование: вектор проецируется
+на октаэдр |x| + |y| + |z| = 1, нижняя половина отворачивается наружу,
+две координаты квантуются равномерно (ноль и оси - точно). Наибольшая
+ошибка направления: QUANT_OCT16 - 0.95 градуса, QUANT_OCT24 - 0.058,
+QUANT_OCT32 - 0.0037.
+
+Позиции квантуются равномерно внутри aabb_t, точки вне него прижимаются
+к границе. Ошибка по оси не больше половины шага ( max - min ) / ( 2^бит - 1 ):
+QUANT_POS32 - 11, 11 и 10 бит по x, y, z (1/4094 и 1/2046 размера),
+QUANT_POS48 - 16 бит на ось (1/131070 размера).
+
+Кватернионы ( x, y, z, w ) - "три наименьших": номер наибольшей по
+модулю компоненты (2 бита) и три остальные, лежащие в [-1/sqrt(2), 1/sqrt(2)];
+знак выбирается так, чтобы наибольшая была положительной (q и -q - один
+поворот), она восстанавливается из нормы; единичный кватернион передаётся
+точно. Наибольшая ошибка угла поворота: QUANT_QUAT32 (3 x 10 бит) -
+0.24 градуса, QUANT_QUAT48 (3 x 15 бит) - 0.008.
+Декодированные векторы и кватернионы нормализованы.
+*/
+
+// размер закодированного единичного вектора в байтах
+typedef enum {
+    QUANT_OCT16 = 2,        // 2 x 8 бит
+    QUANT_OCT24 = 3,        // 2 x 12 бит
+    QUANT_OCT32 = 4         // 2 x 16 бит
+} quantoct_t;
+
+// размер закодированной позиции в байтах
+typedef enum {
+    QUANT_POS32 = 4,        // 11 + 11 + 10 бит
+    QUANT_POS48 = 6         // 3 x 16 бит
+} quantpos_t;
+
+// размер закодированного кватерниона в байтах
+typedef enum {
+    QUANT_QUAT32 = 4,       // 2 + 3 x 10 бит
+    QUANT_QUAT48 = 6        // 2 + 3 x 15 бит
+} quantquat_t;
+
+
+void        QuantOctEncodeArray( void* out, const vec3_t* n, int count, quantoct_t fmt );
+void        QuantOctDecodeArray( vec3_t* n, const void* in, int count, quantoct_t fmt );
+void        QuantPosEncodeArray( void* out, const vec3_t* p, int count, const aabb_t* box, quantpos_t fmt );
+void        QuantPosDecodeArray( vec3_t* p, const void* in, int count, const aabb_t* box, quantpos_t fmt );
+void        QuantQuatEncodeArray( void* out, const vec4_t* q, int count, quantquat_t fmt );
+void        QuantQuatDecodeArray( vec4_t* q, const void* in, int count, quantquat_t fmt );
+
+
+
+#endif //__QUANT_H__
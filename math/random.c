@@ -0,0 +1,397 @@
+#include "random.h"
+#include "lane.h"
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+#define RANDOM_FLOAT_UNIT   ( 1.0f / 16777216.0f )  // 2^-24
+
+static uint64_t RandomSplitMix( uint64_t* x ) {
+    uint64_t z = ( *x += 0x9E3779B97F4A7C15ull );
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+    return z ^ ( z >> 31 );
+}
+
+static inline uint32_t RandomRotl( uint32_t x, int k ) {
+    return ( x << k ) | ( x >> ( 32 - k ) );
+}
+
+/*
+RandomNext
+
+Шаг xoshiro128++ для всех RANDOM_LANES последовательностей, в out
+записывается по одному числу от каждой.
+*/
+static void RandomNext( random_t* mrestrict r, uint32_t* mrestrict out ) {
+#if defined( __SSE2__ )
+    for( int h = 0; h < RANDOM_LANES; h += 4 ) {
+        __m128i s0 = _mm_loadu_si128( ( const __m128i* )&r->s[0][h] );
+        __m128i s1 = _mm_loadu_si128( ( const __m128i* )&r->s[1][h] );
+        __m128i s2 = _mm_loadu_si128( ( const __m128i* )&r->s[2][h] );
+        __m128i s3 = _mm_loadu_si128( ( const __m128i* )&r->s[3][h] );
+        __m128i a = _mm_add_epi32( s0, s3 );
+        __m128i res = _mm_add_epi32( _mm_or_si128( _mm_slli_epi32( a, 7 ), _mm_srli_epi32( a, 25 ) ), s0 );
+        __m128i t = _mm_slli_epi32( s1, 9 );
+        s2 = _mm_xor_si128( s2, s0 );
+        s3 = _mm_xor_si128( s3, s1 );
+        s1 = _mm_xor_si128( s1, s2 );
+        s0 = _mm_xor_si128( s0, s3 );
+        s2 = _mm_xor_si128( s2, t );
+        s3 = _mm_or_si128( _mm_slli_epi32( s3, 11 ), _mm_srli_epi32( s3, 21 ) );
+        _mm_storeu_si128( ( __m128i* )&r->s[0][h], s0 );
+        _mm_storeu_si128( ( __m128i* )&r->s[1][h], s1 );
+        _mm_storeu_si128( ( __m128i* )&r->s[2][h], s2 );
+        _mm_storeu_si128( ( __m128i* )&r->s[3][h], s3 );
+        _mm_storeu_si128( ( __m128i* )( out + h ), res );
+    }
+#else
+    for( int l = 0; l < RANDOM_LANES; l++ ) {
+        uint32_t s0 = r->s[0][l];
+        uint32_t s1 = r->s[1][l];
+        uint32_t s2 = r->s[2][l];
+        uint32_t s3 = r->s[3][l];
+        uint32_t t = s1 << 9;
+        out[l] = RandomRotl( s0 + s3, 7 ) + s0;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        r->s[0][l] = s0;
+        r->s[1][l] = s1;
+        r->s[2][l] = s2;
+        r->s[3][l] = RandomRotl( s3, 11 );
+    }
+#endif
+}
+
+/*
+RandomBlock
+
+RANDOM_LANES чисел, равномерно распределённых на [0, 1), из старших 24 бит.
+*/
+static void RandomBlock( random_t* mrestrict r, float* mrestrict out ) {
+    uint32_t u[RANDOM_LANES];
+    RandomNext( r, u );
+#if defined( __SSE2__ )
+    for( int h = 0; h < RANDOM_LANES; h += 4 ) {
+        __m128i x = _mm_srli_epi32( _mm_loadu_si128( ( const __m128i* )( u + h ) ), 8 );
+        _mm_storeu_ps( out + h, _mm_mul_ps( _mm_cvtepi32_ps( x ), _mm_set1_ps( RANDOM_FLOAT_UNIT ) ) );
+    }
+#else
+    for( int l = 0; l < RANDOM_LANES; l++ ) {
+        out[l] = ( float )( u[l] >> 8 ) * RANDOM_FLOAT_UNIT;
+    }
+#endif
+}
+
+/*
+RandomSinCos
+
+Синус и косинус угла 2 * pi * t для t из [0, 1) без обращения к sin1f:
+угол переносится в [-pi, pi), сводится к [-pi / 2, pi / 2] и считается
+рядом Тейлора (ошибка меньше 1e-7).
+*/
+static inline void RandomSinCos( lanef_t t, lanef_t* s, lanef_t* c ) {
+    // sin( 2 pi t ) = -sin( a ), cos( 2 pi t ) = -cos( a ), a = 2 pi ( t - 0.5 )
+    lanef_t a = LaneMul( LaneSub( t, LaneSet1( 0.5f ) ), LaneSet1( 6.28318530717958647f ) );
+    lanef_t hi = LaneLt( LaneSet1( 1.57079632679489662f ), a );
+    lanef_t lo = LaneLt( a, LaneSet1( -1.57079632679489662f ) );
+    lanef_t x = LaneSel( hi, LaneSub( LaneSet1( 3.14159265358979324f ), a ), a );
+    x = LaneSel( lo, LaneSub( LaneSet1( -3.14159265358979324f ), a ), x );
+    lanef_t x2 = LaneMul( x, x );
+
+    lanef_t ps = LaneSet1( -1.0f / 39916800.0f );
+    ps = LaneAdd( LaneMul( ps, x2 ), LaneSet1( 1.0f / 362880.0f ) );
+    ps = LaneAdd( LaneMul( ps, x2 ), LaneSet1( -1.0f / 5040.0f ) );
+    ps = LaneAdd( LaneMul( ps, x2 ), LaneSet1( 1.0f / 120.0f ) );
+    ps = LaneAdd( LaneMul( ps, x2 ), LaneSet1( -1.0f / 6.0f ) );
+    ps = LaneMul( LaneAdd( LaneMul( ps, x2 ), LaneSet1( 1.0f ) ), x );
+
+    lanef_t pc = LaneSet1( 1.0f / 479001600.0f );
+    pc = LaneAdd( LaneMul( pc, x2 ), LaneSet1( -1.0f / 3628800.0f ) );
+    pc = LaneAdd( LaneMul( pc, x2 ), LaneSet1( 1.0f / 40320.0f ) );
+    pc = LaneAdd( LaneMul( pc, x2 ), LaneSet1( -1.0f / 720.0f ) );
+    pc = LaneAdd( LaneMul( pc, x2 ), LaneSet1( 1.0f / 24.0f ) );
+    pc = LaneAdd( LaneMul( pc, x2 ), LaneSet1( -0.5f ) );
+    pc = LaneAdd( LaneMul( pc, x2 ), LaneSet1( 1.0f ) );
+
+    // при отражении угла относительно +-pi / 2 знак косинуса меняется
+    lanef_t neg = LaneSub( LaneSet1( 0.0f ), pc );
+    *s = LaneSub( LaneSet1( 0.0f ), ps );
+    *c = LaneSel( hi, pc, LaneSel( lo, pc, neg ) );
+}
+
+/*
+RandomUnitVec3Lane
+
+Равномерное направление на сфере по двум числам из [0, 1):
+z = 1 - 2 * u равномерно на [-1, 1] (теорема Архимеда), долгота 2 * pi * v.
+*/
+static inline void RandomUnitVec3Lane( lanef_t u, lanef_t v, lanef_t* x, lanef_t* y, lanef_t* z ) {
+    lanef_t s, c;
+    RandomSinCos( v, &s, &c );
+    *z = LaneSub( LaneSet1( 1.0f ), LaneMul( u, LaneSet1( 2.0f ) ) );
+    lanef_t rr = LaneSqrt( LaneMax( LaneSub( LaneSet1( 1.0f ), LaneMul( *z, *z ) ), LaneSet1( 0.0f ) ) );
+    *x = LaneMul( rr, c );
+    *y = LaneMul( rr, s );
+}
+
+// скопировать n вычисленных точек из структуры массивов в out
+static void RandomScatter2( vec2_t* out, const float* x, const float* y, int n ) {
+    for( int j = 0; j < n; j++ ) {
+        out[j].x = x[j];
+        out[j].y = y[j];
+    }
+}
+
+static void RandomScatter3( vec3_t* out, const float* x, const float* y, const float* z, int n ) {
+    for( int j = 0; j < n; j++ ) {
+        out[j].x = x[j];
+        out[j].y = y[j];
+        out[j].z = z[j];
+    }
+}
+
+/*
+RandomInit
+
+Начальное состояние последовательностей потока stream. Каждая из
+RANDOM_LANES последовательностей получает своё состояние из splitmix64.
+*/
+void RandomInit( random_t* r, uint64_t seed, uint32_t stream ) {
+    for( int l = 0; l < RANDOM_LANES; l++ ) {
+        uint64_t x = seed ^ ( ( ( uint64_t )stream * RANDOM_LANES + l + 1 ) * 0xD1B54A32D192ED03ull );
+        uint64_t a = RandomSplitMix( &x );
+        uint64_t b = RandomSplitMix( &x );
+        r->s[0][l] = ( uint32_t )a;
+        r->s[1][l] = ( uint32_t )( a >> 32 );
+        r->s[2][l] = ( uint32_t )b;
+        r->s[3][l] = ( uint32_t )( b >> 32 );
+        // нулевое состояние xoshiro не покидает
+        if( ( a | b ) == 0 ) {
+            r->s[0][l] = 1;
+        }
+    }
+    r->pos = RANDOM_LANES;
+}
+
+/*
+RandomU32
+
+Следующее 32-битное число. Числа берутся из буфера, который
+пополняется сразу на RANDOM_LANES чисел.
+*/
+uint32_t RandomU32( random_t* r ) {
+    if( r->pos >= RANDOM_LANES ) {
+        RandomNext( r, r->buf );
+        r->pos = 0;
+    }
+    return r->buf[r->pos++];
+}
+
+/*
+RandomFloat
+
+Число, равномерно распределённое на [0, 1).
+*/
+float RandomFloat( random_t* r ) {
+    return ( float )( RandomU32( r ) >> 8 ) * RANDOM_FLOAT_UNIT;
+}
+
+/*
+RandomRange
+
+Число, равномерно распределённое на [lo, hi).
+*/
+float RandomRange( random_t* r, float lo, float hi ) {
+    return lo + ( hi - lo ) * RandomFloat( r );
+}
+
+/*
+RandomFloatArray
+
+count чисел, равномерно распределённых на [0, 1).
+*/
+void RandomFloatArray( random_t* r, float* out, int count ) {
+    float u[RANDOM_LANES];
+    int i = 0;
+    for( ; i + RANDOM_LANES <= count; i += RANDOM_LANES ) {
+        RandomBlock( r, out + i );
+    }
+    if( i < count ) {
+        RandomBlock( r, u );
+        for( int j = 0; j < count - i; j++ ) {
+            out[i + j] = u[j];
+        }
+    }
+}
+
+/*
+RandomRangeArray
+
+count чисел, равномерно распределённых на [lo, hi).
+*/
+void RandomRangeArray( random_t* r, float* out, float lo, float hi, int count ) {
+    float u[RANDOM_LANES];
+    for( int i = 0; i < count; i += RANDOM_LANES ) {
+        RandomBlock( r, u );
+        for( int k = 0; k < RANDOM_LANES; k += LANE_WIDTH ) {
+            LaneStore( u + k, LaneAdd( LaneSet1( lo ), LaneMul( LaneLoad( u + k ), LaneSet1( hi - lo ) ) ) );
+        }
+        int n = count - i < RANDOM_LANES ? count - i : RANDOM_LANES;
+        for( int j = 0; j < n; j++ ) {
+            out[i + j] = u[j];
+        }
+    }
+}
+
+/*
+RandomUnitVec2Array
+
+count единичных векторов с равномерно распределённым углом.
+*/
+void RandomUnitVec2Array( random_t* r, vec2_t* out, int count ) {
+    float u[RANDOM_LANES], x[RANDOM_LANES], y[RANDOM_LANES];
+    for( int i = 0; i < count; i += RANDOM_LANES ) {
+        RandomBlock( r, u );
+        for( int k = 0; k < RANDOM_LANES; k += LANE_WIDTH ) {
+            lanef_t s, c;
+            RandomSinCos( LaneLoad( u + k ), &s, &c );
+            LaneStore( x + k, c );
+            LaneStore( y + k, s );
+        }
+        RandomScatter2( out + i, x, y, count - i < RANDOM_LANES ? count - i : RANDOM_LANES );
+    }
+}
+
+/*
+RandomUnitVec3Array
+
+count единичных векторов, равномерно распределённых по сфере.
+*/
+void RandomUnitVec3Array( random_t* r, vec3_t* out, int count ) {
+    float u[2][RANDOM_LANES], x[RANDOM_LANES], y[RANDOM_LANES], z[RANDOM_LANES];
+    for( int i = 0; i < count; i += RANDOM_LANES ) {
+        RandomBlock( r, u[0] );
+        RandomBlock( r, u[1] );
+        for( int k = 0; k < RANDOM_LANES; k += LANE_WIDTH ) {
+            lanef_t vx, vy, vz;
+            RandomUnitVec3Lane( LaneLoad( u[0] + k ), LaneLoad( u[1] + k ), &vx, &vy, &vz );
+            LaneStore( x + k, vx );
+            LaneStore( y + k, vy );
+            LaneStore( z + k, vz );
+        }
+        RandomScatter3( out + i, x, y, z, count - i < RANDOM_LANES ? count - i : RANDOM_LANES );
+    }
+}
+
+/*
+RandomDiscArray
+
+count точек, равномерно распределённых по кругу радиуса radius
+с центром в нуле: расстояние radius * sqrt( u ), угол 2 * pi * v.
+*/
+void RandomDiscArray( random_t* r, vec2_t* out, float radius, int count ) {
+    float u[2][RANDOM_LANES], x[RANDOM_LANES], y[RANDOM_LANES];
+    for( int i = 0; i < count; i += RANDOM_LANES ) {
+        RandomBlock( r, u[0] );
+        RandomBlock( r, u[1] );
+        for( int k = 0; k < RANDOM_LANES; k += LANE_WIDTH ) {
+            lanef_t s, c;
+            RandomSinCos( LaneLoad( u[1] + k ), &s, &c );
+            lanef_t d = LaneMul( LaneSqrt( LaneLoad( u[0] + k ) ), LaneSet1( radius ) );
+            LaneStore( x + k, LaneMul( c, d ) );
+            LaneStore( y + k, LaneMul( s, d ) );
+        }
+        RandomScatter2( out + i, x, y, count - i < RANDOM_LANES ? count - i : RANDOM_LANES );
+    }
+}
+
+/*
+RandomBallLane
+
+Точка внутри шара: равномерное направление и расстояние max( u0, u1, u2 ),
+функция распределения которого d^3 - как у объёма шара радиуса d.
+*/
+static inline void RandomBallLane( const float ( *u )[RANDOM_LANES], int k, float radius, lanef_t* x, lanef_t* y, lanef_t* z ) {
+    RandomUnitVec3Lane( LaneLoad( u[0] + k ), LaneLoad( u[1] + k ), x, y, z );
+    lanef_t d = LaneMax( LaneMax( LaneLoad( u[2] + k ), LaneLoad( u[3] + k ) ), LaneLoad( u[4] + k ) );
+    d = LaneMul( d, LaneSet1( radius ) );
+    *x = LaneMul( *x, d );
+    *y = LaneMul( *y, d );
+    *z = LaneMul( *z, d );
+}
+
+/*
+RandomSphereArray
+
+count точек, равномерно распределённых внутри шара радиуса radius
+с центром в нуле. Для точек на поверхности - RandomUnitVec3Array.
+*/
+void RandomSphereArray( random_t* r, vec3_t* out, float radius, int count ) {
+    float u[5][RANDOM_LANES], x[RANDOM_LANES], y[RANDOM_LANES], z[RANDOM_LANES];
+    for( int i = 0; i < count; i += RANDOM_LANES ) {
+        for( int j = 0; j < 5; j++ ) {
+            RandomBlock( r, u[j] );
+        }
+        for( int k = 0; k < RANDOM_LANES; k += LANE_WIDTH ) {
+            lanef_t vx, vy, vz;
+            RandomBallLane( ( const float ( * )[RANDOM_LANES] )u, k, radius, &vx, &vy, &vz );
+            LaneStore( x + k, vx );
+            LaneStore( y + k, vy );
+            LaneStore( z + k, vz );
+        }
+        RandomScatter3( out + i, x, y, z, count - i < RANDOM_LANES ? count - i : RANDOM_LANES );
+    }
+}
+
+/*
+RandomHemisphereArray
+
+count точек, равномерно распределённых внутри половины шара радиуса radius,
+лежащей со стороны единичной нормали n. Точки из другой половины
+отражаются плоскостью, поэтому распределение остаётся равномерным.
+*/
+void RandomHemisphereArray( random_t* r, vec3_t* out, const vec3_t* n, float radius, int count ) {
+    float u[5][RANDOM_LANES], x[RANDOM_LANES], y[RANDOM_LANES], z[RANDOM_LANES];
+    lanef_t nx = LaneSet1( n->x );
+    lanef_t ny = LaneSet1( n->y );
+    lanef_t nz = LaneSet1( n->z );
+    for( int i = 0; i < count; i += RANDOM_LANES ) {
+        for( int j = 0; j < 5; j++ ) {
+            RandomBlock( r, u[j] );
+        }
+        for( int k = 0; k < RANDOM_LANES; k += LANE_WIDTH ) {
+            lanef_t vx, vy, vz;
+            RandomBallLane( ( const float ( * )[RANDOM_LANES] )u, k, radius, &vx, &vy, &vz );
+            lanef_t d = LaneAdd( LaneAdd( LaneMul( vx, nx ), LaneMul( vy, ny ) ), LaneMul( vz, nz ) );
+            lanef_t f = LaneMul( LaneMin( d, LaneSet1( 0.0f ) ), LaneSet1( 2.0f ) );
+            LaneStore( x + k, LaneSub( vx, LaneMul( f, nx ) ) );
+            LaneStore( y + k, LaneSub( vy, LaneMul( f, ny ) ) );
+            LaneStore( z + k, LaneSub( vz, LaneMul( f, nz ) ) );
+        }
+        RandomScatter3( out + i, x, y, z, count - i < RANDOM_LANES ? count - i : RANDOM_LANES );
+    }
+}
+
+/*
+RandomBoxArray
+
+count точек, равномерно распределённых в параллелепипеде [min, max).
+*/
+void RandomBoxArray( random_t* r, vec3_t* out, const vec3_t* min, const vec3_t* max, int count ) {
+    float u[3][RANDOM_LANES];
+    for( int i = 0; i < count; i += RANDOM_LANES ) {
+        for( int j = 0; j < 3; j++ ) {
+            RandomBlock( r, u[j] );
+            for( int k = 0; k < RANDOM_LANES; k += LANE_WIDTH ) {
+                lanef_t v = LaneMul( LaneLoad( u[j] + k ), LaneSet1( max->m[j] - min->m[j] ) );
+                LaneStore( u[j] + k, LaneAdd( v, LaneSet1( min->m[j] ) ) );
+            }
+        }
+        RandomScatter3( out + i, u[0], u[1], u[2], count - i < RANDOM_LANES ? count - i : RANDOM_LANES );
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef __RANDOM_H__
+#define __RANDOM_H__
+
+#include <stdint.h>
+
+#include "vector.h"
+
+#define RANDOM_LANES    8       // независимых последовательностей в одном генераторе
+
+/*
+Генератор xoshiro128++ из RANDOM_LANES независимых последовательностей,
+которые продвигаются одновременно (SSE2 - по 4 за команду).
+Генератор не потокобезопасен: каждый поток создаёт свой random_t
+с общим seed и собственным номером stream, последовательности
+разных потоков не пересекаются на практике.
+При одинаковых seed и stream результат не зависит от набора команд.
+*/
+typedef struct {
+    uint32_t        s[4][RANDOM_LANES];     // состояние, по столбцу на последовательность
+    uint32_t        buf[RANDOM_LANES];      // готовые числа для скалярных функций
+    int             pos;                    // первое неиспользованное число в buf
+} random_t;
+
+
+void        RandomInit( random_t* r, uint64_t seed, uint32_t stream );
+
+uint32_t    RandomU32( random_t* r );
+float       RandomFloat( random_t* r );
+float       RandomRange( random_t* r, float lo, float hi );
+
+void        RandomFloatArray( random_t* r, float* out, int count );
+void        RandomRangeArray( random_t* r, float* out, float lo, float hi, int count );
+
+void        RandomUnitVec2Array( random_t* r, vec2_t* out, int count );
+void        RandomUnitVec3Array( random_t* r, vec3_t* out, int count );
+void        RandomDiscArray( random_t* r, vec2_t* out, float radius, int count );
+void        RandomSphereArray( random_t* r, vec3_t* out, float radius, int count );
+void        RandomHemisphereArray( random_t* r, vec3_t* out, const vec3_t* n, float radius, int count );
+void        RandomBoxArray( random_t* r, vec3_t* out, const vec3_t* min, const vec3_t* max, int count );
+
+
+
+#endif //__RANDOM_H__
@@ -0,0 +1,360 @@
+#include "sparse.h"
+#include "value.h"
+#include "arena.h"
+#include "pool.h"
+
+#define BSR3_CHUNK      4096    // наименьший чанк векторных циклов CG: на меньших запуск пула дороже самой работы
+#define BSR3_DOT_PARTS  64      // наибольшее число частичных сумм скалярного произведения
+
+/*
+Bsr3SortRow
+
+Сортировка блоков одной строки по столбцу вставками (в строке обычно
+несколько блоков) и сложение блоков с одинаковым столбцом.
+Возвращает количество блоков строки после слияния.
+*/
+static int Bsr3SortRow( int* cols, mat3_t* blocks, int count ) {
+    for( int i = 1; i < count; i++ ) {
+        int c = cols[i];
+        mat3_t b = blocks[i];
+        int j = i - 1;
+        while( ( j >= 0 ) && ( cols[j] > c ) ) {
+            cols[j + 1] = cols[j];
+            blocks[j + 1] = blocks[j];
+            j--;
+        }
+        cols[j + 1] = c;
+        blocks[j + 1] = b;
+    }
+
+    int n = 0;
+    for( int i = 0; i < count; i++ ) {
+        if( ( n > 0 ) && ( cols[n - 1] == cols[i] ) ) {
+            Mat3Add( &blocks[n - 1], &blocks[n - 1], &blocks[i] );
+        }
+        else {
+            cols[n] = cols[i];
+            blocks[n] = blocks[i];
+            n++;
+        }
+    }
+    return n;
+}
+
+/*
+Bsr3FromTriplets
+
+Построение матрицы rows x rows блоков из count троек ( row[i], col[i], blocks[i] ).
+Блоки с одинаковыми row и col складываются.
+Возвращает mfalse при неверных индексах или нехватке памяти.
+*/
+mbool_t Bsr3FromTriplets( bsr3_t* m, int rows, const int* row, const int* col, const mat3_t* blocks, int count ) {
+    m->rows = 0;
+    m->num_blocks = 0;
+    m->row_ptr = calloc( rows + 1, sizeof( int ) );
+    m->cols = malloc( ( count > 0 ? count : 1 ) * sizeof( int ) );
+    m->blocks = malloc( ( count > 0 ? count : 1 ) * sizeof( mat3_t ) );
+    int* cursor = malloc( ( rows + 1 ) * sizeof( int ) );
+
+    if( ( m->row_ptr == NULL ) || ( m->cols == NULL ) || ( m->blocks == NULL ) || ( cursor == NULL ) ) {
+        free( cursor );
+        Bsr3Release( m );
+        return mfalse;
+    }
+
+    // подсчёт блоков в каждой строке
+    for( int i = 0; i < count; i++ ) {
+        if( ( row[i] < 0 ) || ( row[i] >= rows ) || ( col[i] < 0 ) || ( col[i] >= rows ) ) {
+            free( cursor );
+            Bsr3Release( m );
+            return mfalse;
+        }
+        m->row_ptr[row[i] + 1]++;
+    }
+    for( int i = 0; i < rows; i++ ) {
+        m->row_ptr[i + 1] += m->row_ptr[i];
+        cursor[i] = m->row_ptr[i];
+    }
+
+    // раскладка блоков по строкам
+    for( int i = 0; i < count; i++ ) {
+        int k = cursor[row[i]]++;
+        m->cols[k] = col[i];
+        m->blocks[k] = blocks[i];
+    }
+
+    // сортировка и слияние внутри строк со сдвигом к началу массива
+    int n = 0;
+    for( int i = 0; i < rows; i++ ) {
+        int begin = m->row_ptr[i];
+        int end = m->row_ptr[i + 1];
+        int merged = Bsr3SortRow( &m->cols[begin], &m->blocks[begin], end - begin );
+        for( int k = 0; k < merged; k++ ) {
+            m->cols[n + k] = m->cols[begin + k];
+            m->blocks[n + k] = m->blocks[begin + k];
+        }
+        m->row_ptr[i] = n;
+        n += merged;
+    }
+    m->row_ptr[rows] = n;
+
+    free( cursor );
+    m->rows = rows;
+    m->num_blocks = n;
+    return mtrue;
+}
+
+/*
+Bsr3Release
+
+Освобождение памяти матрицы.
+*/
+void Bsr3Release( bsr3_t* m ) {
+    free( m->row_ptr );
+    free( m->cols );
+    free( m->blocks );
+    m->row_ptr = NULL;
+    m->cols = NULL;
+    m->blocks = NULL;
+    m->rows = 0;
+    m->num_blocks = 0;
+}
+
+// аргументы ядер умножения и CG для PoolParallelFor
+typedef struct {
+    vec3_t*         out;
+    const bsr3_t*   m;
+    const vec3_t*   v;
+} bsr3mulvec_t;
+
+// строки [begin, end) для Bsr3MulVec
+static void Bsr3MulVecChunk( void* ctx, int begin, int end ) {
+    const bsr3mulvec_t* job = ctx;
+    const bsr3_t* m = job->m;
+    for( int i = begin; i < end; i++ ) {
+        vec3_t s = Vec3Make( 0.0f, 0.0f, 0.0f );
+        for( int k = m->row_ptr[i]; k < m->row_ptr[i + 1]; k++ ) {
+            s = Vec3AddVal( s, Mat3MulVec3Val( &m->blocks[k], job->v[m->cols[k]] ) );
+        }
+        job->out[i] = s;
+    }
+}
+
+/*
+Bsr3MulVec
+
+Умножение разреженной матрицы m на вектор v из m->rows элементов.
+Стоимость пропорциональна количеству ненулевых блоков.
+Строки распределяются между потоками пула. out не должен совпадать с v.
+*/
+void Bsr3MulVec( vec3_t* out, const bsr3_t* m, const vec3_t* v ) {
+    bsr3mulvec_t job = { out, m, v };
+    int per_row = m->rows > 0 ? m->num_blocks / m->rows : 0;
+    PoolParallelFor( Bsr3MulVecChunk, &job, m->rows,
+                     PoolChunk( sizeof( vec3_t ) + per_row * ( sizeof( mat3_t ) + sizeof( int ) + sizeof( vec3_t ) ) ) );
+}
+
+typedef struct {
+    const vec3_t*   a;
+    const vec3_t*   b;
+    int             n;
+    int             chunk;
+    double          part[BSR3_DOT_PARTS];
+} bsr3dot_t;
+
+// частичные суммы [begin, end) для Bsr3Dot
+static void Bsr3DotChunk( void* ctx, int begin, int end ) {
+    bsr3dot_t* job = ctx;
+    for( int c = begin; c < end; c++ ) {
+        int e = ( c + 1 ) * job->chunk < job->n ? ( c + 1 ) * job->chunk : job->n;
+        double s = 0.0;
+        for( int i = c * job->chunk; i < e; i++ ) {
+            s += ( double )job->a[i].x * job->b[i].x + ( double )job->a[i].y * job->b[i].y + ( double )job->a[i].z * job->b[i].z;
+        }
+        job->part[c] = s;
+    }
+}
+
+/*
+Bsr3Dot
+
+Скалярное произведение векторов из n элементов vec3_t.
+Накопление в double, чтобы ошибка суммы не росла с размером системы.
+Частичные суммы считаются по чанкам, границы которых зависят только от n,
+и складываются по порядку, поэтому результат не зависит от числа потоков.
+*/
+static double Bsr3Dot( const vec3_t* a, const vec3_t* b, int n ) {
+    bsr3dot_t job;
+    job.a = a;
+    job.b = b;
+    job.n = n;
+    job.chunk = ( n + BSR3_DOT_PARTS - 1 ) / BSR3_DOT_PARTS;
+    job.chunk = job.chunk > BSR3_CHUNK ? job.chunk : BSR3_CHUNK;
+    int parts = ( n + job.chunk - 1 ) / job.chunk;
+    PoolParallelFor( Bsr3DotChunk, &job, parts, 1 );
+
+    double s = 0.0;
+    for( int c = 0; c < parts; c++ ) {
+        s += job.part[c];
+    }
+    return s;
+}
+
+typedef struct {
+    vec3_t*         x;
+    vec3_t*         r;
+    vec3_t*         z;
+    vec3_t*         p;
+    const vec3_t*   ap;
+    const mat3_t*   dinv;
+    float           alpha;
+    float           beta;
+} bsr3cg_t;
+
+// x += alpha * p, r -= alpha * ap, z = D^-1 * r на [begin, end)
+static void Bsr3StepChunk( void* ctx, int begin, int end ) {
+    const bsr3cg_t* cg = ctx;
+    for( int i = begin; i < end; i++ ) {
+        cg->x[i] = Vec3AddVal( cg->x[i], Vec3Scale1fVal( cg->p[i], cg->alpha ) );
+        cg->r[i] = Vec3SubVal( cg->r[i], Vec3Scale1fVal( cg->ap[i], cg->alpha ) );
+        cg->z[i] = Mat3MulVec3Val( &cg->dinv[i], cg->r[i] );
+    }
+}
+
+// p = z + beta * p на [begin, end)
+static void Bsr3DirChunk( void* ctx, int begin, int end ) {
+    const bsr3cg_t* cg = ctx;
+    for( int i = begin; i < end; i++ ) {
+        cg->p[i] = Vec3AddVal( cg->z[i], Vec3Scale1fVal( cg->p[i], cg->beta ) );
+    }
+}
+
+/*
+Bsr3IterateCG
+
+Итерации метода сопряжённых градиентов. r - рабочая память на 4 * a->rows векторов.
+*/
+static mbool_t Bsr3IterateCG( vec3_t* x, const bsr3_t* a, const vec3_t* b, const mat3_t* dinv, vec3_t* r,
+                              const cgparams_t* params, double b_norm, int* out_iters, double* out_rel ) {
+    int n = a->rows;
+    vec3_t* z = r + n;
+    vec3_t* p = z + n;
+    vec3_t* ap = p + n;
+    bsr3cg_t cg = { x, r, z, p, ap, dinv, 0.0f, 0.0f };
+    mbool_t converged = mfalse;
+    int iters = 0;
+    double rel = 0.0;
+
+    // r = b - A * x, z = D^-1 * r, p = z
+    Bsr3MulVec( ap, a, x );
+    for( int i = 0; i < n; i++ ) {
+        r[i] = Vec3SubVal( b[i], ap[i] );
+        z[i] = Mat3MulVec3Val( &dinv[i], r[i] );
+        p[i] = z[i];
+    }
+    double rz = Bsr3Dot( r, z, n );
+
+    for( ;; ) {
+        rel = sqrt( Bsr3Dot( r, r, n ) ) / b_norm;
+        if( rel <= params->tolerance ) {
+            converged = mtrue;
+            break;
+        }
+        if( iters >= params->max_iters ) {
+            break;
+        }
+
+        Bsr3MulVec( ap, a, p );
+        double p_ap = Bsr3Dot( p, ap, n );
+        if( p_ap <= 0.0 ) {
+            // матрица не положительно определена
+            break;
+        }
+        cg.alpha = ( float )( rz / p_ap );
+        PoolParallelFor( Bsr3StepChunk, &cg, n, BSR3_CHUNK );
+
+        double rz_new = Bsr3Dot( r, z, n );
+        cg.beta = ( float )( rz_new / rz );
+        rz = rz_new;
+
+        PoolParallelFor( Bsr3DirChunk, &cg, n, BSR3_CHUNK );
+        iters++;
+    }
+
+    *out_iters = iters;
+    *out_rel = rel;
+    return converged;
+}
+
+/*
+Bsr3SolveCG
+
+Решение системы a * x = b для симметричной положительно определённой матрицы
+методом сопряжённых градиентов с блочным предобусловливателем Якоби
+(обратные диагональные блоки 3x3).
+
+x - начальное приближение (например, решение прошлого кадра), в него
+же записывается результат. Итерации прекращаются, когда невязка
+относительно |b| становится не больше params->tolerance или выполнено
+params->max_iters итераций. stats может быть NULL.
+Возвращает mtrue, если требуемая невязка достигнута.
+*/
+mbool_t Bsr3SolveCG( vec3_t* x, const bsr3_t* a, const vec3_t* b, const cgparams_t* params, cgstats_t* stats ) {
+    int n = a->rows;
+    mbool_t converged = mfalse;
+    int iters = 0;
+    double rel = 0.0;
+
+    // рабочие векторы берутся из арены кадра, если она слишком мала - из кучи
+    arena_t* arena = ArenaFrame();
+    arenamark_t mark = ArenaMark( arena );
+    vec3_t* r = ArenaVec3Array( arena, 4 * n );
+    mat3_t* dinv = ArenaMat3Array( arena, n );
+    mbool_t heap = ( r == NULL ) || ( dinv == NULL );
+    if( heap ) {
+        ArenaReset( arena, mark );
+        r = malloc( 4 * ( n > 0 ? n : 1 ) * sizeof( vec3_t ) );
+        dinv = malloc( ( n > 0 ? n : 1 ) * sizeof( mat3_t ) );
+        if( ( r == NULL ) || ( dinv == NULL ) ) {
+            free( r );
+            free( dinv );
+            return mfalse;
+        }
+    }
+
+    // обратные диагональные блоки; вырожденный блок не предобусловливается
+    for( int i = 0; i < n; i++ ) {
+        Mat3Ident( &dinv[i] );
+        for( int k = a->row_ptr[i]; k < a->row_ptr[i + 1]; k++ ) {
+            if( a->cols[k] == i ) {
+                mat3_t d;
+                if( Mat3InvTo( &d, &a->blocks[k] ) ) {
+                    dinv[i] = d;
+                }
+                break;
+            }
+        }
+    }
+
+    double b_norm = sqrt( Bsr3Dot( b, b, n ) );
+    if( b_norm == 0.0 ) {
+        for( int i = 0; i < n; i++ ) {
+            Vec3Zero( &x[i] );
+        }
+        converged = mtrue;
+    }
+    else {
+        converged = Bsr3IterateCG( x, a, b, dinv, r, params, b_norm, &iters, &rel );
+    }
+
+    if( stats != NULL ) {
+        stats->iters = iters;
+        stats->residual = ( float )rel;
+    }
+    if( heap ) {
+        free( r );
+        free( dinv );
+    }
+    ArenaReset( arena, mark );
+    return converged;
+}
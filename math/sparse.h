@@ -0,0 +1,39 @@
+#ifndef __SPARSE_H__
+#define __SPARSE_H__
+
+#include "matrix.h"
+
+/*
+Разреженная блочная матрица в формате BSR (CSR из блоков 3x3).
+Элемент матрицы - блок mat3_t, вектор - массив vec3_t,
+поэтому одна блочная строка соответствует одной частице или телу.
+*/
+typedef struct {
+    int             rows;       // количество блочных строк (и столбцов)
+    int             num_blocks; // количество ненулевых блоков
+    int*            row_ptr;    // rows + 1 элементов: начало блоков строки
+    int*            cols;       // блочный столбец каждого блока
+    mat3_t*         blocks;
+} bsr3_t;
+
+// параметры метода сопряжённых градиентов
+typedef struct {
+    int             max_iters;  // ограничение числа итераций
+    float           tolerance;  // требуемая невязка относительно |b|
+} cgparams_t;
+
+// результат метода сопряжённых градиентов
+typedef struct {
+    int             iters;
+    float           residual;   // достигнутая невязка относительно |b|
+} cgstats_t;
+
+
+mbool_t     Bsr3FromTriplets( bsr3_t* m, int rows, const int* row, const int* col, const mat3_t* blocks, int count );
+void        Bsr3Release( bsr3_t* m );
+void        Bsr3MulVec( vec3_t* out, const bsr3_t* m, const vec3_t* v );
+mbool_t     Bsr3SolveCG( vec3_t* x, const bsr3_t* a, const vec3_t* b, const cgparams_t* params, cgstats_t* stats );
+
+
+
+#endif //__SPARSE_H__
@@ -0,0 +1,542 @@
+#include "spline.h"
+#include "value.h"
+#include "pool.h"
+
+/*
+Базисные матрицы: строка i даёт коэффициент c[i] как комбинацию
+четырёх опорных векторов сегмента g[0..3].
+*/
+
+// g = ( P0, P1, P2, P3 ) - точки Безье
+static const float spline_bezier[4][4] = {
+    {  1.0f,  0.0f,  0.0f,  0.0f },
+    { -3.0f,  3.0f,  0.0f,  0.0f },
+    {  3.0f, -6.0f,  3.0f,  0.0f },
+    { -1.0f,  3.0f, -3.0f,  1.0f },
+};
+
+// g = ( P0, P1, P2, P3 ), сегмент проходит от P1 до P2
+static const float spline_catmull_rom[4][4] = {
+    {  0.0f,  1.0f,  0.0f,  0.0f },
+    { -0.5f,  0.0f,  0.5f,  0.0f },
+    {  1.0f, -2.5f,  2.0f, -0.5f },
+    { -0.5f,  1.5f, -1.5f,  0.5f },
+};
+
+// g = ( P0, P1, T0, T1 ) - концы и касательные в них
+static const float spline_hermite[4][4] = {
+    {  1.0f,  0.0f,  0.0f,  0.0f },
+    {  0.0f,  0.0f,  1.0f,  0.0f },
+    { -3.0f,  3.0f, -2.0f, -1.0f },
+    {  2.0f, -2.0f,  1.0f,  1.0f },
+};
+
+// состояние прямых разностей: f - текущая точка, d1..d3 - разности
+typedef struct {
+    vec4_t          f;
+    vec4_t          d1;
+    vec4_t          d2;
+    vec4_t          d3;
+} splinefd_t;
+
+/*
+SplinePoint
+
+Точка размерности dim, дополненная нулями до vec4_t.
+*/
+static vec4_t SplinePoint( const float* p, int dim ) {
+    return Vec4Make( p[0], dim > 1 ? p[1] : 0.0f, dim > 2 ? p[2] : 0.0f, dim > 3 ? p[3] : 0.0f );
+}
+
+/*
+SplineStore
+
+Запись первых dim компонент точки v в out.
+*/
+static inline void SplineStore( float* out, vec4_t v, int dim ) {
+    // покомпонентно, а не циклом по v.m: иначе v уходит через стек
+    out[0] = v.x;
+    if( dim > 1 ) {
+        out[1] = v.y;
+    }
+    if( dim > 2 ) {
+        out[2] = v.z;
+    }
+    if( dim > 3 ) {
+        out[3] = v.w;
+    }
+}
+
+/*
+SplineFromBasis
+
+Коэффициенты сегмента по базисной матрице и опорным векторам g.
+*/
+static void SplineFromBasis( cubic_t* out, const float basis[4][4], const vec4_t* g ) {
+    for( int i = 0; i < 4; i++ ) {
+        vec4_t c = Vec4Make( 0.0f, 0.0f, 0.0f, 0.0f );
+        for( int j = 0; j < 4; j++ ) {
+            c = Vec4AddVal( c, Vec4Scale1fVal( g[j], basis[i][j] ) );
+        }
+        out->c[i] = c;
+    }
+}
+
+/*
+SplineBezierPath
+
+Составная кривая Безье: сегмент i строится по точкам 3 * i .. 3 * i + 3,
+соседние сегменты имеют общую точку. Возвращает количество сегментов.
+*/
+static int SplineBezierPath( cubic_t* seg, const float* p, int dim, int count ) {
+    int n = count > 0 ? ( count - 1 ) / 3 : 0;
+    for( int i = 0; i < n; i++ ) {
+        vec4_t g[4];
+        for( int j = 0; j < 4; j++ ) {
+            g[j] = SplinePoint( p + ( 3 * i + j ) * dim, dim );
+        }
+        SplineFromBasis( &seg[i], spline_bezier, g );
+    }
+    return n;
+}
+
+/*
+SplineCatmullRomPath
+
+Сплайн Катмулла-Рома через точки p[1] .. p[count - 2]; крайние точки
+задают только касательные. Возвращает количество сегментов.
+*/
+static int SplineCatmullRomPath( cubic_t* seg, const float* p, int dim, int count ) {
+    int n = count > 3 ? count - 3 : 0;
+    for( int i = 0; i < n; i++ ) {
+        vec4_t g[4];
+        for( int j = 0; j < 4; j++ ) {
+            g[j] = SplinePoint( p + ( i + j ) * dim, dim );
+        }
+        SplineFromBasis( &seg[i], spline_catmull_rom, g );
+    }
+    return n;
+}
+
+/*
+SplineHermitePath
+
+Эрмитов сплайн через точки p с касательными t. Возвращает количество сегментов.
+*/
+static int SplineHermitePath( cubic_t* seg, const float* p, const float* t, int dim, int count ) {
+    int n = count > 1 ? count - 1 : 0;
+    for( int i = 0; i < n; i++ ) {
+        vec4_t g[4];
+        g[0] = SplinePoint( p + i * dim, dim );
+        g[1] = SplinePoint( p + ( i + 1 ) * dim, dim );
+        g[2] = SplinePoint( t + i * dim, dim );
+        g[3] = SplinePoint( t + ( i + 1 ) * dim, dim );
+        SplineFromBasis( &seg[i], spline_hermite, g );
+    }
+    return n;
+}
+
+/*
+SplineEvalVal
+
+Точка кривой при параметре u. u ограничивается отрезком [0, num_segments].
+У пустой кривой (num_segments <= 0) возвращается нулевой вектор.
+Сегмент вычисляется по схеме Горнера.
+*/
+static inline vec4_t SplineEvalVal( const cubic_t* seg, int num_segments, float u ) {
+    if( num_segments <= 0 ) {
+        vec4_t zero;
+        Vec4Zero( &zero );
+        return zero;
+    }
+    u = clamp3f( 0.0f, ( float )num_segments, u );
+    int i = ( int )u;
+    if( i > num_segments - 1 ) {
+        i = num_segments - 1;
+    }
+    float t = u - ( float )i;
+    const cubic_t* c = &seg[i];
+
+    vec4_t v = Vec4AddVal( Vec4Scale1fVal( c->c[3], t ), c->c[2] );
+    v = Vec4AddVal( Vec4Scale1fVal( v, t ), c->c[1] );
+    return Vec4AddVal( Vec4Scale1fVal( v, t ), c->c[0] );
+}
+
+// аргументы SplineEvalArray для PoolParallelFor
+typedef struct {
+    float*          out;
+    int             dim;
+    const cubic_t*  seg;
+    int             num_segments;
+    const float*    u;
+} splineeval_t;
+
+static void SplineEvalChunk( void* ctx, int begin, int end ) {
+    const splineeval_t* job = ctx;
+    for( int i = begin; i < end; i++ ) {
+        SplineStore( job->out + i * job->dim, SplineEvalVal( job->seg, job->num_segments, job->u[i] ), job->dim );
+    }
+}
+
+/*
+SplineEvalArray
+
+Точки кривой при count значениях параметра u, чанками между потоками пула.
+У пустой кривой (num_segments <= 0) все точки нулевые.
+*/
+static inline void SplineEvalArray( float* out, int dim, const cubic_t* seg, int num_segments, const float* u, int count ) {
+    splineeval_t job = { out, dim, seg, num_segments, u };
+    PoolParallelFor( SplineEvalChunk, &job, count, PoolChunk( ( dim + 1 ) * sizeof( float ) ) );
+}
+
+/*
+SplineFdInit
+
+Начальные прямые разности сегмента c для шага 1 / steps.
+Далее каждая следующая точка получается тремя сложениями (SplineFdStep).
+*/
+static inline void SplineFdInit( splinefd_t* fd, const cubic_t* c, int steps ) {
+    float h = 1.0f / steps;
+    float h2 = h * h;
+    float h3 = h2 * h;
+    vec4_t a = Vec4Scale1fVal( c->c[3], h3 );
+    vec4_t b = Vec4Scale1fVal( c->c[2], h2 );
+
+    fd->f = c->c[0];
+    fd->d1 = Vec4AddVal( Vec4AddVal( a, b ), Vec4Scale1fVal( c->c[1], h ) );
+    fd->d2 = Vec4AddVal( Vec4Scale1fVal( a, 6.0f ), Vec4Scale1fVal( b, 2.0f ) );
+    fd->d3 = Vec4Scale1fVal( a, 6.0f );
+}
+
+static inline void SplineFdStep( splinefd_t* fd ) {
+    fd->f = Vec4AddVal( fd->f, fd->d1 );
+    fd->d1 = Vec4AddVal( fd->d1, fd->d2 );
+    fd->d2 = Vec4AddVal( fd->d2, fd->d3 );
+}
+
+/*
+SplineTessellate
+
+Разбиение кривой на равные по параметру шаги: steps точек на сегмент
+и конечная точка кривой. Разности пересчитываются в начале каждого
+сегмента, поэтому ошибка округления не накапливается по всей кривой.
+Возвращает количество точек num_segments * steps + 1.
+*/
+static inline int SplineTessellate( float* out, int dim, const cubic_t* seg, int num_segments, int steps ) {
+    int k = 0;
+    if( ( num_segments <= 0 ) || ( steps <= 0 ) ) {
+        return 0;
+    }
+    for( int i = 0; i < num_segments; i++ ) {
+        splinefd_t fd;
+        SplineFdInit( &fd, &seg[i], steps );
+        for( int j = 0; j < steps; j++ ) {
+            SplineStore( out + k * dim, fd.f, dim );
+            SplineFdStep( &fd );
+            k++;
+        }
+    }
+    SplineStore( out + k * dim, SplineEvalVal( seg, num_segments, ( float )num_segments ), dim );
+    return k + 1;
+}
+
+
+
+/*
+Spline2BezierPath
+
+Составная кривая Безье из count точек (3 * n + 1 для n сегментов).
+Возвращает количество сегментов.
+*/
+int Spline2BezierPath( cubic_t* seg, const vec2_t* p, int count ) {
+    return SplineBezierPath( seg, p->m, 2, count );
+}
+
+/*
+Spline2CatmullRomPath
+
+Сплайн Катмулла-Рома через count точек, count - 3 сегмента.
+*/
+int Spline2CatmullRomPath( cubic_t* seg, const vec2_t* p, int count ) {
+    return SplineCatmullRomPath( seg, p->m, 2, count );
+}
+
+/*
+Spline2HermitePath
+
+Эрмитов сплайн через count точек с касательными, count - 1 сегмент.
+*/
+int Spline2HermitePath( cubic_t* seg, const vec2_t* p, const vec2_t* tangents, int count ) {
+    return SplineHermitePath( seg, p->m, tangents->m, 2, count );
+}
+
+/*
+Spline2Eval
+
+Точка кривой при параметре u из [0, num_segments].
+При num_segments <= 0 возвращается нулевой вектор.
+*/
+vec2_t Spline2Eval( const cubic_t* seg, int num_segments, float u ) {
+    vec4_t v = SplineEvalVal( seg, num_segments, u );
+    return Vec2Make( v.x, v.y );
+}
+
+/*
+Spline2EvalArray
+
+Точки кривой при count значениях параметра u.
+При num_segments <= 0 все точки нулевые.
+*/
+void Spline2EvalArray( vec2_t* out, const cubic_t* seg, int num_segments, const float* u, int count ) {
+    SplineEvalArray( out->m, 2, seg, num_segments, u, count );
+}
+
+/*
+Spline2Tessellate
+
+Разбиение кривой прямыми разностями, steps точек на сегмент.
+out должен вмещать num_segments * steps + 1 точек. Возвращает количество точек.
+*/
+int Spline2Tessellate( vec2_t* out, const cubic_t* seg, int num_segments, int steps ) {
+    return SplineTessellate( out->m, 2, seg, num_segments, steps );
+}
+
+/*
+Spline3BezierPath
+
+Составная кривая Безье из count точек (3 * n + 1 для n сегментов).
+Возвращает количество сегментов.
+*/
+int Spline3BezierPath( cubic_t* seg, const vec3_t* p, int count ) {
+    return SplineBezierPath( seg, p->m, 3, count );
+}
+
+/*
+Spline3CatmullRomPath
+
+Сплайн Катмулла-Рома через count точек, count - 3 сегмента.
+*/
+int Spline3CatmullRomPath( cubic_t* seg, const vec3_t* p, int count ) {
+    return SplineCatmullRomPath( seg, p->m, 3, count );
+}
+
+/*
+Spline3HermitePath
+
+Эрмитов сплайн через count точек с касательными, count - 1 сегмент.
+*/
+int Spline3HermitePath( cubic_t* seg, const vec3_t* p, const vec3_t* tangents, int count ) {
+    return SplineHermitePath( seg, p->m, tangents->m, 3, count );
+}
+
+/*
+Spline3Eval
+
+Точка кривой при параметре u из [0, num_segments].
+При num_segments <= 0 возвращается нулевой вектор.
+*/
+vec3_t Spline3Eval( const cubic_t* seg, int num_segments, float u ) {
+    return SplineEvalVal( seg, num_segments, u ).vec3;
+}
+
+/*
+Spline3EvalArray
+
+Точки кривой при count значениях параметра u.
+При num_segments <= 0 все точки нулевые.
+*/
+void Spline3EvalArray( vec3_t* out, const cubic_t* seg, int num_segments, const float* u, int count ) {
+    SplineEvalArray( out->m, 3, seg, num_segments, u, count );
+}
+
+/*
+Spline3Tessellate
+
+Разбиение кривой прямыми разностями, steps точек на сегмент.
+out должен вмещать num_segments * steps + 1 точек. Возвращает количество точек.
+*/
+int Spline3Tessellate( vec3_t* out, const cubic_t* seg, int num_segments, int steps ) {
+    return SplineTessellate( out->m, 3, seg, num_segments, steps );
+}
+
+/*
+Spline4BezierPath
+
+Составная кривая Безье из count точек (3 * n + 1 для n сегментов).
+Возвращает количество сегментов.
+*/
+int Spline4BezierPath( cubic_t* seg, const vec4_t* p, int count ) {
+    return SplineBezierPath( seg, p->m, 4, count );
+}
+
+/*
+Spline4CatmullRomPath
+
+Сплайн Катмулла-Рома через count точек, count - 3 сегмента.
+*/
+int Spline4CatmullRomPath( cubic_t* seg, const vec4_t* p, int count ) {
+    return SplineCatmullRomPath( seg, p->m, 4, count );
+}
+
+/*
+Spline4HermitePath
+
+Эрмитов сплайн через count точек с касательными, count - 1 сегмент.
+*/
+int Spline4HermitePath( cubic_t* seg, const vec4_t* p, const vec4_t* tangents, int count ) {
+    return SplineHermitePath( seg, p->m, tangents->m, 4, count );
+}
+
+/*
+Spline4Eval
+
+Точка кривой при параметре u из [0, num_segments].
+При num_segments <= 0 возвращается нулевой вектор.
+*/
+vec4_t Spline4Eval( const cubic_t* seg, int num_segments, float u ) {
+    return SplineEvalVal( seg, num_segments, u );
+}
+
+/*
+Spline4EvalArray
+
+Точки кривой при count значениях параметра u.
+При num_segments <= 0 все точки нулевые.
+*/
+void Spline4EvalArray( vec4_t* out, const cubic_t* seg, int num_segments, const float* u, int count ) {
+    SplineEvalArray( out->m, 4, seg, num_segments, u, count );
+}
+
+/*
+Spline4Tessellate
+
+Разбиение кривой прямыми разностями, steps точек на сегмент.
+out должен вмещать num_segments * steps + 1 точек. Возвращает количество точек.
+*/
+int Spline4Tessellate( vec4_t* out, const cubic_t* seg, int num_segments, int steps ) {
+    return SplineTessellate( out->m, 4, seg, num_segments, steps );
+}
+
+
+
+/*
+ArcLenInit
+
+Построение таблицы длины дуги: каждый сегмент делится на steps частей
+прямыми разностями, длина накапливается по хордам.
+Возвращает mfalse при нехватке памяти или пустой кривой.
+*/
+mbool_t ArcLenInit( arclen_t* a, const cubic_t* seg, int num_segments, int steps ) {
+    a->count = 0;
+    a->step = 0.0f;
+    a->length = 0.0f;
+    a->dist = NULL;
+    if( ( num_segments <= 0 ) || ( steps <= 0 ) ) {
+        return mfalse;
+    }
+
+    int count = num_segments * steps + 1;
+    a->dist = malloc( count * sizeof( float ) );
+    if( a->dist == NULL ) {
+        return mfalse;
+    }
+
+    // сумма в double: у длинных кривых хорды намного короче всей длины
+    double length = 0.0;
+    int k = 0;
+    a->dist[k++] = 0.0f;
+    for( int i = 0; i < num_segments; i++ ) {
+        splinefd_t fd;
+        SplineFdInit( &fd, &seg[i], steps );
+        for( int j = 0; j < steps; j++ ) {
+            vec4_t prev = fd.f;
+            SplineFdStep( &fd );
+            vec4_t d = Vec4SubVal( fd.f, prev );
+            length += sqrt1f( Vec4DotVal( d, d ) );
+            a->dist[k++] = ( float )length;
+        }
+    }
+
+    a->count = count;
+    a->step = 1.0f / steps;
+    a->length = ( float )length;
+    return mtrue;
+}
+
+/*
+ArcLenRelease
+
+Освобождение памяти таблицы.
+*/
+void ArcLenRelease( arclen_t* a ) {
+    free( a->dist );
+    a->dist = NULL;
+    a->count = 0;
+    a->length = 0.0f;
+}
+
+/*
+ArcLenLerp
+
+Параметр u для расстояния s внутри отрезка таблицы [i, i + 1].
+*/
+static inline float ArcLenLerp( const arclen_t* a, int i, float s ) {
+    float d = a->dist[i + 1] - a->dist[i];
+    float f = d > 0.0f ? ( s - a->dist[i] ) / d : 0.0f;
+    return ( i + f ) * a->step;
+}
+
+/*
+ArcLenParam
+
+Параметр кривой u, на котором пройдено расстояние s от начала.
+Поиск по таблице двоичный, между отсчётами - линейная интерполяция.
+Для пустой таблицы (ArcLenInit не удался) возвращает 0 - начало кривой.
+*/
+float ArcLenParam( const arclen_t* a, float s ) {
+    if( a->count < 2 ) {
+        return 0.0f;
+    }
+    s = clamp3f( 0.0f, a->length, s );
+    int lo = 0;
+    int hi = a->count - 1;
+    while( hi - lo > 1 ) {
+        int mid = ( lo + hi ) / 2;
+        if( a->dist[mid] <= s ) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return ArcLenLerp( a, lo, s );
+}
+
+/*
+ArcLenUniform
+
+count значений параметра u, разбивающих кривую на равные по длине части
+(первое - начало кривой, последнее - конец). Расстояния растут, поэтому
+таблица проходится один раз без поиска. Для пустой таблицы все значения - 0.
+*/
+void ArcLenUniform( float* u, const arclen_t* a, int count ) {
+    if( count <= 0 ) {
+        return;
+    }
+    if( ( count == 1 ) || ( a->count < 2 ) ) {
+        for( int k = 0; k < count; k++ ) {
+            u[k] = 0.0f;
+        }
+        return;
+    }
+
+    float ds = a->length / ( count - 1 );
+    int i = 0;
+    for( int k = 0; k < count; k++ ) {
+        float s = min2f( k * ds, a->length );
+        while( ( i < a->count - 2 ) && ( a->dist[i + 1] <= s ) ) {
+            i++;
+        }
+        u[k] = ArcLenLerp( a, i, s );
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef __SPLINE_H__
+#define __SPLINE_H__
+
+#include "vector.h"
+
+/*
+Кубический сегмент кривой в степенном базисе:
+p( t ) = c[0] + c[1] * t + c[2] * t^2 + c[3] * t^3, t в [0, 1].
+Коэффициенты хранятся как vec4_t для кривых любой размерности,
+у кривых на плоскости и в пространстве лишние компоненты равны нулю.
+
+Кривая из n сегментов задаётся массивом cubic_t, параметр кривой u
+лежит в [0, n]: целая часть - номер сегмента, дробная - t.
+У пустой кривой (n = 0) функции Eval дают нулевые точки.
+*/
+typedef struct {
+    vec4_t          c[4];
+} cubic_t;
+
+// таблица длины дуги для перехода от пройденного расстояния к параметру u
+typedef struct {
+    int             count;      // количество отсчётов
+    float           step;       // шаг параметра u между отсчётами
+    float           length;     // длина всей кривой
+    float*          dist;       // длина дуги от начала до каждого отсчёта
+} arclen_t;
+
+
+int         Spline2BezierPath( cubic_t* seg, const vec2_t* p, int count );
+int         Spline2CatmullRomPath( cubic_t* seg, const vec2_t* p, int count );
+int         Spline2HermitePath( cubic_t* seg, const vec2_t* p, const vec2_t* tangents, int count );
+vec2_t      Spline2Eval( const cubic_t* seg, int num_segments, float u );
+void        Spline2EvalArray( vec2_t* out, const cubic_t* seg, int num_segments, const float* u, int count );
+int         Spline2Tessellate( vec2_t* out, const cubic_t* seg, int num_segments, int steps );
+
+int         Spline3BezierPath( cubic_t* seg, const vec3_t* p, int count );
+int         Spline3CatmullRomPath( cubic_t* seg, const vec3_t* p, int count );
+int         Spline3HermitePath( cubic_t* seg, const vec3_t* p, const vec3_t* tangents, int count );
+vec3_t      Spline3Eval( const cubic_t* seg, int num_segments, float u );
+void        Spline3EvalArray( vec3_t* out, const cubic_t* seg, int num_segments, const float* u, int count );
+int         Spline3Tessellate( vec3_t* out, const cubic_t* seg, int num_segments, int steps );
+
+int         Spline4BezierPath( cubic_t* seg, const vec4_t* p, int count );
+int         Spline4CatmullRomPath( cubic_t* seg, const vec4_t* p, int count );
+int         Spline4HermitePath( cubic_t* seg, const vec4_t* p, const vec4_t* tangents, int count );
+vec4_t      Spline4Eval( const cubic_t* seg, int num_segments, float u );
+void        Spline4EvalArray( vec4_t* out, const cubic_t* seg, int num_segments, const float* u, int count );
+int         Spline4Tessellate( vec4_t* out, const cubic_t* seg, int num_segments, int steps );
+
+mbool_t     ArcLenInit( arclen_t* a, const cubic_t* seg, int num_segments, int steps );
+void        ArcLenRelease( arclen_t* a );
+float       ArcLenParam( const arclen_t* a, float s );
+void        ArcLenUniform( float* u, const arclen_t* a, int count );
+
+
+
+#endif //__SPLINE_H__
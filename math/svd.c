@@ -0,0 +1,460 @@
+#include "svd.h"
+#include "lane.h"
+#include "pool.h"
+
+/*
+Ядро разложения записано один раз через операции над полосой lanef_t:
+при сборке с AVX полоса содержит 8 матриц, с SSE - 4, без них - одну.
+Количество итераций фиксировано, а выбор между значениями делается
+маской (LaneSel), поэтому все матрицы полосы проходят одни и те же команды.
+
+Внедиагональные элементы в ходе итераций уходят в денормализованные
+числа, которые замедляют SIMD-команды в разы, поэтому на время
+разложения включается сброс денормализованных чисел в ноль.
+*/
+
+#define SVD_SWEEPS      5               // проходов Якоби по трём парам (4 дают ошибку ~1e-4 на плохо обусловленных)
+#define SVD_GAMMA       5.828427124f    // 3 + 2 * sqrt( 2 )
+#define SVD_CSTAR       0.923879532f    // cos( pi / 8 )
+#define SVD_SSTAR       0.382683432f    // sin( pi / 8 )
+#define SVD_TINY        1e-24f          // квадрат длины, ниже которого вращение QR не строится
+
+/*
+SvdRotCols
+
+Умножение матрицы m справа на вращение в плоскости ( p, q ):
+столбцы p и q заменяются на c * p + s * q и c * q - s * p.
+*/
+static inline void SvdRotCols( lanef_t* m, int p, int q, lanef_t c, lanef_t s ) {
+    for( int i = 0; i < 3; i++ ) {
+        lanef_t mp = m[i * 3 + p];
+        lanef_t mq = m[i * 3 + q];
+        m[i * 3 + p] = LaneAdd( LaneMul( c, mp ), LaneMul( s, mq ) );
+        m[i * 3 + q] = LaneSub( LaneMul( c, mq ), LaneMul( s, mp ) );
+    }
+}
+
+/*
+SvdRotRows
+
+Умножение матрицы m слева на транспонированное вращение в плоскости ( p, q ).
+*/
+static inline void SvdRotRows( lanef_t* m, int p, int q, lanef_t c, lanef_t s ) {
+    for( int j = 0; j < 3; j++ ) {
+        lanef_t mp = m[p * 3 + j];
+        lanef_t mq = m[q * 3 + j];
+        m[p * 3 + j] = LaneAdd( LaneMul( c, mp ), LaneMul( s, mq ) );
+        m[q * 3 + j] = LaneSub( LaneMul( c, mq ), LaneMul( s, mp ) );
+    }
+}
+
+/*
+SvdJacobi
+
+Шаг Якоби для симметричной матрицы s в плоскости ( p, q ) с накоплением
+вращений в v. Угол берётся по приближённой формуле половинного угла
+без тригонометрии; если она неточна, вращение делается на pi / 4.
+*/
+static inline void SvdJacobi( lanef_t* s, lanef_t* v, int p, int q ) {
+    lanef_t ch = LaneMul( LaneSet1( 2.0f ), LaneSub( s[p * 3 + p], s[q * 3 + q] ) );
+    lanef_t sh = s[p * 3 + q];
+    lanef_t ch2 = LaneMul( ch, ch );
+    lanef_t sh2 = LaneMul( sh, sh );
+    lanef_t approx = LaneLt( LaneMul( LaneSet1( SVD_GAMMA ), sh2 ), ch2 );
+    lanef_t w = LaneRsqrt( LaneAdd( ch2, sh2 ) );
+    ch = LaneSel( approx, LaneMul( w, ch ), LaneSet1( SVD_CSTAR ) );
+    sh = LaneSel( approx, LaneMul( w, sh ), LaneSet1( SVD_SSTAR ) );
+
+    // ( ch, sh ) - половинный угол, переход к полному
+    lanef_t c = LaneSub( LaneMul( ch, ch ), LaneMul( sh, sh ) );
+    lanef_t sn = LaneMul( LaneSet1( 2.0f ), LaneMul( ch, sh ) );
+
+    SvdRotCols( s, p, q, c, sn );
+    SvdRotRows( s, p, q, c, sn );
+    SvdRotCols( v, p, q, c, sn );
+}
+
+/*
+SvdSwapCols
+
+Перестановка столбцов i и j матрицы m там, где задана маска swap.
+Один из столбцов меняет знак, чтобы определитель m не изменился.
+*/
+static inline void SvdSwapCols( lanef_t* m, lanef_t swap, int i, int j ) {
+    lanef_t zero = LaneSet1( 0.0f );
+    for( int r = 0; r < 3; r++ ) {
+        lanef_t mi = m[r * 3 + i];
+        lanef_t mj = m[r * 3 + j];
+        m[r * 3 + i] = LaneSel( swap, mj, mi );
+        m[r * 3 + j] = LaneSel( swap, LaneSub( zero, mi ), mj );
+    }
+}
+
+/*
+SvdCondSwap
+
+Упорядочивание пары ключей key[i] >= key[j] с перестановкой столбцов
+i и j матриц b (может быть NULL) и v.
+*/
+static inline void SvdCondSwap( lanef_t* b, lanef_t* v, lanef_t* key, int i, int j ) {
+    lanef_t swap = LaneLt( key[i], key[j] );
+    if( b != NULL ) {
+        SvdSwapCols( b, swap, i, j );
+    }
+    SvdSwapCols( v, swap, i, j );
+
+    lanef_t ki = key[i];
+    key[i] = LaneSel( swap, key[j], ki );
+    key[j] = LaneSel( swap, ki, key[j] );
+}
+
+/*
+SvdGivens
+
+Вращение Гивенса, обнуляющее b[q][p] по ведущему элементу b[p][p],
+с накоплением в u.
+*/
+static inline void SvdGivens( lanef_t* b, lanef_t* u, int p, int q ) {
+    lanef_t a0 = b[p * 3 + p];
+    lanef_t a1 = b[q * 3 + p];
+    lanef_t r2 = LaneAdd( LaneMul( a0, a0 ), LaneMul( a1, a1 ) );
+    lanef_t small = LaneLt( r2, LaneSet1( SVD_TINY ) );
+    lanef_t w = LaneRsqrt( r2 );
+    lanef_t c = LaneSel( small, LaneSet1( 1.0f ), LaneMul( w, a0 ) );
+    lanef_t sn = LaneSel( small, LaneSet1( 0.0f ), LaneMul( w, a1 ) );
+
+    SvdRotRows( b, p, q, c, sn );
+    SvdRotCols( u, p, q, c, sn );
+}
+
+/*
+SvdKernel
+
+Разложение полосы матриц a: a = u * diag( s ) * v^T.
+1. Собственные векторы a^T * a методом Якоби - матрица v.
+2. b = a * v, столбцы b упорядочиваются по убыванию длины.
+3. QR-разложение b вращениями Гивенса: b = u * r, диагональ r - s.
+*/
+static void SvdKernel( lanef_t* u, lanef_t* s, lanef_t* v, const lanef_t* a ) {
+    lanef_t ata[9];
+    lanef_t b[9];
+    lanef_t len[3];
+
+    for( int i = 0; i < 3; i++ ) {
+        for( int j = 0; j < 3; j++ ) {
+            ata[i * 3 + j] = LaneAdd( LaneAdd( LaneMul( a[i], a[j] ), LaneMul( a[3 + i], a[3 + j] ) ),
+                                     LaneMul( a[6 + i], a[6 + j] ) );
+            v[i * 3 + j] = LaneSet1( i == j ? 1.0f : 0.0f );
+            u[i * 3 + j] = v[i * 3 + j];
+        }
+    }
+
+    for( int sweep = 0; sweep < SVD_SWEEPS; sweep++ ) {
+        SvdJacobi( ata, v, 0, 1 );
+        SvdJacobi( ata, v, 0, 2 );
+        SvdJacobi( ata, v, 1, 2 );
+    }
+
+    for( int i = 0; i < 3; i++ ) {
+        for( int j = 0; j < 3; j++ ) {
+            b[i * 3 + j] = LaneAdd( LaneAdd( LaneMul( a[i * 3], v[j] ), LaneMul( a[i * 3 + 1], v[3 + j] ) ),
+                                   LaneMul( a[i * 3 + 2], v[6 + j] ) );
+        }
+    }
+
+    for( int j = 0; j < 3; j++ ) {
+        len[j] = LaneAdd( LaneAdd( LaneMul( b[j], b[j] ), LaneMul( b[3 + j], b[3 + j] ) ), LaneMul( b[6 + j], b[6 + j] ) );
+    }
+    SvdCondSwap( b, v, len, 0, 1 );
+    SvdCondSwap( b, v, len, 0, 2 );
+    SvdCondSwap( b, v, len, 1, 2 );
+
+    SvdGivens( b, u, 0, 1 );
+    SvdGivens( b, u, 0, 2 );
+    SvdGivens( b, u, 1, 2 );
+
+    s[0] = b[0];
+    s[1] = b[4];
+    s[2] = b[8];
+}
+
+/*
+SvdEigenKernel
+
+Собственные значения val (по убыванию) и собственные векторы - столбцы
+поворота vec - полосы симметричных матриц s. s портится.
+*/
+static void SvdEigenKernel( lanef_t* val, lanef_t* vec, lanef_t* s ) {
+    for( int i = 0; i < 9; i++ ) {
+        vec[i] = LaneSet1( i % 4 == 0 ? 1.0f : 0.0f );
+    }
+
+    for( int sweep = 0; sweep < SVD_SWEEPS; sweep++ ) {
+        SvdJacobi( s, vec, 0, 1 );
+        SvdJacobi( s, vec, 0, 2 );
+        SvdJacobi( s, vec, 1, 2 );
+    }
+
+    val[0] = s[0];
+    val[1] = s[4];
+    val[2] = s[8];
+    SvdCondSwap( NULL, vec, val, 0, 1 );
+    SvdCondSwap( NULL, vec, val, 0, 2 );
+    SvdCondSwap( NULL, vec, val, 1, 2 );
+}
+
+/*
+SvdGather
+
+Загрузка n <= LANE_WIDTH матриц в полосу. Незанятые места заполняются
+единичной матрицей, чтобы в них не появлялись NaN.
+*/
+static void SvdGather( lanef_t* a, const mat3_t* m, int n ) {
+    float buf[9][LANE_WIDTH];
+    for( int l = 0; l < LANE_WIDTH; l++ ) {
+        for( int k = 0; k < 9; k++ ) {
+            buf[k][l] = l < n ? m[l].m[k] : ( k % 4 == 0 ? 1.0f : 0.0f );
+        }
+    }
+    for( int k = 0; k < 9; k++ ) {
+        a[k] = LaneLoad( buf[k] );
+    }
+}
+
+/*
+SvdScatter
+
+Выгрузка полосы из count значений в buf[count][LANE_WIDTH].
+*/
+static void SvdScatter( float buf[][LANE_WIDTH], const lanef_t* a, int count ) {
+    for( int k = 0; k < count; k++ ) {
+        LaneStore( buf[k], a[k] );
+    }
+}
+
+/*
+Mat3Svd
+
+Сингулярное разложение матрицы m.
+*/
+void Mat3Svd( svd3_t* out, const mat3_t* m ) {
+    Mat3SvdArray( out, m, 1 );
+}
+
+// аргументы пакетных разложений для PoolParallelFor
+typedef struct {
+    void*           out;
+    mat3_t*         s;
+    const mat3_t*   m;
+} svdjob_t;
+
+// чанк [begin, end) для Mat3SvdArray, выполняется в потоке пула
+static void SvdArrayChunk( void* ctx, int begin, int end ) {
+    const svdjob_t* job = ctx;
+    svd3_t* out = job->out;
+    const mat3_t* m = job->m;
+    unsigned int csr = LaneFtzBegin();
+    for( int i = begin; i < end; i += LANE_WIDTH ) {
+        int n = end - i < LANE_WIDTH ? end - i : LANE_WIDTH;
+        lanef_t a[9], u[9], s[3], v[9];
+        float bu[9][LANE_WIDTH], bs[3][LANE_WIDTH], bv[9][LANE_WIDTH];
+
+        SvdGather( a, &m[i], n );
+        SvdKernel( u, s, v, a );
+        SvdScatter( bu, u, 9 );
+        SvdScatter( bs, s, 3 );
+        SvdScatter( bv, v, 9 );
+
+        for( int l = 0; l < n; l++ ) {
+            svd3_t* o = &out[i + l];
+            for( int k = 0; k < 9; k++ ) {
+                o->u.m[k] = bu[k][l];
+                o->v.m[k] = bv[k][l];
+            }
+            Vec3Set( &o->s, bs[0][l], bs[1][l], bs[2][l] );
+        }
+    }
+    LaneFtzEnd( csr );
+}
+
+/*
+Mat3SvdArray
+
+Сингулярное разложение count матриц. Матрицы обрабатываются
+группами по LANE_WIDTH без ветвлений внутри группы, большие массивы
+делятся на чанки между потоками пула.
+*/
+void Mat3SvdArray( svd3_t* out, const mat3_t* m, int count ) {
+    svdjob_t job = { out, NULL, m };
+    MATH_METRIC( MATH_METRIC_MAT3_SVD, count, 0 );
+    PoolParallelFor( SvdArrayChunk, &job, count, PoolChunk( sizeof( mat3_t ) + sizeof( svd3_t ) ) );
+}
+
+/*
+Mat3Polar
+
+Полярное разложение m = r * s, где r - поворот, s - симметричная матрица.
+s может быть NULL.
+*/
+void Mat3Polar( mat3_t* r, mat3_t* s, const mat3_t* m ) {
+    Mat3PolarArray( r, s, m, 1 );
+}
+
+// чанк [begin, end) для Mat3PolarArray, выполняется в потоке пула
+static void SvdPolarChunk( void* ctx, int begin, int end ) {
+    const svdjob_t* job = ctx;
+    mat3_t* r = job->out;
+    mat3_t* s = job->s;
+    const mat3_t* m = job->m;
+    unsigned int csr = LaneFtzBegin();
+    for( int i = begin; i < end; i += LANE_WIDTH ) {
+        int n = end - i < LANE_WIDTH ? end - i : LANE_WIDTH;
+        lanef_t a[9], u[9], sv[3], v[9], rot[9], sym[9];
+        float br[9][LANE_WIDTH], bs[9][LANE_WIDTH];
+
+        SvdGather( a, &m[i], n );
+        SvdKernel( u, sv, v, a );
+
+        for( int p = 0; p < 3; p++ ) {
+            for( int q = 0; q < 3; q++ ) {
+                rot[p * 3 + q] = LaneAdd( LaneAdd( LaneMul( u[p * 3], v[q * 3] ), LaneMul( u[p * 3 + 1], v[q * 3 + 1] ) ),
+                                         LaneMul( u[p * 3 + 2], v[q * 3 + 2] ) );
+                sym[p * 3 + q] = LaneAdd( LaneAdd( LaneMul( LaneMul( v[p * 3], sv[0] ), v[q * 3] ),
+                                                 LaneMul( LaneMul( v[p * 3 + 1], sv[1] ), v[q * 3 + 1] ) ),
+                                         LaneMul( LaneMul( v[p * 3 + 2], sv[2] ), v[q * 3 + 2] ) );
+            }
+        }
+        SvdScatter( br, rot, 9 );
+        SvdScatter( bs, sym, 9 );
+
+        for( int l = 0; l < n; l++ ) {
+            for( int k = 0; k < 9; k++ ) {
+                r[i + l].m[k] = br[k][l];
+            }
+            if( s != NULL ) {
+                for( int k = 0; k < 9; k++ ) {
+                    s[i + l].m[k] = bs[k][l];
+                }
+            }
+        }
+    }
+    LaneFtzEnd( csr );
+}
+
+/*
+Mat3PolarArray
+
+Полярное разложение count матриц через SVD: r = u * v^T, s = v * diag( s ) * v^T.
+r всегда поворот (определитель +1): для матриц с отражением
+отрицательное собственное значение остаётся в s.
+s может быть NULL. r или s могут совпадать с m.
+*/
+void Mat3PolarArray( mat3_t* r, mat3_t* s, const mat3_t* m, int count ) {
+    svdjob_t job = { r, s, m };
+    MATH_METRIC( MATH_METRIC_MAT3_POLAR, count, 0 );
+    PoolParallelFor( SvdPolarChunk, &job, count, PoolChunk( 3 * sizeof( mat3_t ) ) );
+}
+
+/*
+Mat3SymEigen
+
+Собственные значения и собственные векторы симметричной матрицы m.
+*/
+void Mat3SymEigen( eigen3_t* out, const mat3_t* m ) {
+    Mat3SymEigenArray( out, m, 1 );
+}
+
+// чанк [begin, end) для Mat3SymEigenArray, выполняется в потоке пула
+static void SvdEigenChunk( void* ctx, int begin, int end ) {
+    const svdjob_t* job = ctx;
+    eigen3_t* out = job->out;
+    const mat3_t* m = job->m;
+    unsigned int csr = LaneFtzBegin();
+    for( int i = begin; i < end; i += LANE_WIDTH ) {
+        int n = end - i < LANE_WIDTH ? end - i : LANE_WIDTH;
+        lanef_t a[9], val[3], vec[9];
+        float bval[3][LANE_WIDTH], bvec[9][LANE_WIDTH];
+
+        SvdGather( a, &m[i], n );
+        SvdEigenKernel( val, vec, a );
+        SvdScatter( bval, val, 3 );
+        SvdScatter( bvec, vec, 9 );
+
+        for( int l = 0; l < n; l++ ) {
+            eigen3_t* o = &out[i + l];
+            for( int k = 0; k < 9; k++ ) {
+                o->vectors.m[k] = bvec[k][l];
+            }
+            Vec3Set( &o->values, bval[0][l], bval[1][l], bval[2][l] );
+        }
+    }
+    LaneFtzEnd( csr );
+}
+
+/*
+Mat3SymEigenArray
+
+Собственные значения и собственные векторы count симметричных матриц
+(например, тензоров инерции или матриц ковариации).
+Матрицы обрабатываются группами по LANE_WIDTH без ветвлений внутри группы.
+*/
+void Mat3SymEigenArray( eigen3_t* out, const mat3_t* m, int count ) {
+    svdjob_t job = { out, NULL, m };
+    MATH_METRIC( MATH_METRIC_MAT3_EIGEN, count, 0 );
+    PoolParallelFor( SvdEigenChunk, &job, count, PoolChunk( sizeof( mat3_t ) + sizeof( eigen3_t ) ) );
+}
+
+/*
+Mat3Covariance
+
+Матрица ковариации count точек p за один проход по массиву.
+Суммы считаются в double относительно первой точки, чтобы далёкие
+от начала координат облака не теряли точность при вычитании.
+mean (может быть NULL) получает центр точек.
+*/
+void Mat3Covariance( mat3_t* cov, vec3_t* mean, const vec3_t* p, int count ) {
+    double s[3] = { 0.0, 0.0, 0.0 };
+    double ss[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+    Mat3Zero( cov );
+    if( count <= 0 ) {
+        if( mean != NULL ) {
+            Vec3Zero( mean );
+        }
+        return;
+    }
+
+    vec3_t k = p[0];
+    for( int i = 0; i < count; i++ ) {
+        double dx = ( double )p[i].x - k.x;
+        double dy = ( double )p[i].y - k.y;
+        double dz = ( double )p[i].z - k.z;
+        s[0] += dx;
+        s[1] += dy;
+        s[2] += dz;
+        ss[0] += dx * dx;
+        ss[1] += dx * dy;
+        ss[2] += dx * dz;
+        ss[3] += dy * dy;
+        ss[4] += dy * dz;
+        ss[5] += dz * dz;
+    }
+
+    double inv = 1.0 / count;
+    double mx = s[0] * inv;
+    double my = s[1] * inv;
+    double mz = s[2] * inv;
+    float xx = ( float )( ss[0] * inv - mx * mx );
+    float xy = ( float )( ss[1] * inv - mx * my );
+    float xz = ( float )( ss[2] * inv - mx * mz );
+    float yy = ( float )( ss[3] * inv - my * my );
+    float yz = ( float )( ss[4] * inv - my * mz );
+    float zz = ( float )( ss[5] * inv - mz * mz );
+    Mat3Set9f( cov, xx, xy, xz,
+                    xy, yy, yz,
+                    xz, yz, zz );
+
+    if( mean != NULL ) {
+        Vec3Set( mean, ( float )( k.x + mx ), ( float )( k.y + my ), ( float )( k.z + mz ) );
+    }
+}
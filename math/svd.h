@@ -0,0 +1,40 @@
+#ifndef __SVD_H__
+#define __SVD_H__
+
+#include "matrix.h"
+
+/*
+Сингулярное разложение матрицы 3-го порядка: A = U * diag( s ) * V^T.
+U и V - матрицы поворота (определитель +1), s.x >= s.y >= |s.z|.
+Если определитель A отрицательный, отрицательным будет s.z, а не U или V,
+поэтому U * V^T всегда остаётся поворотом.
+*/
+typedef struct {
+    mat3_t          u;
+    vec3_t          s;
+    mat3_t          v;
+} svd3_t;
+
+/*
+Собственные значения симметричной матрицы 3-го порядка по убыванию
+и соответствующие им собственные векторы - столбцы матрицы поворота vectors.
+*/
+typedef struct {
+    vec3_t          values;
+    mat3_t          vectors;
+} eigen3_t;
+
+
+void        Mat3Svd( svd3_t* out, const mat3_t* m );
+void        Mat3SvdArray( svd3_t* out, const mat3_t* m, int count );
+
+void        Mat3Polar( mat3_t* r, mat3_t* s, const mat3_t* m );
+void        Mat3PolarArray( mat3_t* r, mat3_t* s, const mat3_t* m, int count );
+
+void        Mat3SymEigen( eigen3_t* out, const mat3_t* m );
+void        Mat3SymEigenArray( eigen3_t* out, const mat3_t* m, int count );
+void        Mat3Covariance( mat3_t* cov, vec3_t* mean, const vec3_t* p, int count );
+
+
+
+#endif //__SVD_H__
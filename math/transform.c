@@ -0,0 +1,607 @@
+#include "transform.h"
+#include "value.h"
+#include "pool.h"
+
+#if defined( _MSC_VER )
+#include <windows.h>
+#endif
+
+// допуск ортонормированности при распознавании поворота
+static const float XFORM_RIGID_EPS = 1e-5f;
+
+/*
+XformSetAffineRow
+
+Нижняя строка аффинного преобразования ( 0 0 0 1 ).
+*/
+static void XformSetAffineRow( mat4_t* m ) {
+    m->m[12] = 0.0f;
+    m->m[13] = 0.0f;
+    m->m[14] = 0.0f;
+    m->m[15] = 1.0f;
+}
+
+/*
+XformMulScaleTranslate
+
+Произведение двух преобразований вида s * E + t.
+*/
+static void XformMulScaleTranslate( mat4_t* out, const mat4_t* a, const mat4_t* b ) {
+    float sa = a->m[0];
+    float s = sa * b->m[0];
+    float tx = sa * b->m[3]  + a->m[3];
+    float ty = sa * b->m[7]  + a->m[7];
+    float tz = sa * b->m[11] + a->m[11];
+
+    Mat4Ident( out );
+    out->m[0]  = s;
+    out->m[5]  = s;
+    out->m[10] = s;
+    out->m[3]  = tx;
+    out->m[7]  = ty;
+    out->m[11] = tz;
+}
+
+/*
+XformMulAffine
+
+Произведение двух аффинных преобразований.
+Нижняя строка не участвует в вычислениях: 36 умножений вместо 64.
+*/
+static void XformMulAffine( mat4_t* out, const mat4_t* a, const mat4_t* b ) {
+    mat4_t buf;
+    for( int i = 0; i < 3; i++ ) {
+        const float* r = &a->m[i * 4];
+        buf.m[i * 4 + 0] = r[0] * b->m[0] + r[1] * b->m[4] + r[2] * b->m[8];
+        buf.m[i * 4 + 1] = r[0] * b->m[1] + r[1] * b->m[5] + r[2] * b->m[9];
+        buf.m[i * 4 + 2] = r[0] * b->m[2] + r[1] * b->m[6] + r[2] * b->m[10];
+        buf.m[i * 4 + 3] = r[0] * b->m[3] + r[1] * b->m[7] + r[2] * b->m[11] + r[3];
+    }
+    XformSetAffineRow( &buf );
+    *out = buf;
+}
+
+/*
+XformKindMul
+
+Вид произведения преобразований вида a и b.
+Результат - верхняя оценка: произведение может оказаться проще.
+*/
+xformkind_t XformKindMul( xformkind_t a, xformkind_t b ) {
+    if( a == XFORM_IDENTITY ) {
+        return b;
+    }
+    if( b == XFORM_IDENTITY ) {
+        return a;
+    }
+    if( ( a == XFORM_PROJECTIVE ) || ( b == XFORM_PROJECTIVE ) ) {
+        return XFORM_PROJECTIVE;
+    }
+    if( ( a <= XFORM_UNIFORM_SCALE ) && ( b <= XFORM_UNIFORM_SCALE ) ) {
+        return a > b ? a : b;
+    }
+    // поворот с переносом остаётся движением, с масштабом - уже нет
+    if( ( ( a == XFORM_RIGID ) && ( b <= XFORM_TRANSLATION ) ) ||
+        ( ( b == XFORM_RIGID ) && ( a <= XFORM_TRANSLATION ) ) ||
+        ( ( a == XFORM_RIGID ) && ( b == XFORM_RIGID ) ) ) {
+        return XFORM_RIGID;
+    }
+    return XFORM_AFFINE;
+}
+
+/*
+XformIdent
+
+Установка единичного преобразования.
+*/
+void XformIdent( xform_t* x ) {
+    Mat4Ident( &x->m );
+    x->kind = XFORM_IDENTITY;
+}
+
+/*
+XformTranslate
+
+Установка переноса на вектор t.
+*/
+void XformTranslate( xform_t* x, const vec3_t* t ) {
+    Mat4Ident( &x->m );
+    x->m.m[3]  = t->x;
+    x->m.m[7]  = t->y;
+    x->m.m[11] = t->z;
+    x->kind = XFORM_TRANSLATION;
+}
+
+/*
+XformScale
+
+Установка равномерного масштаба s.
+*/
+void XformScale( xform_t* x, float s ) {
+    Mat4Ident( &x->m );
+    x->m.m[0]  = s;
+    x->m.m[5]  = s;
+    x->m.m[10] = s;
+    x->kind = XFORM_UNIFORM_SCALE;
+}
+
+/*
+XformRotate
+
+Установка поворота на угол angle (в радианах) вокруг оси axis.
+Ось axis не обязана быть нормализованной.
+*/
+void XformRotate( xform_t* x, const vec3_t* axis, float angle ) {
+    float len = sqrt1f( sqr1f( axis->x ) + sqr1f( axis->y ) + sqr1f( axis->z ) );
+    if( len == 0.0f ) {
+        XformIdent( x );
+        return;
+    }
+    float ax = axis->x / len;
+    float ay = axis->y / len;
+    float az = axis->z / len;
+
+    float s, c;
+    sincosf( angle, &s, &c );
+    float t = 1.0f - c;
+
+    Mat4Set16f( &x->m, t * ax * ax + c,      t * ax * ay - s * az, t * ax * az + s * ay, 0.0f,
+                       t * ax * ay + s * az, t * ay * ay + c,      t * ay * az - s * ax, 0.0f,
+                       t * ax * az - s * ay, t * ay * az + s * ax, t * az * az + c,      0.0f,
+                       0.0f,                 0.0f,                 0.0f,                 1.0f );
+    x->kind = XFORM_RIGID;
+}
+
+/*
+XformFromMat4
+
+Установка преобразования из матрицы m с определением его вида.
+Проверка выполняется один раз, дальше вид поддерживается операциями.
+*/
+void XformFromMat4( xform_t* x, const mat4_t* m ) {
+    x->m = *m;
+
+    if( ( m->m[12] != 0.0f ) || ( m->m[13] != 0.0f ) ||
+        ( m->m[14] != 0.0f ) || ( m->m[15] != 1.0f ) ) {
+        x->kind = XFORM_PROJECTIVE;
+        return;
+    }
+
+    if( ( m->m[1] == 0.0f ) && ( m->m[2] == 0.0f ) && ( m->m[4] == 0.0f ) &&
+        ( m->m[6] == 0.0f ) && ( m->m[8] == 0.0f ) && ( m->m[9] == 0.0f ) &&
+        ( m->m[0] == m->m[5] ) && ( m->m[0] == m->m[10] ) ) {
+        if( m->m[0] != 1.0f ) {
+            x->kind = XFORM_UNIFORM_SCALE;
+        }
+        else if( ( m->m[3] != 0.0f ) || ( m->m[7] != 0.0f ) || ( m->m[11] != 0.0f ) ) {
+            x->kind = XFORM_TRANSLATION;
+        }
+        else {
+            x->kind = XFORM_IDENTITY;
+        }
+        return;
+    }
+
+    // строки 3x3 части ортонормированы и образуют правую тройку - поворот
+    const float* r0 = &m->m[0];
+    const float* r1 = &m->m[4];
+    const float* r2 = &m->m[8];
+    float d00 = r0[0] * r0[0] + r0[1] * r0[1] + r0[2] * r0[2];
+    float d11 = r1[0] * r1[0] + r1[1] * r1[1] + r1[2] * r1[2];
+    float d22 = r2[0] * r2[0] + r2[1] * r2[1] + r2[2] * r2[2];
+    float d01 = r0[0] * r1[0] + r0[1] * r1[1] + r0[2] * r1[2];
+    float d02 = r0[0] * r2[0] + r0[1] * r2[1] + r0[2] * r2[2];
+    float d12 = r1[0] * r2[0] + r1[1] * r2[1] + r1[2] * r2[2];
+    float det = r0[0] * ( r1[1] * r2[2] - r1[2] * r2[1] )
+              + r0[1] * ( r1[2] * r2[0] - r1[0] * r2[2] )
+              + r0[2] * ( r1[0] * r2[1] - r1[1] * r2[0] );
+
+    if( ( abs1f( d00 - 1.0f ) <= XFORM_RIGID_EPS ) && ( abs1f( d11 - 1.0f ) <= XFORM_RIGID_EPS ) &&
+        ( abs1f( d22 - 1.0f ) <= XFORM_RIGID_EPS ) && ( abs1f( d01 ) <= XFORM_RIGID_EPS ) &&
+        ( abs1f( d02 ) <= XFORM_RIGID_EPS ) && ( abs1f( d12 ) <= XFORM_RIGID_EPS ) && ( det > 0.0f ) ) {
+        x->kind = XFORM_RIGID;
+        return;
+    }
+
+    x->kind = XFORM_AFFINE;
+}
+
+/*
+XformSetMat4
+
+Установка преобразования из матрицы m с заранее известным видом kind.
+Вид не проверяется.
+*/
+void XformSetMat4( xform_t* x, const mat4_t* m, xformkind_t kind ) {
+    x->m = *m;
+    x->kind = kind;
+}
+
+/*
+XformMul
+
+Произведение преобразований a и b (сначала применяется b, затем a).
+Для каждого сочетания видов выбирается самое дешёвое вычисление.
+out может совпадать с a или b.
+*/
+void XformMul( xform_t* out, const xform_t* a, const xform_t* b ) {
+    xformkind_t kind = XformKindMul( a->kind, b->kind );
+
+    if( a->kind == XFORM_IDENTITY ) {
+        *out = *b;
+        return;
+    }
+    if( b->kind == XFORM_IDENTITY ) {
+        *out = *a;
+        return;
+    }
+
+    if( kind == XFORM_PROJECTIVE ) {
+        Mat4Mul( &out->m, &a->m, &b->m );
+    }
+    else if( ( a->kind == XFORM_TRANSLATION ) && ( b->kind == XFORM_TRANSLATION ) ) {
+        float tx = a->m.m[3]  + b->m.m[3];
+        float ty = a->m.m[7]  + b->m.m[7];
+        float tz = a->m.m[11] + b->m.m[11];
+        Mat4Ident( &out->m );
+        out->m.m[3]  = tx;
+        out->m.m[7]  = ty;
+        out->m.m[11] = tz;
+    }
+    else if( kind <= XFORM_UNIFORM_SCALE ) {
+        XformMulScaleTranslate( &out->m, &a->m, &b->m );
+    }
+    else if( a->kind == XFORM_TRANSLATION ) {
+        // перенос слева только сдвигает столбец переноса
+        float tx = a->m.m[3];
+        float ty = a->m.m[7];
+        float tz = a->m.m[11];
+        out->m = b->m;
+        out->m.m[3]  += tx;
+        out->m.m[7]  += ty;
+        out->m.m[11] += tz;
+    }
+    else {
+        XformMulAffine( &out->m, &a->m, &b->m );
+    }
+
+    out->kind = kind;
+}
+
+/*
+XformInv
+
+Вычисление обратного преобразования.
+Возвращает mfalse, если преобразование вырожденное, out при этом не изменяется.
+out может совпадать с x.
+*/
+mbool_t XformInv( xform_t* out, const xform_t* x ) {
+    const float* m = x->m.m;
+    mat4_t buf;
+
+    switch( x->kind ) {
+        case XFORM_IDENTITY:
+            Mat4Ident( &buf );
+            break;
+
+        case XFORM_TRANSLATION:
+            Mat4Ident( &buf );
+            buf.m[3]  = -m[3];
+            buf.m[7]  = -m[7];
+            buf.m[11] = -m[11];
+            break;
+
+        case XFORM_UNIFORM_SCALE: {
+            if( m[0] == 0.0f ) {
+                return mfalse;
+            }
+            float inv_s = 1.0f / m[0];
+            Mat4Ident( &buf );
+            buf.m[0]  = inv_s;
+            buf.m[5]  = inv_s;
+            buf.m[10] = inv_s;
+            buf.m[3]  = -m[3]  * inv_s;
+            buf.m[7]  = -m[7]  * inv_s;
+            buf.m[11] = -m[11] * inv_s;
+            break;
+        }
+
+        case XFORM_RIGID:
+            // обратный поворот - транспонированный, перенос - -R^T * t
+            buf.m[0]  = m[0]; buf.m[1]  = m[4]; buf.m[2]  = m[8];
+            buf.m[4]  = m[1]; buf.m[5]  = m[5]; buf.m[6]  = m[9];
+            buf.m[8]  = m[2]; buf.m[9]  = m[6]; buf.m[10] = m[10];
+            buf.m[3]  = -( m[0] * m[3] + m[4] * m[7] + m[8]  * m[11] );
+            buf.m[7]  = -( m[1] * m[3] + m[5] * m[7] + m[9]  * m[11] );
+            buf.m[11] = -( m[2] * m[3] + m[6] * m[7] + m[10] * m[11] );
+            XformSetAffineRow( &buf );
+            break;
+
+        case XFORM_AFFINE: {
+            // столбцы обратной 3x3 матрицы - векторные произведения её строк
+            float c0x = m[5] * m[10] - m[6] * m[9];
+            float c0y = m[6] * m[8]  - m[4] * m[10];
+            float c0z = m[4] * m[9]  - m[5] * m[8];
+            float det = m[0] * c0x + m[1] * c0y + m[2] * c0z;
+            if( det == 0.0f ) {
+                return mfalse;
+            }
+            float inv_det = 1.0f / det;
+
+            buf.m[0]  = c0x * inv_det;
+            buf.m[4]  = c0y * inv_det;
+            buf.m[8]  = c0z * inv_det;
+            buf.m[1]  = ( m[9] * m[2]  - m[10] * m[1] ) * inv_det;
+            buf.m[5]  = ( m[10] * m[0] - m[8]  * m[2] ) * inv_det;
+            buf.m[9]  = ( m[8] * m[1]  - m[9]  * m[0] ) * inv_det;
+            buf.m[2]  = ( m[1] * m[6]  - m[2]  * m[5] ) * inv_det;
+            buf.m[6]  = ( m[2] * m[4]  - m[0]  * m[6] ) * inv_det;
+            buf.m[10] = ( m[0] * m[5]  - m[1]  * m[4] ) * inv_det;
+
+            buf.m[3]  = -( buf.m[0] * m[3] + buf.m[1] * m[7] + buf.m[2]  * m[11] );
+            buf.m[7]  = -( buf.m[4] * m[3] + buf.m[5] * m[7] + buf.m[6]  * m[11] );
+            buf.m[11] = -( buf.m[8] * m[3] + buf.m[9] * m[7] + buf.m[10] * m[11] );
+            XformSetAffineRow( &buf );
+            break;
+        }
+
+        default:
+            buf = x->m;
+            if( !Mat4Inv( &buf ) ) {
+                return mfalse;
+            }
+            break;
+    }
+
+    out->m = buf;
+    out->kind = x->kind;
+    return mtrue;
+}
+
+/*
+XformMulVec3
+
+Преобразование точки v (w = 1). Деление на w выполняется
+только для проективных преобразований.
+*/
+void XformMulVec3( vec3_t* out, const xform_t* x, const vec3_t* v ) {
+    const float* m = x->m.m;
+    float vx = v->x;
+    float vy = v->y;
+    float vz = v->z;
+
+    switch( x->kind ) {
+        case XFORM_IDENTITY:
+            *out = *v;
+            break;
+
+        case XFORM_TRANSLATION:
+            out->x = vx + m[3];
+            out->y = vy + m[7];
+            out->z = vz + m[11];
+            break;
+
+        case XFORM_UNIFORM_SCALE:
+            out->x = vx * m[0] + m[3];
+            out->y = vy * m[0] + m[7];
+            out->z = vz * m[0] + m[11];
+            break;
+
+        case XFORM_RIGID:
+        case XFORM_AFFINE:
+            out->x = m[0] * vx + m[1] * vy + m[2]  * vz + m[3];
+            out->y = m[4] * vx + m[5] * vy + m[6]  * vz + m[7];
+            out->z = m[8] * vx + m[9] * vy + m[10] * vz + m[11];
+            break;
+
+        default:
+            Mat4MulVec3( out, &x->m, v );
+            break;
+    }
+}
+
+/*
+XformMulVec4
+
+Преобразование вектора-столбца v 4-ого порядка.
+*/
+void XformMulVec4( vec4_t* out, const xform_t* x, const vec4_t* v ) {
+    const float* m = x->m.m;
+    float vx = v->x;
+    float vy = v->y;
+    float vz = v->z;
+    float vw = v->w;
+
+    switch( x->kind ) {
+        case XFORM_IDENTITY:
+            *out = *v;
+            break;
+
+        case XFORM_TRANSLATION:
+            out->x = vx + m[3]  * vw;
+            out->y = vy + m[7]  * vw;
+            out->z = vz + m[11] * vw;
+            out->w = vw;
+            break;
+
+        case XFORM_UNIFORM_SCALE:
+            out->x = vx * m[0] + m[3]  * vw;
+            out->y = vy * m[0] + m[7]  * vw;
+            out->z = vz * m[0] + m[11] * vw;
+            out->w = vw;
+            break;
+
+        case XFORM_RIGID:
+        case XFORM_AFFINE:
+            out->x = m[0] * vx + m[1] * vy + m[2]  * vz + m[3]  * vw;
+            out->y = m[4] * vx + m[5] * vy + m[6]  * vz + m[7]  * vw;
+            out->z = m[8] * vx + m[9] * vy + m[10] * vz + m[11] * vw;
+            out->w = vw;
+            break;
+
+        default: {
+            vec4_t buf = *v;
+            Mat4MulVec4( out, &x->m, &buf );
+            break;
+        }
+    }
+}
+
+/*
+Mat4ToNormalMat3
+
+Матрица преобразования нормалей: обратная транспонированная к 3x3 части m.
+Строки результата - векторные произведения строк 3x3 части, делённые на
+определитель, поэтому обращение и транспонирование выполняются за один проход.
+Возвращает mfalse, если 3x3 часть вырожденная, out при этом не изменяется.
+*/
+mbool_t Mat4ToNormalMat3( mat3_t* out, const mat4_t* m ) {
+    vec3_t r0 = Vec3Make( m->m[0], m->m[1], m->m[2] );
+    vec3_t r1 = Vec3Make( m->m[4], m->m[5], m->m[6] );
+    vec3_t r2 = Vec3Make( m->m[8], m->m[9], m->m[10] );
+
+    vec3_t c0 = Vec3CrossVal( r1, r2 );
+    vec3_t c1 = Vec3CrossVal( r2, r0 );
+    vec3_t c2 = Vec3CrossVal( r0, r1 );
+
+    float det = Vec3DotVal( r0, c0 );
+    if( det == 0.0f ) {
+        return mfalse;
+    }
+
+    float inv_det = 1.0f / det;
+    out->a = Vec3Scale1fVal( c0, inv_det );
+    out->b = Vec3Scale1fVal( c1, inv_det );
+    out->c = Vec3Scale1fVal( c2, inv_det );
+    return mtrue;
+}
+
+/*
+XformToNormalMat3
+
+Матрица преобразования нормалей для преобразования x.
+Для поворота это сама 3x3 часть, для масштаба - единичная, делённая на масштаб.
+*/
+mbool_t XformToNormalMat3( mat3_t* out, const xform_t* x ) {
+    const float* m = x->m.m;
+
+    switch( x->kind ) {
+        case XFORM_IDENTITY:
+        case XFORM_TRANSLATION:
+            Mat3Ident( out );
+            return mtrue;
+
+        case XFORM_UNIFORM_SCALE:
+            if( m[0] == 0.0f ) {
+                return mfalse;
+            }
+            Mat3Ident( out );
+            out->a.x = 1.0f / m[0];
+            out->b.y = out->a.x;
+            out->c.z = out->a.x;
+            return mtrue;
+
+        case XFORM_RIGID:
+            Mat3Set9f( out, m[0], m[1], m[2],
+                            m[4], m[5], m[6],
+                            m[8], m[9], m[10] );
+            return mtrue;
+
+        default:
+            return Mat4ToNormalMat3( out, &x->m );
+    }
+}
+
+// аргументы Mat4ToNormalMat3Array и XformToNormalMat3Array для PoolParallelFor
+typedef struct {
+    mat3_t*         out;
+    const mat4_t*   m;
+    const xform_t*  x;
+    int             singular;   // вырожденных матриц, суммируется из всех чанков
+} xformnormal_t;
+
+#if defined( _MSC_VER )
+
+static void XformAddSingular( int* singular, int n ) {
+    InterlockedExchangeAdd( ( volatile LONG* )singular, n );
+}
+
+#else
+
+static void XformAddSingular( int* singular, int n ) {
+    __atomic_add_fetch( singular, n, __ATOMIC_RELAXED );
+}
+
+#endif
+
+static void Mat4NormalChunk( void* ctx, int begin, int end ) {
+    xformnormal_t* job = ctx;
+    int singular = 0;
+    for( int i = begin; i < end; i++ ) {
+        if( !Mat4ToNormalMat3( &job->out[i], &job->m[i] ) ) {
+            Mat3Ident( &job->out[i] );
+            singular++;
+        }
+    }
+    if( singular > 0 ) {
+        XformAddSingular( &job->singular, singular );
+    }
+}
+
+static void XformNormalChunk( void* ctx, int begin, int end ) {
+    xformnormal_t* job = ctx;
+    int singular = 0;
+    for( int i = begin; i < end; i++ ) {
+        if( !XformToNormalMat3( &job->out[i], &job->x[i] ) ) {
+            Mat3Ident( &job->out[i] );
+            singular++;
+        }
+    }
+    if( singular > 0 ) {
+        XformAddSingular( &job->singular, singular );
+    }
+}
+
+/*
+Mat4ToNormalMat3Array
+
+Матрицы преобразования нормалей для count матриц m, чанками между потоками пула.
+Для вырожденных матриц записывается единичная матрица и возвращается mfalse.
+*/
+mbool_t Mat4ToNormalMat3Array( mat3_t* out, const mat4_t* m, int count ) {
+    xformnormal_t job = { out, m, NULL, 0 };
+    PoolParallelFor( Mat4NormalChunk, &job, count, PoolChunk( sizeof( mat4_t ) + sizeof( mat3_t ) ) );
+    return job.singular == 0 ? mtrue : mfalse;
+}
+
+/*
+XformToNormalMat3Array
+
+Матрицы преобразования нормалей для count преобразований x, чанками между потоками пула.
+Для вырожденных преобразований записывается единичная матрица и возвращается mfalse.
+*/
+mbool_t XformToNormalMat3Array( mat3_t* out, const xform_t* x, int count ) {
+    xformnormal_t job = { out, NULL, x, 0 };
+    PoolParallelFor( XformNormalChunk, &job, count, PoolChunk( sizeof( xform_t ) + sizeof( mat3_t ) ) );
+    return job.singular == 0 ? mtrue : mfalse;
+}
+
+/*
+Mat4WorldRange
+
+Мировые матрицы узлов иерархии с begin по end - 1: world[i] = world[parent[i]] * local[i],
+для корней (parent[i] < 0) world[i] = local[i]. Родитель должен стоять
+раньше потомка (parent[i] < i), а его мировая матрица - быть уже вычислена,
+поэтому диапазоны можно обрабатывать параллельно, если каждый ждёт
+диапазоны с родителями своих узлов (JobGraphDependIndex).
+*/
+void Mat4WorldRange( mat4_t* world, const mat4_t* local, const int* parent, int begin, int end ) {
+    for( int i = begin; i < end; i++ ) {
+        if( parent[i] < 0 ) {
+            world[i] = local[i];
+        }
+        else {
+            Mat4MulR( &world[i], &world[parent[i]], &local[i] );
+        }
+    }
+}
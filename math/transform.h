@@ -0,0 +1,44 @@
+#ifndef __TRANSFORM_H__
+#define __TRANSFORM_H__
+
+#include "matrix.h"
+
+// вид преобразования, от самого простого к самому общему
+typedef enum {
+    XFORM_IDENTITY = 0,     // единичная матрица
+    XFORM_TRANSLATION,      // только перенос
+    XFORM_UNIFORM_SCALE,    // равномерный масштаб и перенос
+    XFORM_RIGID,            // поворот и перенос
+    XFORM_AFFINE,           // произвольная 3x3 часть и перенос
+    XFORM_PROJECTIVE        // нижняя строка отлична от ( 0 0 0 1 )
+} xformkind_t;
+
+// матрица 4-ого порядка с известным видом преобразования
+typedef struct {
+    mat4_t          m;
+    xformkind_t     kind;
+} xform_t;
+
+
+void        XformIdent( xform_t* x );
+void        XformTranslate( xform_t* x, const vec3_t* t );
+void        XformScale( xform_t* x, float s );
+void        XformRotate( xform_t* x, const vec3_t* axis, float angle );
+void        XformFromMat4( xform_t* x, const mat4_t* m );
+void        XformSetMat4( xform_t* x, const mat4_t* m, xformkind_t kind );
+void        XformMul( xform_t* out, const xform_t* a, const xform_t* b );
+mbool_t     XformInv( xform_t* out, const xform_t* x );
+void        XformMulVec3( vec3_t* out, const xform_t* x, const vec3_t* v );
+void        XformMulVec4( vec4_t* out, const xform_t* x, const vec4_t* v );
+xformkind_t XformKindMul( xformkind_t a, xformkind_t b );
+
+mbool_t     Mat4ToNormalMat3( mat3_t* out, const mat4_t* m );
+mbool_t     XformToNormalMat3( mat3_t* out, const xform_t* x );
+mbool_t     Mat4ToNormalMat3Array( mat3_t* out, const mat4_t* m, int count );
+mbool_t     XformToNormalMat3Array( mat3_t* out, const xform_t* x, int count );
+
+void        Mat4WorldRange( mat4_t* world, const mat4_t* local, const int* parent, int begin, int end );
+
+
+
+#endif //__TRANSFORM_H__
@@ -0,0 +1,196 @@
+#ifndef __VALUE_H__
+#define __VALUE_H__
+
+#include "matrix.h"
+
+/*
+Операции над векторами, принимающие и возвращающие значения.
+
+Функции встраиваемые: при передаче по значению компилятору не нужно
+учитывать возможное пересечение out, a и b, поэтому в циклах векторы
+остаются в регистрах и не перечитываются из памяти после каждой записи.
+*/
+
+static inline vec2_t Vec2Make( float x, float y ) {
+    vec2_t r;
+    r.x = x;
+    r.y = y;
+    return r;
+}
+
+static inline vec2_t Vec2AddVal( vec2_t a, vec2_t b ) {
+    return Vec2Make( a.x + b.x, a.y + b.y );
+}
+
+static inline vec2_t Vec2SubVal( vec2_t a, vec2_t b ) {
+    return Vec2Make( a.x - b.x, a.y - b.y );
+}
+
+static inline vec2_t Vec2NegVal( vec2_t v ) {
+    return Vec2Make( -v.x, -v.y );
+}
+
+static inline vec2_t Vec2ScaleVal( vec2_t v, vec2_t s ) {
+    return Vec2Make( v.x * s.x, v.y * s.y );
+}
+
+static inline vec2_t Vec2Scale1fVal( vec2_t v, float f ) {
+    return Vec2Make( v.x * f, v.y * f );
+}
+
+static inline float Vec2DotVal( vec2_t a, vec2_t b ) {
+    return a.x * b.x + a.y * b.y;
+}
+
+static inline vec2_t Vec2LerpVal( vec2_t a, vec2_t b, float s ) {
+    return Vec2Make( a.x + ( b.x - a.x ) * s, a.y + ( b.y - a.y ) * s );
+}
+
+// нулевой вектор нормализуется в ( 1 0 ), как и в Vec2Norm
+static inline vec2_t Vec2NormVal( vec2_t v ) {
+    float len = sqrtf( v.x * v.x + v.y * v.y );
+    if( len == 0.0f ) {
+        return Vec2Make( 1.0f, 0.0f );
+    }
+    return Vec2Scale1fVal( v, 1.0f / len );
+}
+
+
+
+static inline vec3_t Vec3Make( float x, float y, float z ) {
+    vec3_t r;
+    r.x = x;
+    r.y = y;
+    r.z = z;
+    return r;
+}
+
+static inline vec3_t Vec3AddVal( vec3_t a, vec3_t b ) {
+    return Vec3Make( a.x + b.x, a.y + b.y, a.z + b.z );
+}
+
+static inline vec3_t Vec3SubVal( vec3_t a, vec3_t b ) {
+    return Vec3Make( a.x - b.x, a.y - b.y, a.z - b.z );
+}
+
+static inline vec3_t Vec3NegVal( vec3_t v ) {
+    return Vec3Make( -v.x, -v.y, -v.z );
+}
+
+static inline vec3_t Vec3ScaleVal( vec3_t v, vec3_t s ) {
+    return Vec3Make( v.x * s.x, v.y * s.y, v.z * s.z );
+}
+
+static inline vec3_t Vec3Scale1fVal( vec3_t v, float f ) {
+    return Vec3Make( v.x * f, v.y * f, v.z * f );
+}
+
+static inline float Vec3DotVal( vec3_t a, vec3_t b ) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline vec3_t Vec3CrossVal( vec3_t a, vec3_t b ) {
+    return Vec3Make( a.y * b.z - a.z * b.y,
+                     a.z * b.x - a.x * b.z,
+                     a.x * b.y - a.y * b.x );
+}
+
+static inline vec3_t Vec3LerpVal( vec3_t a, vec3_t b, float s ) {
+    return Vec3Make( a.x + ( b.x - a.x ) * s,
+                     a.y + ( b.y - a.y ) * s,
+                     a.z + ( b.z - a.z ) * s );
+}
+
+// нулевой вектор нормализуется в ( 1 0 0 ), как и в Vec3Norm
+static inline vec3_t Vec3NormVal( vec3_t v ) {
+    float len = sqrtf( v.x * v.x + v.y * v.y + v.z * v.z );
+    if( len == 0.0f ) {
+        return Vec3Make( 1.0f, 0.0f, 0.0f );
+    }
+    return Vec3Scale1fVal( v, 1.0f / len );
+}
+
+
+
+static inline vec4_t Vec4Make( float x, float y, float z, float w ) {
+    vec4_t r;
+    r.x = x;
+    r.y = y;
+    r.z = z;
+    r.w = w;
+    return r;
+}
+
+static inline vec4_t Vec4AddVal( vec4_t a, vec4_t b ) {
+    return Vec4Make( a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w );
+}
+
+static inline vec4_t Vec4SubVal( vec4_t a, vec4_t b ) {
+    return Vec4Make( a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w );
+}
+
+static inline vec4_t Vec4NegVal( vec4_t v ) {
+    return Vec4Make( -v.x, -v.y, -v.z, -v.w );
+}
+
+static inline vec4_t Vec4ScaleVal( vec4_t v, vec4_t s ) {
+    return Vec4Make( v.x * s.x, v.y * s.y, v.z * s.z, v.w * s.w );
+}
+
+static inline vec4_t Vec4Scale1fVal( vec4_t v, float f ) {
+    return Vec4Make( v.x * f, v.y * f, v.z * f, v.w * f );
+}
+
+static inline float Vec4DotVal( vec4_t a, vec4_t b ) {
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+static inline vec4_t Vec4LerpVal( vec4_t a, vec4_t b, float s ) {
+    return Vec4Make( a.x + ( b.x - a.x ) * s,
+                     a.y + ( b.y - a.y ) * s,
+                     a.z + ( b.z - a.z ) * s,
+                     a.w + ( b.w - a.w ) * s );
+}
+
+// нулевой вектор нормализуется в ( 1 0 0 0 ), как и в Vec4Norm
+static inline vec4_t Vec4NormVal( vec4_t v ) {
+    float len = sqrtf( v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w );
+    if( len == 0.0f ) {
+        return Vec4Make( 1.0f, 0.0f, 0.0f, 0.0f );
+    }
+    return Vec4Scale1fVal( v, 1.0f / len );
+}
+
+
+
+// умножение матрицы на вектор-столбец, как в Mat3MulVec3
+static inline vec3_t Mat3MulVec3Val( const mat3_t* mrestrict m, vec3_t v ) {
+    return Vec3Make( m->m[0] * v.x + m->m[1] * v.y + m->m[2] * v.z,
+                     m->m[3] * v.x + m->m[4] * v.y + m->m[5] * v.z,
+                     m->m[6] * v.x + m->m[7] * v.y + m->m[8] * v.z );
+}
+
+// умножение матрицы на вектор-столбец, как в Mat4MulVec4
+static inline vec4_t Mat4MulVec4Val( const mat4_t* mrestrict m, vec4_t v ) {
+    return Vec4Make( m->m[0]  * v.x + m->m[1]  * v.y + m->m[2]  * v.z + m->m[3]  * v.w,
+                     m->m[4]  * v.x + m->m[5]  * v.y + m->m[6]  * v.z + m->m[7]  * v.w,
+                     m->m[8]  * v.x + m->m[9]  * v.y + m->m[10] * v.z + m->m[11] * v.w,
+                     m->m[12] * v.x + m->m[13] * v.y + m->m[14] * v.z + m->m[15] * v.w );
+}
+
+// преобразование точки (w = 1) с делением на w, как в Mat4MulVec3
+static inline vec3_t Mat4MulVec3Val( const mat4_t* mrestrict m, vec3_t v ) {
+    float x = m->m[0]  * v.x + m->m[1]  * v.y + m->m[2]  * v.z + m->m[3];
+    float y = m->m[4]  * v.x + m->m[5]  * v.y + m->m[6]  * v.z + m->m[7];
+    float z = m->m[8]  * v.x + m->m[9]  * v.y + m->m[10] * v.z + m->m[11];
+    float w = m->m[12] * v.x + m->m[13] * v.y + m->m[14] * v.z + m->m[15];
+    if( w == 0.0f ) {
+        w = 1.0f;
+    }
+    float inv_w = 1.0f / w;
+    return Vec3Make( x * inv_w, y * inv_w, z * inv_w );
+}
+
+
+
+#endif //__VALUE_H__
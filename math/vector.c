@@ -6,6 +6,7 @@ Vec2Set
 Установить значение вектора v.
 */
 void Vec2Set( vec2_t* v, float x, float y ) {
+    MATH_PROBE();
     v->x = x;
     v->y = y;
 }
@@ -16,6 +17,7 @@ Vec2Cpy
 Скопировать вектор v в out.
 */
 void Vec2Cpy( vec2_t* out, const vec2_t* v ) {
+    MATH_PROBE();
     out->x = v->x;
     out->y = v->y;
 }
@@ -26,6 +28,7 @@ Vec2Zero
 Установить вектор в 0.
 */
 void Vec2Zero( vec2_t* v ) {
+    MATH_PROBE();
     v->x = 0.0f;
     v->y = 0.0f;
 }
@@ -36,6 +39,7 @@ Vec2Neg
 Сделать негативным каждое значение вектора v.
 */
 void Vec2Neg( vec2_t* v ) {
+    MATH_PROBE();
     v->x = -v->x;
     v->y = -v->y;
 }
@@ -46,6 +50,7 @@ Vec2Inv
 Сделать обратным каждое значение вектора v (обратное значение для n – это 1/n).
 */
 void Vec2Inv( vec2_t* v ) {
+    MATH_PROBE();
     v->x = 1.0f / v->x;
     v->y = 1.0f / v->y;
 }
@@ -58,6 +63,7 @@ Vec2Scale
 и записать результат в v. 
 */
 void Vec2Scale( vec2_t* v, const vec2_t* s ) {
+    MATH_PROBE();
     v->x *= s->x;
     v->y *= s->y;
 }
@@ -69,6 +75,7 @@ Vec2Scale1f
 Каждое значение вектора v перемножить f и записать результат в v. 
 */
 void Vec2Scale1f( vec2_t* v, float f ){
+    MATH_PROBE();
     v->x *= f;
     v->y *= f;
 }
@@ -80,6 +87,7 @@ Vec2Add
 Сложить два вектора a и b, результат записать в out.
 */
 void Vec2Add( vec2_t* out, const vec2_t* a, const vec2_t* b ) {
+    MATH_PROBE();
     out->x = a->x + b->x;
     out->y = a->y + b->y;
 }
@@ -90,6 +98,7 @@ Vec2Sub
 Вычесть вектор b из вектора a, результат записать в out.
 */
 void Vec2Sub( vec2_t* out, const vec2_t* a, const vec2_t* b ) {
+    MATH_PROBE();
     out->x = a->x - b->x;
     out->y = a->y - b->y;
 }
@@ -102,6 +111,7 @@ Vec2Cmp
 если не равны, то возвращаемое значение будет mfalse.
 */
 mbool_t Vec2Cmp( const vec2_t* a, const vec2_t* b ) {
+    MATH_PROBE();
     if( ( a->x == b->x ) && ( a->y == b->y ) ) {
         return mtrue;
     }
@@ -116,6 +126,7 @@ Vec2CmpEps
 значение будет mtrue, иначе возвращаемое значение будет mfalse.
 */
 mbool_t Vec2CmpEps( const vec2_t* a, const vec2_t* b, float eps ) {
+    MATH_PROBE();
     float x = ( a->x > b->x ? a->x : b->x ) - ( a->x < b->x ? a->x : b->x );
     float y = ( a->y > b->y ? a->y : b->y ) - ( a->y < b->y ? a->y : b->y );
     if( ( x > eps ) || ( y > eps ) ) {
@@ -130,6 +141,7 @@ Vec2Len
 Вернуть расстояние от вектора a вектора b.
 */
 float Vec2Len( const vec2_t* a, const vec2_t* b ) {
+    MATH_PROBE();
     return sqrt1f( sqr1f( a->x - b->x ) + sqr1f( a->y - b->y ) );
 }
 
@@ -139,6 +151,7 @@ Vec2SqrLen
 Вернуть расстояние от вектора a вектора b в квадрате.
 */
 float Vec2SqrLen( const vec2_t* a, const vec2_t* b ) {
+    MATH_PROBE();
     return sqr1f( Vec2Len( a, b ) );
 }
 
@@ -149,6 +162,7 @@ Vec2Norm
 Нормализованный вектор записывается в v.
 */
 float Vec2Norm( vec2_t* v ) {
+    MATH_PROBE();
     float len = sqrt1f( sqr1f( v->x ) + sqr1f( v->y ) );
     if( len == 0 ) {
        v->x = 1;
@@ -167,6 +181,7 @@ Vec2Dot
 Вернуть скалярное произведение векторов a и b.
 */
 float Vec2Dot( const vec2_t* a, const vec2_t* b ) {
+    MATH_PROBE();
     return a->x * b->x + a->y * b->y;
 }
 
@@ -176,6 +191,7 @@ Vec2Cos
 Вернуть косинус угла между двумя векторами a и b.
 */
 float Vec2Cos( const vec2_t* a, const vec2_t* b ) {
+    MATH_PROBE();
     return Vec2Dot( a, b ) / ( sqrt1f( sqr1f( a->x ) + sqr1f( a->y ) ) 
                              * sqrt1f( sqr1f( b->x ) + sqr1f( b->y ) ) );
 }
@@ -186,6 +202,7 @@ Vec2Angle
 Вернуть угол в радианах между двумя векторами a и b.
 */
 float Vec2Angle( const vec2_t* a, const vec2_t* b ) {
+    MATH_PROBE();
     float len_a = sqrt1f( sqr1f( a->x ) + sqr1f( a->y ) );
     float len_b = sqrt1f( sqr1f( b->x ) + sqr1f( b->y ) );
     float cos_ab = Vec2Dot( a, b ) / len_a * len_b;
@@ -199,6 +216,7 @@ Vec2Clamp
 максимальными max значениями. Результат записать в v.
 */
 void Vec2Clamp( vec2_t* v, const vec2_t* min, const vec2_t* max ) {
+    MATH_PROBE();
     if( v->x < min->x ) {
         v->x = min->x;
     }
@@ -220,6 +238,7 @@ Vec2Lerp
 с коэффициентом scale. Результат записать в out.
 */
 void Vec2Lerp( vec2_t* out, const vec2_t* a, const vec2_t* b, float s ) {
+    MATH_PROBE();
     out->x = b->x * s + a->x * ( 1.0f - s );
     out->y = b->y * s + a->y * ( 1.0f - s );
 }
@@ -231,6 +250,7 @@ Vec2ToStr
 с количеством знаков после запятой prec.
 */
 void Vec2ToStr( char* out, const vec2_t* v, int prec ) {
+    MATH_PROBE();
     sprintf( out, "%.*f %.*f", prec, v->m[0], prec, v->m[1] );
 }
 
@@ -240,6 +260,7 @@ Vec2ToVec3
 Преобразование из двухмерного вектора в трёхмерный.
 */
 void Vec2ToVec3( vec3_t* out, const vec2_t* v ) {
+    MATH_PROBE();
     out->x = v->x;
     out->y = v->y;
     out->z = 1.0f;
@@ -251,6 +272,7 @@ Vec2ToVec4
 Преобразование из двумерного вектора в четырёхмерный.
 */
 void Vec2ToVec4( vec4_t* out, const vec2_t* v ) {
+    MATH_PROBE();
     out->x = v->x;
     out->y = v->y;
     out->z = 1.0f;
@@ -263,6 +285,7 @@ Vec3Set
 Установить значение вектора v.
 */
 void Vec3Set( vec3_t* v, float x, float y, float z ) {
+    MATH_PROBE();
     v->x = x;
     v->y = y;
     v->z = z;
@@ -274,6 +297,7 @@ Vec3Cpy
 Скопировать вектор v в out.
 */
 void Vec3Cpy( vec3_t* out, const vec3_t* v ) {
+    MATH_PROBE();
     out->x = v->x;
     out->y = v->y;
     out->z = v->z;
@@ -285,6 +309,7 @@ Vec3Zero
 Установить вектор в 0.
 */
 void Vec3Zero( vec3_t* v ) {
+    MATH_PROBE();
     v->x = 0.0f;
     v->y = 0.0f;
     v->z = 0.0f;
@@ -296,6 +321,7 @@ Vec3Neg
 Сделать негативным каждое значение вектора v.
 */
 void Vec3Neg( vec3_t* v ) {
+    MATH_PROBE();
     v->x = -v->x;
     v->y = -v->y;
     v->z = -v->z;
@@ -307,6 +333,7 @@ Vec3Inv
 Сделать обратным каждое значение вектора v (обратное значение для n – это 1/n).
 */
 void Vec3Inv( vec3_t* v ) {
+    MATH_PROBE();
     v->x = 1.0f / v->x;
     v->y = 1.0f / v->y;
     v->z = 1.0f / v->z;
@@ -320,6 +347,7 @@ Vec3Scale
 и записать результат в v. 
 */
 void Vec3Scale( vec3_t* v, const vec3_t* s ) {
+    MATH_PROBE();
     v->x *= s->x;
     v->y *= s->y;
     v->z *= s->z;
@@ -332,6 +360,7 @@ Vec3Scale1f
 Каждое значение вектора v перемножить f и записать результат в v. 
 */
 void Vec3Scale1f( vec3_t* v, float f ){
+    MATH_PROBE();
     v->x *= f;
     v->y *= f;
     v->z *= f;
@@ -343,6 +372,7 @@ Vec3Add
 Сложить два вектора a и b, результат записать в out.
 */
 void Vec3Add( vec3_t* out, const vec3_t* a, const vec3_t* b ) {
+    MATH_PROBE();
     out->x = a->x + b->x;
     out->y = a->y + b->y;
     out->z = a->z + b->z;
@@ -354,6 +384,7 @@ Vec3Sub
 Вычесть вектор b из вектора a, результат записать в out.
 */
 void Vec3Sub( vec3_t* out, const vec3_t* a, const vec3_t* b ) {
+    MATH_PROBE();
     out->x = a->x - b->x;
     out->y = a->y - b->y;
     out->z = a->z - b->z;
@@ -365,6 +396,7 @@ Vec3Cross
 Выполнить векторное произведение векторов a и b, результат записать в out.
 */
 void Vec3Cross( vec3_t* out, const vec3_t* a, const vec3_t* b ) {
+    MATH_PROBE();
     out->x = a->y * b->z - a->z * b->y;
     out->y = a->z * b->x - a->x * b->z;
     out->z = a->x * b->y - a->y * b->x;
@@ -378,6 +410,7 @@ Vec3Cmp
 если не равны, то возвращаемое значение будет mfalse.
 */
 mbool_t Vec3Cmp( const vec3_t* a, const vec3_t* b ) {
+    MATH_PROBE();
     if( ( a->x == b->x ) && ( a->y == b->y ) && ( a->z == b->z ) ) {
         return mtrue;
     }
@@ -392,6 +425,7 @@ Vec3CmpEps
 значение будет mtrue, иначе возвращаемое значение будет mfalse.
 */
 mbool_t Vec3CmpEps( const vec3_t* a, const vec3_t* b, float eps ) {
+    MATH_PROBE();
     float x = ( a->x > b->x ? a->x : b->x ) - ( a->x < b->x ? a->x : b->x );
     float y = ( a->y > b->y ? a->y : b->y ) - ( a->y < b->y ? a->y : b->y );
     float z = ( a->z > b->z ? a->z : b->z ) - ( a->z < b->z ? a->z : b->z );
@@ -407,6 +441,7 @@ Vec3Len
 Вернуть расстояние от вектора a вектора b.
 */
 float Vec3Len( const vec3_t* a, const vec3_t* b ) {
+    MATH_PROBE();
     return sqrt1f( sqr1f( a->x - b->x) + sqr1f( a->y - b->y ) + sqr1f( a->z - b->z ) );
 }
 
@@ -416,7 +451,8 @@ Vec3SqrLen
 Вернуть расстояние от вектора a вектора b в квадрате.
 */
 float Vec3SqrLen( const vec3_t* a, const vec3_t* b ) {
-    return sqrt1f( Vec3Len( a, b ) );
+    MATH_PROBE();
+    return sqr1f( Vec3Len( a, b ) );
 }
 
 /*
@@ -426,7 +462,8 @@ Vec3Norm
 Нормализованный вектор записывается в v.
 */
 float Vec3Norm( vec3_t* v ) {
-    float len = sqrt1f( sqr1f( v->x ) + sqr1f( v->y ) + sqrt1f( v->z ) );
+    MATH_PROBE();
+    float len = sqrt1f( sqr1f( v->x ) + sqr1f( v->y ) + sqr1f( v->z ) );
     if( len == 0.0f ) {
        v->x = 1.0f;
        v->y = 0.0f;
@@ -446,6 +483,7 @@ Vec3Dot
 Вернуть скалярное произведение векторов a и b.
 */
 float Vec3Dot( const vec3_t* a, const vec3_t* b ) {
+    MATH_PROBE();
     return a->x * b->x + a->y * b->y + a->z * b->z;
 }
 
@@ -455,6 +493,7 @@ Vec3Cos
 Вернуть косинус угла между двумя векторами a и b.
 */
 float Vec3Cos( const vec3_t* a, const vec3_t* b ) {
+    MATH_PROBE();
     return Vec3Dot( a, b ) / ( sqrt1f( sqr1f( a->x ) + sqr1f( a->y ) + sqr1f( a->z ) )
                             *  sqrt1f( sqr1f( b->x ) + sqr1f( b->y ) + sqr1f( b->z ) ) );
 }
@@ -465,6 +504,7 @@ Vec3Angle
 Вернуть угол в радианах между двумя векторами a и b.
 */
 float Vec3Angle( const vec3_t* a, const vec3_t* b ) {
+    MATH_PROBE();
     float len_a = sqrt1f( sqr1f( a->x ) + sqr1f( a->y ) + sqr1f( a->z ) );
     float len_b = sqrt1f( sqr1f( b->x ) + sqr1f( b->y ) + sqr1f( b->z ) );
     float cos_ab = Vec3Dot( a, b ) / len_a * len_b;
@@ -478,6 +518,7 @@ Vec3Clamp
 максимальными max значениями. Результат записать в v.
 */
 void Vec3Clamp( vec3_t* v, const vec3_t* min, const vec3_t* max ) {
+    MATH_PROBE();
     if( v->x < min->x ) {
         v->x = min->x;
     }
@@ -505,6 +546,7 @@ Vec3Lerp
 с коэффициентом scale. Результат записать в out.
 */
 void Vec3Lerp( vec3_t* out, const vec3_t* a, const vec3_t* b, float s ) {
+    MATH_PROBE();
     out->x = b->x * s + a->x * ( 1.0f - s );
     out->y = b->y * s + a->y * ( 1.0f - s );
     out->z = b->z * s + a->z * ( 1.0f - s );
@@ -517,6 +559,7 @@ Vec3ToStr
 с количеством знаков после запятой prec.
 */
 void Vec3ToStr( char* out, const vec3_t* v, int prec ) {
+    MATH_PROBE();
     sprintf( out, "%.*f %.*f %.*f", prec, v->m[0], prec, v->m[1], prec, v->m[2] );
 }
 
@@ -526,6 +569,7 @@ Vec3ToVec2
 Преобразование из трёхмерного вектора в двумерный вектор.
 */
 void Vec3ToVec2( vec2_t* out, const vec3_t* v ) {
+    MATH_PROBE();
     float z = 1 / v->z;
     out->x = v->x * z;
     out->y = v->y * z;
@@ -537,6 +581,7 @@ Vec3ToVec4
 Преобразование из трёхмерного вектора в четырёхмерный.
 */
 void Vec3ToVec4( vec4_t* out, const vec3_t* v ) {
+    MATH_PROBE();
     out->x = v->x;
     out->y = v->y;
     out->z = v->z;
@@ -549,6 +594,7 @@ Vec4Set
 Установить значение вектора v.
 */
 void Vec4Set( vec4_t* v, float x, float y, float z, float w ) {
+    MATH_PROBE();
     v->x = x;
     v->y = y;
     v->z = z;
@@ -561,6 +607,7 @@ Vec4Cpy
 Скопировать вектор v в out.
 */
 void Vec4Cpy( vec4_t* out, const vec4_t* v ) {
+    MATH_PROBE();
     out->x = v->x;
     out->y = v->y;
     out->z = v->z;
@@ -573,6 +620,7 @@ Vec4Zero
 Установить вектор в 0.
 */
 void Vec4Zero( vec4_t* v ) {
+    MATH_PROBE();
     v->x = 0.0f;
     v->y = 0.0f;
     v->z = 0.0f;
@@ -585,6 +633,7 @@ Vec4Neg
 Сделать негативным каждое значение вектора v.
 */
 void Vec4Neg( vec4_t* v ) {
+    MATH_PROBE();
     v->x = -v->x;
     v->y = -v->y;
     v->z = -v->z;
@@ -597,6 +646,7 @@ Vec4Inv
 Сделать обратным каждое значение вектора v (обратное значение для n – это 1/n).
 */
 void Vec4Inv( vec4_t* v ) {
+    MATH_PROBE();
     v->x = 1.0f / v->x;
     v->y = 1.0f / v->y;
     v->z = 1.0f / v->z;
@@ -611,6 +661,7 @@ Vec4Scale
 и записать результат в v. 
 */
 void Vec4Scale( vec4_t* v, const vec4_t* s ) {
+    MATH_PROBE();
     v->x *= s->x;
     v->y *= s->y;
     v->z *= s->z;
@@ -624,6 +675,7 @@ Vec4Scale1f
 Каждое значение вектора v перемножить f и записать результат в v. 
 */
 void Vec4Scale1f( vec4_t* v, float f ) {
+    MATH_PROBE();
     v->x *= f;
     v->y *= f;
     v->z *= f;
@@ -636,6 +688,7 @@ Vec4Add
 Сложить два вектора a и b, результат записать в out.
 */
 void Vec4Add( vec4_t* out, const vec4_t* a, const vec4_t* b ) {
+    MATH_PROBE();
     out->x = a->x + b->x;
     out->y = a->y + b->y;
     out->z = a->z + b->z;
@@ -648,6 +701,7 @@ Vec4Sub
 Вычесть вектор b из вектора a, результат записать в out.
 */
 void Vec4Sub( vec4_t* out, const vec4_t* a, const vec4_t* b ) {
+    MATH_PROBE();
     out->x = a->x - b->x;
     out->y = a->y - b->y;
     out->z = a->z - b->z;
@@ -662,6 +716,7 @@ Vec4Cmp
 если не равны, то возвращаемое значение будет mfalse.
 */
 mbool_t Vec4Cmp( const vec4_t* a, const vec4_t* b ) {
+    MATH_PROBE();
     if( ( a->x == b->x ) && ( a->y == b->y ) &&
         ( a->z == b->z ) && ( a->w == b->w ) ) {
         return mtrue;
@@ -677,6 +732,7 @@ Vec4CmpEps
 значение будет mtrue, иначе возвращаемое значение будет mfalse.
 */
 mbool_t Vec4CmpEps( const vec4_t* a, const vec4_t* b, float eps ) {
+    MATH_PROBE();
     float x = ( a->x > b->x ? a->x : b->x ) - ( a->x < b->x ? a->x : b->x );
     float y = ( a->y > b->y ? a->y : b->y ) - ( a->y < b->y ? a->y : b->y );
     float z = ( a->z > b->z ? a->z : b->z ) - ( a->z < b->z ? a->z : b->z );
@@ -693,6 +749,7 @@ Vec4Len
 Вернуть расстояние от вектора a вектора b.
 */
 float Vec4Len( const vec4_t* a, const vec4_t* b ) {
+    MATH_PROBE();
     return sqrt1f( sqr1f( a->x - b->x ) + sqr1f( a->y - b->y ) +
                    sqr1f( a->z - b->z ) + sqr1f( a->w - b->w ) );
 }
@@ -703,6 +760,7 @@ Vec4SqrLen
 Вернуть расстояние от вектора a вектора b в квадрате.
 */
 float Vec4SqrLen( const vec4_t* a, const vec4_t* b ) {
+    MATH_PROBE();
     return sqr1f( Vec4Len( a, b ) );
 }
 
@@ -713,6 +771,7 @@ Vec4Norm
 Нормализованный вектор записывается в v.
 */
 float Vec4Norm( vec4_t* v ) {
+    MATH_PROBE();
     float len = sqrt1f( sqr1f( v->x ) + sqr1f( v->y ) + sqr1f(v->z) + sqr1f(v->w) );
     if( len == 0.0f ) {
        v->x = 1.0f;
@@ -735,6 +794,7 @@ Vec4Dot
 Вернуть скалярное произведение векторов a и b.
 */
 float Vec4Dot( const vec4_t* a, const vec4_t* b ) {
+    MATH_PROBE();
     return a->x * b->x + a->y * b->y + a->z * b->z + a->w * b->w;
 }
 
@@ -745,6 +805,7 @@ Vec4Clamp
 максимальными max значениями. Результат записать в v.
 */
 void Vec4Clamp( vec4_t* v, const vec4_t* min, const vec4_t* max ) {
+    MATH_PROBE();
     if( v->x < min->x ) {
         v->x = min->x;
     }
@@ -778,6 +839,7 @@ Vec4Lerp
 с коэффициентом scale. Результат записать в out.
 */
 void Vec4Lerp( vec4_t* out, const vec4_t* a, const vec4_t* b, float s ) {
+    MATH_PROBE();
     out->x = b->x * s + a->x * ( 1.0f - s );
     out->y = b->y * s + a->y * ( 1.0f - s );
     out->z = b->z * s + a->z * ( 1.0f - s );
@@ -791,6 +853,7 @@ Vec4ToStr
 с количеством знаков после запятой prec.
 */
 void Vec4ToStr( char* out, const vec4_t* v, int prec ) {
+    MATH_PROBE();
     sprintf( out, "%.*f %.*f %.*f %.*f",
              prec, v->m[0], prec, v->m[1], prec, v->m[2], prec, v->m[3] );
 }
@@ -801,6 +864,7 @@ Vec4ToVec2
 Преобразование из четырёхмерного вектора в двумерный.
 */
 void Vec4ToVec2( vec2_t* out, const vec4_t* v ) {
+    MATH_PROBE();
     vec3_t buf;
     Vec4ToVec3( v, &buf );
     Vec3ToVec2( &buf, out );
@@ -812,6 +876,7 @@ Vec4ToVec3
 Преобразование из четырёхмерного вектора в трёхмерный.
 */
 void Vec4ToVec3( vec3_t* out, const vec4_t* v ) {
+    MATH_PROBE();
     float w = 1.0f / v->w;
     out->x = v->x * w;
     out->y = v->y * w;
@@ -52,6 +52,12 @@ typedef struct {
     };
 } vec4_t;
 
+// ограничивающий параллелепипед, выровненный по осям (broadphase, quant)
+typedef struct {
+    vec3_t          min;
+    vec3_t          max;
+} aabb_t;
+
 
 void        Vec2Set( vec2_t* v, float x, float y );
 void        Vec2Cpy( vec2_t* out, const vec2_t* v );
@@ -0,0 +1,187 @@
+#include <string.h>
+
+#include "xformstore.h"
+
+#if defined( _MSC_VER )
+#include <windows.h>
+#endif
+
+#define XSTORE_INDEX    3u      // номер среднего буфера в state
+#define XSTORE_FRESH    4u      // средний буфер ещё не забран читателем
+
+#if defined( _MSC_VER )
+
+static unsigned int XformStoreLoad( unsigned int* state ) {
+    return ( unsigned int )InterlockedCompareExchange( ( volatile LONG* )state, 0, 0 );
+}
+
+static unsigned int XformStoreSwap( unsigned int* state, unsigned int v ) {
+    return ( unsigned int )InterlockedExchange( ( volatile LONG* )state, ( LONG )v );
+}
+
+#else
+
+static unsigned int XformStoreLoad( unsigned int* state ) {
+    return __atomic_load_n( state, __ATOMIC_ACQUIRE );
+}
+
+static unsigned int XformStoreSwap( unsigned int* state, unsigned int v ) {
+    return __atomic_exchange_n( state, v, __ATOMIC_ACQ_REL );
+}
+
+#endif
+
+/*
+XformStoreAddRange
+
+Добавление [begin, end) в список с объединением пересекающихся и
+соседних диапазонов. Если диапазонов больше XSTORE_RANGES, сливаются
+два с самым коротким промежутком: список может покрыть лишние матрицы,
+но никогда не теряет изменённые.
+*/
+static void XformStoreAddRange( xstoreranges_t* l, int begin, int end ) {
+    if( begin >= end ) {
+        return;
+    }
+    int i = 0;
+    while( ( i < l->count ) && ( l->r[i].end < begin ) ) {
+        i++;
+    }
+    int j = i;
+    while( ( j < l->count ) && ( l->r[j].begin <= end ) ) {
+        begin = l->r[j].begin < begin ? l->r[j].begin : begin;
+        end = l->r[j].end > end ? l->r[j].end : end;
+        j++;
+    }
+    memmove( &l->r[i + 1], &l->r[j], ( l->count - j ) * sizeof( xstorerange_t ) );
+    l->r[i].begin = begin;
+    l->r[i].end = end;
+    l->count += 1 - ( j - i );
+
+    if( l->count > XSTORE_RANGES ) {
+        int k = 0;
+        for( int m = 1; m + 1 < l->count; m++ ) {
+            if( l->r[m + 1].begin - l->r[m].end < l->r[k + 1].begin - l->r[k].end ) {
+                k = m;
+            }
+        }
+        l->r[k].end = l->r[k + 1].end;
+        memmove( &l->r[k + 1], &l->r[k + 2], ( l->count - k - 2 ) * sizeof( xstorerange_t ) );
+        l->count--;
+    }
+}
+
+/*
+XformStoreInit
+
+Хранилище на count матриц, все буферы заполнены единичными матрицами.
+Возвращает mfalse при нехватке памяти.
+*/
+mbool_t XformStoreInit( xformstore_t* s, int count ) {
+    memset( s, 0, sizeof( xformstore_t ) );
+    s->count = count > 0 ? count : 0;
+    for( int b = 0; b < XSTORE_BUFFERS; b++ ) {
+        s->buf[b] = MathAlignedAlloc( ( s->count > 0 ? s->count : 1 ) * sizeof( mat4_t ), 64 );
+        if( s->buf[b] == NULL ) {
+            XformStoreRelease( s );
+            return mfalse;
+        }
+        for( int i = 0; i < s->count; i++ ) {
+            Mat4Ident( &s->buf[b][i] );
+        }
+    }
+    s->back = 0;
+    s->state = 1;
+    s->front = 2;
+    return mtrue;
+}
+
+void XformStoreRelease( xformstore_t* s ) {
+    for( int b = 0; b < XSTORE_BUFFERS; b++ ) {
+        MathAlignedFree( s->buf[b] );
+        s->buf[b] = NULL;
+    }
+    s->count = 0;
+}
+
+/*
+XformStoreWrite
+
+Задний буфер писателя. Он уже содержит последний опубликованный кадр,
+писатель меняет в нём нужные матрицы и отмечает их XformStoreDirty.
+*/
+mat4_t* XformStoreWrite( xformstore_t* s ) {
+    return s->buf[s->back];
+}
+
+/*
+XformStoreDirty
+
+Отметка матриц [begin, end) заднего буфера как изменённых в этом кадре.
+*/
+void XformStoreDirty( xformstore_t* s, int begin, int end ) {
+    begin = begin < 0 ? 0 : begin;
+    end = end > s->count ? s->count : end;
+    XformStoreAddRange( &s->dirty, begin, end );
+}
+
+void XformStoreSet( xformstore_t* s, int index, const mat4_t* m ) {
+    if( ( index < 0 ) || ( index >= s->count ) ) {
+        return;
+    }
+    s->buf[s->back][index] = *m;
+    XformStoreAddRange( &s->dirty, index, index + 1 );
+}
+
+/*
+XformStorePublish
+
+Публикация заднего буфера как нового кадра. Писатель получает бывший
+средний буфер и догоняет его до опубликованного кадра, копируя только
+диапазоны, изменённые с тех пор, как этот буфер был актуальным.
+Читатель в это время может читать опубликованный буфер: оба его только читают.
+*/
+void XformStorePublish( xformstore_t* s ) {
+    int published = s->back;
+    for( int b = 0; b < XSTORE_BUFFERS; b++ ) {
+        if( b == published ) {
+            continue;
+        }
+        for( int k = 0; k < s->dirty.count; k++ ) {
+            XformStoreAddRange( &s->stale[b], s->dirty.r[k].begin, s->dirty.r[k].end );
+        }
+    }
+    s->dirty.count = 0;
+    s->frames[published] = ++s->frame;
+
+    unsigned int old = XformStoreSwap( &s->state, ( unsigned int )published | XSTORE_FRESH );
+    s->back = ( int )( old & XSTORE_INDEX );
+
+    xstoreranges_t* stale = &s->stale[s->back];
+    s->copied = 0;
+    for( int k = 0; k < stale->count; k++ ) {
+        int n = stale->r[k].end - stale->r[k].begin;
+        memcpy( &s->buf[s->back][stale->r[k].begin], &s->buf[published][stale->r[k].begin], n * sizeof( mat4_t ) );
+        s->copied += n;
+    }
+    stale->count = 0;
+    s->frames[s->back] = s->frame;
+}
+
+/*
+XformStoreRead
+
+Буфер читателя с последним опубликованным кадром; номер кадра
+записывается в frame (может быть NULL). Не блокируется: если нового
+кадра нет, возвращается тот же буфер, что и в прошлый раз.
+*/
+const mat4_t* XformStoreRead( xformstore_t* s, unsigned int* frame ) {
+    if( XformStoreLoad( &s->state ) & XSTORE_FRESH ) {
+        unsigned int old = XformStoreSwap( &s->state, ( unsigned int )s->front );
+        s->front = ( int )( old & XSTORE_INDEX );
+    }
+    if( frame != NULL ) {
+        *frame = s->frames[s->front];
+    }
+    return s->buf[s->front];
+}
@@ -0,0 +1,74 @@
+#ifndef __XFORMSTORE_H__
+#define __XFORMSTORE_H__
+
+#include "matrix.h"
+
+#define XSTORE_BUFFERS  3
+#define XSTORE_RANGES   32      // диапазонов в списке изменений, больше - соседние сливаются
+
+/*
+Тройной буфер мировых матриц между потоком симуляции (писатель) и
+потоком отрисовки (читатель). Писатель заполняет свой задний буфер и
+публикует его атомарной заменой номера среднего буфера; читатель
+забирает средний буфер такой же заменой, если в нём есть новый кадр.
+Ни одна сторона не ждёт другую и не копирует весь массив.
+
+Буфер, который писатель получает после публикации, отстаёт от
+опубликованного кадра. Для каждого буфера хранится список диапазонов,
+изменённых с тех пор, как он был актуальным; при публикации в новый
+задний буфер копируются только эти диапазоны. Поэтому писатель обязан
+отмечать изменённые матрицы через XformStoreDirty (или XformStoreSet).
+
+Один писатель и один читатель. Указатель, полученный читателем,
+действителен до его следующего XformStoreRead, указатель писателя -
+до следующего XformStorePublish.
+*/
+
+// полуинтервал номеров матриц [begin, end)
+typedef struct {
+    int             begin;
+    int             end;
+} xstorerange_t;
+
+// упорядоченные непересекающиеся диапазоны; лишний элемент - для вставки перед слиянием
+typedef struct {
+    xstorerange_t   r[XSTORE_RANGES + 1];
+    int             count;
+} xstoreranges_t;
+
+typedef struct {
+    mat4_t*         buf[XSTORE_BUFFERS];
+    int             count;
+    unsigned int    frames[XSTORE_BUFFERS];     // номер кадра в буфере
+
+    // общее: номер среднего буфера и признак нового кадра
+    unsigned char   pad0[64];
+    unsigned int    state;
+    unsigned char   pad1[64];
+
+    // писатель
+    int             back;
+    unsigned int    frame;
+    int             copied;                     // матриц скопировано при последней публикации
+    xstoreranges_t  dirty;                      // изменения текущего кадра
+    xstoreranges_t  stale[XSTORE_BUFFERS];      // чем буфер отличается от последнего кадра
+    unsigned char   pad2[64];
+
+    // читатель
+    int             front;
+} xformstore_t;
+
+
+mbool_t         XformStoreInit( xformstore_t* s, int count );
+void            XformStoreRelease( xformstore_t* s );
+
+mat4_t*         XformStoreWrite( xformstore_t* s );
+void            XformStoreDirty( xformstore_t* s, int begin, int end );
+void            XformStoreSet( xformstore_t* s, int index, const mat4_t* m );
+void            XformStorePublish( xformstore_t* s );
+
+const mat4_t*   XformStoreRead( xformstore_t* s, unsigned int* frame );
+
+
+
+#endif //__XFORMSTORE_H__
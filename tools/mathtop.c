@@ -0,0 +1,153 @@
+// Compile: gcc -O2 tools/mathtop.c -o mathtop
+// Использование: mathtop <pid | /имя сегмента> [период в мс] [число обновлений]
+// Показывает счётчики процесса, собранного с -DMATH_METRICS, не останавливая его.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "../math/metrics.h"
+
+#define TOP_READ_TRIES  1000    // попыток согласованного чтения строки
+
+/*
+TopNow
+
+Текущее время в секундах от произвольной точки отсчёта.
+*/
+static double TopNow( void ) {
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+TopReadRow
+
+Согласованная копия строки потока: копирование повторяется, пока
+писатель меняет строку (нечётный seq) или успел изменить её за время копирования.
+Поток, завершившийся посреди записи, оставляет seq нечётным навсегда,
+поэтому попыток не больше TOP_READ_TRIES.
+Возвращает 0, если согласованной копии получить не удалось; out тогда не меняется.
+*/
+static int TopReadRow( mathcounter_t* out, const mathmetricrow_t* row, int num_metrics ) {
+    mathcounter_t c[MATH_METRIC_COUNT];
+    for( int t = 0; t < TOP_READ_TRIES; t++ ) {
+        uint32_t s1 = __atomic_load_n( &row->seq, __ATOMIC_ACQUIRE );
+        if( s1 & 1 ) {
+            // писатель внутри записи: даём ему закончить
+            sched_yield();
+            continue;
+        }
+        for( int i = 0; i < num_metrics; i++ ) {
+            c[i].calls = __atomic_load_n( &row->c[i].calls, __ATOMIC_RELAXED );
+            c[i].elements = __atomic_load_n( &row->c[i].elements, __ATOMIC_RELAXED );
+            c[i].events = __atomic_load_n( &row->c[i].events, __ATOMIC_RELAXED );
+            c[i].max_batch = __atomic_load_n( &row->c[i].max_batch, __ATOMIC_RELAXED );
+        }
+        __atomic_thread_fence( __ATOMIC_ACQUIRE );
+        if( __atomic_load_n( &row->seq, __ATOMIC_RELAXED ) == s1 ) {
+            memcpy( out, c, num_metrics * sizeof( mathcounter_t ) );
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+TopSnapshot
+
+Сумма счётчиков по всем строкам потоков. В rows хранится последняя
+согласованная копия каждой строки: устаревшая строка входит в сумму
+этой копией, чтобы счётчики не шли назад.
+Возвращает количество устаревших строк.
+*/
+static int TopSnapshot( mathcounter_t* sum, mathcounter_t ( *rows )[MATH_METRIC_COUNT], const mathmetricshm_t* shm, int num_metrics ) {
+    uint32_t num_rows = __atomic_load_n( &shm->num_rows, __ATOMIC_ACQUIRE );
+    int stale = 0;
+    memset( sum, 0, num_metrics * sizeof( mathcounter_t ) );
+    for( uint32_t r = 0; ( r < num_rows ) && ( r < MATH_METRICS_ROWS ); r++ ) {
+        if( !__atomic_load_n( &shm->rows[r].used, __ATOMIC_ACQUIRE ) ) {
+            continue;
+        }
+        if( !TopReadRow( rows[r], &shm->rows[r], num_metrics ) ) {
+            stale++;
+        }
+        const mathcounter_t* row = rows[r];
+        for( int i = 0; i < num_metrics; i++ ) {
+            sum[i].calls += row[i].calls;
+            sum[i].elements += row[i].elements;
+            sum[i].events += row[i].events;
+            sum[i].max_batch = row[i].max_batch > sum[i].max_batch ? row[i].max_batch : sum[i].max_batch;
+        }
+    }
+    return stale;
+}
+
+int main( int argc, char** argv ) {
+    char name[64];
+    if( argc < 2 ) {
+        fprintf( stderr, "usage: %s <pid | /name> [interval_ms] [updates]\n", argv[0] );
+        return 1;
+    }
+    if( argv[1][0] == '/' ) {
+        snprintf( name, sizeof( name ), "%s", argv[1] );
+    }
+    else {
+        snprintf( name, sizeof( name ), "/math_metrics.%s", argv[1] );
+    }
+    int interval = argc > 2 ? atoi( argv[2] ) : 1000;
+    int updates = argc > 3 ? atoi( argv[3] ) : 0;   // 0 - без ограничения
+
+    int fd = shm_open( name, O_RDONLY, 0 );
+    if( fd < 0 ) {
+        fprintf( stderr, "%s: cannot open %s\n", argv[0], name );
+        return 1;
+    }
+    const mathmetricshm_t* shm = mmap( NULL, sizeof( mathmetricshm_t ), PROT_READ, MAP_SHARED, fd, 0 );
+    close( fd );
+    if( ( shm == MAP_FAILED ) || ( __atomic_load_n( &shm->magic, __ATOMIC_ACQUIRE ) != MATH_METRICS_MAGIC ) ||
+        ( shm->version != MATH_METRICS_VERSION ) ) {
+        fprintf( stderr, "%s: %s is not a math metrics segment\n", argv[0], name );
+        return 1;
+    }
+    int num_metrics = shm->num_metrics < MATH_METRIC_COUNT ? shm->num_metrics : MATH_METRIC_COUNT;
+
+    static mathcounter_t rows[MATH_METRICS_ROWS][MATH_METRIC_COUNT];
+    mathcounter_t prev[MATH_METRIC_COUNT], cur[MATH_METRIC_COUNT];
+    TopSnapshot( prev, rows, shm, num_metrics );
+    double t0 = TopNow();
+    for( int u = 0; ( updates == 0 ) || ( u < updates ); u++ ) {
+        usleep( interval * 1000 );
+        int stale = TopSnapshot( cur, rows, shm, num_metrics );
+        double t1 = TopNow();
+        double dt = t1 - t0;
+
+        if( isatty( STDOUT_FILENO ) ) {
+            printf( "\033[H\033[2J" );
+        }
+        // num_rows считает и потоки, которым строки не хватило
+        uint32_t num_rows = __atomic_load_n( &shm->num_rows, __ATOMIC_ACQUIRE );
+        printf( "pid %u   threads %u   dropped %u   stale %d\n\n", shm->pid,
+                num_rows < MATH_METRICS_ROWS ? num_rows : MATH_METRICS_ROWS, shm->dropped, stale );
+        printf( "%-18s %12s %14s %14s %10s %10s %10s\n", "kernel", "calls", "elements", "elem/s", "avg batch", "max batch", "events" );
+        for( int i = 0; i < num_metrics; i++ ) {
+            uint64_t dc = cur[i].calls - prev[i].calls;
+            uint64_t de = cur[i].elements - prev[i].elements;
+            printf( "%-18.*s %12llu %14llu %14.0f %10.1f %10llu %10llu\n", MATH_METRICS_NAME_LEN, shm->names[i],
+                    ( unsigned long long )cur[i].calls, ( unsigned long long )cur[i].elements, de / dt,
+                    dc > 0 ? ( double )de / dc : 0.0, ( unsigned long long )cur[i].max_batch,
+                    ( unsigned long long )cur[i].events );
+        }
+        fflush( stdout );
+        memcpy( prev, cur, sizeof( prev ) );
+        t0 = t1;
+    }
+    munmap( ( void* )shm, sizeof( mathmetricshm_t ) );
+    return 0;
+}